@@ -1,5 +1,6 @@
 QT       += core gui
 QT       += network
+QT       += concurrent
 
 greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
 
@@ -10,18 +11,75 @@ CONFIG += c++17
 #DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
 
 SOURCES += \
+    clientoptions.cpp \
+    commandframe.cpp \
+    controlcoalescer.cpp \
+    controlcore.cpp \
+    gamepadinput.cpp \
+    inputconditioner.cpp \
     joypad.cpp \
+    latencyhistogram.cpp \
+    latencypanel.cpp \
+    latencytracker.cpp \
     main.cpp \
     mainwindow.cpp \
-    iwindows_xinput_wrapper.cpp \
+    networkworker.cpp \
+    robotcommandstate.cpp \
+    robotsession.cpp \
+    robotstateview.cpp \
+    sceneconverter.cpp \
+    scriptdriver.cpp \
+    sessionlog.cpp \
+    sessionreplayer.cpp \
+    telemetryconsole.cpp \
+    telemetryparser.cpp \
+    telemetryplot.cpp \
+    telemetrystore.cpp \
+    timelinesequencer.cpp \
+    wakeupmonitor.cpp \
     xmlwindow.cpp
 
 HEADERS += \
+    clientoptions.h \
+    commandframe.h \
+    controlcoalescer.h \
+    controlcore.h \
+    gamepadinput.h \
+    inputconditioner.h \
     joypad.h \
+    latencyhistogram.h \
+    latencypanel.h \
+    latencytracker.h \
     mainwindow.h \
-    iwindows_xinput_wrapper.h \
+    networkworker.h \
+    robotcommandstate.h \
+    robotendpoint.h \
+    robotsession.h \
+    robotstateview.h \
+    sceneconverter.h \
+    scriptdriver.h \
+    sessionlog.h \
+    sessionreplayer.h \
+    spscring.h \
+    telemetryconsole.h \
+    telemetryparser.h \
+    telemetryplot.h \
+    telemetrystore.h \
+    timelinesequencer.h \
+    wakeupmonitor.h \
     xmlwindow.h
 
+win32 {
+    SOURCES += iwindows_xinput_wrapper.cpp
+    HEADERS += iwindows_xinput_wrapper.h
+    LIBS += -lcfgmgr32
+}
+
+linux {
+    SOURCES += evdevgamepad.cpp shmtransport.cpp
+    HEADERS += evdevgamepad.h shmtransport.h
+}
+
 FORMS += \
     mainwindow.ui \
     xmlwindow.ui
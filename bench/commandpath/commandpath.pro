@@ -0,0 +1,18 @@
+CONFIG += c++17 console
+CONFIG -= app_bundle qt
+
+# Before/after latency of the command path, see main.cpp. Standard library only.
+
+INCLUDEPATH += ../..
+
+LIBS += -lpthread
+
+SOURCES += \
+    ../../commandframe.cpp \
+    ../../latencyhistogram.cpp \
+    main.cpp
+
+HEADERS += \
+    ../../commandframe.h \
+    ../../latencyhistogram.h \
+    ../../spscring.h
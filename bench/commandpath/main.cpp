@@ -0,0 +1,290 @@
+/*
+ *  Command path latency, socket writes on the GUI thread versus the NetworkWorker.
+ *
+ *  A model of one display frame of the GUI thread: the coalesced JoyPad or gamepad
+ *  command of the frame is encoded, then the widgets paint for --paint-ms. Every
+ *  --stall-every frames the paint takes --stall-ms instead, for a file dialog or a
+ *  large XmlWindow load.
+ *
+ *      gui      the frame is written to a socket owned by the GUI thread. As with
+ *               QTcpSocket it is only buffered and leaves when control returns to
+ *               the event loop, i.e. after the paint (the code before user-003).
+ *      worker   the frame goes into an SpscRing and a wakeup is posted only when the
+ *               worker is not already scheduled, as NetworkWorker::send() does; the
+ *               worker thread drains the ring into its own socket.
+ *
+ *  The receiving end of a socket pair decodes the frames and records the time from
+ *  the encoder's timestamp to their arrival. Linux and other POSIX systems only.
+ *
+ *  usage: commandpath [--seconds s] [--paint-ms ms] [--stall-ms ms] [--stall-every n]
+ */
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "commandframe.h"
+#include "latencyhistogram.h"
+#include "spscring.h"
+
+namespace
+{
+
+struct Settings
+{
+    double seconds = 5.0;
+    double paintMs = 4.0;
+    double stallMs = 40.0;
+    int stallEvery = 60;
+
+    // display frames per second of the modelled GUI thread
+    int frameRate = 60;
+};
+
+struct Frame
+{
+    char bytes[CommandFrameFormat::Size];
+};
+
+void busyFor(double milliseconds)
+{
+    const auto end = std::chrono::steady_clock::now() + std::chrono::duration<double, std::milli>(milliseconds);
+    while (std::chrono::steady_clock::now() < end)
+        ;
+}
+
+bool writeAll(int fd, const char *data, size_t length)
+{
+    while (length > 0)
+    {
+        ssize_t written = ::write(fd, data, length);
+        if (written <= 0)
+            return false;
+
+        data += written;
+        length -= (size_t)written;
+    }
+
+    return true;
+}
+
+/**
+ * @brief receive
+ *      Reads frames until the socket closes and records their age on arrival
+ */
+void receive(int fd, LatencyHistogram &latency)
+{
+    CommandFrameDecoder decoder;
+    CommandFrame frame;
+    char buffer[4096];
+    ssize_t length;
+
+    while ((length = ::read(fd, buffer, sizeof(buffer))) > 0)
+    {
+        const uint64_t now = CommandFrameEncoder::now();
+
+        decoder.feed(buffer, (size_t)length);
+        while (decoder.next(frame))
+            latency.record(now - frame.timestamp);
+    }
+}
+
+/**
+ * @brief paintFor
+ *      Paint time of display frame number index
+ */
+double paintFor(const Settings &settings, int index)
+{
+    return settings.stallEvery > 0 && index % settings.stallEvery == settings.stallEvery - 1
+            ? settings.stallMs : settings.paintMs;
+}
+
+void runGui(const Settings &settings, int fd)
+{
+    CommandFrameEncoder encoder;
+    std::vector<char> pending;
+
+    const auto period = std::chrono::duration<double>(1.0 / settings.frameRate);
+    const int frames = (int)(settings.seconds * settings.frameRate);
+    auto next = std::chrono::steady_clock::now();
+
+    for (int i = 0; i < frames; i++)
+    {
+        const char *frame = encoder.encode(CommandOpcode::PitchRoll, 0.1f, -0.1f);
+        pending.insert(pending.end(), frame, frame + CommandFrameEncoder::size());
+
+        busyFor(paintFor(settings, i));
+
+        // back in the event loop, the socket flushes its write buffer
+        writeAll(fd, pending.data(), pending.size());
+        pending.clear();
+
+        next += std::chrono::duration_cast<std::chrono::steady_clock::duration>(period);
+        std::this_thread::sleep_until(next);
+    }
+}
+
+void runWorker(const Settings &settings, int fd)
+{
+    SpscRing<Frame, 1024> ring;
+    std::atomic<bool> flushPending(false);
+    std::atomic<bool> done(false);
+
+    // stands in for the queued invokeMethod() of NetworkWorker::send()
+    std::mutex mutex;
+    std::condition_variable wakeup;
+    bool posted = false;
+
+    std::thread worker([&]() {
+        Frame frame;
+        char batch[64 * CommandFrameFormat::Size];
+
+        for (;;)
+        {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wakeup.wait(lock, [&]() { return posted || done.load(); });
+                posted = false;
+            }
+
+            flushPending.store(false);
+
+            size_t length = 0;
+            while (ring.pop(frame))
+            {
+                std::memcpy(batch + length, frame.bytes, sizeof(frame.bytes));
+                length += sizeof(frame.bytes);
+
+                if (length == sizeof(batch))
+                {
+                    writeAll(fd, batch, length);
+                    length = 0;
+                }
+            }
+
+            if (length > 0)
+                writeAll(fd, batch, length);
+
+            if (done.load() && ring.empty())
+                return;
+        }
+    });
+
+    CommandFrameEncoder encoder;
+
+    const auto period = std::chrono::duration<double>(1.0 / settings.frameRate);
+    const int frames = (int)(settings.seconds * settings.frameRate);
+    auto next = std::chrono::steady_clock::now();
+
+    for (int i = 0; i < frames; i++)
+    {
+        Frame *slot = ring.beginPush();
+        if (slot)
+        {
+            std::memcpy(slot->bytes, encoder.encode(CommandOpcode::PitchRoll, 0.1f, -0.1f), sizeof(slot->bytes));
+            ring.commitPush();
+
+            if (!flushPending.exchange(true))
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                posted = true;
+                wakeup.notify_one();
+            }
+        }
+
+        busyFor(paintFor(settings, i));
+
+        next += std::chrono::duration_cast<std::chrono::steady_clock::duration>(period);
+        std::this_thread::sleep_until(next);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        done.store(true);
+        wakeup.notify_one();
+    }
+
+    worker.join();
+}
+
+void report(const char *name, const LatencyHistogram &latency)
+{
+    std::printf("%-7s %6llu frames  p50 %6llu us  p99 %6llu us  max %6llu us  mean %8.1f us\n", name,
+                (unsigned long long)latency.count(),
+                (unsigned long long)latency.percentile(0.5),
+                (unsigned long long)latency.percentile(0.99),
+                (unsigned long long)latency.max(),
+                latency.mean());
+}
+
+/**
+ * @brief measure
+ *      Runs one of the two command paths against a fresh socket pair
+ */
+void measure(const char *name, const Settings &settings, void (*run)(const Settings &, int))
+{
+    int fds[2];
+    if (::socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0)
+    {
+        std::perror("socketpair");
+        std::exit(1);
+    }
+
+    LatencyHistogram latency;
+    std::thread receiver(receive, fds[1], std::ref(latency));
+
+    run(settings, fds[0]);
+
+    ::shutdown(fds[0], SHUT_WR);
+    receiver.join();
+
+    ::close(fds[0]);
+    ::close(fds[1]);
+
+    report(name, latency);
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+    Settings settings;
+
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        const std::string option = argv[i];
+        const double value = std::atof(argv[i + 1]);
+
+        if (option == "--seconds")
+            settings.seconds = value;
+        else if (option == "--paint-ms")
+            settings.paintMs = value;
+        else if (option == "--stall-ms")
+            settings.stallMs = value;
+        else if (option == "--stall-every")
+            settings.stallEvery = (int)value;
+        else
+        {
+            std::fprintf(stderr, "unknown option %s\n", argv[i]);
+            return 1;
+        }
+    }
+
+    std::printf("%d frames/s, %.1f ms paint, %.1f ms stall every %d frames, %.1f s per path\n",
+                settings.frameRate, settings.paintMs, settings.stallMs, settings.stallEvery, settings.seconds);
+
+    measure("gui", settings, runGui);
+    measure("worker", settings, runWorker);
+
+    return 0;
+}
@@ -0,0 +1,141 @@
+/*
+ *  TelemetryParser throughput on one core.
+ *
+ *  Formats a block of records as the mock simulator sends them, then pushes it
+ *  through the parser in chunks of TelemetryChunk size, the way RobotSession feeds
+ *  it from the network worker, for --seconds. A sink touches every sample so the
+ *  parsed values are not optimised away. With --store the samples go into a
+ *  TelemetryStore instead, as in the client.
+ *
+ *  usage: telemetryparser [--seconds s] [--channels n] [--chunk bytes] [--store 1]
+ */
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+#include "telemetryparser.h"
+#include "telemetrystore.h"
+
+namespace
+{
+
+const char *const KnownChannels[] = { "vx", "vy", "theta", "omega", "height", "yaw" };
+
+class SumSink : public TelemetrySink
+{
+public:
+    void sample(const TelemetrySample &sample) override
+    {
+        sum += sample.value + (double)sample.channel.size();
+    }
+
+    double sum = 0.0;
+};
+
+std::string makeRecords(int channels, int first, int count)
+{
+    std::string out;
+    char line[64];
+
+    for (int record = first; record < first + count; record++)
+    {
+        double t = record / 1000.0;
+        out.append(line, (size_t)std::snprintf(line, sizeof(line), "t=%.6f", t));
+
+        for (int i = 0; i < channels; i++)
+        {
+            out += ' ';
+            if (i < (int)(sizeof(KnownChannels) / sizeof(KnownChannels[0])))
+                out += KnownChannels[i];
+            else
+                out += "ch" + std::to_string(i);
+
+            out.append(line, (size_t)std::snprintf(line, sizeof(line), "=%.5f", std::sin(t * (i + 1)) * (i + 1)));
+        }
+
+        out += '\n';
+    }
+
+    return out;
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+    double seconds = 3.0;
+    int channels = 6;
+    size_t chunk = 4096;
+    bool store = false;
+
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        const std::string option = argv[i];
+
+        if (option == "--seconds")
+            seconds = std::atof(argv[i + 1]);
+        else if (option == "--channels")
+            channels = std::atoi(argv[i + 1]);
+        else if (option == "--chunk")
+            chunk = (size_t)std::atol(argv[i + 1]);
+        else if (option == "--store")
+            store = std::atoi(argv[i + 1]) != 0;
+        else
+        {
+            std::fprintf(stderr, "unknown option %s\n", argv[i]);
+            return 1;
+        }
+    }
+
+    if (chunk == 0)
+        chunk = 1;
+
+    // two blocks in turn, so the store sees time moving forward most of the time
+    const std::string blocks[2] = { makeRecords(channels, 0, 10000), makeRecords(channels, 10000, 10000) };
+
+    TelemetryParser parser;
+    SumSink sink;
+    TelemetryStore telemetry(1u << 30);
+    if (store)
+        parser.addSink(&telemetry);
+    else
+        parser.addSink(&sink);
+
+    using Clock = std::chrono::steady_clock;
+    const auto start = Clock::now();
+    const auto end = start + std::chrono::duration<double>(seconds);
+
+    uint64_t bytes = 0;
+    auto now = start;
+
+    for (int round = 0; now < end; round++)
+    {
+        const std::string &block = blocks[round & 1];
+
+        for (size_t offset = 0; offset < block.size(); offset += chunk)
+        {
+            size_t length = block.size() - offset < chunk ? block.size() - offset : chunk;
+            parser.feed(block.data() + offset, length);
+            parser.parse();
+        }
+
+        bytes += block.size();
+        now = Clock::now();
+    }
+
+    const double elapsed = std::chrono::duration<double>(now - start).count();
+
+    std::printf("%d channels, %zu byte chunks, %.1f bytes per record%s\n",
+                channels, chunk, (double)blocks[0].size() / 10000, store ? ", into a TelemetryStore" : "");
+    std::printf("%.1f MB/s, %.2f M records/s, %.2f M samples/s\n",
+                bytes / elapsed / 1e6, parser.records() / elapsed / 1e6, parser.samples() / elapsed / 1e6);
+
+    // keeps the sink's work from being optimised away
+    if (!store && sink.sum == 0.0)
+        std::printf("no samples\n");
+
+    return 0;
+}
@@ -0,0 +1,15 @@
+CONFIG += c++17 console
+CONFIG -= app_bundle qt
+
+# Throughput of TelemetryParser on one core, see main.cpp. Standard library only.
+
+INCLUDEPATH += ../..
+
+SOURCES += \
+    ../../telemetryparser.cpp \
+    ../../telemetrystore.cpp \
+    main.cpp
+
+HEADERS += \
+    ../../telemetryparser.h \
+    ../../telemetrystore.h
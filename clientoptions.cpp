@@ -0,0 +1,160 @@
+#include "clientoptions.h"
+
+#include <QCommandLineParser>
+
+ClientOptions ClientOptions::parse(const QStringList &arguments)
+{
+    QCommandLineParser parser;
+    parser.setApplicationDescription("GUI controller for the MuJoCo quadruped simulator");
+    parser.addHelpOption();
+
+    QCommandLineOption record("record", "Record commands and telemetry to <file>.", "file");
+    QCommandLineOption replay("replay", "Send the commands recorded in <file>.", "file");
+    QCommandLineOption speed("replay-speed", "Replay speed factor, or \"max\" for as fast as possible.", "factor", "1");
+    QCommandLineOption gamepadRate("gamepad-rate", "Gamepad polls per second, 1 to 1000.", "hz", "1000");
+    QCommandLineOption gamepadEvents("gamepad-events", "Linux: replay gamepad input recorded from /dev/input/event* in <file>.", "file");
+    QCommandLineOption robots("robots", "Connect to <n> local simulators on command port 9000+i and telemetry port 8080+i.", "n", "1");
+    QCommandLineOption robot("robot", "Connect to a simulator at <host[:command[:telemetry]]>, may be repeated.", "endpoint");
+    QCommandLineOption transport("transport", "\"tcp\", or \"shm\" for shared memory with a simulator on this host (Linux).", "kind", "tcp");
+    QCommandLineOption udpSetpoints("udp-setpoints", "Send velocity, pitch and roll as UDP datagrams to the command port.");
+    QCommandLineOption controller("controller", "Drive robot <r> with gamepad <pad>, may be repeated.", "pad=r");
+    QCommandLineOption inputCurve("input-curve", "Thumbstick response curve exponent, 1 for linear.", "exponent", "1");
+    QCommandLineOption inputSmoothing("input-smoothing", "Cutoff of the stick and JoyPad filter at rest, 0 to turn off the filter and prediction.", "hz", "5");
+    QCommandLineOption inputPrediction("input-prediction", "Extrapolate stick and JoyPad input by <ms> along its speed.", "ms", "0");
+    QCommandLineOption timeline("timeline", "Play the timestamped setpoints in <file> on the active robot.", "file");
+    QCommandLineOption measureWakeups("measure-wakeups", "Log event loop wakeups per second and CPU use every 10 seconds.");
+    QCommandLineOption paintBenchmark("benchmark-paint", "Time <frames> JoyPad repaints, print the averages and exit.", "frames");
+    QCommandLineOption headless("headless", "Run without a window, until --script, --timeline and --replay end; with none of them, until standard input ends.");
+    QCommandLineOption script("script", "Headless: read commands from <file>.", "file");
+
+    parser.addOption(record);
+    parser.addOption(replay);
+    parser.addOption(speed);
+    parser.addOption(gamepadRate);
+    parser.addOption(gamepadEvents);
+    parser.addOption(robots);
+    parser.addOption(robot);
+    parser.addOption(transport);
+    parser.addOption(udpSetpoints);
+    parser.addOption(controller);
+    parser.addOption(inputCurve);
+    parser.addOption(inputSmoothing);
+    parser.addOption(inputPrediction);
+    parser.addOption(timeline);
+    parser.addOption(measureWakeups);
+    parser.addOption(paintBenchmark);
+    parser.addOption(headless);
+    parser.addOption(script);
+
+    parser.process(arguments);
+
+    ClientOptions options;
+    options.recordPath = parser.value(record);
+    options.replayPath = parser.value(replay);
+    options.gamepadEvents = parser.value(gamepadEvents);
+    options.timelinePath = parser.value(timeline);
+    options.measureWakeups = parser.isSet(measureWakeups);
+    options.paintBenchmark = qMax(0, parser.value(paintBenchmark).toInt());
+    options.headless = parser.isSet(headless);
+    options.scriptPath = parser.value(script);
+
+    QString factor = parser.value(speed);
+    bool ok = false;
+    double value = factor.toDouble(&ok);
+
+    if (factor == "max")
+        options.replaySpeed = 0;
+    else if (ok && value > 0)
+        options.replaySpeed = value;
+
+    int rate = parser.value(gamepadRate).toInt(&ok);
+    if (ok && rate > 0)
+        options.gamepadRate = qMin(rate, 1000);
+
+    double curve = parser.value(inputCurve).toDouble(&ok);
+    if (ok && curve > 0)
+        options.input.exponent = curve;
+
+    double cutoff = parser.value(inputSmoothing).toDouble(&ok);
+    if (ok && cutoff > 0)
+        options.input.minCutoff = cutoff;
+    else if (ok && cutoff == 0)
+        options.input.filter = false;
+
+    double prediction = parser.value(inputPrediction).toDouble(&ok);
+    if (ok && prediction >= 0)
+        options.input.prediction = qMin(prediction, 100.0) / 1000.0;
+
+    // --robot wins over --robots
+    const QStringList endpoints = parser.values(robot);
+    for (const QString &text : endpoints)
+    {
+        QStringList parts = text.split(':');
+        RobotEndpoint endpoint;
+
+        if (!parts.value(0).isEmpty())
+            endpoint.host = parts.value(0);
+
+        quint16 port = parts.value(1).toUShort(&ok);
+        if (ok && port)
+            endpoint.commandPort = port;
+
+        port = parts.value(2).toUShort(&ok);
+        if (ok && port)
+            endpoint.telemetryPort = port;
+
+        options.robots.append(endpoint);
+    }
+
+    if (options.robots.isEmpty())
+    {
+        int count = qBound(1, parser.value(robots).toInt(), 64);
+        for (int i = 0; i < count; i++)
+        {
+            RobotEndpoint endpoint;
+            endpoint.commandPort += i;
+            endpoint.telemetryPort += i;
+            options.robots.append(endpoint);
+        }
+    }
+
+    if (parser.value(transport) == "shm")
+    {
+        for (RobotEndpoint &endpoint : options.robots)
+            endpoint.sharedMemory = true;
+    }
+    else if (parser.value(transport) != "tcp")
+        qWarning("unknown transport %s, using tcp", qPrintable(parser.value(transport)));
+
+    for (RobotEndpoint &endpoint : options.robots)
+        endpoint.udpSetpoints = parser.isSet(udpSetpoints);
+
+    // gamepad i drives robot i if there is one
+    for (int pad = 0; pad < MaxControllers; pad++)
+        options.controllerRobot.append(pad < options.robots.size() ? pad : 0);
+
+    const QStringList assignments = parser.values(controller);
+    for (const QString &text : assignments)
+    {
+        int pad = text.section('=', 0, 0).toInt(&ok);
+        if (!ok || pad < 0 || pad >= MaxControllers)
+            continue;
+
+        int target = text.section('=', 1).toInt(&ok);
+        if (ok && target >= 0 && target < options.robots.size())
+            options.controllerRobot[pad] = target;
+    }
+
+    return options;
+}
+
+bool ClientOptions::isHeadless(int argc, char *argv[])
+{
+    for (int i = 1; i < argc; i++)
+    {
+        if (qstrcmp(argv[i], "--headless") == 0 || qstrcmp(argv[i], "-headless") == 0)
+            return true;
+    }
+
+    return false;
+}
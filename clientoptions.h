@@ -0,0 +1,73 @@
+#ifndef CLIENTOPTIONS_H
+#define CLIENTOPTIONS_H
+
+#include <QList>
+#include <QString>
+#include <QStringList>
+
+#include "inputconditioner.h"
+#include "robotendpoint.h"
+
+/**
+ * @brief The ClientOptions struct
+ *      Startup options taken from the command line
+ */
+struct ClientOptions
+{
+    // gamepads that can be assigned to a robot
+    static constexpr int MaxControllers = 4;
+
+    // record every command and telemetry chunk to this session log
+    QString recordPath;
+
+    // send the commands of this session log instead of waiting for input
+    QString replayPath;
+
+    // replay speed factor, 0 for as fast as possible
+    double replaySpeed = 1;
+
+    // gamepad polls per second, up to 1000
+    int gamepadRate = 1000;
+
+    // Linux: read gamepad 0 from this raw input_event dump instead of /dev/input
+    QString gamepadEvents;
+
+    // one session per robot, a single local simulator unless given
+    QList<RobotEndpoint> robots;
+
+    // controllerRobot[uID] is the robot driven by gamepad uID
+    QList<int> controllerRobot;
+
+    // shaping, filtering and prediction of thumbsticks and the JoyPad
+    InputConditionerConfig input;
+
+    // timestamped setpoints to play on the active robot, see timelinesequencer.h
+    QString timelinePath;
+
+    // log wakeups per second and cpu use, see wakeupmonitor.h
+    bool measureWakeups = false;
+
+    // time this many JoyPad repaints and exit, see JoyPad::benchmarkPaint()
+    int paintBenchmark = 0;
+
+    // run without a window, driven by a script, see scriptdriver.h
+    bool headless = false;
+
+    // headless command script, standard input unless given or a timeline is played
+    QString scriptPath;
+
+    /**
+     * @brief parse
+     * @param arguments - as returned by QCoreApplication::arguments()
+     */
+    static ClientOptions parse(const QStringList &arguments);
+
+    /**
+     * @brief isHeadless
+     *      Looks for --headless before any QCoreApplication exists, to pick the kind
+     *      of application to create
+     */
+    static bool isHeadless(int argc, char *argv[]);
+};
+
+#endif // CLIENTOPTIONS_H
@@ -0,0 +1,254 @@
+#include "commandframe.h"
+
+#include <chrono>
+#include <cstring>
+
+// Little-endian helpers, independent of host byte order
+static void putU16(char *out, uint16_t v)
+{
+    out[0] = (char)(v & 0xff);
+    out[1] = (char)(v >> 8);
+}
+
+static void putU32(char *out, uint32_t v)
+{
+    for (int i = 0; i < 4; ++i)
+        out[i] = (char)((v >> (8 * i)) & 0xff);
+}
+
+static void putU64(char *out, uint64_t v)
+{
+    for (int i = 0; i < 8; ++i)
+        out[i] = (char)((v >> (8 * i)) & 0xff);
+}
+
+static uint16_t getU16(const char *in)
+{
+    return (uint16_t)((unsigned char)in[0] | ((unsigned char)in[1] << 8));
+}
+
+static uint32_t getU32(const char *in)
+{
+    uint32_t v = 0;
+    for (int i = 0; i < 4; ++i)
+        v |= (uint32_t)(unsigned char)in[i] << (8 * i);
+    return v;
+}
+
+static uint64_t getU64(const char *in)
+{
+    uint64_t v = 0;
+    for (int i = 0; i < 8; ++i)
+        v |= (uint64_t)(unsigned char)in[i] << (8 * i);
+    return v;
+}
+
+//---------------------------------- FRAME ------------------------------------
+
+/**
+ * @brief CommandFrame::value
+ * @param index of the float32 slot in the payload, 0 to 3
+ * @return float
+ */
+float CommandFrame::value(int index) const
+{
+    uint32_t bits = getU32((const char *)payload + 4 * index);
+    float v;
+    std::memcpy(&v, &bits, sizeof(v));
+    return v;
+}
+
+/**
+ * @brief CommandFrame::setValue
+ * @param index of the float32 slot in the payload, 0 to 3
+ * @param value
+ */
+void CommandFrame::setValue(int index, float value)
+{
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    putU32((char *)payload + 4 * index, bits);
+}
+
+/**
+ * @brief CommandFrame::word
+ * @param index of the 32 bit slot in the payload, 0 to 3
+ * @return uint32_t
+ */
+uint32_t CommandFrame::word(int index) const
+{
+    return getU32((const char *)payload + 4 * index);
+}
+
+void CommandFrame::setWord(int index, uint32_t word)
+{
+    putU32((char *)payload + 4 * index, word);
+}
+
+/**
+ * @brief CommandFrame::text
+ * @return payload interpreted as a zero padded string
+ */
+std::string CommandFrame::text() const
+{
+    size_t length = 0;
+    while (length < CommandFrameFormat::PayloadSize && payload[length] != 0)
+        length++;
+
+    return std::string((const char *)payload, length);
+}
+
+/**
+ * @brief CommandFrame::setText
+ * @param text - truncated to CommandFrameFormat::PayloadSize bytes
+ */
+void CommandFrame::setText(const std::string &text)
+{
+    std::memset(payload, 0, sizeof(payload));
+    std::memcpy(payload, text.data(), text.size() < sizeof(payload) ? text.size() : sizeof(payload));
+}
+
+//---------------------------------- ENCODER ------------------------------------
+
+CommandFrameEncoder::CommandFrameEncoder() :
+    m_sequence(0),
+    m_timestamp(0)
+{
+    std::memset(m_buffer, 0, sizeof(m_buffer));
+}
+
+uint64_t CommandFrameEncoder::now()
+{
+    using namespace std::chrono;
+    return (uint64_t)duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+/**
+ * @brief CommandFrameEncoder::encode
+ * @param opcode
+ * @param v0..v3 - payload values, unused slots are sent as zero
+ * @return pointer to CommandFrameEncoder::size() encoded bytes
+ */
+const char *CommandFrameEncoder::encode(CommandOpcode opcode, float v0, float v1, float v2, float v3)
+{
+    m_frame.opcode = opcode;
+    m_frame.setValue(0, v0);
+    m_frame.setValue(1, v1);
+    m_frame.setValue(2, v2);
+    m_frame.setValue(3, v3);
+
+    return encode(m_frame);
+}
+
+/**
+ * @brief CommandFrameEncoder::encode
+ * @param opcode
+ * @param text - truncated to CommandFrameFormat::PayloadSize bytes
+ * @return pointer to CommandFrameEncoder::size() encoded bytes
+ */
+const char *CommandFrameEncoder::encode(CommandOpcode opcode, const std::string &text)
+{
+    m_frame.opcode = opcode;
+    m_frame.setText(text);
+
+    return encode(m_frame);
+}
+
+/**
+ * @brief CommandFrameEncoder::encode
+ *      Stamps frame with the next sequence number and the current time
+ * @param frame
+ * @return pointer to CommandFrameEncoder::size() encoded bytes
+ */
+const char *CommandFrameEncoder::encode(CommandFrame &frame)
+{
+    frame.sequence = ++m_sequence;
+    frame.timestamp = m_timestamp = now();
+
+    write(frame, m_buffer);
+    return m_buffer;
+}
+
+void CommandFrameEncoder::write(const CommandFrame &frame, char *out)
+{
+    putU16(out, CommandFrameFormat::Magic);
+    out[2] = (char)CommandFrameFormat::Version;
+    out[3] = (char)frame.opcode;
+    putU32(out + 4, frame.sequence);
+    putU64(out + 8, frame.timestamp);
+    std::memcpy(out + 16, frame.payload, CommandFrameFormat::PayloadSize);
+}
+
+//---------------------------------- DECODER ------------------------------------
+
+CommandFrameDecoder::CommandFrameDecoder() :
+    m_head(0),
+    m_skipped(0)
+{
+    m_buffer.reserve(64 * CommandFrameFormat::Size);
+}
+
+bool CommandFrameDecoder::read(const char *in, CommandFrame &frame)
+{
+    if (getU16(in) != CommandFrameFormat::Magic || (uint8_t)in[2] != CommandFrameFormat::Version)
+        return false;
+
+    frame.opcode = (CommandOpcode)(uint8_t)in[3];
+    frame.sequence = getU32(in + 4);
+    frame.timestamp = getU64(in + 8);
+    std::memcpy(frame.payload, in + 16, CommandFrameFormat::PayloadSize);
+
+    return true;
+}
+
+/**
+ * @brief CommandFrameDecoder::feed
+ * @param data - raw bytes from the stream, any chunking
+ * @param length
+ */
+void CommandFrameDecoder::feed(const char *data, size_t length)
+{
+    // drop consumed bytes before growing, the buffer only ever holds a partial frame
+    // plus whatever has not been popped yet
+    if (m_head > 0 && m_head == m_buffer.size())
+    {
+        m_buffer.clear();
+        m_head = 0;
+    }
+    else if (m_head >= m_buffer.capacity() / 2)
+    {
+        m_buffer.erase(m_buffer.begin(), m_buffer.begin() + m_head);
+        m_head = 0;
+    }
+
+    m_buffer.insert(m_buffer.end(), data, data + length);
+}
+
+/**
+ * @brief CommandFrameDecoder::next
+ * @param frame - receives the next complete frame
+ * @return false if no complete frame is buffered
+ */
+bool CommandFrameDecoder::next(CommandFrame &frame)
+{
+    while (m_buffer.size() - m_head >= CommandFrameFormat::Size)
+    {
+        if (read(m_buffer.data() + m_head, frame))
+        {
+            m_head += CommandFrameFormat::Size;
+            return true;
+        }
+
+        // out of sync, resynchronize on the next magic
+        m_head++;
+        m_skipped++;
+    }
+
+    return false;
+}
+
+void CommandFrameDecoder::clear()
+{
+    m_buffer.clear();
+    m_head = 0;
+}
@@ -0,0 +1,160 @@
+#ifndef COMMANDFRAME_H
+#define COMMANDFRAME_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/*
+ *  Binary command frames sent to the simulator on the control socket.
+ *  This header deliberately only depends on the standard library so the
+ *  simulator side can compile it (and commandframe.cpp) as is.
+ *
+ *  Wire layout (version 1, little-endian, 32 bytes):
+ *
+ *      offset  size  field
+ *      0       2     magic      0x4752 ("RG")
+ *      2       1     version
+ *      3       1     opcode     see CommandOpcode
+ *      4       4     sequence   incremented for every frame sent
+ *      8       8     timestamp  microseconds on the sender's monotonic clock
+ *      16      16    payload    four float32 values or up to 16 bytes of text
+ */
+
+namespace CommandFrameFormat
+{
+    constexpr uint16_t Magic = 0x4752;
+    constexpr uint8_t Version = 1;
+    constexpr size_t Size = 32;
+    constexpr size_t PayloadSize = 16;
+    constexpr int ValueCount = 4;
+}
+
+/**
+ * @brief The CommandOpcode enum
+ *      Values match the single character prefixes of the old ASCII protocol,
+ *      so the simulator can keep its existing dispatch table.
+ */
+enum class CommandOpcode : uint8_t
+{
+    VelocityX = 'X',
+    VelocityY = 'Y',
+    Pitch = 'P',
+    Roll = 'R',
+    PitchRoll = 'C',
+    HeightUp = 'U',
+    HeightDown = 'D',
+    Stand = 'S',
+    Trot = 'T',
+    View = 'V',
+    SensorSearch = 'I',
+
+    ArmRotatePos = '0',
+    ArmRotateNeg = '1',
+    ArmExtendPos = '2',
+    ArmExtendNeg = '3',
+    ArmHeightPos = '4',
+    ArmHeightNeg = '5',
+    GripAnglePos = '6',
+    GripAngleNeg = '7',
+    GripPos = '8',
+    GripNeg = '9',
+
+    // desired state delta or keyframe, see robotcommandstate.h
+    StateUpdate = 'K',
+
+    // continuous setpoints, sent as datagrams, see robotcommandstate.h
+    Setpoint = 'J'
+};
+
+/**
+ * @brief The CommandFrame struct
+ *      Decoded form of a single frame
+ */
+struct CommandFrame
+{
+    CommandOpcode opcode = CommandOpcode::View;
+    uint32_t sequence = 0;
+    uint64_t timestamp = 0;
+    unsigned char payload[CommandFrameFormat::PayloadSize] = {};
+
+    float value(int index) const;
+    void setValue(int index, float value);
+
+    uint32_t word(int index) const;
+    void setWord(int index, uint32_t word);
+
+    std::string text() const;
+    void setText(const std::string &text);
+};
+
+/**
+ * @brief The CommandFrameEncoder class
+ *      Encodes frames into a buffer owned by the encoder, so sending a
+ *      command never allocates. The returned pointer stays valid until the
+ *      next encode call.
+ */
+class CommandFrameEncoder
+{
+public:
+    CommandFrameEncoder();
+
+    const char *encode(CommandOpcode opcode, float v0 = 0.f, float v1 = 0.f, float v2 = 0.f, float v3 = 0.f);
+    const char *encode(CommandOpcode opcode, const std::string &text);
+    const char *encode(CommandFrame &frame);
+
+    static constexpr size_t size() { return CommandFrameFormat::Size; }
+    uint32_t lastSequence() const { return m_sequence; }
+    uint64_t lastTimestamp() const { return m_timestamp; }
+
+    /**
+     * @brief now
+     * @return microseconds on the monotonic clock used for frame timestamps
+     */
+    static uint64_t now();
+
+    /**
+     * @brief write
+     *      Serializes frame into out, which must hold CommandFrameFormat::Size bytes
+     */
+    static void write(const CommandFrame &frame, char *out);
+
+private:
+    uint32_t m_sequence;
+    uint64_t m_timestamp;
+    CommandFrame m_frame;
+    char m_buffer[CommandFrameFormat::Size];
+};
+
+/**
+ * @brief The CommandFrameDecoder class
+ *      Reference decoder for the receiving side. Bytes can be fed in arbitrary
+ *      chunks as they come off the socket; complete frames are popped with next().
+ *      If the stream gets out of sync, bytes are skipped until the next magic.
+ */
+class CommandFrameDecoder
+{
+public:
+    CommandFrameDecoder();
+
+    void feed(const char *data, size_t length);
+    bool next(CommandFrame &frame);
+    void clear();
+
+    uint64_t skippedBytes() const { return m_skipped; }
+
+    /**
+     * @brief read
+     *      Decodes a single frame from CommandFrameFormat::Size bytes at in
+     * @return false if the magic or version does not match
+     */
+    static bool read(const char *in, CommandFrame &frame);
+
+private:
+    std::vector<char> m_buffer;
+    size_t m_head;
+    uint64_t m_skipped;
+};
+
+#endif // COMMANDFRAME_H
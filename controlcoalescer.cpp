@@ -0,0 +1,80 @@
+#include "controlcoalescer.h"
+
+#include <QTimer>
+
+ControlCoalescer::ControlCoalescer(QObject *parent) : QObject(parent),
+    m_timer(new QTimer(this)),
+    m_rate(0),
+    m_x(0), m_y(0),
+    m_sentX(0), m_sentY(0)
+{
+    m_timer->setTimerType(Qt::PreciseTimer);
+    connect(m_timer, &QTimer::timeout, this, &ControlCoalescer::tick);
+
+    setRate(100);
+}
+
+void ControlCoalescer::setRate(int hz)
+{
+    m_rate = qMax(1, hz);
+    m_timer->setInterval(qMax(1, 1000 / m_rate));
+}
+
+int ControlCoalescer::rate() const
+{
+    return m_rate;
+}
+
+/**
+ * @brief ControlCoalescer::setX
+ * @param value of x axis, replaces any pending x value
+ */
+void ControlCoalescer::setX(float value)
+{
+    m_x = value;
+    schedule();
+}
+
+/**
+ * @brief ControlCoalescer::setY
+ * @param value of y axis, replaces any pending y value
+ */
+void ControlCoalescer::setY(float value)
+{
+    m_y = value;
+    schedule();
+}
+
+void ControlCoalescer::setXY(float xValue, float yValue)
+{
+    m_x = xValue;
+    m_y = yValue;
+    schedule();
+}
+
+void ControlCoalescer::schedule()
+{
+    if (!m_timer->isActive())
+        m_timer->start();
+}
+
+/**
+ * @brief ControlCoalescer::tick
+ *      Emits one update with the latest state, stops the timer once idle
+ */
+void ControlCoalescer::tick()
+{
+    bool xChanged = m_x != m_sentX;
+    bool yChanged = m_y != m_sentY;
+
+    if (!xChanged && !yChanged)
+    {
+        m_timer->stop();
+        return;
+    }
+
+    m_sentX = m_x;
+    m_sentY = m_y;
+
+    emit updated(m_x, m_y, xChanged, yChanged);
+}
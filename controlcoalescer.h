@@ -0,0 +1,59 @@
+#ifndef CONTROLCOALESCER_H
+#define CONTROLCOALESCER_H
+
+#include <QObject>
+
+class QTimer;
+
+/**
+ * @brief The ControlCoalescer class
+ *      Sits between the JoyPad and the control socket. Every change only updates
+ *      the latest value; once per control tick a single combined update is emitted,
+ *      and nothing at all if the state did not change since the last tick.
+ *      The tick timer only runs while there is something pending.
+ */
+class ControlCoalescer : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit ControlCoalescer(QObject *parent = nullptr);
+
+    /**
+     * @brief setRate
+     * @param hz - control rate, updates are emitted at most this often
+     */
+    void setRate(int hz);
+    int rate() const;
+
+signals:
+    /**
+     * @brief updated
+     * @param x - latest x value
+     * @param y - latest y value
+     * @param xChanged - x differs from the last update
+     * @param yChanged - y differs from the last update
+     */
+    void updated(float x, float y, bool xChanged, bool yChanged);
+
+public slots:
+    void setX(float value);
+    void setY(float value);
+    void setXY(float xValue, float yValue);
+
+private slots:
+    void tick();
+
+private:
+    void schedule();
+
+    QTimer *m_timer;
+    int m_rate;
+
+    float m_x;
+    float m_y;
+    float m_sentX;
+    float m_sentY;
+};
+
+#endif // CONTROLCOALESCER_H
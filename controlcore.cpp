@@ -0,0 +1,615 @@
+#include "controlcore.h"
+
+#include <QThread>
+#include <QTimer>
+
+#ifdef Q_OS_LINUX
+#include "evdevgamepad.h"
+#endif
+
+// telemetry kept in memory for all robots together
+static const size_t TelemetryBudget = 256u * 1024u * 1024u;
+
+//---------------------------------- CONSTRUCTOR AND DESTRUCTOR ------------------------------------
+
+ControlCore::ControlCore(const ClientOptions &options, QObject *parent) : QObject(parent),
+    m_options(options),
+    m_networkThread(nullptr),
+    m_network(nullptr),
+    m_activeSession(nullptr),
+    m_commandTarget(nullptr),
+    m_fieldDue(0),
+    m_keyframeTimer(nullptr),
+    m_gamepad(nullptr),
+    m_timeline(nullptr),
+    m_replayer(nullptr),
+    m_wakeupMonitor(nullptr),
+    m_poseAxes(PoseAxes::None),
+    m_poseHeld(false),
+    m_cpuStart(0)
+{
+    initNetwork();
+    initGamepad();
+    initTimeline();
+    initReplay();
+}
+
+/**
+ * @brief ControlCore::~ControlCore
+ */
+ControlCore::~ControlCore()
+{
+    m_gamepad->Stop();
+
+    if (m_replayer)
+        m_replayer->stop();
+
+    if (m_networkThread->isRunning())
+    {
+        QMetaObject::invokeMethod(m_network, &NetworkWorker::stop, Qt::BlockingQueuedConnection);
+        m_networkThread->quit();
+        m_networkThread->wait();
+    }
+
+    if (m_clock.isValid())
+    {
+        double seconds = m_clock.nsecsElapsed() / 1e9;
+        double cpu = (double)(std::clock() - m_cpuStart) / CLOCKS_PER_SEC;
+
+        qInfo("cpu: %.3f s in %.3f s for %d robot(s), %.2f%% of a core per robot",
+              cpu, seconds, (int)m_sessions.size(), 100.0 * cpu / seconds / m_sessions.size());
+    }
+
+    NetworkWorker::QueueStats stats = m_network->queueStats();
+    if (stats.frames > 0)
+        qInfo("command queue latency: avg %.1f us, max %llu us over %llu frames, %llu dropped, %llu stale, %llu reconnects",
+              (double)stats.totalLatency / (double)stats.frames,
+              (unsigned long long)stats.maxLatency,
+              (unsigned long long)stats.frames,
+              (unsigned long long)stats.dropped,
+              (unsigned long long)stats.stale,
+              (unsigned long long)stats.reconnects);
+
+    for (RobotSession *session : std::as_const(m_sessions))
+    {
+        const LatencyHistogram &roundTrip = session->latency().histogram();
+        if (roundTrip.count() > 0)
+            qInfo("robot %d command round trip: p50 %llu us, p99 %llu us, p99.9 %llu us, max %llu us over %llu acks",
+                  session->index(),
+                  (unsigned long long)roundTrip.percentile(0.5),
+                  (unsigned long long)roundTrip.percentile(0.99),
+                  (unsigned long long)roundTrip.percentile(0.999),
+                  (unsigned long long)roundTrip.max(),
+                  (unsigned long long)roundTrip.count());
+    }
+
+    LatencyHistogram filterLag = m_gamepad->FilterLag();
+    if (filterLag.count() > 0)
+        qInfo("thumbstick filter lag: p50 %llu us, p99 %llu us, max %llu us over %llu samples",
+              (unsigned long long)filterLag.percentile(0.5),
+              (unsigned long long)filterLag.percentile(0.99),
+              (unsigned long long)filterLag.max(),
+              (unsigned long long)filterLag.count());
+
+    if (m_timeline && m_timeline->jitter().count() > 0)
+    {
+        const LatencyHistogram &jitter = m_timeline->jitter();
+        qInfo("timeline dispatch jitter: p50 %llu us, p99 %llu us, max %llu us, mean %.1f us over %llu events, %llu late",
+              (unsigned long long)jitter.percentile(0.5),
+              (unsigned long long)jitter.percentile(0.99),
+              (unsigned long long)jitter.max(),
+              jitter.mean(),
+              (unsigned long long)jitter.count(),
+              (unsigned long long)m_timeline->lateEvents());
+    }
+
+    const LatencyHistogram &sendJitter = m_network->sendJitter();
+    if (sendJitter.count() > 0)
+        qInfo("timeline send jitter: p50 %llu us, p99 %llu us, max %llu us, mean %.1f us over %llu frames",
+              (unsigned long long)sendJitter.percentile(0.5),
+              (unsigned long long)sendJitter.percentile(0.99),
+              (unsigned long long)sendJitter.max(),
+              sendJitter.mean(),
+              (unsigned long long)sendJitter.count());
+
+    delete m_network;
+}
+
+void ControlCore::start()
+{
+    m_clock.start();
+    m_cpuStart = std::clock();
+
+    m_networkThread->start();
+    m_keyframeTimer->start();
+    m_gamepad->Start();
+
+    // the widgets start out showing the gait the robots start with
+    emit standingChanged(standing());
+
+    if (m_options.measureWakeups)
+    {
+        m_wakeupMonitor = new WakeupMonitor(this);
+        m_wakeupMonitor->start();
+    }
+}
+
+//---------------------------------- INITIALIZATION ------------------------------------
+
+/**
+ * @brief ControlCore::initNetwork
+ *      The connections of every robot are owned by one NetworkWorker on its own thread,
+ *      each robot gets a RobotSession on this one. Robot commands go through the
+ *      sessions' desired-state vectors, see robotcommandstate.h; a keyframe with every
+ *      field goes out once per second so the simulators can always resynchronize.
+ */
+void ControlCore::initNetwork()
+{
+    m_networkThread = new QThread(this);
+    m_network = new NetworkWorker;
+
+    if (m_options.robots.isEmpty())
+        m_options.robots.append(RobotEndpoint());
+
+    // the telemetry memory budget is split between all robots
+    size_t memoryCap = TelemetryBudget / (size_t)m_options.robots.size();
+
+    for (const RobotEndpoint &endpoint : std::as_const(m_options.robots))
+        m_sessions.append(new RobotSession(m_network, m_network->addRobot(endpoint), memoryCap, this));
+
+    m_activeSession = m_sessions.first();
+
+    m_network->moveToThread(m_networkThread);
+
+    if (!m_options.recordPath.isEmpty())
+        m_network->setRecording(m_options.recordPath);
+
+    connect(m_networkThread, &QThread::started, m_network, &NetworkWorker::start);
+    connect(m_network, &NetworkWorker::telemetryReady, this, &ControlCore::readTelemetry);
+    connect(m_network, &NetworkWorker::resyncRequired, this, [this](int robot) { m_sessions[robot]->requestKeyframe(); });
+    connect(m_network, &NetworkWorker::connectionChanged, this, [this](int robot, bool connected) {
+        m_sessions[robot]->setConnected(connected);
+    });
+
+    m_keyframeTimer = new QTimer(this);
+    m_keyframeTimer->setInterval(1000);
+    connect(m_keyframeTimer, &QTimer::timeout, this, &ControlCore::sendKeyframe);
+}
+
+/**
+ * @brief ControlCore::initGamepad
+ *      XInput on Windows, evdev on Linux, see GamepadInput::create()
+ */
+void ControlCore::initGamepad()
+{
+    m_gamepad = GamepadInput::create(this);
+    m_gamepad->Setup();
+    m_gamepad->SetPollingRate(m_options.gamepadRate);
+    m_gamepad->SetConditioning(m_options.input);
+
+#ifdef Q_OS_LINUX
+    if (!m_options.gamepadEvents.isEmpty())
+        static_cast<EvdevGamepad *>(m_gamepad)->SetRecording(m_options.gamepadEvents);
+#endif
+
+    connect(m_gamepad, &GamepadInput::ButtonPressed, this, &ControlCore::handleButtons);
+    connect(m_gamepad, &GamepadInput::LeftThumbStick, this, &ControlCore::handleLeftStick);
+    connect(m_gamepad, &GamepadInput::RightThumbStick, this, &ControlCore::handleRightStick);
+}
+
+/**
+ * @brief ControlCore::initTimeline
+ *      Plays --timeline on the active robot once it is connected. Every change carries
+ *      the time its event was due, so the NetworkWorker can time the frame sending it.
+ */
+void ControlCore::initTimeline()
+{
+    if (m_options.timelinePath.isEmpty())
+        return;
+
+    m_timeline = new TimelineSequencer(this);
+
+    if (!m_timeline->load(m_options.timelinePath))
+    {
+        qWarning("unable to load timeline %s: %s", qPrintable(m_options.timelinePath), qPrintable(m_timeline->errorString()));
+        delete m_timeline;
+        m_timeline = nullptr;
+        return;
+    }
+
+    connect(m_timeline, &TimelineSequencer::fieldDue, this, [this](RobotField field, float value, quint64 due) {
+        m_fieldDue = due;
+        setField(field, value);
+        m_fieldDue = 0;
+    });
+
+    connect(m_activeSession, &RobotSession::connectedChanged, m_timeline, [this](bool connected) {
+        if (connected && !m_timeline->isStarted())
+            m_timeline->start();
+    });
+}
+
+/**
+ * @brief ControlCore::initReplay
+ *      Sends the commands of --replay to robot 0 once it is connected. They go through
+ *      the robot's session like live commands, so they get fresh sequence numbers and
+ *      timestamps and their acks are timed. Each burst waits until the worker has
+ *      written it, so a replay at full speed never overruns the command queue.
+ */
+void ControlCore::initReplay()
+{
+    if (m_options.replayPath.isEmpty())
+        return;
+
+    m_replayer = new SessionReplayer(this);
+    m_replayer->setSpeed(m_options.replaySpeed);
+
+    if (!m_replayer->open(m_options.replayPath))
+    {
+        qWarning("unable to open session %s for replay", qPrintable(m_options.replayPath));
+        delete m_replayer;
+        m_replayer = nullptr;
+        return;
+    }
+
+    RobotSession *session = m_sessions.first();
+    m_replayer->setSender([session](const QByteArray &frame) { return session->replay(frame); });
+    connect(m_replayer, &SessionReplayer::waiting, session, [this, session]() {
+        m_network->requestDrained(session->index());
+    });
+    connect(m_network, &NetworkWorker::commandsDrained, m_replayer, [this, session](int robot) {
+        if (robot == session->index())
+            m_replayer->resume();
+    });
+    connect(session, &RobotSession::connectedChanged, m_replayer, [this](bool connected) {
+        if (connected && !m_replayer->isStarted())
+            m_replayer->start();
+    });
+}
+
+// ---------------------------------- SESSIONS ------------------------------------
+
+/**
+ * @brief ControlCore::selectRobot
+ * @param index - session shown and driven by keys and operator actions from now on
+ */
+void ControlCore::selectRobot(int index)
+{
+    if (index < 0 || index >= m_sessions.size() || m_sessions[index] == m_activeSession)
+        return;
+
+    m_activeSession = m_sessions[index];
+    emit activeSessionChanged(m_activeSession);
+    emit standingChanged(standing());
+}
+
+/**
+ * @brief ControlCore::target
+ *      The robot assigned to the gamepad whose signal is being handled, otherwise the
+ *      active robot
+ */
+RobotSession *ControlCore::target() const
+{
+    return m_commandTarget ? m_commandTarget : m_activeSession;
+}
+
+/**
+ * @brief ControlCore::isStanding
+ *      Every robot has a gait of its own, and it decides how that robot's gamepad is read
+ */
+bool ControlCore::isStanding(const RobotSession *session)
+{
+    return session->commandState().value(RobotField::Gait) == (float)RobotGait::Stand;
+}
+
+/**
+ * @brief ControlCore::controllerSession
+ * @param uID - gamepad index
+ * @return the robot assigned to the gamepad with --controller
+ */
+RobotSession *ControlCore::controllerSession(short uID) const
+{
+    return m_sessions.value(m_options.controllerRobot.value(uID, 0), m_activeSession);
+}
+
+void ControlCore::setCommand(RobotField field, float value)
+{
+    RobotSession *session = target();
+
+    if (session->set(field, value, m_fieldDue) && session == m_activeSession)
+        emit fieldChanged(field, value);
+}
+
+void ControlCore::nudgeCommand(RobotField field, float step)
+{
+    RobotSession *session = target();
+
+    if (session->add(field, step) && session == m_activeSession)
+        emit fieldChanged(field, session->commandState().value(field));
+}
+
+/**
+ * @brief ControlCore::readTelemetry
+ *      Drains the telemetry handed over by the network thread
+ */
+void ControlCore::readTelemetry(int robot)
+{
+    m_sessions[robot]->readTelemetry();
+}
+
+void ControlCore::sendKeyframe()
+{
+    for (RobotSession *session : std::as_const(m_sessions))
+        session->requestKeyframe();
+}
+
+// ---------------------------------- OPERATOR ACTIONS ------------------------------------
+
+void ControlCore::setVelocityX(float vx)
+{
+    setCommand(RobotField::VelocityX, vx);
+}
+
+void ControlCore::setVelocityY(float vy)
+{
+    setCommand(RobotField::VelocityY, vy);
+}
+
+void ControlCore::setField(RobotField field, float value)
+{
+    if (field != RobotField::Gait)
+        setCommand(field, value);
+    else if (value == (float)RobotGait::Stand)
+        stand();
+    else
+        trot();
+}
+
+/**
+ * @brief ControlCore::stand
+ *      Standing still, the sticks and d-pad move the arm instead of the body
+ */
+void ControlCore::stand()
+{
+    setCommand(RobotField::Gait, (float)RobotGait::Stand);
+
+    if (target() == m_activeSession)
+        emit standingChanged(true);
+}
+
+void ControlCore::trot()
+{
+    setCommand(RobotField::Gait, (float)RobotGait::Trot);
+
+    if (target() == m_activeSession)
+        emit standingChanged(false);
+}
+
+void ControlCore::nudge(RobotField field, int direction)
+{
+    float step;
+
+    switch (field)
+    {
+    case RobotField::Height:
+        step = RobotCommandState::HeightStep;
+        break;
+
+    case RobotField::Grip:
+        step = RobotCommandState::GripStep;
+        break;
+
+    default:
+        step = RobotCommandState::JointStep;
+        break;
+    }
+
+    nudgeCommand(field, direction < 0 ? -step : step);
+}
+
+void ControlCore::setPoseAxes(ControlCore::PoseAxes axes)
+{
+    m_poseAxes = axes;
+}
+
+/**
+ * @brief ControlCore::setPose
+ *      Receives at most one coalesced JoyPad update per control tick
+ */
+void ControlCore::setPose(float x, float y, bool xChanged, bool yChanged)
+{
+    if (m_poseAxes == PoseAxes::Roll && xChanged)
+        setCommand(RobotField::Roll, x);
+    else if (m_poseAxes == PoseAxes::Pitch && yChanged)
+        setCommand(RobotField::Pitch, y);
+    else if (m_poseAxes == PoseAxes::Both)
+    {
+        setCommand(RobotField::Roll, x);
+        setCommand(RobotField::Pitch, y);
+    }
+}
+
+/**
+ * @brief ControlCore::setPoseHeld
+ *      While the JoyPad knob is held, centred thumbsticks do not reset the pose
+ */
+void ControlCore::setPoseHeld(bool held)
+{
+    m_poseHeld = held;
+}
+
+/**
+ * @brief ControlCore::setView
+ * @param view - 1 front, 2 back, 3 top, 4 side, 5 gripper
+ */
+void ControlCore::setView(float view)
+{
+    target()->send(CommandOpcode::View, view);
+}
+
+bool ControlCore::sensorSearch(const QString &text)
+{
+    const QByteArray utf8 = text.toUtf8();
+    if (utf8.size() > (qsizetype)CommandFrameFormat::PayloadSize)
+    {
+        qWarning("sensor search \"%s\" is %d bytes, at most %d fit a frame",
+                 qPrintable(text), (int)utf8.size(), (int)CommandFrameFormat::PayloadSize);
+        return false;
+    }
+
+    target()->send(CommandOpcode::SensorSearch, utf8.toStdString());
+    return true;
+}
+
+// ---------------------------------- KEYS ------------------------------------
+
+bool ControlCore::handleKey(int key)
+{
+    switch (key)
+    {
+    case Qt::Key_W:
+        setCommand(RobotField::VelocityX, 2.f);
+        break;
+
+    case Qt::Key_S:
+        setCommand(RobotField::VelocityX, -2.f);
+        break;
+
+    case Qt::Key_A:
+        setCommand(RobotField::VelocityY, 1.f);
+        break;
+
+    case Qt::Key_D:
+        setCommand(RobotField::VelocityY, -1.f);
+        break;
+
+    case Qt::Key_Q:
+        nudge(RobotField::Height, -1);
+        break;
+
+    case Qt::Key_E:
+        nudge(RobotField::Height, 1);
+        break;
+
+    case Qt::Key_V:
+        setCommand(RobotField::VelocityX, 0.f);
+        break;
+
+    case Qt::Key_B:
+        setCommand(RobotField::VelocityY, 0.f);
+        break;
+
+    case Qt::Key_R:
+        stand();
+        break;
+
+    case Qt::Key_T:
+        trot();
+        break;
+
+    default:
+        return false;
+    }
+
+    return true;
+}
+
+// ---------------------------------- XBOX CONTROLLER ----------------------------------
+
+/**
+ * @brief ControlCore::handleButtons
+ * @param uID
+ * @param buttons - XboxOneButtons bitmask
+ */
+void ControlCore::handleButtons(short uID, quint16 buttons)
+{
+    m_commandTarget = controllerSession(uID);
+
+    if (!isStanding(target()))
+    {
+        if (buttons & XboxOneButtons::X1_up)
+            setCommand(RobotField::VelocityX, 2.f);
+        else if (buttons & XboxOneButtons::X1_down)
+            setCommand(RobotField::VelocityX, -2.f);
+        else if (buttons & XboxOneButtons::X1_left)
+            setCommand(RobotField::VelocityY, 1.f);
+        else if (buttons & XboxOneButtons::X1_right)
+            setCommand(RobotField::VelocityY, -1.f);
+        else if (buttons & XboxOneButtons::X1_a)
+            setCommand(RobotField::VelocityY, 0.f);
+        else if (buttons & XboxOneButtons::X1_x)
+            setCommand(RobotField::VelocityX, 0.f);
+    }
+    else
+    {
+        if (buttons & XboxOneButtons::X1_up)
+            nudge(RobotField::Height, 1);
+        else if (buttons & XboxOneButtons::X1_down)
+            nudge(RobotField::Height, -1);
+
+        if (buttons & XboxOneButtons::X1_x)
+            nudge(RobotField::Grip, 1);
+        else if (buttons & XboxOneButtons::X1_a)
+            nudge(RobotField::Grip, -1);
+    }
+
+    m_commandTarget = nullptr;
+}
+
+/**
+ * @brief ControlCore::handleLeftStick
+ *      Pitch while walking, arm rotation and extension while standing
+ */
+void ControlCore::handleLeftStick(short uID, double x, double y)
+{
+    m_commandTarget = controllerSession(uID);
+
+    if (!isStanding(target()))
+    {
+        if (y != 0 || !m_poseHeld)
+            setCommand(RobotField::Pitch, y);
+    }
+    else
+    {
+        if (x >= .15)
+            nudge(RobotField::ArmRotate, 1);
+        else if (x <= -.15)
+            nudge(RobotField::ArmRotate, -1);
+
+        if (y >= .15)
+            nudge(RobotField::ArmExtend, 1);
+        else if (y <= -.15)
+            nudge(RobotField::ArmExtend, -1);
+    }
+
+    m_commandTarget = nullptr;
+}
+
+/**
+ * @brief ControlCore::handleRightStick
+ *      Roll while walking, grip angle and arm height while standing
+ */
+void ControlCore::handleRightStick(short uID, double x, double y)
+{
+    m_commandTarget = controllerSession(uID);
+
+    if (!isStanding(target()))
+    {
+        if (x != 0 || !m_poseHeld)
+            setCommand(RobotField::Roll, x);
+    }
+    else
+    {
+        if (x >= .15)
+            nudge(RobotField::GripAngle, 1);
+        else if (x <= -.15)
+            nudge(RobotField::GripAngle, -1);
+
+        if (y >= .15)
+            nudge(RobotField::ArmHeight, 1);
+        else if (y <= -.15)
+            nudge(RobotField::ArmHeight, -1);
+    }
+
+    m_commandTarget = nullptr;
+}
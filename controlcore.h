@@ -0,0 +1,180 @@
+#ifndef CONTROLCORE_H
+#define CONTROLCORE_H
+
+#include <QElapsedTimer>
+#include <QObject>
+#include <QString>
+#include <QVector>
+
+#include <ctime>
+
+#include "clientoptions.h"
+#include "gamepadinput.h"
+#include "networkworker.h"
+#include "robotcommandstate.h"
+#include "robotsession.h"
+#include "sessionreplayer.h"
+#include "timelinesequencer.h"
+#include "wakeupmonitor.h"
+
+class QThread;
+class QTimer;
+
+/**
+ * @brief The ControlCore class
+ *      Everything RoboUI does without a window: the network worker and one RobotSession
+ *      per robot, the gamepad, and the mapping of keys, gamepad input and operator
+ *      actions to robot commands. Only needs QtCore and QtNetwork, so it runs under
+ *      QCoreApplication for --headless soak tests and benchmarks.
+ *
+ *      The MainWindow forwards its widgets to the slots below; what changed reaches
+ *      the widgets through fieldChanged() and standingChanged(), batched per display
+ *      frame by a RobotStateView.
+ */
+class ControlCore : public QObject
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @brief The PoseAxes enum
+     *      Which JoyPad axes drive the body pose, roll from x and pitch from y
+     */
+    enum class PoseAxes
+    {
+        None,
+        Roll,
+        Pitch,
+        Both
+    };
+
+    explicit ControlCore(const ClientOptions &options, QObject *parent = nullptr);
+    ~ControlCore();
+
+    /**
+     * @brief start
+     *      Connects to every robot and starts reading the gamepad
+     */
+    void start();
+
+    const QVector<RobotSession *> &sessions() const { return m_sessions; }
+    RobotSession *activeSession() const { return m_activeSession; }
+
+    /**
+     * @brief standing
+     * @return true if the active robot was last told to stand
+     */
+    bool standing() const { return isStanding(m_activeSession); }
+
+    /**
+     * @brief timeline
+     * @return the sequencer playing --timeline, nullptr without one
+     */
+    TimelineSequencer *timeline() const { return m_timeline; }
+
+    /**
+     * @brief replayer
+     * @return the replayer sending --replay to robot 0, nullptr without one
+     */
+    SessionReplayer *replayer() const { return m_replayer; }
+
+signals:
+    /**
+     * @brief fieldChanged
+     *      A field of the active robot's desired state changed
+     */
+    void fieldChanged(RobotField field, float value);
+
+    /**
+     * @brief standingChanged
+     *      The active robot's gait was set, or another robot became the active one
+     */
+    void standingChanged(bool standing);
+    void activeSessionChanged(RobotSession *session);
+
+public slots:
+    void selectRobot(int index);
+
+    void setVelocityX(float vx);
+    void setVelocityY(float vy);
+
+    /**
+     * @brief setField
+     *      Sets any field of the desired state, a Gait value as stand() or trot() would
+     */
+    void setField(RobotField field, float value);
+
+    void stand();
+    void trot();
+
+    /**
+     * @brief nudge
+     *      Moves a field by one step, for height, arm joint and grip buttons
+     * @param direction - 1 or -1
+     */
+    void nudge(RobotField field, int direction);
+
+    void setPoseAxes(ControlCore::PoseAxes axes);
+    void setPose(float x, float y, bool xChanged, bool yChanged);
+    void setPoseHeld(bool held);
+
+    void setView(float view);
+
+    /**
+     * @brief sensorSearch
+     * @param text - UTF-8 encoded, at most CommandFrameFormat::PayloadSize bytes
+     * @return false if the text does not fit one frame and nothing was sent
+     */
+    bool sensorSearch(const QString &text);
+
+    /**
+     * @brief handleKey
+     * @param key - Qt::Key
+     * @return false if the key has no binding
+     */
+    bool handleKey(int key);
+
+    void handleButtons(short uID, quint16 buttons);
+    void handleLeftStick(short uID, double x, double y);
+    void handleRightStick(short uID, double x, double y);
+
+private slots:
+    void readTelemetry(int robot);
+    void sendKeyframe();
+
+private:
+    void initNetwork();
+    void initGamepad();
+    void initTimeline();
+    void initReplay();
+
+    RobotSession *target() const;
+    static bool isStanding(const RobotSession *session);
+    RobotSession *controllerSession(short uID) const;
+    void setCommand(RobotField field, float value);
+    void nudgeCommand(RobotField field, float step);
+
+    ClientOptions m_options;
+
+    QThread *m_networkThread;
+    NetworkWorker *m_network;
+    QVector<RobotSession *> m_sessions;
+    RobotSession *m_activeSession;
+    RobotSession *m_commandTarget;
+    uint64_t m_fieldDue;            // scheduled time of the timeline event being set, or 0
+    QTimer *m_keyframeTimer;
+
+    GamepadInput *m_gamepad;
+    TimelineSequencer *m_timeline;
+    SessionReplayer *m_replayer;
+    WakeupMonitor *m_wakeupMonitor;
+
+    PoseAxes m_poseAxes;
+    bool m_poseHeld;
+
+    // wall and process CPU time since start(), reported on exit
+    QElapsedTimer m_clock;
+    std::clock_t m_cpuStart;
+};
+
+#endif // CONTROLCORE_H
@@ -0,0 +1,603 @@
+#include "evdevgamepad.h"
+
+#include <QDir>
+#include <QThread>
+
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+#include <ctime>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+// older headers only have the timeval member
+#ifndef input_event_sec
+#define input_event_sec time.tv_sec
+#define input_event_usec time.tv_usec
+#endif
+
+static const char *const InputDirectory = "/dev/input";
+
+// the axes a gamepad state is built from
+static const int MappedAxes[] = { ABS_X, ABS_Y, ABS_RX, ABS_RY, ABS_Z, ABS_RZ, ABS_BRAKE, ABS_GAS, ABS_HAT0X, ABS_HAT0Y };
+
+static bool testBit(const unsigned char *bits, int bit)
+{
+    return (bits[bit / 8] >> (bit % 8)) & 1;
+}
+
+static qint64 monotonicNow()
+{
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (qint64)now.tv_sec * 1000000 + now.tv_nsec / 1000;
+}
+
+/**
+ * @brief buttonBit
+ * @return XboxOneButtons bit of an evdev key code, 0 if unmapped
+ */
+static quint16 buttonBit(int code)
+{
+    switch (code)
+    {
+    case BTN_SOUTH:         return X1_a;
+    case BTN_EAST:          return X1_b;
+    // xpad reports X and Y as BTN_X and BTN_Y, which alias BTN_NORTH and BTN_WEST
+    case BTN_X:             return X1_x;
+    case BTN_Y:             return X1_y;
+    case BTN_TL:            return X1_lbump;
+    case BTN_TR:            return X1_rbump;
+    case BTN_SELECT:        return X1_back;
+    case BTN_START:         return X1_start;
+    case BTN_MODE:          return X1_guide;
+    case BTN_THUMBL:        return X1_ltdown;
+    case BTN_THUMBR:        return X1_rtdown;
+    case BTN_DPAD_UP:       return X1_up;
+    case BTN_DPAD_DOWN:     return X1_down;
+    case BTN_DPAD_LEFT:     return X1_left;
+    case BTN_DPAD_RIGHT:    return X1_right;
+    default:                return 0;
+    }
+}
+
+//---------------------------------- DECODER ------------------------------------
+
+EvdevDecoder::EvdevDecoder()
+{
+    for (int i = 0; i < ABS_CNT; i++)
+        m_ranges[i] = { -32768, 32767 };
+
+    m_ranges[ABS_Z] = m_ranges[ABS_RZ] = { 0, 1023 };
+    m_ranges[ABS_BRAKE] = m_ranges[ABS_GAS] = { 0, 1023 };
+    m_ranges[ABS_HAT0X] = m_ranges[ABS_HAT0Y] = { -1, 1 };
+
+    reset();
+}
+
+void EvdevDecoder::reset()
+{
+    std::memset(&m_state, 0, sizeof(m_state));
+    m_state.connected = true;
+    m_dropping = false;
+}
+
+void EvdevDecoder::setRange(int axis, int minimum, int maximum)
+{
+    if (axis >= 0 && axis < ABS_CNT && maximum > minimum)
+        m_ranges[axis] = { minimum, maximum };
+}
+
+qint16 EvdevDecoder::scaleStick(int axis, int value, bool flip) const
+{
+    const Range &range = m_ranges[axis];
+    double t = (double)(value - range.minimum) / (double)(range.maximum - range.minimum);
+    long scaled = std::lround(t * 65535.0) - 32768;
+
+    if (flip)
+        scaled = -scaled;
+
+    return (qint16)qBound(-32768L, scaled, 32767L);
+}
+
+quint8 EvdevDecoder::scaleTrigger(int axis, int value) const
+{
+    const Range &range = m_ranges[axis];
+    double t = (double)(value - range.minimum) / (double)(range.maximum - range.minimum);
+
+    return (quint8)qBound(0L, std::lround(t * 255.0), 255L);
+}
+
+void EvdevDecoder::setKey(int code, bool pressed)
+{
+    quint16 bit = buttonBit(code);
+
+    if (pressed)
+        m_state.buttons |= bit;
+    else
+        m_state.buttons &= ~bit;
+}
+
+void EvdevDecoder::setAxis(int code, int value)
+{
+    switch (code)
+    {
+    case ABS_X:     m_state.thumbLX = scaleStick(code, value, false); break;
+    case ABS_Y:     m_state.thumbLY = scaleStick(code, value, true); break;
+    case ABS_RX:    m_state.thumbRX = scaleStick(code, value, false); break;
+    case ABS_RY:    m_state.thumbRY = scaleStick(code, value, true); break;
+
+    case ABS_Z:
+    case ABS_BRAKE:
+        m_state.leftTrigger = scaleTrigger(code, value);
+        break;
+
+    case ABS_RZ:
+    case ABS_GAS:
+        m_state.rightTrigger = scaleTrigger(code, value);
+        break;
+
+    // the d-pad of most pads is a hat switch rather than four keys
+    case ABS_HAT0X:
+        m_state.buttons &= ~(X1_left | X1_right);
+        if (value < 0)
+            m_state.buttons |= X1_left;
+        else if (value > 0)
+            m_state.buttons |= X1_right;
+        break;
+
+    case ABS_HAT0Y:
+        m_state.buttons &= ~(X1_up | X1_down);
+        if (value < 0)
+            m_state.buttons |= X1_up;
+        else if (value > 0)
+            m_state.buttons |= X1_down;
+        break;
+
+    default:
+        break;
+    }
+}
+
+/**
+ * @brief EvdevDecoder::feed
+ * @param event - next event of the stream
+ * @param state - receives the new state when Frame is returned
+ */
+EvdevDecoder::Result EvdevDecoder::feed(const input_event &event, GamepadState &state)
+{
+    if (event.type == EV_SYN)
+    {
+        if (event.code == SYN_DROPPED)
+        {
+            m_dropping = true;
+            return Pending;
+        }
+
+        if (event.code != SYN_REPORT)
+            return Pending;
+
+        if (m_dropping)
+        {
+            m_dropping = false;
+            return Dropped;
+        }
+
+        m_state.packet++;
+        m_state.timestamp = (qint64)event.input_event_sec * 1000000 + event.input_event_usec;
+        state = m_state;
+        return Frame;
+    }
+
+    if (m_dropping)
+        return Pending;
+
+    if (event.type == EV_KEY)
+        setKey(event.code, event.value != 0);
+    else if (event.type == EV_ABS)
+        setAxis(event.code, event.value);
+
+    return Pending;
+}
+
+//---------------------------------- DEVICES ------------------------------------
+
+EvdevGamepad::EvdevGamepad(QObject *parent) : GamepadInput(parent),
+    m_epoll(-1),
+    m_inotify(-1),
+    m_wake(-1),
+    m_thread(nullptr),
+    m_running(false)
+{
+    std::memset(m_padUsed, 0, sizeof(m_padUsed));
+}
+
+EvdevGamepad::~EvdevGamepad()
+{
+    Stop();
+}
+
+void EvdevGamepad::SetRecording(const QString &path)
+{
+    m_recordingPath = path;
+}
+
+void EvdevGamepad::Start()
+{
+    if (m_thread)
+        return;
+
+    m_wake = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (m_wake < 0)
+    {
+        qWarning("evdev: eventfd failed: %s", strerror(errno));
+        return;
+    }
+
+    m_running = true;
+
+    if (m_recordingPath.isEmpty())
+        m_thread = QThread::create([this]() { Run(); });
+    else
+        m_thread = QThread::create([this]() { Replay(); });
+
+    m_thread->start(QThread::HighestPriority);
+}
+
+void EvdevGamepad::Stop()
+{
+    if (!m_thread)
+        return;
+
+    m_running = false;
+
+    uint64_t one = 1;
+    if (write(m_wake, &one, sizeof(one)) < 0)
+        qWarning("evdev: unable to wake the input thread: %s", strerror(errno));
+
+    m_thread->wait();
+    delete m_thread;
+    m_thread = nullptr;
+
+    close(m_wake);
+    m_wake = -1;
+}
+
+/**
+ * @brief EvdevGamepad::Run
+ *      Input thread: sleeps in epoll_wait until a device, the inotify watch or Stop() wakes it
+ */
+void EvdevGamepad::Run()
+{
+    m_epoll = epoll_create1(EPOLL_CLOEXEC);
+    if (m_epoll < 0)
+    {
+        qWarning("evdev: epoll_create1 failed: %s", strerror(errno));
+        return;
+    }
+
+    epoll_event watch = {};
+    watch.events = EPOLLIN;
+    watch.data.ptr = &m_wake;
+    epoll_ctl(m_epoll, EPOLL_CTL_ADD, m_wake, &watch);
+
+    m_inotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (m_inotify >= 0 && inotify_add_watch(m_inotify, InputDirectory, IN_CREATE | IN_ATTRIB) >= 0)
+    {
+        watch.data.ptr = &m_inotify;
+        epoll_ctl(m_epoll, EPOLL_CTL_ADD, m_inotify, &watch);
+    }
+    else
+        qWarning("evdev: no hotplug support: %s", strerror(errno));
+
+    Scan();
+
+    epoll_event events[16];
+
+    while (m_running)
+    {
+        int count = epoll_wait(m_epoll, events, 16, -1);
+
+        if (count < 0)
+        {
+            if (errno == EINTR)
+                continue;
+
+            qWarning("evdev: epoll_wait failed: %s", strerror(errno));
+            break;
+        }
+
+        for (int i = 0; i < count; i++)
+        {
+            if (events[i].data.ptr == &m_wake)
+                continue;
+
+            if (events[i].data.ptr == &m_inotify)
+            {
+                ReadInotify();
+                continue;
+            }
+
+            Device *device = static_cast<Device *>(events[i].data.ptr);
+
+            if (device->fd < 0)
+                continue;
+
+            if (events[i].events & EPOLLIN)
+                Read(device);
+            else if (events[i].events & (EPOLLHUP | EPOLLERR))
+                Close(device);
+        }
+
+        // closed devices are only freed once no pending event can refer to them
+        for (size_t i = 0; i < m_devices.size();)
+        {
+            if (m_devices[i]->fd < 0)
+                m_devices.erase(m_devices.begin() + i);
+            else
+                i++;
+        }
+    }
+
+    for (const std::unique_ptr<Device> &device : m_devices)
+    {
+        if (device->fd >= 0)
+            Close(device.get());
+    }
+    m_devices.clear();
+
+    if (m_inotify >= 0)
+        close(m_inotify);
+    close(m_epoll);
+
+    m_inotify = -1;
+    m_epoll = -1;
+}
+
+void EvdevGamepad::Scan()
+{
+    const QStringList entries = QDir(InputDirectory).entryList({ "event*" }, QDir::System);
+
+    for (const QString &entry : entries)
+        Open(QByteArray(InputDirectory) + '/' + entry.toLatin1());
+}
+
+/**
+ * @brief EvdevGamepad::Open
+ *      Opens path if it is a gamepad that is not open yet and a controller slot is free
+ */
+void EvdevGamepad::Open(const QByteArray &path)
+{
+    for (const std::unique_ptr<Device> &device : m_devices)
+    {
+        if (device->fd >= 0 && device->path == path)
+            return;
+    }
+
+    int pad = 0;
+    while (pad < MaxPads && m_padUsed[pad])
+        pad++;
+
+    if (pad == MaxPads)
+        return;
+
+    int fd = open(path.constData(), O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+    if (fd < 0)
+        return;
+
+    unsigned char keys[KEY_CNT / 8 + 1] = {};
+    unsigned char axes[ABS_CNT / 8 + 1] = {};
+
+    if (ioctl(fd, EVIOCGBIT(EV_KEY, sizeof(keys)), keys) < 0
+            || ioctl(fd, EVIOCGBIT(EV_ABS, sizeof(axes)), axes) < 0
+            || !testBit(keys, BTN_GAMEPAD) || !testBit(axes, ABS_X))
+    {
+        close(fd);
+        return;
+    }
+
+    // timestamps on the same clock as CommandFrameEncoder::now()
+    int clock = CLOCK_MONOTONIC;
+    ioctl(fd, EVIOCSCLOCKID, &clock);
+
+    std::unique_ptr<Device> device(new Device);
+    device->fd = fd;
+    device->pad = pad;
+    device->path = path;
+
+    for (int axis : MappedAxes)
+    {
+        input_absinfo info;
+        if (testBit(axes, axis) && ioctl(fd, EVIOCGABS(axis), &info) >= 0)
+            device->decoder.setRange(axis, info.minimum, info.maximum);
+    }
+
+    epoll_event watch = {};
+    watch.events = EPOLLIN;
+    watch.data.ptr = device.get();
+
+    if (epoll_ctl(m_epoll, EPOLL_CTL_ADD, fd, &watch) < 0)
+    {
+        close(fd);
+        return;
+    }
+
+    m_padUsed[pad] = true;
+    m_devices.push_back(std::move(device));
+
+    Resync(m_devices.back().get());
+}
+
+void EvdevGamepad::Close(Device *device)
+{
+    epoll_ctl(m_epoll, EPOLL_CTL_DEL, device->fd, nullptr);
+    close(device->fd);
+    device->fd = -1;
+
+    m_padUsed[device->pad] = false;
+
+    // report the controller as released once when it goes away
+    std::memset(&device->state, 0, sizeof(device->state));
+    device->state.timestamp = monotonicNow();
+    Publish(device->pad, device->state);
+}
+
+void EvdevGamepad::Read(Device *device)
+{
+    input_event events[64];
+
+    for (;;)
+    {
+        ssize_t length = read(device->fd, events, sizeof(events));
+
+        if (length < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            if (errno != EAGAIN)
+                Close(device);
+            return;
+        }
+
+        if (length == 0)
+            return;
+
+        bool frame = false;
+
+        for (size_t i = 0; i < (size_t)length / sizeof(input_event); i++)
+        {
+            switch (device->decoder.feed(events[i], device->state))
+            {
+            case EvdevDecoder::Frame:
+                frame = true;
+                break;
+            case EvdevDecoder::Dropped:
+                Resync(device);
+                break;
+            case EvdevDecoder::Pending:
+                break;
+            }
+        }
+
+        // only the latest complete state of a batch is published
+        if (frame)
+            Publish(device->pad, device->state);
+    }
+}
+
+/**
+ * @brief EvdevGamepad::Resync
+ *      Reads the current key and axis state back from the device, after opening
+ *      it or after the kernel dropped events
+ */
+void EvdevGamepad::Resync(Device *device)
+{
+    unsigned char keys[KEY_CNT / 8 + 1] = {};
+
+    if (ioctl(device->fd, EVIOCGKEY(sizeof(keys)), keys) >= 0)
+    {
+        for (int code = BTN_MISC; code < KEY_CNT; code++)
+        {
+            if (buttonBit(code))
+                device->decoder.setKey(code, testBit(keys, code));
+        }
+    }
+
+    for (int axis : MappedAxes)
+    {
+        input_absinfo info;
+        if (ioctl(device->fd, EVIOCGABS(axis), &info) >= 0)
+            device->decoder.setAxis(axis, info.value);
+    }
+
+    input_event report = {};
+    report.type = EV_SYN;
+    report.code = SYN_REPORT;
+
+    qint64 now = monotonicNow();
+    report.input_event_sec = now / 1000000;
+    report.input_event_usec = now % 1000000;
+
+    device->decoder.feed(report, device->state);
+    Publish(device->pad, device->state);
+}
+
+void EvdevGamepad::ReadInotify()
+{
+    alignas(inotify_event) char buffer[4096];
+    ssize_t length;
+
+    while ((length = read(m_inotify, buffer, sizeof(buffer))) > 0)
+    {
+        for (char *p = buffer; p < buffer + length;)
+        {
+            const inotify_event *event = reinterpret_cast<const inotify_event *>(p);
+
+            // udev fixes the permissions after creating the node, so IN_ATTRIB retries the open
+            if (event->len > 0 && std::strncmp(event->name, "event", 5) == 0)
+                Open(QByteArray(InputDirectory) + '/' + event->name);
+
+            p += sizeof(inotify_event) + event->len;
+        }
+    }
+}
+
+//---------------------------------- RECORDING ------------------------------------
+
+/**
+ * @brief EvdevGamepad::Replay
+ *      Input thread for SetRecording(): feeds the dump through a decoder with the recorded
+ *      gaps between events. States are stamped with the time they are replayed at.
+ */
+void EvdevGamepad::Replay()
+{
+    int fd = open(m_recordingPath.toLocal8Bit().constData(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+    {
+        qWarning("evdev: unable to open %s: %s", qPrintable(m_recordingPath), strerror(errno));
+        return;
+    }
+
+    EvdevDecoder decoder;
+    GamepadState state;
+    input_event event;
+
+    qint64 first = -1;
+    qint64 start = monotonicNow();
+
+    while (m_running && read(fd, &event, sizeof(event)) == (ssize_t)sizeof(event))
+    {
+        qint64 recorded = (qint64)event.input_event_sec * 1000000 + event.input_event_usec;
+        if (first < 0)
+            first = recorded;
+
+        qint64 wait = (recorded - first) - (monotonicNow() - start);
+
+        if (wait > 0)
+        {
+            pollfd wake = { m_wake, POLLIN, 0 };
+            timespec timeout = { (time_t)(wait / 1000000), (long)(wait % 1000000) * 1000 };
+
+            if (ppoll(&wake, 1, &timeout, nullptr) > 0)
+                break;
+        }
+
+        if (decoder.feed(event, state) == EvdevDecoder::Frame)
+        {
+            state.timestamp = monotonicNow();
+            Publish(0, state);
+        }
+    }
+
+    close(fd);
+
+    std::memset(&state, 0, sizeof(state));
+    state.timestamp = monotonicNow();
+    Publish(0, state);
+}
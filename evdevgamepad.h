@@ -0,0 +1,133 @@
+#ifndef EVDEVGAMEPAD_H
+#define EVDEVGAMEPAD_H
+
+#include <QString>
+
+#include <linux/input.h>
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "gamepadinput.h"
+
+class QThread;
+
+/**
+ * @brief The EvdevDecoder class
+ *      Turns the input_event stream of one gamepad into GamepadStates. Holds no file
+ *      descriptors, so recorded streams can be decoded exactly like live devices.
+ *
+ *      Axes are scaled from the device's range to XInput's, with evdev's downward Y axes
+ *      flipped. A state is complete at every SYN_REPORT and carries that event's kernel
+ *      timestamp. After SYN_DROPPED everything up to the next SYN_REPORT is ignored and
+ *      the owner is expected to resynchronize from the device.
+ */
+class EvdevDecoder
+{
+public:
+    enum Result
+    {
+        Pending,        // event applied, frame not complete yet
+        Frame,          // state holds a new complete frame
+        Dropped         // the kernel dropped events, state needs a resync
+    };
+
+    EvdevDecoder();
+
+    /**
+     * @brief setRange
+     *      Range of an ABS_* axis as reported by EVIOCGABS. The defaults match
+     *      the xpad driver: sticks -32768 to 32767, triggers 0 to 1023.
+     */
+    void setRange(int axis, int minimum, int maximum);
+
+    Result feed(const input_event &event, GamepadState &state);
+
+    /**
+     * @brief setKey, setAxis
+     *      Apply a key or axis value read back from the device during a resync
+     */
+    void setKey(int code, bool pressed);
+    void setAxis(int code, int value);
+
+    void reset();
+
+private:
+    struct Range
+    {
+        int minimum;
+        int maximum;
+    };
+
+    qint16 scaleStick(int axis, int value, bool flip) const;
+    quint8 scaleTrigger(int axis, int value) const;
+
+    Range m_ranges[ABS_CNT];
+    GamepadState m_state;
+    bool m_dropping;
+};
+
+/**
+ * @brief The EvdevGamepad class
+ *      Linux backend of GamepadInput. Gamepads under /dev/input are read on a dedicated
+ *      thread that sleeps in epoll_wait until the kernel has events, so nothing runs while
+ *      the controllers are idle. Controllers plugged in later are picked up through an
+ *      inotify watch on /dev/input in the same epoll set.
+ *
+ *      Timestamps come from the kernel, on CLOCK_MONOTONIC.
+ */
+class EvdevGamepad : public GamepadInput
+{
+    Q_OBJECT
+
+public:
+    explicit EvdevGamepad(QObject *parent = nullptr);
+    ~EvdevGamepad();
+
+    /**
+     * @brief SetRecording
+     *      Reads a raw input_event dump (as captured with `cat /dev/input/eventN > file`)
+     *      instead of devices, replayed with its recorded timing as controller 0.
+     *      Call before Start().
+     */
+    void SetRecording(const QString &path);
+
+public slots:
+    void Start() override;
+    void Stop() override;
+
+private:
+    struct Device
+    {
+        int fd;
+        int pad;
+        QByteArray path;
+        EvdevDecoder decoder;
+        GamepadState state;
+    };
+
+    void Run();
+    void Replay();
+
+    void Scan();
+    void Open(const QByteArray &path);
+    void Close(Device *device);
+    void Read(Device *device);
+    void Resync(Device *device);
+    void ReadInotify();
+
+    QString m_recordingPath;
+
+    int m_epoll;
+    int m_inotify;
+    int m_wake;                         // eventfd that interrupts the thread on Stop()
+
+    std::vector<std::unique_ptr<Device>> m_devices;
+    bool m_padUsed[MaxPads];
+
+    QThread *m_thread;
+    std::atomic<bool> m_running;
+};
+
+#endif // EVDEVGAMEPAD_H
@@ -0,0 +1,283 @@
+#include "gamepadinput.h"
+
+#include <QTimer>
+
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+#include "commandframe.h"
+
+#if defined(Q_OS_WIN)
+#include "iwindows_xinput_wrapper.h"
+#elif defined(Q_OS_LINUX)
+#include "evdevgamepad.h"
+#endif
+
+GamepadInput::GamepadInput(QObject *parent) : QObject(parent),
+    m_deliverPending(false),
+    m_repeatTimer(new QTimer(this)),
+    m_settleTimer(new QTimer(this))
+{
+    std::memset(m_delivered, 0, sizeof(m_delivered));
+
+    m_repeatTimer->setInterval(50);
+    connect(m_repeatTimer, &QTimer::timeout, this, &GamepadInput::Repeat);
+
+    m_settleTimer->setSingleShot(true);
+    m_settleTimer->setInterval(InputConditioner::SettleDelay);
+    connect(m_settleTimer, &QTimer::timeout, this, &GamepadInput::Settle);
+}
+
+GamepadInput::~GamepadInput()
+{
+}
+
+GamepadInput *GamepadInput::create(QObject *parent)
+{
+#if defined(Q_OS_WIN)
+    return new IWindows_XInput_Wrapper(parent);
+#elif defined(Q_OS_LINUX)
+    return new EvdevGamepad(parent);
+#else
+    return new GamepadInput(parent);
+#endif
+}
+
+void GamepadInput::Setup()
+{
+}
+
+void GamepadInput::Start()
+{
+}
+
+void GamepadInput::Stop()
+{
+}
+
+void GamepadInput::SetPollingRate(int Hz)
+{
+    Q_UNUSED(Hz);
+}
+
+void GamepadInput::SetRepeatInterval(int ms)
+{
+    if (ms <= 0)
+        m_repeatTimer->stop();
+
+    m_repeatTimer->setInterval(qMax(0, ms));
+}
+
+void GamepadInput::SetConditioning(const InputConditionerConfig &Config)
+{
+    for (int i = 0; i < MaxPads; i++)
+    {
+        m_sticks[i][LeftStick].setConfig(Config);
+        m_sticks[i][RightStick].setConfig(Config);
+    }
+}
+
+LatencyHistogram GamepadInput::FilterLag() const
+{
+    LatencyHistogram lag;
+
+    for (int i = 0; i < MaxPads; i++)
+    {
+        lag.merge(m_sticks[i][LeftStick].lag());
+        lag.merge(m_sticks[i][RightStick].lag());
+    }
+
+    return lag;
+}
+
+//---------------------------------- SNAPSHOT ------------------------------------
+
+/**
+ * @brief GamepadInput::Snapshot
+ *      Retries while the backend is in the middle of publishing
+ */
+bool GamepadInput::Snapshot(short uID, GamepadState &State) const
+{
+    if (uID < 0 || uID >= MaxPads)
+        return false;
+
+    const Slot &pad = m_pads[uID];
+    unsigned before, after;
+    unsigned long long state, sticks;
+    long long timestamp;
+    bool connected;
+
+    do
+    {
+        before = pad.sequence.load(std::memory_order_acquire);
+        connected = pad.connected.load(std::memory_order_relaxed);
+        state = pad.state.load(std::memory_order_relaxed);
+        sticks = pad.sticks.load(std::memory_order_relaxed);
+        timestamp = pad.timestamp.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        after = pad.sequence.load(std::memory_order_relaxed);
+    }
+    while ((before & 1) || before != after);
+
+    State.connected = connected;
+    State.packet = (quint32)(state & 0xffffffff);
+    State.buttons = (quint16)(state >> 32);
+    State.leftTrigger = (quint8)(state >> 48);
+    State.rightTrigger = (quint8)(state >> 56);
+    State.thumbLX = (qint16)(sticks & 0xffff);
+    State.thumbLY = (qint16)(sticks >> 16);
+    State.thumbRX = (qint16)(sticks >> 32);
+    State.thumbRY = (qint16)(sticks >> 48);
+    State.timestamp = timestamp;
+
+    return true;
+}
+
+void GamepadInput::Publish(int uID, const GamepadState &State)
+{
+    if (uID < 0 || uID >= MaxPads)
+        return;
+
+    Slot &pad = m_pads[uID];
+
+    unsigned long long state = (unsigned long long)State.packet
+            | ((unsigned long long)State.buttons << 32)
+            | ((unsigned long long)State.leftTrigger << 48)
+            | ((unsigned long long)State.rightTrigger << 56);
+
+    unsigned long long sticks = (unsigned long long)(quint16)State.thumbLX
+            | ((unsigned long long)(quint16)State.thumbLY << 16)
+            | ((unsigned long long)(quint16)State.thumbRX << 32)
+            | ((unsigned long long)(quint16)State.thumbRY << 48);
+
+    unsigned sequence = pad.sequence.load(std::memory_order_relaxed);
+    pad.sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    pad.connected.store(State.connected, std::memory_order_relaxed);
+    pad.state.store(state, std::memory_order_relaxed);
+    pad.sticks.store(sticks, std::memory_order_relaxed);
+    pad.timestamp.store(State.timestamp, std::memory_order_relaxed);
+
+    pad.sequence.store(sequence + 2, std::memory_order_release);
+
+    if (!m_deliverPending.exchange(true))
+        QMetaObject::invokeMethod(this, &GamepadInput::Deliver, Qt::QueuedConnection);
+}
+
+//---------------------------------- SIGNALS ------------------------------------
+
+void GamepadInput::Deliver()
+{
+    m_deliverPending = false;
+    Emit(false);
+
+    m_settleTimer->start();
+}
+
+void GamepadInput::Repeat()
+{
+    Emit(true);
+}
+
+/**
+ * @brief GamepadInput::Settle
+ *      No new state for SettleDelay ms, moves every filtered stick onto its input
+ */
+void GamepadInput::Settle()
+{
+    for (int i = 0; i < MaxPads; i++)
+    {
+        for (GamepadStick Stick : { LeftStick, RightStick })
+        {
+            if (m_sticks[i][Stick].settling())
+                EmitStick(i, Stick, m_sticks[i][Stick].snap(), false);
+        }
+    }
+}
+
+/**
+ * @brief GamepadInput::Emit
+ *      Emits what changed since the last call, or with Repeat everything that is held
+ */
+void GamepadInput::Emit(bool Repeat)
+{
+    GamepadState state;
+    bool held = false;
+
+    for (int i = 0; i < MaxPads; i++)
+    {
+        Snapshot(i, state);
+        GamepadState &previous = m_delivered[i];
+
+        if (!state.connected && !previous.connected)
+            continue;
+
+        if (state.buttons != previous.buttons || (Repeat && state.buttons != 0))
+            emit ButtonPressed(i, state.buttons);
+        if (state.leftTrigger != previous.leftTrigger)
+            emit LeftTrigger(i, state.leftTrigger);
+        if (state.rightTrigger != previous.rightTrigger)
+            emit RightTrigger(i, state.rightTrigger);
+
+        qint64 timestamp = Repeat ? (qint64)CommandFrameEncoder::now() : state.timestamp;
+        TranslateStick(i, state.thumbLX, state.thumbLY, LeftStick, Repeat, timestamp);
+        TranslateStick(i, state.thumbRX, state.thumbRY, RightStick, Repeat, timestamp);
+
+        if (state.packet != previous.packet || state.connected != previous.connected)
+            emit StateChanged(i, state.timestamp);
+
+        previous = state;
+        held = held || IsHeld(state);
+    }
+
+    // the repeat timer only runs while something is held
+    if (held && m_repeatTimer->interval() > 0)
+    {
+        if (!m_repeatTimer->isActive())
+            m_repeatTimer->start();
+    }
+    else
+        m_repeatTimer->stop();
+}
+
+void GamepadInput::TranslateStick(short uID, qint16 X, qint16 Y, GamepadStick Stick, bool Force, qint64 Timestamp)
+{
+    // Normalize values between -1.0 and 1.0
+    double normX = fmax(-1.0, (double) X / 32767.0);
+    double normY = fmax(-1.0, (double) Y / 32767.0);
+
+    // Radial deadzone, response curve, filter and prediction
+    EmitStick(uID, Stick, m_sticks[uID][Stick].condition(normX, normY, (uint64_t)Timestamp), Force);
+}
+
+void GamepadInput::EmitStick(short uID, GamepadStick Stick, const InputConditioner::Output &Conditioned, bool Force)
+{
+    double StickX = Conditioned.x;
+    double StickY = Conditioned.y;
+
+    // Only send when the stick left its previous position, or is held and due for a repeat
+    QPointF &last = m_lastStick[uID][Stick];
+    QPointF position(StickX, StickY);
+
+    if (position == last && !(Force && !position.isNull()))
+        return;
+
+    last = position;
+
+    if (Stick == LeftStick)
+        emit LeftThumbStick(uID, StickX, StickY);
+    else
+        emit RightThumbStick(uID, StickX, StickY);
+}
+
+bool GamepadInput::IsHeld(const GamepadState &State) const
+{
+    // the deadzone is the same for all sticks
+    double limit = m_sticks[0][LeftStick].config().deadzone * 32767.0;
+
+    return State.buttons != 0
+            || std::hypot((double)State.thumbLX, (double)State.thumbLY) > limit
+            || std::hypot((double)State.thumbRX, (double)State.thumbRY) > limit;
+}
@@ -0,0 +1,200 @@
+#ifndef GAMEPADINPUT_H
+#define GAMEPADINPUT_H
+
+#include <QObject>
+#include <QPointF>
+
+#include <atomic>
+
+#include "inputconditioner.h"
+
+class QTimer;
+
+/**
+ * @brief The XboxOneButtons enum
+ *      Button bits of GamepadState::buttons. The values are XInput's wButtons bits;
+ *      other backends map their buttons onto them.
+ */
+enum XboxOneButtons
+{
+    X1_up = 1,
+    X1_down = 2,
+    X1_left = 4,
+    X1_right = 8,
+    X1_start = 16,
+    X1_back = 32,
+    X1_ltdown = 64,
+    X1_rtdown = 128,
+    X1_lbump = 256,
+    X1_rbump = 512,
+    X1_guide = 1024,
+
+    X1_a = 4096,
+    X1_b = 8192,
+    X1_x = 16384,
+    X1_y = 32768
+};
+
+enum GamepadStick
+{
+    LeftStick,
+    RightStick
+};
+
+/**
+ * @brief The GamepadState struct
+ *      State of one controller in XInput's units: sticks -32768 to 32767 with up and
+ *      right positive, triggers 0 to 255
+ */
+struct GamepadState
+{
+    bool connected;
+    quint32 packet;         // changes whenever the state changes
+    quint16 buttons;        // XboxOneButtons bitmask
+    quint8 leftTrigger;
+    quint8 rightTrigger;
+    qint16 thumbLX;
+    qint16 thumbLY;
+    qint16 thumbRX;
+    qint16 thumbRY;
+    qint64 timestamp;       // time of the input in microseconds, CommandFrameEncoder::now() clock
+};
+
+/**
+ * @brief The GamepadInput class
+ *      Platform neutral gamepad interface. A backend reads its controllers on a thread of
+ *      its own and hands every new state to Publish(), which stores it in a lock-free
+ *      per-controller snapshot and wakes this object's thread once. The signals are then
+ *      emitted there for whatever changed since they were last emitted.
+ *
+ *      Buttons and sticks that are held are re-emitted every repeat interval, so actions
+ *      bound to holding an input keep repeating.
+ *
+ *      Every stick goes through an InputConditioner fed with the state's timestamp.
+ *      Once no new state arrived for InputConditioner::SettleDelay ms, the sticks are
+ *      at rest and their filters snap onto them, well before the next repeat.
+ *
+ *      Instantiated directly the class is a backend without controllers.
+ */
+class GamepadInput : public QObject
+{
+    Q_OBJECT
+
+public:
+    static constexpr int MaxPads = 4;
+
+    explicit GamepadInput(QObject *parent = nullptr);
+    ~GamepadInput();
+
+    /**
+     * @brief create
+     * @return the backend for this platform: XInput on Windows, evdev on Linux
+     */
+    static GamepadInput *create(QObject *parent = nullptr);
+
+    /**
+     * @brief SetPollingRate
+     *      Only meaningful for backends that have to poll
+     * @param Hz - polls per second, 1 to 1000
+     */
+    virtual void SetPollingRate(int Hz);
+
+    /**
+     * @brief SetRepeatInterval
+     * @param ms - interval for re-emitting held inputs, 0 to only emit changes, default 50
+     */
+    void SetRepeatInterval(int ms);
+
+    /**
+     * @brief SetConditioning
+     *      Deadzone, response curve, filter and prediction of all sticks
+     */
+    void SetConditioning(const InputConditionerConfig &Config);
+
+    /**
+     * @brief FilterLag
+     *      InputConditioner::lag() of all sticks together
+     */
+    LatencyHistogram FilterLag() const;
+
+    /**
+     * @brief Snapshot
+     *      Latest state of one controller, safe to call from any thread
+     * @return false if uID is out of range
+     */
+    bool Snapshot(short uID, GamepadState &State) const;
+
+signals:
+    /**
+     * @brief ButtonPressed
+     * @param uID - UserID
+     * @param Buttons - XboxOneButtons bitmask of all currently pressed buttons
+     */
+    void ButtonPressed(short uID, quint16 Buttons);
+
+    void LeftTrigger(short uID, quint8 Value);
+    void RightTrigger(short uID, quint8 Value);
+
+    /**
+     * @brief LeftThumbStick, RightThumbStick
+     *      Normalized to -1.0 to 1.0 and conditioned, see SetConditioning()
+     */
+    void LeftThumbStick(short uID, double LX, double LY);
+    void RightThumbStick(short uID, double RX, double RY);
+
+    /**
+     * @brief StateChanged
+     *      Emitted after the signals above for every new state of a controller
+     * @param Timestamp - GamepadState::timestamp of the state
+     */
+    void StateChanged(short uID, qint64 Timestamp);
+
+public slots:
+    virtual void Setup();
+    virtual void Start();
+    virtual void Stop();
+
+protected:
+    /**
+     * @brief Publish
+     *      Backend thread. Stores State as the latest state of controller uID.
+     */
+    void Publish(int uID, const GamepadState &State);
+
+private slots:
+    void Deliver();
+    void Repeat();
+    void Settle();
+
+private:
+    void Emit(bool Repeat);
+    void TranslateStick(short uID, qint16 X, qint16 Y, GamepadStick Stick, bool Force, qint64 Timestamp);
+    void EmitStick(short uID, GamepadStick Stick, const InputConditioner::Output &Conditioned, bool Force);
+    bool IsHeld(const GamepadState &State) const;
+
+    /**
+     * @brief Slot - seqlock protected state of one controller, written by the backend
+     *      thread only. The sequence is odd while a write is in progress.
+     */
+    struct Slot
+    {
+        std::atomic<unsigned> sequence{0};
+        std::atomic<bool> connected{false};
+        std::atomic<unsigned long long> state{0};
+        std::atomic<unsigned long long> sticks{0};
+        std::atomic<long long> timestamp{0};
+    };
+
+    Slot m_pads[MaxPads];
+
+    // state last emitted per controller, this object's thread only
+    GamepadState m_delivered[MaxPads];
+    QPointF m_lastStick[MaxPads][2];
+    InputConditioner m_sticks[MaxPads][2];
+
+    std::atomic<bool> m_deliverPending;
+    QTimer *m_repeatTimer;
+    QTimer *m_settleTimer;
+};
+
+#endif // GAMEPADINPUT_H
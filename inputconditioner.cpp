@@ -0,0 +1,137 @@
+#include "inputconditioner.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+
+constexpr double Pi = 3.14159265358979323846;
+
+// smoothing factor of a low-pass with the given cutoff for a sample dt seconds after
+// the previous one
+double smoothing(double cutoff, double dt)
+{
+    double tau = 1.0 / (2.0 * Pi * cutoff);
+    return 1.0 / (1.0 + tau / dt);
+}
+
+// scales (x, y) back onto the unit circle if it lies outside
+InputConditioner::Output clampToCircle(double x, double y)
+{
+    double radius = std::hypot(x, y);
+    if (radius > 1.0)
+        return { x / radius, y / radius };
+
+    return { x, y };
+}
+
+} // namespace
+
+InputConditioner::InputConditioner(const InputConditionerConfig &config) :
+    m_config(config)
+{
+    reset();
+}
+
+void InputConditioner::setConfig(const InputConditionerConfig &config)
+{
+    m_config = config;
+    reset();
+}
+
+void InputConditioner::reset()
+{
+    m_primed = false;
+    m_timestamp = 0;
+    m_rawX = 0;
+    m_rawY = 0;
+    m_x = 0;
+    m_y = 0;
+    m_dx = 0;
+    m_dy = 0;
+}
+
+bool InputConditioner::settling() const
+{
+    return m_primed && (m_x != m_rawX || m_y != m_rawY || m_dx != 0 || m_dy != 0);
+}
+
+InputConditioner::Output InputConditioner::snap()
+{
+    if (!m_primed)
+        return { 0.0, 0.0 };
+
+    m_x = m_rawX;
+    m_y = m_rawY;
+    m_dx = 0;
+    m_dy = 0;
+
+    return { m_x, m_y };
+}
+
+/**
+ * @brief InputConditioner::shape
+ *      The deadzone is applied to the radius so diagonals are not cut off, and the
+ *      direction is kept
+ */
+InputConditioner::Output InputConditioner::shape(double x, double y) const
+{
+    Output input = clampToCircle(x, y);
+    double radius = std::hypot(input.x, input.y);
+
+    if (radius <= m_config.deadzone || radius == 0.0)
+        return { 0.0, 0.0 };
+
+    double scaled = (radius - m_config.deadzone) / (1.0 - m_config.deadzone);
+    if (m_config.exponent != 1.0)
+        scaled = std::pow(scaled, m_config.exponent);
+
+    return { input.x / radius * scaled, input.y / radius * scaled };
+}
+
+InputConditioner::Output InputConditioner::condition(double x, double y, uint64_t timestamp)
+{
+    Output input = shape(x, y);
+
+    if (!m_config.filter || (input.x == 0.0 && input.y == 0.0))
+    {
+        reset();
+        m_lag.record(0);
+        return input;
+    }
+
+    if (!m_primed)
+    {
+        m_primed = true;
+        m_timestamp = timestamp;
+        m_rawX = m_x = input.x;
+        m_rawY = m_y = input.y;
+        m_lag.record(0);
+        return input;
+    }
+
+    // mouse events only carry milliseconds, closer samples count as 1 ms apart
+    double dt = timestamp > m_timestamp ? (double)(timestamp - m_timestamp) / 1e6 : 0.0;
+    dt = std::max(dt, 1e-3);
+    m_timestamp = std::max(timestamp, m_timestamp);
+
+    // speed estimate, from the raw samples as the lag of the filtered position
+    // would inflate it
+    double alpha = smoothing(m_config.derivativeCutoff, dt);
+    m_dx += alpha * ((input.x - m_rawX) / dt - m_dx);
+    m_dy += alpha * ((input.y - m_rawY) / dt - m_dy);
+    m_rawX = input.x;
+    m_rawY = input.y;
+
+    // position, smoothed less the faster it moves
+    double cutoff = m_config.minCutoff + m_config.beta * std::hypot(m_dx, m_dy);
+    alpha = smoothing(cutoff, dt);
+    m_x += alpha * (input.x - m_x);
+    m_y += alpha * (input.y - m_y);
+
+    double lag = 1.0 / (2.0 * Pi * cutoff) - m_config.prediction;
+    m_lag.record(lag > 0 ? (uint64_t)(lag * 1e6) : 0);
+
+    return clampToCircle(m_x + m_dx * m_config.prediction, m_y + m_dy * m_config.prediction);
+}
@@ -0,0 +1,118 @@
+#ifndef INPUTCONDITIONER_H
+#define INPUTCONDITIONER_H
+
+#include <cstdint>
+
+#include "latencyhistogram.h"
+
+/**
+ * @brief The InputConditionerConfig struct
+ *      Shaping, smoothing and prediction of a two axis input
+ */
+struct InputConditionerConfig
+{
+    // radius below which the input is zero, the rest is rescaled to 0..1
+    double deadzone = 0.15;
+
+    // response curve exponent, 1 is linear, above 1 gives finer control near the centre
+    double exponent = 1.0;
+
+    // false passes the shaped input on unchanged, without filter or prediction
+    bool filter = true;
+
+    // One-Euro filter: cutoff in Hz of a resting input, its increase per unit/s of
+    // speed, and the cutoff of the speed estimate
+    double minCutoff = 5.0;
+    double beta = 1.0;
+    double derivativeCutoff = 5.0;
+
+    // seconds the filtered input is extrapolated along its speed, 0 for none
+    double prediction = 0.0;
+};
+
+/**
+ * @brief The InputConditioner class
+ *      Turns raw samples of a stick or pad, -1 to 1 on both axes, into setpoints: a
+ *      radial deadzone, a response curve, a One-Euro filter and a short prediction.
+ *
+ *      The One-Euro filter is a low-pass whose cutoff rises with the speed of the
+ *      input, so it removes jitter from a resting input and adds little lag to a fast
+ *      one. A low-pass with cutoff fc delays a slow input by about 1 / (2 pi fc); that
+ *      delay, less the prediction, is recorded for every sample in lag().
+ *
+ *      An input inside the deadzone comes out as zero at once and resets the filter.
+ *      As the filter only moves on new samples, an input that stopped moving is left
+ *      behind; once no sample came for SettleDelay ms, callers snap() it to the input.
+ *
+ *      Only depends on the standard library.
+ */
+class InputConditioner
+{
+public:
+    struct Output
+    {
+        double x;
+        double y;
+    };
+
+    // milliseconds without a new sample after which an input counts as still
+    static constexpr int SettleDelay = 20;
+
+    explicit InputConditioner(const InputConditionerConfig &config = InputConditionerConfig());
+
+    void setConfig(const InputConditionerConfig &config);
+    const InputConditionerConfig &config() const { return m_config; }
+
+    /**
+     * @brief condition
+     * @param timestamp - time of the sample in microseconds, on any monotonic clock
+     */
+    Output condition(double x, double y, uint64_t timestamp);
+
+    /**
+     * @brief shape
+     *      Deadzone and response curve only
+     */
+    Output shape(double x, double y) const;
+
+    void reset();
+
+    /**
+     * @brief settling
+     * @return true while the output has not caught up with the last sample
+     */
+    bool settling() const;
+
+    /**
+     * @brief snap
+     *      Moves the output onto the last sample at once, for an input that came to rest
+     * @return the new output
+     */
+    Output snap();
+
+    /**
+     * @brief lag
+     *      Estimated delay the filter added to each sample, in microseconds
+     */
+    const LatencyHistogram &lag() const { return m_lag; }
+
+private:
+    InputConditionerConfig m_config;
+
+    bool m_primed;
+    uint64_t m_timestamp;
+
+    // previous sample after shaping
+    double m_rawX;
+    double m_rawY;
+
+    // filtered position and speed
+    double m_x;
+    double m_y;
+    double m_dx;
+    double m_dy;
+
+    LatencyHistogram m_lag;
+};
+
+#endif // INPUTCONDITIONER_H
@@ -1,10 +1,45 @@
 #include "iwindows_xinput_wrapper.h"
 
-IWindows_XInput_Wrapper::IWindows_XInput_Wrapper(QObject *parent) : QObject(parent)
+#include <QThread>
+
+#include <chrono>
+#include <cstring>
+
+#ifndef CREATE_WAITABLE_TIMER_HIGH_RESOLUTION
+#define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION 0x00000002
+#endif
+
+// XInputGetState on an empty slot is slow, so disconnected slots are only
+// checked for a newly plugged in controller this often
+static const std::chrono::milliseconds RescanInterval(1000);
+
+// a controller can take a moment after its device interface arrives to show up in
+// XInput, so without one the slots are rescanned this long after every arrival
+static const std::chrono::milliseconds ArrivalScanTime(5000);
+
+IWindows_XInput_Wrapper::IWindows_XInput_Wrapper(QObject *parent) : GamepadInput(parent)
 {
     // Initialize function as NULL;
     XInputGetStateEx = NULL;
-    iTimer = NULL;
+    XInputSetState = NULL;
+
+    pollThread = NULL;
+    running = false;
+    pollInterval = 1000;
+
+    wakeEvent = NULL;
+    hotplug = NULL;
+}
+
+IWindows_XInput_Wrapper::~IWindows_XInput_Wrapper()
+{
+    Stop();
+}
+
+void IWindows_XInput_Wrapper::SetPollingRate(int Hz)
+{
+    Hz = qBound(1, Hz, 1000);
+    pollInterval = 1000000 / Hz;
 }
 
 void IWindows_XInput_Wrapper::Setup()
@@ -25,11 +60,6 @@ void IWindows_XInput_Wrapper::Setup()
     // get function from xinput dllXInputGetStateEx_t
     XInputGetStateEx = (XInputGetStateEx_t) GetProcAddress(xinputDll, "XInputGetState");
     XInputSetState = (XInputSetState_t) GetProcAddress(xinputDll, "XInputSetState");
-
-    // Create timer for polling
-    iTimer = new QTimer(this);
-    connect(iTimer, SIGNAL(timeout()), this, SLOT(XInput_Polling()));
-    iTimer->setInterval(50);
 }
 
 void IWindows_XInput_Wrapper::Start()
@@ -41,27 +71,69 @@ void IWindows_XInput_Wrapper::Start()
         return;
     }
 
-    // If there is a slot connected to our signal, we shall emit the signal for it
-    // If there is no slot connected, no reason to emit a signal;
-    bSendButtons = receivers(SIGNAL(ButtonPressed(short, QList<XboxOneButtons>))) > 0 ? true : false;
-    bSendLeftTrigger = receivers(SIGNAL(LeftTrigger(short , byte ))) > 0 ? true : false;
-    bSendRightTrigger = receivers(SIGNAL(RightTrigger(short , byte ))) > 0 ? true : false;
-    bSendLeftThumbstick = receivers(SIGNAL(LeftThumbStick(short , double , double ))) > 0 ? true : false;
-    bSendRightThumbstick = receivers(SIGNAL(RightThumbStick(short , double , double ))) > 0 ? true : false;
+    if (pollThread)
+        return;
+
+    // Without a hotplug notification the thread falls back to rescanning
+    // every RescanInterval while no controller is connected
+    wakeEvent = CreateEventW(NULL, FALSE, FALSE, NULL);
+
+    CM_NOTIFY_FILTER filter;
+    ZeroMemory(&filter, sizeof(filter));
+    filter.cbSize = sizeof(filter);
+    filter.Flags = CM_NOTIFY_FILTER_FLAG_ALL_INTERFACE_CLASSES;
+    filter.FilterType = CM_NOTIFY_FILTER_TYPE_DEVICEINTERFACE;
+
+    if (CM_Register_Notification(&filter, this, &IWindows_XInput_Wrapper::DeviceArrived, &hotplug) != CR_SUCCESS)
+        hotplug = NULL;
 
     // Start polling
-    iTimer->start();
+    running = true;
+    pollThread = QThread::create([this]() { XInput_Polling(); });
+    pollThread->start(QThread::HighestPriority);
 }
 
 void IWindows_XInput_Wrapper::Stop()
 {
-    if (!iTimer == true)
-    {
-        printf("Setup() was never called or has failed. Unable to stop IWindows_XInput_Wrapper, as it was never started nor Setup'd\n");
+    if (!pollThread)
         return;
-    }
 
-    iTimer->stop();
+    running = false;
+    if (wakeEvent)
+        SetEvent(wakeEvent);
+
+    pollThread->wait();
+
+    delete pollThread;
+    pollThread = NULL;
+
+    // waits for a callback in progress
+    if (hotplug)
+        CM_Unregister_Notification(hotplug);
+    hotplug = NULL;
+
+    if (wakeEvent)
+        CloseHandle(wakeEvent);
+    wakeEvent = NULL;
+}
+
+/**
+ * @brief IWindows_XInput_Wrapper::DeviceArrived
+ *      Called on a system thread for every device interface that arrives
+ */
+DWORD CALLBACK IWindows_XInput_Wrapper::DeviceArrived(HCMNOTIFICATION Notification, PVOID Context, CM_NOTIFY_ACTION Action,
+                                                      PCM_NOTIFY_EVENT_DATA EventData, DWORD EventDataSize)
+{
+    Q_UNUSED(Notification)
+    Q_UNUSED(EventData)
+    Q_UNUSED(EventDataSize)
+
+    IWindows_XInput_Wrapper *wrapper = static_cast<IWindows_XInput_Wrapper *>(Context);
+
+    if (Action == CM_NOTIFY_ACTION_DEVICEINTERFACEARRIVAL && wrapper->wakeEvent)
+        SetEvent(wrapper->wakeEvent);
+
+    return ERROR_SUCCESS;
 }
 
 void IWindows_XInput_Wrapper::VibrateController(short uID, WORD LeftMotorSpeed, WORD RightMotorSpeed)
@@ -82,99 +154,114 @@ void IWindows_XInput_Wrapper::VibrateController(short uID, WORD LeftMotorSpeed,
     XInputSetState( uID, &vibration );
 }
 
+/**
+ * @brief IWindows_XInput_Wrapper::XInput_Polling
+ *      Runs on the polling thread until Stop()
+ */
 void IWindows_XInput_Wrapper::XInput_Polling()
 {
-    XINPUT_STATE xState;
-
-    // Iterate over all possible controllers
-    for (int i = 0; i < XUSER_MAX_COUNT; i++)
-    {
-        // If a controller is connected, we can then get its state
-        if (XInputGetStateEx(i, &xState) == ERROR_SUCCESS)
-        {
-
-            if (bSendButtons)
-                TranslateButtons(i, xState.Gamepad.wButtons);
-            if (bSendLeftTrigger)
-                emit LeftTrigger(i, xState.Gamepad.bLeftTrigger);
-            if (bSendRightTrigger)
-                emit RightTrigger(i, xState.Gamepad.bRightTrigger);
-            if (bSendLeftThumbstick)
-                TranslateTriggers(i, xState.Gamepad.sThumbLX, xState.Gamepad.sThumbLY, X1_Left);
-            if (bSendRightThumbstick)
-                TranslateTriggers(i, xState.Gamepad.sThumbRX, xState.Gamepad.sThumbRY, XI_Right);
-        }
-    }
-
-}
-void IWindows_XInput_Wrapper::TranslateButtons(short uID, WORD bID)
-{
-    //wish I could iterate over enum, ah well
-    QList<XboxOneButtons> bPressed;
-
-    if ((X1_up & bID ) != 0)
-        bPressed.append(X1_up);
-
-    if ((X1_down & bID ) != 0)
-        bPressed.append(X1_down);
+    using Clock = std::chrono::steady_clock;
 
-    if ((X1_left & bID ) != 0)
-        bPressed.append(X1_left);
+    // Sleep() cannot wait less than a scheduler tick, a high resolution timer can
+    HANDLE timer = CreateWaitableTimerExW(NULL, NULL, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+    if (timer == NULL)
+        timer = CreateWaitableTimerExW(NULL, NULL, 0, TIMER_ALL_ACCESS);
 
-    if ((X1_right & bID ) != 0)
-        bPressed.append(X1_right);
+    GamepadState last[XUSER_MAX_COUNT];
+    Clock::time_point lastScan[XUSER_MAX_COUNT];
+    std::memset(last, 0, sizeof(last));
 
-    if ((X1_start & bID ) != 0)
-        bPressed.append(X1_start);
-
-    if ((X1_back & bID ) != 0)
-        bPressed.append(X1_back);
-
-    if ((X1_ltdown & bID ) != 0)
-        bPressed.append(X1_ltdown);
-
-    if ((X1_rtdown & bID ) != 0)
-        bPressed.append(X1_rtdown);
+    Clock::time_point next = Clock::now();
+    Clock::time_point arrival = next;
+    XINPUT_STATE xState;
 
-    if ((X1_rbump & bID ) != 0)
-        bPressed.append(X1_rbump);
+    HANDLE waits[2] = { wakeEvent, timer };
 
-    if ((X1_lbump & bID ) != 0)
-        bPressed.append(X1_lbump);
+    while (running)
+    {
+        Clock::time_point now = Clock::now();
+        bool anyConnected = false;
 
-    if ((X1_guide & bID ) != 0)
-        bPressed.append(X1_guide);
+        // Iterate over all possible controllers
+        for (int i = 0; i < XUSER_MAX_COUNT && i < MaxPads; i++)
+        {
+            if (!last[i].connected && now - lastScan[i] < RescanInterval)
+                continue;
+
+            lastScan[i] = now;
+
+            if (XInputGetStateEx(i, &xState) != ERROR_SUCCESS)
+            {
+                // report the controller as released once when it goes away
+                if (last[i].connected)
+                {
+                    std::memset(&last[i], 0, sizeof(last[i]));
+                    last[i].timestamp = std::chrono::duration_cast<std::chrono::microseconds>(now.time_since_epoch()).count();
+                    Publish(i, last[i]);
+                }
+                continue;
+            }
+
+            // Same packet number, nothing changed since the last poll
+            if (last[i].connected && xState.dwPacketNumber == last[i].packet)
+                continue;
+
+            last[i].connected = true;
+            last[i].packet = xState.dwPacketNumber;
+            last[i].buttons = xState.Gamepad.wButtons;
+            last[i].leftTrigger = xState.Gamepad.bLeftTrigger;
+            last[i].rightTrigger = xState.Gamepad.bRightTrigger;
+            last[i].thumbLX = xState.Gamepad.sThumbLX;
+            last[i].thumbLY = xState.Gamepad.sThumbLY;
+            last[i].thumbRX = xState.Gamepad.sThumbRX;
+            last[i].thumbRY = xState.Gamepad.sThumbRY;
+            last[i].timestamp = std::chrono::duration_cast<std::chrono::microseconds>(now.time_since_epoch()).count();
+
+            Publish(i, last[i]);
+        }
 
-    if ((X1_a & bID ) != 0)
-        bPressed.append(X1_a);
+        for (int i = 0; i < XUSER_MAX_COUNT && i < MaxPads; i++)
+            anyConnected = anyConnected || last[i].connected;
 
-    if ((X1_b & bID ) != 0)
-        bPressed.append(X1_b);
+        // nothing to poll: rescan for a while after starting or a device arrival,
+        // otherwise sleep until a device arrives or Stop()
+        if (!anyConnected)
+        {
+            DWORD timeout = (DWORD)RescanInterval.count();
+            if (hotplug && now - arrival >= ArrivalScanTime)
+                timeout = INFINITE;
+
+            if (WaitForSingleObject(wakeEvent, timeout) == WAIT_OBJECT_0)
+            {
+                arrival = Clock::now();
+                for (Clock::time_point &scan : lastScan)
+                    scan = Clock::time_point();
+            }
+
+            next = Clock::now();
+            continue;
+        }
 
-    if ((X1_x & bID ) != 0)
-        bPressed.append(X1_x);
+        // sleep until the next poll, without trying to catch up on missed ones
+        next += std::chrono::microseconds(pollInterval.load());
+        now = Clock::now();
 
-    if ((X1_y & bID ) != 0)
-        bPressed.append(X1_y);
+        if (next <= now)
+        {
+            next = now;
+            continue;
+        }
 
-    emit ButtonPressed(uID, bPressed);
+        LARGE_INTEGER due;
+        due.QuadPart = -(LONGLONG)(std::chrono::duration_cast<std::chrono::nanoseconds>(next - now).count() / 100);
 
-}
+        // Stop() cuts the wait short, so does a device arrival
+        if (timer && SetWaitableTimer(timer, &due, 0, NULL, NULL, FALSE))
+            WaitForMultipleObjects(2, waits, FALSE, INFINITE);
+        else
+            WaitForSingleObject(wakeEvent, (DWORD)std::chrono::duration_cast<std::chrono::milliseconds>(next - now).count());
+    }
 
-void IWindows_XInput_Wrapper::TranslateTriggers(short uID, short X, short Y, IWindows_XInput_Enum e)
-{
-    // Normalize values between -1.0 and 1.0
-    double normX = fmax(-1.0, (double) X / 32767.0);
-    double normY = fmax(-1.0, (double) Y / 32767.0);
-
-    // Factoring in deadzone
-    double StickX = (abs(normX) < deadzoneX ? 0 : normX);
-    double StickY = (abs(normY) < deadzoneY ? 0 : normY);
-
-    // Send signal to corrent thumbstick
-    /// TODO: can potentially simplify this to one function
-    if (e == X1_Left)
-        emit LeftThumbStick(uID, StickX, StickY);
-    if (e == XI_Right)
-        emit RightThumbStick(uID, StickX, StickY);
+    if (timer)
+        CloseHandle(timer);
 }
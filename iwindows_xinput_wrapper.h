@@ -1,11 +1,15 @@
 #ifndef IWINDOWS_XINPUT_WRAPPER_H
 #define IWINDOWS_XINPUT_WRAPPER_H
 
-#include <QObject>
 #include <qt_windows.h>
 #include <XInput.h>
+#include <cfgmgr32.h>
 
-#include <QTimer>
+#include <atomic>
+
+#include "gamepadinput.h"
+
+class QThread;
 
 /**
  * @brief DWORD
@@ -15,66 +19,27 @@
 typedef DWORD (__stdcall *XInputGetStateEx_t) (DWORD, XINPUT_STATE*);
 typedef DWORD (__stdcall *XInputSetState_t) (DWORD, XINPUT_VIBRATION *);
 
-enum IWindows_XInput_Enum
-{
-    X1_Left,
-    XI_Right
-};
-
 /**
- * @brief The XboxOneButtons enum
- *      As I only have an X1 controller, I am only using enum for the X1
+ * @brief The IWindows_XInput_Wrapper class
+ *      XInput backend of GamepadInput. XInput has no change notification, so all
+ *      controllers are polled on a dedicated thread; a poll whose packet number did
+ *      not change does no further work.
+ *
+ *      Without a controller nothing is polled: the thread sleeps until a device
+ *      interface arrives, and then looks for a controller for ArrivalScanTime.
  */
-enum XboxOneButtons
-{
-    X1_up = 1,
-    X1_down = 2,
-    X1_left = 4,
-    X1_right = 8,
-    X1_start = 16,
-    X1_back = 32,
-    X1_ltdown = 64,
-    X1_rtdown = 128,
-    X1_lbump = 256,
-    X1_rbump = 512,
-    X1_guide = 1024,
-
-    X1_a = 4096,
-    X1_b = 8192,
-    X1_x = 16384,
-    X1_y = 32768
-};
-
-class IWindows_XInput_Wrapper : public QObject
+class IWindows_XInput_Wrapper : public GamepadInput
 {
     Q_OBJECT
 public:
     explicit IWindows_XInput_Wrapper(QObject *parent = 0);
+    ~IWindows_XInput_Wrapper();
 
-signals:
-
-    /**
-     * @brief ButtonPressed
-     * @param uID - UserID
-     * @param PressedButtons - a list of all currently pressed buttons
-     */
-    void ButtonPressed(short uID, QList<XboxOneButtons> PressedButtons);
-    /**
-     * @brief LeftTrigger
-     * @param uID - UserID
-     * @param Value
-     */
-    void LeftTrigger(short uID, byte Value);
     /**
-     * @brief RightTrigger
-     * @param uID - UserID
-     * @param Value
+     * @brief SetPollingRate
+     * @param Hz - polls per second, 1 to 1000, default 1000
      */
-    void RightTrigger(short uID, byte Value);
-
-    void LeftThumbStick(short uID, double LX, double LY);
-
-    void RightThumbStick(short uID, double RX, double RY);
+    void SetPollingRate(int Hz) override;
 
 public slots:
 
@@ -83,72 +48,41 @@ public slots:
      *  This loads the library once.
      *  Not runned in constructor, in case of faulty coding loading multiple xinputs
      */
-    void Setup();
+    void Setup() override;
 
     /**
      * @brief Start
-     *  Starts the thread of this class
-     *  Also sets up what to send via signals
-     *      If you want to update signals, Stop and Start again
+     *  Starts the polling thread of this class
      */
-    void Start();
+    void Start() override;
 
     /**
      * @brief Stop
-     *  Stops main thread
+     *  Stops the polling thread
      */
-    void Stop();
+    void Stop() override;
 
     void VibrateController(short uID, WORD LeftMotorSpeed, WORD RightMotorSpeed);
 
-private slots:
-
+private:
     /**
      * @brief XInput_Polling
-     *  Main thread
+     *  Main loop of the polling thread
      */
     void XInput_Polling();
 
-    /**
-     * @brief TranslateButtons
-     * Determines which buttons are pressed, or if multiples are pressed
-     */
-    void TranslateButtons(short uID, WORD bID);
-
-    /**
-     * @brief TranslateTriggers
-     * @param uID - userID
-     * @param X - X param of stick
-     * @param Y - Y param of stick
-     * @param e - Should we translate Left or Right stick?
-     */
-    void TranslateTriggers(short uID, short X, short Y, IWindows_XInput_Enum e);
+    static DWORD CALLBACK DeviceArrived(HCMNOTIFICATION Notification, PVOID Context, CM_NOTIFY_ACTION Action,
+                                        PCM_NOTIFY_EVENT_DATA EventData, DWORD EventDataSize);
 
-private:
     XInputGetStateEx_t XInputGetStateEx;
     XInputSetState_t XInputSetState;
 
-    /**
-     * @brief - Tells loop which signals to emit
-     */
-    bool bSendButtons;
-    bool bSendLeftTrigger;
-    bool bSendRightTrigger;
-    bool bSendLeftThumbstick;
-    bool bSendRightThumbstick;
-
-    /**
-     * @brief iTimer - Timer for polling
-     */
-    QTimer * iTimer;
+    QThread *pollThread;
+    std::atomic<bool> running;
+    std::atomic<int> pollInterval;      // microseconds
 
-
-    /**
-     * @brief deadzoneX/Y
-     *      Specifies thumbstick deadzones
-     */
-    double deadzoneX = 0.15;
-    double deadzoneY = 0.15;
+    HANDLE wakeEvent;                   // set by Stop() and on device arrival
+    HCMNOTIFICATION hotplug;
 };
 
 #endif // IWINDOWS_XINPUT_WRAPPER_H
@@ -1,9 +1,13 @@
 #include "joypad.h"
 
+#include <QElapsedTimer>
 #include <QPainter>
+#include <QPaintEvent>
 #include <QParallelAnimationGroup>
 #include <QPropertyAnimation>
 #include <QMouseEvent>
+#include <QTimer>
+#include <QtMath>
 #include <math.h>
 #include <QDebug>
 
@@ -19,8 +23,25 @@ JoyPad::JoyPad(QWidget *parent) : QWidget(parent),
     m_returnAnimation(new QParallelAnimationGroup(this)),
     m_xAnimation(new QPropertyAnimation(this, "x")),
     m_yAnimation(new QPropertyAnimation(this, "y")),
-    m_alignment(Qt::AlignTop | Qt::AlignLeft)
+    m_settleTimer(new QTimer(this)),
+    m_alignment(Qt::AlignTop | Qt::AlignLeft),
+    knopPressed(false)
 {
+    setConditioning(InputConditionerConfig());
+
+    m_settleTimer->setSingleShot(true);
+    m_settleTimer->setInterval(InputConditioner::SettleDelay);
+    connect(m_settleTimer, &QTimer::timeout, this, &JoyPad::settle);
+
+    // the knob gradient is relative to the knob, so it never has to be rebuilt
+    QRadialGradient gradient(QPointF(0.5, 0.5), 0.5, QPointF(0.5, 0.5));
+    gradient.setCoordinateMode(QGradient::ObjectMode);
+    gradient.setColorAt(0, Qt::gray);
+    gradient.setColorAt(1, Qt::darkGray);
+    gradient.setFocalRadius(0.2);
+    gradient.setCenterRadius(0.5);
+    m_knobBrush = QBrush(gradient);
+
     m_xAnimation->setEndValue(0.f);
     m_xAnimation->setDuration(400);
     m_xAnimation->setEasingCurve(QEasingCurve::OutSine);
@@ -60,9 +81,8 @@ void JoyPad::setX(float value)
     m_x = constrain(value, -1.f, 1.f);
 
     qreal radius = ( m_bounds.width() - m_knopBounds.width() ) / 2;
-    m_knopBounds.moveCenter(QPointF(m_bounds.center().x() + m_x * radius, m_knopBounds.center().y()));
+    moveKnob(QPointF(m_bounds.center().x() + m_x * radius, m_knopBounds.center().y()));
 
-    update();
     emit xChanged(m_x);
 
     if (!this->knopPressed)
@@ -80,9 +100,8 @@ void JoyPad::setY(float value)
     m_y = constrain(value, -1.f, 1.f);
 
     qreal radius = ( m_bounds.width() - m_knopBounds.width() ) / 2;
-    m_knopBounds.moveCenter(QPointF(m_knopBounds.center().x(), m_bounds.center().y() - m_y * radius));
+    moveKnob(QPointF(m_knopBounds.center().x(), m_bounds.center().y() - m_y * radius));
 
-    update();
     emit yChanged(m_y);
 
     if (!this->knopPressed)
@@ -151,6 +170,38 @@ void JoyPad::setAlignment(Qt::Alignment f)
     m_alignment = f;
 }
 
+void JoyPad::setConditioning(const InputConditionerConfig &config)
+{
+    InputConditionerConfig knob = config;
+    knob.deadzone = 0;
+    knob.exponent = 1;
+
+    m_conditioner.setConfig(knob);
+}
+
+/**
+ * @brief JoyPad::moveKnob
+ * @param center of the knob in widget coordinates
+ */
+void JoyPad::moveKnob(const QPointF &center)
+{
+    QRect before = knobDirtyRect();
+    m_knopBounds.moveCenter(center);
+
+    update(before);
+    update(knobDirtyRect());
+}
+
+/**
+ * @brief JoyPad::knobDirtyRect
+ * @return pixels the antialiased knob and its outline may touch
+ */
+QRect JoyPad::knobDirtyRect() const
+{
+    int margin = qCeil(m_bounds.width() * 0.005) + 1;
+    return m_knopBounds.toAlignedRect().adjusted(-margin, -margin, margin, margin);
+}
+
 /**
  * @brief JoyPad::resizeEvent
  * @param event
@@ -199,20 +250,39 @@ void JoyPad::resizeEvent(QResizeEvent *event)
     // adjust knob position
     qreal radius = ( m_bounds.width() - m_knopBounds.width() ) / 2;
     m_knopBounds.moveCenter(QPointF(m_bounds.center().x() + m_x * radius, m_bounds.center().y() - m_y * radius));
+
+    renderBackground();
 }
 
 /**
- * @brief JoyPad::paintEvent
- * @param event
+ * @brief JoyPad::renderBackground
+ *
+ * draws the background ellipse and crosshair into a pixmap at the device pixel ratio
+ * of the screen, so repaints only copy it
  */
-void JoyPad::paintEvent(QPaintEvent *event)
+void JoyPad::renderBackground()
 {
-    Q_UNUSED(event)
+    qreal ratio = devicePixelRatioF();
 
-    QPainter painter(this);
+    m_background = QPixmap(size() * ratio);
+    m_background.setDevicePixelRatio(ratio);
+    m_background.fill(Qt::transparent);
+
+    if (m_bounds.isEmpty())
+        return;
+
+    QPainter painter(&m_background);
+    drawBackground(painter);
+}
+
+/**
+ * @brief JoyPad::drawBackground
+ * @param painter
+ */
+void JoyPad::drawBackground(QPainter &painter) const
+{
     painter.setRenderHint(QPainter::Antialiasing);
 
-    // draw background
     QRadialGradient gradient(m_bounds.center(), m_bounds.width()/2, m_bounds.center());
     gradient.setFocalRadius(m_bounds.width()*0.3);
     gradient.setCenterRadius(m_bounds.width()*0.7);
@@ -229,11 +299,22 @@ void JoyPad::paintEvent(QPaintEvent *event)
     painter.drawLine(QPointF(m_bounds.center().x() + m_bounds.width()*0.35, m_bounds.center().y()), QPointF(m_bounds.right(), m_bounds.center().y()));
     painter.drawLine(QPointF(m_bounds.center().x(), m_bounds.top()), QPointF(m_bounds.center().x(), m_bounds.center().y() - m_bounds.width()*0.35));
     painter.drawLine(QPointF(m_bounds.center().x(), m_bounds.center().y() + m_bounds.width()*0.35), QPointF(m_bounds.center().x(), m_bounds.bottom()));
+}
+
+/**
+ * @brief JoyPad::paintUncached
+ * @param painter
+ *
+ * everything a paint event drew before the background was cached: the background and
+ * a knob gradient built anew, over the whole widget
+ */
+void JoyPad::paintUncached(QPainter &painter) const
+{
+    drawBackground(painter);
 
-    // draw knob
     if (!this->isEnabled()) return;
 
-    gradient = QRadialGradient(m_knopBounds.center(), m_knopBounds.width()/2, m_knopBounds.center());
+    QRadialGradient gradient(m_knopBounds.center(), m_knopBounds.width()/2, m_knopBounds.center());
     gradient.setColorAt(0, Qt::gray);
     gradient.setColorAt(1, Qt::darkGray);
     gradient.setFocalRadius(m_knopBounds.width()*0.2);
@@ -244,6 +325,33 @@ void JoyPad::paintEvent(QPaintEvent *event)
     painter.drawEllipse(m_knopBounds);
 }
 
+/**
+ * @brief JoyPad::paintEvent
+ * @param event
+ *
+ * copies the exposed part of the cached background and draws the knob over it
+ */
+void JoyPad::paintEvent(QPaintEvent *event)
+{
+    // moved to a screen with another pixel ratio
+    if (m_background.devicePixelRatio() != devicePixelRatioF())
+        renderBackground();
+
+    QPainter painter(this);
+
+    QRect exposed = event->rect();
+    qreal ratio = m_background.devicePixelRatio();
+    painter.drawPixmap(exposed, m_background, QRectF(QPointF(exposed.topLeft()) * ratio, QSizeF(exposed.size()) * ratio));
+
+    // draw knob
+    if (!this->isEnabled() || !exposed.intersects(knobDirtyRect())) return;
+
+    painter.setRenderHint(QPainter::Antialiasing);
+    painter.setPen(QPen(QBrush(Qt::darkGray), m_bounds.width()*0.005));
+    painter.setBrush(m_knobBrush);
+    painter.drawEllipse(m_knopBounds);
+}
+
 /**
  * @brief JoyPad::mousePressEvent
  * @param event
@@ -253,7 +361,8 @@ void JoyPad::mousePressEvent(QMouseEvent *event)
     if (m_knopBounds.contains(event->pos()))
     {
         m_returnAnimation->stop();
-        m_lastPos = event->pos();
+        m_grabOffset = event->position() - m_knopBounds.center();
+        m_conditioner.reset();
         knopPressed = true;
     }
 }
@@ -267,38 +376,56 @@ void JoyPad::mouseReleaseEvent(QMouseEvent *event)
     Q_UNUSED(event)
 
     knopPressed = false;
+    m_settleTimer->stop();
     m_returnAnimation->start();
 }
 
 /**
  * @brief JoyPad::mouseMoveEvent
  * @param event
+ *
+ * the knob follows the point it was grabbed at, through the input conditioner
  */
 void JoyPad::mouseMoveEvent(QMouseEvent *event)
 {
     if (!knopPressed) return;
 
-    // moved distance
-    QPointF dPos = event->pos() - m_lastPos;
+    qreal radius = ( m_bounds.width() - m_knopBounds.width() ) / 2;
+    if (radius == 0) return;
 
-    // change the distance sligthly to guarantee overlaping knop and pointer
-    dPos += 0.05 * (event->pos() - m_knopBounds.center());
+    QPointF fromCenterToKnop = event->position() - m_grabOffset - m_bounds.center();
 
-    QPointF fromCenterToKnop = m_knopBounds.center() + dPos - m_bounds.center();
+    double rawX = constrain(fromCenterToKnop.x() / radius, -1.0, 1.0);
+    double rawY = constrain(-fromCenterToKnop.y() / radius, -1.0, 1.0);
 
-    qreal radius = ( m_bounds.width() - m_knopBounds.width() ) / 2;
+    // event timestamps are in milliseconds
+    followInput(m_conditioner.condition(rawX, rawY, (uint64_t)event->timestamp() * 1000));
+    m_settleTimer->start();
+}
 
-    fromCenterToKnop.setX(constrain(fromCenterToKnop.x(), -radius, radius));
-    fromCenterToKnop.setY(constrain(fromCenterToKnop.y(), -radius, radius));
+/**
+ * @brief JoyPad::settle
+ *
+ * the pointer stopped, the filter would only move on with the next mouse event
+ */
+void JoyPad::settle()
+{
+    if (knopPressed && m_conditioner.settling())
+        followInput(m_conditioner.snap());
+}
 
-    m_knopBounds.moveCenter(fromCenterToKnop + m_bounds.center());
-    m_lastPos = event->pos();
+/**
+ * @brief JoyPad::followInput
+ * @param conditioned - knob position, -1 to 1 on both axes
+ */
+void JoyPad::followInput(const InputConditioner::Output &conditioned)
+{
+    qreal radius = ( m_bounds.width() - m_knopBounds.width() ) / 2;
 
-    update();
+    moveKnob(QPointF(m_bounds.center().x() + conditioned.x * radius, m_bounds.center().y() - conditioned.y * radius));
 
-    if (radius == 0) return;
-    float x = ( m_knopBounds.center().x() - m_bounds.center().x() ) / radius;
-    float y = (-m_knopBounds.center().y() + m_bounds.center().y() ) / radius;
+    float x = conditioned.x;
+    float y = conditioned.y;
 
     if (m_x != x && m_y != y)
     {
@@ -317,3 +444,61 @@ void JoyPad::mouseMoveEvent(QMouseEvent *event)
         emit yChanged(m_y);
     }
 }
+
+/**
+ * @brief JoyPad::benchmarkPaint
+ * @param frames - knob positions around the pad
+ *
+ * before the background was cached every move repainted the whole widget with
+ * paintUncached(); now it copies the two knob rects from the cache
+ */
+void JoyPad::benchmarkPaint(int frames)
+{
+    JoyPad pad;
+    pad.resize(200, 200);
+
+    qreal ratio = pad.devicePixelRatioF();
+    QImage target(pad.size() * ratio, QImage::Format_ARGB32_Premultiplied);
+    target.setDevicePixelRatio(ratio);
+    target.fill(Qt::transparent);
+
+    // delivers the pending resize event
+    pad.render(&target);
+
+    QElapsedTimer timer;
+    qint64 uncached = 0;
+    qint64 full = 0;
+    qint64 moves = 0;
+
+    for (int i = 0; i < frames; i++)
+    {
+        timer.start();
+        {
+            QPainter painter(&target);
+            painter.setCompositionMode(QPainter::CompositionMode_Source);
+            painter.fillRect(pad.rect(), Qt::transparent);
+            painter.setCompositionMode(QPainter::CompositionMode_SourceOver);
+            pad.paintUncached(painter);
+        }
+        uncached += timer.nsecsElapsed();
+
+        timer.start();
+        pad.render(&target, QPoint(), QRegion(pad.rect()));
+        full += timer.nsecsElapsed();
+
+        QRect before = pad.knobDirtyRect();
+        pad.m_x = cos(i * 0.1);
+        pad.m_y = sin(i * 0.1);
+
+        qreal radius = ( pad.m_bounds.width() - pad.m_knopBounds.width() ) / 2;
+        pad.m_knopBounds.moveCenter(QPointF(pad.m_bounds.center().x() + pad.m_x * radius, pad.m_bounds.center().y() - pad.m_y * radius));
+
+        timer.start();
+        pad.render(&target, QPoint(), QRegion(before) + pad.knobDirtyRect());
+        moves += timer.nsecsElapsed();
+    }
+
+    if (frames > 0)
+        qInfo("joypad paint at %.1fx: uncached full %.1f us, cached full %.1f us, knob move %.1f us, average of %d frames",
+              ratio, uncached / 1000.0 / frames, full / 1000.0 / frames, moves / 1000.0 / frames, frames);
+}
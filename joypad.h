@@ -1,9 +1,15 @@
 #pragma once
 
+#include <QBrush>
+#include <QPixmap>
 #include <QWidget>
 
+#include "inputconditioner.h"
+
+class QPainter;
 class QPropertyAnimation;
 class QParallelAnimationGroup;
+class QTimer;
 
 class JoyPad : public QWidget
 {
@@ -38,6 +44,19 @@ public slots:
     */
     void setAlignment(Qt::Alignment f);
 
+    /*  Renders the widget off screen for each knob position of a circle around the
+     *  pad: with the paint routine that predates the cached background, in full from
+     *  the cache, and as a knob move. Logs the average time of each in microseconds.
+    */
+    static void benchmarkPaint(int frames);
+
+    /*  Filter and prediction of dragging the knob; the deadzone and response curve
+     *  are not used, the knob stays under the pointer. Once the pointer rests for
+     *  InputConditioner::SettleDelay ms the knob snaps onto it.
+    */
+    void setConditioning(const InputConditionerConfig &config);
+    const InputConditioner &conditioner() const { return m_conditioner; }
+
 private:
     void resizeEvent(QResizeEvent *event) override;
     virtual void paintEvent(QPaintEvent *event) override;
@@ -45,6 +64,21 @@ private:
     void mouseReleaseEvent(QMouseEvent *event) override;
     void mouseMoveEvent(QMouseEvent *event) override;
 
+    // Moves the knob and repaints the rects it left and entered
+    void moveKnob(const QPointF &center);
+    QRect knobDirtyRect() const;
+
+    // Moves the knob to a conditioned position and emits the changed coordinates
+    void followInput(const InputConditioner::Output &conditioned);
+    void settle();
+
+    // Draws the pad without the knob at the current device pixel ratio
+    void renderBackground();
+    void drawBackground(QPainter &painter) const;
+
+    // The paint routine from before the background was cached, the benchmark's baseline
+    void paintUncached(QPainter &painter) const;
+
     float m_x;
     float m_y;
 
@@ -56,7 +90,12 @@ private:
     QRectF m_bounds;
     QRectF m_knopBounds;
 
-    QPoint m_lastPos;
+    QPointF m_grabOffset;
+    InputConditioner m_conditioner;
+    QTimer *m_settleTimer;
+
+    QPixmap m_background;
+    QBrush m_knobBrush;
 
     Qt::Alignment m_alignment;
 
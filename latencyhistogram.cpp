@@ -0,0 +1,119 @@
+#include "latencyhistogram.h"
+
+#include <cstring>
+
+// index of the highest set bit, value must not be 0
+static int highestBit(uint64_t value)
+{
+    int bit = 0;
+
+    if (value >> 32) { value >>= 32; bit += 32; }
+    if (value >> 16) { value >>= 16; bit += 16; }
+    if (value >> 8) { value >>= 8; bit += 8; }
+    if (value >> 4) { value >>= 4; bit += 4; }
+    if (value >> 2) { value >>= 2; bit += 2; }
+    if (value >> 1) { bit += 1; }
+
+    return bit;
+}
+
+LatencyHistogram::LatencyHistogram()
+{
+    clear();
+}
+
+void LatencyHistogram::clear()
+{
+    std::memset(m_buckets, 0, sizeof(m_buckets));
+    m_count = 0;
+    m_sum = 0;
+    m_min = UINT64_MAX;
+    m_max = 0;
+}
+
+/**
+ * @brief LatencyHistogram::bucketIndex
+ *      Values below 16 get one bucket each, above that the top five bits of
+ *      the value select the power of two range and the sub-bucket within it
+ */
+int LatencyHistogram::bucketIndex(uint64_t value)
+{
+    if (value < (uint64_t)SubBucketCount)
+        return (int)value;
+
+    int bit = highestBit(value);
+    int shift = bit - SubBucketBits;
+
+    return (shift + 1) * SubBucketCount + (int)((value >> shift) & (SubBucketCount - 1));
+}
+
+uint64_t LatencyHistogram::bucketLower(int index)
+{
+    if (index < SubBucketCount)
+        return (uint64_t)index;
+
+    int shift = index / SubBucketCount - 1;
+    uint64_t sub = (uint64_t)(index % SubBucketCount);
+
+    return (SubBucketCount + sub) << shift;
+}
+
+uint64_t LatencyHistogram::bucketUpper(int index)
+{
+    if (index < SubBucketCount)
+        return (uint64_t)index;
+
+    int shift = index / SubBucketCount - 1;
+    return bucketLower(index) + (((uint64_t)1 << shift) - 1);
+}
+
+void LatencyHistogram::record(uint64_t value)
+{
+    m_buckets[bucketIndex(value)]++;
+    m_count++;
+    m_sum += value;
+
+    if (value < m_min)
+        m_min = value;
+    if (value > m_max)
+        m_max = value;
+}
+
+void LatencyHistogram::merge(const LatencyHistogram &other)
+{
+    for (int i = 0; i < BucketCount; i++)
+        m_buckets[i] += other.m_buckets[i];
+
+    m_count += other.m_count;
+    m_sum += other.m_sum;
+
+    if (other.m_min < m_min)
+        m_min = other.m_min;
+    if (other.m_max > m_max)
+        m_max = other.m_max;
+}
+
+uint64_t LatencyHistogram::percentile(double p) const
+{
+    if (m_count == 0)
+        return 0;
+
+    if (p >= 1.0)
+        return m_max;
+
+    uint64_t rank = (uint64_t)(p * (double)m_count) + 1;
+    uint64_t seen = 0;
+
+    for (int i = 0; i < BucketCount; i++)
+    {
+        seen += m_buckets[i];
+
+        if (seen >= rank)
+        {
+            uint64_t upper = bucketUpper(i);
+            return upper < m_max ? upper : m_max;
+        }
+    }
+
+    return m_max;
+}
@@ -0,0 +1,64 @@
+#ifndef LATENCYHISTOGRAM_H
+#define LATENCYHISTOGRAM_H
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief The LatencyHistogram class
+ *      Fixed size log-linear histogram of microsecond values. Every power of two range
+ *      is split into 16 linear sub-buckets, so any value is reported within 1/16 (about 6%)
+ *      of its true size, from 1 us up to the full uint64_t range, in under 8 KB.
+ *
+ *      record() is a handful of integer operations and never allocates. Only depends on
+ *      the standard library so the mock simulator and load generator can use it too.
+ */
+class LatencyHistogram
+{
+public:
+    static constexpr int SubBucketBits = 4;
+    static constexpr int SubBucketCount = 1 << SubBucketBits;
+    static constexpr int BucketCount = (64 - SubBucketBits + 1) * SubBucketCount;
+
+    LatencyHistogram();
+
+    void record(uint64_t value);
+    void clear();
+
+    /**
+     * @brief merge
+     *      Adds every value recorded by another histogram, e.g. to combine robots
+     */
+    void merge(const LatencyHistogram &other);
+
+    uint64_t count() const { return m_count; }
+    uint64_t min() const { return m_count ? m_min : 0; }
+    uint64_t max() const { return m_max; }
+    double mean() const { return m_count ? (double)m_sum / (double)m_count : 0.0; }
+
+    /**
+     * @brief percentile
+     * @param p - between 0 and 1, e.g. 0.999 for p99.9
+     * @return upper bound of the bucket holding the percentile, clamped to max()
+     */
+    uint64_t percentile(double p) const;
+
+    /**
+     * @brief bucketCount, bucketLower, bucketUpper
+     *      Raw buckets for exports; bucket i holds values in [bucketLower(i), bucketUpper(i)]
+     */
+    uint64_t bucketCount(int index) const { return m_buckets[index]; }
+    static uint64_t bucketLower(int index);
+    static uint64_t bucketUpper(int index);
+
+    static int bucketIndex(uint64_t value);
+
+private:
+    uint64_t m_buckets[BucketCount];
+    uint64_t m_count;
+    uint64_t m_sum;
+    uint64_t m_min;
+    uint64_t m_max;
+};
+
+#endif // LATENCYHISTOGRAM_H
@@ -0,0 +1,153 @@
+#include "latencypanel.h"
+
+#include <QContextMenuEvent>
+#include <QFile>
+#include <QFileDialog>
+#include <QLabel>
+#include <QMenu>
+#include <QMessageBox>
+#include <QTextStream>
+#include <QTimer>
+#include <QVBoxLayout>
+
+#include "latencytracker.h"
+
+// microseconds as a short human readable string
+static QString formatLatency(uint64_t us)
+{
+    if (us < 1000)
+        return QString("%1 us").arg(us);
+    if (us < 1000000)
+        return QString("%1 ms").arg(us / 1000.0, 0, 'f', 2);
+    return QString("%1 s").arg(us / 1000000.0, 0, 'f', 2);
+}
+
+LatencyPanel::LatencyPanel(QWidget *parent) : QFrame(parent),
+    m_tracker(nullptr),
+    m_label(new QLabel(this)),
+    m_refreshTimer(new QTimer(this)),
+    m_shown(0)
+{
+    QVBoxLayout *layout = new QVBoxLayout(this);
+    layout->setContentsMargins(6, 4, 6, 4);
+    layout->addWidget(m_label);
+
+    m_label->setAlignment(Qt::AlignLeft | Qt::AlignTop);
+    m_label->setFont(QFont("Consolas", 8));
+
+    m_refreshTimer->setSingleShot(true);
+    m_refreshTimer->setInterval(250);
+    connect(m_refreshTimer, &QTimer::timeout, this, &LatencyPanel::refresh);
+
+    setToolTip(tr("Command round trip latency, right click to reset or export"));
+}
+
+void LatencyPanel::setTracker(LatencyTracker *tracker)
+{
+    m_tracker = tracker;
+    refresh();
+}
+
+void LatencyPanel::trackerChanged()
+{
+    if (!m_tracker || !isVisible() || m_refreshTimer->isActive())
+        return;
+
+    if (m_tracker->histogram().count() + m_tracker->lost() != m_shown)
+        m_refreshTimer->start();
+}
+
+void LatencyPanel::refresh()
+{
+    if (!m_tracker)
+        return;
+
+    const LatencyHistogram &histogram = m_tracker->histogram();
+    m_shown = histogram.count() + m_tracker->lost();
+
+    if (histogram.count() == 0)
+    {
+        m_label->setText(tr("no acks yet"));
+        return;
+    }
+
+    m_label->setText(QString("p50   %1\np99   %2\np99.9 %3\nmax   %4\nn %5, lost %6")
+                     .arg(formatLatency(histogram.percentile(0.5)),
+                          formatLatency(histogram.percentile(0.99)),
+                          formatLatency(histogram.percentile(0.999)),
+                          formatLatency(histogram.max()))
+                     .arg(histogram.count())
+                     .arg(m_tracker->lost()));
+}
+
+bool LatencyPanel::exportTo(const QString &path) const
+{
+    if (!m_tracker)
+        return false;
+
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text))
+        return false;
+
+    const LatencyHistogram &histogram = m_tracker->histogram();
+    QTextStream out(&file);
+
+    out << "# count," << histogram.count() << "\n"
+        << "# lost," << m_tracker->lost() << "\n"
+        << "# unmatched," << m_tracker->unmatched() << "\n"
+        << "# mean_us," << histogram.mean() << "\n"
+        << "# p50_us," << histogram.percentile(0.5) << "\n"
+        << "# p99_us," << histogram.percentile(0.99) << "\n"
+        << "# p99.9_us," << histogram.percentile(0.999) << "\n"
+        << "# max_us," << histogram.max() << "\n"
+        << "lower_us,upper_us,count\n";
+
+    for (int i = 0; i < LatencyHistogram::BucketCount; i++)
+    {
+        if (histogram.bucketCount(i) == 0)
+            continue;
+
+        out << LatencyHistogram::bucketLower(i) << ','
+            << LatencyHistogram::bucketUpper(i) << ','
+            << histogram.bucketCount(i) << "\n";
+    }
+
+    return out.status() == QTextStream::Ok;
+}
+
+void LatencyPanel::showEvent(QShowEvent *event)
+{
+    Q_UNUSED(event)
+    refresh();
+}
+
+void LatencyPanel::hideEvent(QHideEvent *event)
+{
+    Q_UNUSED(event)
+    m_refreshTimer->stop();
+}
+
+void LatencyPanel::contextMenuEvent(QContextMenuEvent *event)
+{
+    if (!m_tracker)
+        return;
+
+    QMenu menu(this);
+    QAction *reset = menu.addAction(tr("Reset"));
+    QAction *save = menu.addAction(tr("Export..."));
+
+    QAction *chosen = menu.exec(event->globalPos());
+
+    if (chosen == reset)
+    {
+        m_tracker->clear();
+        refresh();
+    }
+    else if (chosen == save)
+    {
+        QString path = QFileDialog::getSaveFileName(this, tr("Export Latency Histogram"), "latency.csv", tr("CSV (*.csv)"));
+
+        if (!path.isEmpty() && !exportTo(path))
+            QMessageBox::warning(this, tr("Export Latency Histogram"), tr("Unable to write %1").arg(path));
+    }
+}
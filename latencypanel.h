@@ -0,0 +1,56 @@
+#ifndef LATENCYPANEL_H
+#define LATENCYPANEL_H
+
+#include <QFrame>
+
+#include <cstdint>
+
+class QLabel;
+class QTimer;
+class LatencyTracker;
+
+/**
+ * @brief The LatencyPanel class
+ *      Shows the command round trip percentiles of a LatencyTracker. While the panel is
+ *      visible the figures are refreshed after new acks, at most four times per second;
+ *      the context menu resets the histogram or exports it to a CSV file.
+ */
+class LatencyPanel : public QFrame
+{
+    Q_OBJECT
+
+public:
+    explicit LatencyPanel(QWidget *parent = nullptr);
+
+    void setTracker(LatencyTracker *tracker);
+
+    /**
+     * @brief exportTo
+     *      Writes the summary and every non-empty bucket as CSV
+     * @return false if the file could not be written
+     */
+    bool exportTo(const QString &path) const;
+
+public slots:
+    /**
+     * @brief trackerChanged
+     *      The tracker may have timed new acks
+     */
+    void trackerChanged();
+
+protected:
+    void showEvent(QShowEvent *event) override;
+    void hideEvent(QHideEvent *event) override;
+    void contextMenuEvent(QContextMenuEvent *event) override;
+
+private slots:
+    void refresh();
+
+private:
+    LatencyTracker *m_tracker;
+    QLabel *m_label;
+    QTimer *m_refreshTimer;
+    uint64_t m_shown;           // acks and losses in the figures shown
+};
+
+#endif // LATENCYPANEL_H
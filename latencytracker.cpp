@@ -0,0 +1,57 @@
+#include "latencytracker.h"
+
+#include <cstring>
+
+#include "commandframe.h"
+
+LatencyTracker::LatencyTracker()
+{
+    clear();
+}
+
+void LatencyTracker::clear()
+{
+    std::memset(m_pending, 0, sizeof(m_pending));
+    m_histogram.clear();
+    m_lost = 0;
+    m_unmatched = 0;
+}
+
+/**
+ * @brief LatencyTracker::sent
+ * @param sequence - sequence number of the frame
+ * @param timestamp - frame timestamp, CommandFrameEncoder::now() clock
+ */
+void LatencyTracker::sent(uint32_t sequence, uint64_t timestamp)
+{
+    Pending &slot = m_pending[sequence % PendingCapacity];
+
+    if (slot.timestamp != 0)
+        m_lost++;
+
+    slot.sequence = sequence;
+    slot.timestamp = timestamp;
+}
+
+/**
+ * @brief LatencyTracker::sample
+ *      Picks the "ack" field out of the telemetry stream
+ */
+void LatencyTracker::sample(const TelemetrySample &sample)
+{
+    if (sample.channel != "ack" || sample.value < 0)
+        return;
+
+    uint32_t sequence = (uint32_t)sample.value;
+    Pending &slot = m_pending[sequence % PendingCapacity];
+
+    if (slot.timestamp == 0 || slot.sequence != sequence)
+    {
+        m_unmatched++;
+        return;
+    }
+
+    uint64_t now = CommandFrameEncoder::now();
+    m_histogram.record(now > slot.timestamp ? now - slot.timestamp : 0);
+    slot.timestamp = 0;
+}
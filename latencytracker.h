@@ -0,0 +1,50 @@
+#ifndef LATENCYTRACKER_H
+#define LATENCYTRACKER_H
+
+#include <cstdint>
+
+#include "latencyhistogram.h"
+#include "telemetryparser.h"
+
+/**
+ * @brief The LatencyTracker class
+ *      Round trip latency of command frames. The sender reports every frame's sequence
+ *      number and timestamp through sent(); the simulator acknowledges a frame with an
+ *      "ack=<sequence>" field on the telemetry stream, and the time from the frame being
+ *      stamped to its ack being parsed goes into the histogram.
+ *
+ *      Pending frames live in a ring indexed by sequence; a frame that is not acked
+ *      before its slot is reused counts as lost.
+ */
+class LatencyTracker : public TelemetrySink
+{
+public:
+    static constexpr uint32_t PendingCapacity = 4096;
+
+    LatencyTracker();
+
+    void sent(uint32_t sequence, uint64_t timestamp);
+    void sample(const TelemetrySample &sample) override;
+
+    void clear();
+
+    const LatencyHistogram &histogram() const { return m_histogram; }
+
+    uint64_t lost() const { return m_lost; }
+    uint64_t unmatched() const { return m_unmatched; }
+
+private:
+    struct Pending
+    {
+        uint32_t sequence;
+        uint64_t timestamp;    // 0 once acked
+    };
+
+    Pending m_pending[PendingCapacity];
+    LatencyHistogram m_histogram;
+
+    uint64_t m_lost;
+    uint64_t m_unmatched;
+};
+
+#endif // LATENCYTRACKER_H
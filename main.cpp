@@ -1,10 +1,64 @@
 #include "mainwindow.h"
 #include <QApplication>
 
+#include "controlcore.h"
+#include "scriptdriver.h"
+
+static int runHeadless(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+    ClientOptions options = ClientOptions::parse(a.arguments());
+
+    ControlCore core(options);
+    ScriptDriver driver(&core);
+
+    // the run ends once the script, the timeline and the replay have all finished;
+    // standard input is only read when there is nothing else to run
+    bool script = !options.scriptPath.isEmpty() || (!core.timeline() && !core.replayer());
+    int running = (script ? 1 : 0) + (core.timeline() ? 1 : 0) + (core.replayer() ? 1 : 0);
+
+    auto done = [&a, &running]() {
+        if (--running == 0)
+            a.quit();
+    };
+
+    if (core.timeline())
+        QObject::connect(core.timeline(), &TimelineSequencer::finished, &a, done, Qt::QueuedConnection);
+
+    if (core.replayer())
+        QObject::connect(core.replayer(), &SessionReplayer::finished, &a, done, Qt::QueuedConnection);
+
+    if (script)
+    {
+        if (options.scriptPath.isEmpty())
+            driver.readStandardInput();
+        else if (!driver.open(options.scriptPath))
+            return 1;
+
+        QObject::connect(&driver, &ScriptDriver::finished, &a, done, Qt::QueuedConnection);
+        QObject::connect(&driver, &ScriptDriver::quitRequested, &a, &QCoreApplication::quit, Qt::QueuedConnection);
+        driver.start();
+    }
+
+    core.start();
+    return a.exec();
+}
+
 int main(int argc, char *argv[])
 {
+    if (ClientOptions::isHeadless(argc, argv))
+        return runHeadless(argc, argv);
+
     QApplication a(argc, argv);
-    MainWindow w;
+    ClientOptions options = ClientOptions::parse(a.arguments());
+
+    if (options.paintBenchmark > 0)
+    {
+        JoyPad::benchmarkPaint(options.paintBenchmark);
+        return 0;
+    }
+
+    MainWindow w(options);
     w.show();
     return a.exec();
 }
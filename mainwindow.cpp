@@ -3,27 +3,39 @@
 
 //---------------------------------- CONSTRUCTOR AND DESTRUCTOR ------------------------------------
 
-MainWindow::MainWindow(QWidget *parent)
+MainWindow::MainWindow(const ClientOptions &options, QWidget *parent)
     : QMainWindow(parent)
+    , options(options)
     , ui(new Ui::RoboUI)
 {
     ui->setupUi(this);
 
     QString windowTitle("RoboUI");
 
+    core = new ControlCore(options, this);
+
     initJoyPad();
     initVelocitySliders();
     initMovement();
     initArm();
     initHeight();
-    connectTCP0();
-    connectTCP1();
+    initConsole();
+    initPlot();
+    initLatency();
+    initRobotSelector();
     initSearchBar();
     initViews();
-    initXInputWrapper();
     initStopwatch();
     initWindowSwap();
 
+    // the widgets follow the robot state once per frame, not on every input
+    stateView = new RobotStateView(core, this);
+    connect(stateView, &RobotStateView::fieldShown, this, &MainWindow::showField);
+    connect(stateView, &RobotStateView::standingShown, this, &MainWindow::showStanding);
+    connect(core, &ControlCore::activeSessionChanged, this, &MainWindow::showSession);
+
+    core->start();
+
     this->setWindowTitle(windowTitle);
 }
 
@@ -32,6 +44,15 @@ MainWindow::MainWindow(QWidget *parent)
  */
 MainWindow::~MainWindow()
 {
+    const LatencyHistogram &joyPadLag = jPad->conditioner().lag();
+    if (joyPadLag.count() > 0)
+        qInfo("joypad filter lag: p50 %llu us, p99 %llu us, max %llu us over %llu samples",
+              (unsigned long long)joyPadLag.percentile(0.5),
+              (unsigned long long)joyPadLag.percentile(0.99),
+              (unsigned long long)joyPadLag.max(),
+              (unsigned long long)joyPadLag.count());
+
+    delete core;
     delete ui;
 }
 
@@ -45,11 +66,17 @@ void MainWindow::initJoyPad()
 {
     jPad = new JoyPad(this->ui->centralwidget);
     jPad->setGeometry(385, 345, 200, 200);
+    jPad->setConditioning(options.input);
     jPad->show();
 
-    connect(jPad, &JoyPad::xChanged, this, &MainWindow::xChanged);
-    connect(jPad, &JoyPad::yChanged, this, &MainWindow::yChanged);
-    connect(jPad, &JoyPad::xyChanged, this, &MainWindow::xyChanged);
+    // xChanged and yChanged always carry the current value, so they are all the
+    // coalescer needs; it sends one combined update per control tick
+    coalescer = new ControlCoalescer(this);
+    coalescer->setRate(100);
+
+    connect(jPad, &JoyPad::xChanged, coalescer, &ControlCoalescer::setX);
+    connect(jPad, &JoyPad::yChanged, coalescer, &ControlCoalescer::setY);
+    connect(coalescer, &ControlCoalescer::updated, this, &MainWindow::joyPadChanged);
 }
 
 /**
@@ -135,6 +162,11 @@ void MainWindow::initMovement()
 {
     connect(this->ui->trot, &QRadioButton::clicked, this, &MainWindow::trot);
     connect(this->ui->stand, &QRadioButton::clicked, this, &MainWindow::stand);
+
+    // which JoyPad axes move the body
+    connect(this->ui->thetaLock, &QRadioButton::clicked, core, [this]() { core->setPoseAxes(ControlCore::PoseAxes::Roll); });
+    connect(this->ui->omegaLock, &QRadioButton::clicked, core, [this]() { core->setPoseAxes(ControlCore::PoseAxes::Pitch); });
+    connect(this->ui->unlock, &QRadioButton::clicked, core, [this]() { core->setPoseAxes(ControlCore::PoseAxes::Both); });
 }
 
 /**
@@ -149,359 +181,254 @@ void MainWindow::initViews()
     connect(this->ui->side, &QRadioButton::clicked, this, &MainWindow::updateView);
 }
 
-/**
- * @brief MainWindow::initXInputWrapper
- */
-void MainWindow::initXInputWrapper()
-{
-    xWrapper = new IWindows_XInput_Wrapper;
-    xWrapper->Setup();
-
-    connect(xWrapper, &IWindows_XInput_Wrapper::ButtonPressed, this, &MainWindow::GetButtons);
-    connect(xWrapper, &IWindows_XInput_Wrapper::LeftThumbStick, this, &MainWindow::GetLeftThumbstick);
-    connect(xWrapper, &IWindows_XInput_Wrapper::RightThumbStick, this, &MainWindow::GetRightThumbstick);
-
-    xWrapper->Start();
-}
-
 /**
  * @brief MainWindow::initStopwatch
+ *      The clock is only redrawn while the window is shown, see showEvent()
  */
 void MainWindow::initStopwatch()
 {
     stopwatch = new QElapsedTimer;
 
-    poller = new QTimer;
+    poller = new QTimer(this);
     poller->setInterval(100);
 
     connect(poller, &QTimer::timeout, this, &MainWindow::updateTime);
 
     stopwatch->start();
-    poller->start();
-
 }
 
 /**
- * @brief MainWindow::initWindowSwap
+ * @brief MainWindow::initConsole
+ *      Replaces the designer text edit with the ring backed telemetry console
  */
-void MainWindow::initWindowSwap()
+void MainWindow::initConsole()
 {
-    secondaryWindow = new  XmlWindow();
-    windowPoller = new QTimer;
+    console = new TelemetryConsole(this->ui->textEdit->parentWidget());
+    console->setObjectName("console");
+    console->setGeometry(this->ui->textEdit->geometry());
+    console->setStyleSheet("QAbstractScrollArea#console\n"
+                           "{\n"
+                           "\tborder: 2px solid black;\n"
+                           "\tborder-radius: 10px;\n"
+                           "\tbackground-color: rgb(99, 99, 99);\n"
+                           "}");
 
-    connect(this->ui->windowSwap, &QPushButton::clicked, this, &MainWindow::swapWindows);
-    connect(windowPoller, &QTimer::timeout, this, &MainWindow::pendingWindow);
+    this->ui->textEdit->hide();
+    console->show();
 
-    windowPoller->start(10);
+    core->activeSession()->telemetry().addSink(console);
 }
-// ---------------------------------- SWAP WINDOWS ----------------------------------
 
 /**
- * @brief MainWindow::swapWindows
+ * @brief MainWindow::initPlot
+ *      Live plot of the telemetry store, below the console
  */
-void MainWindow::swapWindows()
+void MainWindow::initPlot()
 {
-    this->hide();
-    secondaryWindow->show();
-}
+    QRect area = this->ui->textEdit->geometry();
 
-void MainWindow::pendingWindow()
-{
-    if (!secondaryWindow->isVisible())
-        this->show();
-}
+    console->setGeometry(area.x(), area.y(), area.width(), 100);
 
-// ---------------------------------- TIME ----------------------------------
+    plot = new TelemetryPlot(this->ui->textEdit->parentWidget());
+    plot->setGeometry(area.x(), area.y() + 105, area.width(), area.height() - 105);
+    plot->setStore(&core->activeSession()->store());
+    plot->setTimeSpan(10);
+    connect(core->activeSession(), &RobotSession::telemetryUpdated, plot, &TelemetryPlot::storeChanged);
+    plot->show();
+}
 
 /**
- * @brief MainWindow::updateTime
+ * @brief MainWindow::initLatency
+ *      Command round trip percentiles, next to the console
  */
-void MainWindow::updateTime()
+void MainWindow::initLatency()
 {
-    this->ui->simTimeLCD->display((float)stopwatch->elapsed() / (float)1000);
+    latencyPanel = new LatencyPanel(this->ui->textEdit->parentWidget());
+    latencyPanel->setObjectName("latencyPanel");
+    latencyPanel->setGeometry(340, 50, 105, 75);
+    latencyPanel->setStyleSheet("QFrame#latencyPanel\n"
+                                "{\n"
+                                "\tborder: 2px solid black;\n"
+                                "\tborder-radius: 10px;\n"
+                                "\tbackground-color: rgb(99, 99, 99);\n"
+                                "}");
+    latencyPanel->setTracker(&core->activeSession()->latency());
+    connect(core->activeSession(), &RobotSession::telemetryUpdated, latencyPanel, &LatencyPanel::trackerChanged);
+    latencyPanel->show();
 }
 
-// ---------------------------------- COMMUNICATION ------------------------------------
-
 /**
- * @brief MainWindow::connectTCP
+ * @brief MainWindow::initRobotSelector
+ *      Chooses the robot shown in the console, plot and latency panel, and driven by
+ *      the keyboard and widgets. Only shown when there is more than one robot.
  */
-void MainWindow::connectTCP0()
+void MainWindow::initRobotSelector()
 {
-    _pSocket0 = new QTcpSocket(this);
-    _pSocket0->connectToHost("127.0.0.1", 9000);
+    robotSelector = new QComboBox(this->ui->textEdit->parentWidget());
+    robotSelector->setGeometry(340, 15, 105, 24);
+
+    int count = core->sessions().size();
+    for (int i = 0; i < count; i++)
+        robotSelector->addItem(QString("Robot %1 (%2)").arg(i).arg(options.robots.value(i).commandPort));
+
+    connect(robotSelector, QOverload<int>::of(&QComboBox::currentIndexChanged), core, &ControlCore::selectRobot);
+
+    robotSelector->setVisible(count > 1);
 }
 
 /**
- * @brief MainWindow::sendData
+ * @brief MainWindow::showSession
+ * @param session - now shown and driven by the widgets
  */
-void MainWindow::writeTCP0(std::string msg)
+void MainWindow::showSession(RobotSession *session)
 {
-    _pSocket0->write(msg.c_str(), qstrlen(msg.c_str()));
+    for (RobotSession *other : core->sessions())
+    {
+        other->telemetry().removeSink(console);
+        disconnect(other, &RobotSession::telemetryUpdated, plot, &TelemetryPlot::storeChanged);
+        disconnect(other, &RobotSession::telemetryUpdated, latencyPanel, &LatencyPanel::trackerChanged);
+    }
+
+    session->telemetry().addSink(console);
+    connect(session, &RobotSession::telemetryUpdated, plot, &TelemetryPlot::storeChanged);
+    connect(session, &RobotSession::telemetryUpdated, latencyPanel, &LatencyPanel::trackerChanged);
+
+    console->clear();
+    plot->setStore(&session->store());
+    latencyPanel->setTracker(&session->latency());
 }
 
 /**
- * @brief MainWindow::connectTCP
+ * @brief MainWindow::initWindowSwap
+ *      This window comes back when the secondary window is hidden, see eventFilter()
  */
-void MainWindow::connectTCP1()
+void MainWindow::initWindowSwap()
 {
-    _pSocket1 = new QTcpSocket(this);
-    connect(_pSocket1, &QTcpSocket::readyRead, this, &MainWindow::readTCP1);
-    _pSocket1->connectToHost("127.0.0.1", 8080);
+    secondaryWindow = new  XmlWindow();
+    secondaryWindow->installEventFilter(this);
+
+    connect(this->ui->windowSwap, &QPushButton::clicked, this, &MainWindow::swapWindows);
 }
+// ---------------------------------- SWAP WINDOWS ----------------------------------
 
 /**
- * @brief MainWindow::sendData
+ * @brief MainWindow::swapWindows
  */
-void MainWindow::writeTCP1(std::string msg)
+void MainWindow::swapWindows()
 {
-    _pSocket1->write(msg.c_str(), qstrlen(msg.c_str()));
+    this->hide();
+    secondaryWindow->show();
 }
 
 /**
- * @brief MainWindow::readTcpData
+ * @brief MainWindow::eventFilter
+ *      Shows this window again once the secondary window is closed or hidden by its
+ *      button. Spontaneous hides, e.g. minimizing, leave it visible.
  */
-void MainWindow::readTCP1()
+bool MainWindow::eventFilter(QObject *watched, QEvent *event)
 {
-    QByteArray data = _pSocket1->readAll();
-    this->ui->textEdit->setText(data);
+    if (watched == secondaryWindow && event->type() == QEvent::Hide && !event->spontaneous())
+        this->show();
+
+    return QMainWindow::eventFilter(watched, event);
 }
 
-// ---------------------------------- XBOX CONTROLLER SLOT ----------------------------------
+// ---------------------------------- TIME ----------------------------------
 
 /**
- * @brief MainWindow::GetButtons
- * @param uID
- * @param PressedButtons
+ * @brief MainWindow::updateTime
  */
-void MainWindow::GetButtons(short uID, QList<XboxOneButtons> PressedButtons)
+void MainWindow::updateTime()
 {
-    Q_UNUSED(uID);
-
-    std::string data;
-
-    if (!this->ui->stand->isChecked())
-    {
-        if (PressedButtons.contains(XboxOneButtons::X1_up))
-        {
-            data = "X2.00000";
-            writeTCP0(data);
-            this->ui->vxLCD->display(2.00);
-            this->ui->vxSlider->setValue(99);
-        }
-        else if (PressedButtons.contains(XboxOneButtons::X1_down))
-        {
-            data = "X-2.0000";
-            this->ui->vxLCD->display(-2.00);
-            this->ui->vxSlider->setValue(-99);
-            writeTCP0(data);
-        }
-        else if (PressedButtons.contains(XboxOneButtons::X1_left))
-        {
-            data = "Y1.0000";
-            writeTCP0(data);
-            this->ui->vyLCD->display(-1.00);
-            this->ui->vySlider->setValue(-99);
-        }
-        else if(PressedButtons.contains(XboxOneButtons::X1_right))
-        {
-            data = "Y-1.00000";
-            writeTCP0(data);
-            this->ui->vyLCD->display(1.00);
-            this->ui->vySlider->setValue(99);
-        }
-        else if (PressedButtons.contains(XboxOneButtons::X1_a))
-        {
-            data = "Y0.00000";
-            this->ui->vyLCD->display(0);
-            this->ui->vySlider->setValue(0);
-            writeTCP0(data);
-        }
-        else if (PressedButtons.contains(XboxOneButtons::X1_x))
-        {
-            data = "X0.00000";
-            this->ui->vxLCD->display(0);
-            this->ui->vxSlider->setValue(0);
-            writeTCP0(data);
-        }
-    }
-    else
-    {
-        if (PressedButtons.contains(XboxOneButtons::X1_up))
-           up();
-        else if (PressedButtons.contains(XboxOneButtons::X1_down))
-            down();
-
-        if (PressedButtons.contains(XboxOneButtons::X1_x))
-            setGripP();
-        else if (PressedButtons.contains(XboxOneButtons::X1_a))
-            setGripN();
-    }
+    this->ui->simTimeLCD->display((float)stopwatch->elapsed() / (float)1000);
 }
 
 /**
- * @brief MainWindow::GetLeftThumbstick
- * @param uID
- * @param x
- * @param y
+ * @brief MainWindow::showEvent
+ *      Nothing redraws the clock while the window is hidden or minimized
  */
-void MainWindow::GetLeftThumbstick(short uID, double x, double y)
+void MainWindow::showEvent(QShowEvent *event)
 {
-    Q_UNUSED(uID);
-    Q_UNUSED(x);
-
-    if (!this->ui->stand->isChecked())
-    {
-        if (y != 0)
-        {
-            // combine y position into a string
-            std::string data = "P";
-            data.append(std::to_string(y));
-
-            // send the current position
-            writeTCP0(data);
-            this->ui->thetaLCD->display(y);
-        }
-        else if (y == 0 && this->ui->thetaLCD->value() != (double)0 && !jPad->knopPressed)
-        {
-            std::string data = "P0.00000";
-            writeTCP0(data);
-            this->ui->thetaLCD->display(0);
-        }
-    }
-    else
-    {
-        if (x >= .15)
-            setArmLRP();
-        else if (x <= -.15)
-            setArmLRN();
-
-        if (y >= .15)
-            setArmExtensionP();
-        else if (y <= -.15)
-            setArmExtensionN();
-    }
+    QMainWindow::showEvent(event);
+    updateTime();
+    poller->start();
 }
 
-/**
- * @brief MainWindow::GetRightThumbstick
- * @param uID
- * @param x
- * @param y
- */
-void MainWindow::GetRightThumbstick(short uID, double x, double y)
+void MainWindow::hideEvent(QHideEvent *event)
 {
-    Q_UNUSED(uID);
-    Q_UNUSED(y);
-
-    if (!this->ui->stand->isChecked())
-    {
-        if (x != 0)
-        {
-            // combine x position into a string
-            std::string data = "R";
-            data.append(std::to_string(x));
-
-            // send the current position
-            writeTCP0(data);
-            this->ui->omegaLCD->display(x);
-        }
-        else if (x == 0 && this->ui->omegaLCD->value() != (double)0 && !jPad->knopPressed)
-        {
-            std::string data = "R0.00000";
-            writeTCP0(data);
-            this->ui->omegaLCD->display(0);
-        }
-    }
-    else
-    {
-        if (x >= .15)
-            setGripAngleP();
-        else if (x <= -.15)
-            setGripAngleN();
-
-        if (y >= .15)
-            setArmHeightP();
-        else if (y <= -.15)
-            setArmHeightN();
-    }
+    QMainWindow::hideEvent(event);
+    poller->stop();
 }
 
-// ---------------------------------- KEYPRESS SLOT ------------------------------------
+// ---------------------------------- DISPLAY ------------------------------------
 
 /**
- * @brief MainWindow::keyPressEvent
- * @param k
+ * @brief MainWindow::showField
+ *      Shows a change of the active robot's desired state, whichever input made it
  */
-void MainWindow::keyPressEvent( QKeyEvent *k )
+void MainWindow::showField(RobotField field, float value)
 {
-    std::string data = "";
-
-    switch ( k->key() )
+    switch (field)
     {
-    case Qt::Key_W:
-        data = "X2.00000";
-        writeTCP0(data);
-        this->ui->vxLCD->display(2.00);
-        this->ui->vxSlider->setValue(99);
+    case RobotField::VelocityX:
+        this->ui->vxLCD->display(value);
+        this->ui->vxSlider->setValue(qRound(value * 48.5f));
         break;
 
-    case Qt::Key_S:
-        data = "X-2.0000";
-        this->ui->vxLCD->display(-2.00);
-        this->ui->vxSlider->setValue(-99);
-        writeTCP0(data);
+    case RobotField::VelocityY:
+        this->ui->vyLCD->display(-value);
+        this->ui->vySlider->setValue(qRound(-value * 97.f));
         break;
 
-    case Qt::Key_A:
-        data = "Y1.0000";
-        writeTCP0(data);
-        this->ui->vyLCD->display(-1.00);
-        this->ui->vySlider->setValue(-99);
+    case RobotField::Pitch:
+        this->ui->thetaLCD->display(value);
         break;
 
-    case Qt::Key_D:
-        data = "Y-1.00000";
-        writeTCP0(data);
-        this->ui->vyLCD->display(1.00);
-        this->ui->vySlider->setValue(99);
+    case RobotField::Roll:
+        this->ui->omegaLCD->display(value);
         break;
 
-    case Qt::Key_Q:
-        data = "D0.00000";
-        writeTCP0(data);
+    default:
         break;
+    }
+}
 
-    case Qt::Key_E:
-        data = "U0.00000";
-        writeTCP0(data);
-        break;
+/**
+ * @brief MainWindow::showStanding
+ *      The arm buttons only work while standing
+ */
+void MainWindow::showStanding(bool standing)
+{
+    int i = 0;
 
-    case Qt::Key_V:
-        data = "X0.00000";
-        this->ui->vxLCD->display(0);
-        this->ui->vxSlider->setValue(0);
-        writeTCP0(data);
-        break;
+    this->ui->stand->setChecked(standing);
+    this->ui->trot->setChecked(!standing);
 
-    case Qt::Key_B:
-        data = "Y0.00000";
-        this->ui->vyLCD->display(0);
-        this->ui->vySlider->setValue(0);
-        writeTCP0(data);
-        break;
+    foreach(QAbstractButton *button, armControls->buttons())
+    {
+        button->setDisabled(!standing);
+        ((QPushButton*)button)->setFlat(!standing);
 
-    case Qt::Key_R:
-        stand();
-        break;
+        if (!standing)
+            button->setText("");
+        else if (i % 2 == 0)
+            button->setText("+");
+        else
+            button->setText("-");
+        i++;
+    }
+}
 
-    case Qt::Key_T:
-        trot();
-        break;
+// ---------------------------------- KEYPRESS SLOT ------------------------------------
 
-    default:
-        break;
-    }
+/**
+ * @brief MainWindow::keyPressEvent
+ * @param k
+ */
+void MainWindow::keyPressEvent( QKeyEvent *k )
+{
+    if (!core->handleKey(k->key()))
+        QMainWindow::keyPressEvent(k);
 }
 
 // ---------------------------------- SEARCH SLOT ------------------------------------
@@ -511,9 +438,10 @@ void MainWindow::keyPressEvent( QKeyEvent *k )
  */
 void MainWindow::sensorSearch()
 {
-    std::string data = "I";
-    data.append(this->ui->searchBar->text().toStdString());
-    writeTCP0(data);
+    if (!core->sensorSearch(this->ui->searchBar->text()))
+        QToolTip::showText(this->ui->searchBar->mapToGlobal(QPoint(0, this->ui->searchBar->height())),
+                           QString("At most %1 bytes fit a search").arg(CommandFrameFormat::PayloadSize),
+                           this->ui->searchBar);
 }
 
 // ---------------------------------- VIEW SLOT ------------------------------------
@@ -523,79 +451,36 @@ void MainWindow::sensorSearch()
  */
 void MainWindow::updateView()
 {
-    std::string data = "V";
+    float view;
 
     if (this->ui->front->isChecked())
-        data.append("1.00000");
+        view = 1.f;
     else if (this->ui->back->isChecked())
-        data.append("2.00000");
+        view = 2.f;
     else if (this->ui->top->isChecked())
-        data.append("3.00000");
+        view = 3.f;
     else if (this->ui->side->isChecked())
-        data.append("4.00000");
+        view = 4.f;
     else
-        data.append("5.00000");
+        view = 5.f;
 
-    writeTCP0(data);
+    core->setView(view);
 }
 
 // ---------------------------------- JOYPAD SLOTS ------------------------------------
 
 /**
- * @brief MainWindow::xChanged
- */
-void MainWindow::xChanged()
-{
-    if (this->ui->thetaLock->isChecked())
-    {
-        // combine x position into a string
-        std::string data = "";
-        data.push_back('R');
-        data.append(std::to_string(jPad->x()));
-
-        // send the current position
-        writeTCP0(data);
-        this->ui->omegaLCD->display(jPad->x());
-    }
-}
-
-/**
- * @brief MainWindow::yChanged
- */
-void MainWindow::yChanged()
-{
-    if (this->ui->omegaLock->isChecked())
-    {
-        // combine y position into a string
-        std::string data = "";
-        data.push_back('P');
-        data.append(std::to_string(jPad->y()));
-
-        // send the current position
-        writeTCP0(data);
-        this->ui->thetaLCD->display(jPad->y());
-    }
-}
-
-/**
- * @brief MainWindow::xyChanged
+ * @brief MainWindow::joyPadChanged
+ *      Receives at most one coalesced update per control tick
+ * @param x
+ * @param y
+ * @param xChanged
+ * @param yChanged
  */
-void MainWindow::xyChanged()
+void MainWindow::joyPadChanged(float x, float y, bool xChanged, bool yChanged)
 {
-    if (this->ui->unlock->isChecked())
-    {
-        // combine xy position into a string
-        std::string data = "";
-        data.push_back('C');
-        data.append(std::to_string(jPad->x()));
-        data.push_back(',');
-        data.append(std::to_string(jPad->y()));
-
-        // send the current position
-        writeTCP0(data);
-        this->ui->omegaLCD->display(jPad->x());
-        this->ui->thetaLCD->display(jPad->y());
-    }
+    core->setPoseHeld(jPad->knopPressed);
+    core->setPose(x, y, xChanged, yChanged);
 }
 
 // ---------------------------------- VELOCITY SLIDER SLOTS ------------------------------------
@@ -605,11 +490,7 @@ void MainWindow::xyChanged()
  */
 void MainWindow::setVelocityX()
 {
-    std::string data = "X";
-    double vx = (double)this->ui->vxSlider->value() / (double)48.5;
-    data.append(std::to_string(vx));
-    writeTCP0(data);
-    this->ui->vxLCD->display(vx);
+    core->setVelocityX((float)this->ui->vxSlider->value() / 48.5f);
 }
 
 /**
@@ -617,11 +498,7 @@ void MainWindow::setVelocityX()
  */
 void MainWindow::setVelocityY()
 {
-    std::string data = "Y";
-    double vy = (double)-1 * (double)(this->ui->vySlider->value() / (double)97);
-    data.append(std::to_string(vy));
-    writeTCP0(data);
-    this->ui->vyLCD->display(-1 * vy);
+    core->setVelocityY(-(float)this->ui->vySlider->value() / 97.f);
 }
 
 /**
@@ -629,10 +506,7 @@ void MainWindow::setVelocityY()
  */
 void MainWindow::resetX()
 {
-    std::string data = "X0.00000";
-    writeTCP0(data);
-    this->ui->vxSlider->setValue(0);
-    this->ui->vxLCD->display(0.00);
+    core->setVelocityX(0.f);
 }
 
 /**
@@ -640,10 +514,7 @@ void MainWindow::resetX()
  */
 void MainWindow::resetY()
 {
-    std::string data = "Y0.00000";
-    writeTCP0(data);
-    this->ui->vySlider->setValue(0);
-    this->ui->vyLCD->display(0.00);
+    core->setVelocityY(0.f);
 }
 
 // ---------------------------------- HEIGHT SLOTS ------------------------------------
@@ -653,8 +524,7 @@ void MainWindow::resetY()
  */
 void MainWindow::up()
 {
-    std::string data = "U0.00000";
-    writeTCP0(data);
+    core->nudge(RobotField::Height, 1);
 }
 
 /**
@@ -662,8 +532,7 @@ void MainWindow::up()
  */
 void MainWindow::down()
 {
-    std::string data = "D0.00000";
-    writeTCP0(data);
+    core->nudge(RobotField::Height, -1);
 }
 
 // ---------------------------------- MOVEMENT SLOTS ------------------------------------
@@ -673,22 +542,7 @@ void MainWindow::down()
  */
 void MainWindow::stand()
 {
-    int i = 0;
-
-    foreach(QAbstractButton *button, armControls->buttons())
-    {
-        button->setDisabled(false);
-        ((QPushButton*)button)->setFlat(false);
-
-        if (i % 2 == 0)
-            button->setText("+");
-        else
-            button->setText("-");
-        i++;
-    }
-
-    std::string data = "S0.00000";
-    writeTCP0(data);
+    core->stand();
 }
 
 /**
@@ -696,15 +550,7 @@ void MainWindow::stand()
  */
 void MainWindow::trot()
 {
-    foreach(QAbstractButton *button, armControls->buttons())
-    {
-        button->setDisabled(true);
-        ((QPushButton*)button)->setFlat(true);
-        button->setText("");
-    }
-
-    std::string data = "T1.00000";
-    writeTCP0(data);
+    core->trot();
 }
 
 // ---------------------------------- ARM SLOTS ------------------------------------
@@ -714,8 +560,7 @@ void MainWindow::trot()
  */
 void MainWindow::setArmLRP()
 {
-    std::string data = "00.00000";
-    writeTCP0(data);
+    core->nudge(RobotField::ArmRotate, 1);
 }
 
 /**
@@ -723,8 +568,7 @@ void MainWindow::setArmLRP()
  */
 void MainWindow::setArmLRN()
 {
-    std::string data = "10.00000";
-    writeTCP0(data);
+    core->nudge(RobotField::ArmRotate, -1);
 }
 
 /**
@@ -732,8 +576,7 @@ void MainWindow::setArmLRN()
  */
 void MainWindow::setArmExtensionP()
 {
-    std::string data = "20.00000";
-    writeTCP0(data);
+    core->nudge(RobotField::ArmExtend, 1);
 }
 
 /**
@@ -741,8 +584,7 @@ void MainWindow::setArmExtensionP()
  */
 void MainWindow::setArmExtensionN()
 {
-    std::string data = "30.00000";
-    writeTCP0(data);
+    core->nudge(RobotField::ArmExtend, -1);
 }
 
 /**
@@ -750,8 +592,7 @@ void MainWindow::setArmExtensionN()
  */
 void MainWindow::setArmHeightP()
 {
-    std::string data = "40.00000";
-    writeTCP0(data);
+    core->nudge(RobotField::ArmHeight, 1);
 }
 
 /**
@@ -759,8 +600,7 @@ void MainWindow::setArmHeightP()
  */
 void MainWindow::setArmHeightN()
 {
-    std::string data = "50.00000";
-    writeTCP0(data);
+    core->nudge(RobotField::ArmHeight, -1);
 }
 
 /**
@@ -768,8 +608,7 @@ void MainWindow::setArmHeightN()
  */
 void MainWindow::setGripAngleP()
 {
-    std::string data = "60.00000";
-    writeTCP0(data);
+    core->nudge(RobotField::GripAngle, 1);
 }
 
 /**
@@ -777,8 +616,7 @@ void MainWindow::setGripAngleP()
  */
 void MainWindow::setGripAngleN()
 {
-    std::string data = "70.00000";
-    writeTCP0(data);
+    core->nudge(RobotField::GripAngle, -1);
 }
 
 /**
@@ -786,8 +624,7 @@ void MainWindow::setGripAngleN()
  */
 void MainWindow::setGripP()
 {
-    std::string data = "80.00000";
-    writeTCP0(data);
+    core->nudge(RobotField::Grip, 1);
 }
 
 /**
@@ -795,6 +632,5 @@ void MainWindow::setGripP()
  */
 void MainWindow::setGripN()
 {
-    std::string data = "90.00000";
-    writeTCP0(data);
+    core->nudge(RobotField::Grip, -1);
 }
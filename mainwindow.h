@@ -9,12 +9,17 @@
 #include <string>
 #include <iostream>
 #include <fstream>
-#include <windows.h>
-#include <xinput.h>
-#include <unistd.h>
 
-#include "iwindows_xinput_wrapper.h"
 #include "joypad.h"
+#include "clientoptions.h"
+#include "controlcoalescer.h"
+#include "controlcore.h"
+#include "latencypanel.h"
+#include "robotcommandstate.h"
+#include "robotsession.h"
+#include "robotstateview.h"
+#include "telemetryconsole.h"
+#include "telemetryplot.h"
 
 #include <xmlwindow.h>
 
@@ -27,25 +32,27 @@ class MainWindow : public QMainWindow
     Q_OBJECT
 
 public:
-    MainWindow(QWidget *parent = nullptr);
+    MainWindow(const ClientOptions &options, QWidget *parent = nullptr);
     ~MainWindow();
 
 private:
-    QTcpSocket *_pSocket0;
-    QTcpSocket *_pSocket1;
+    ClientOptions options;
+    ControlCore *core;
+    RobotStateView *stateView;
+    QComboBox *robotSelector;
+    TelemetryConsole *console;
+    TelemetryPlot *plot;
+    LatencyPanel *latencyPanel;
     JoyPad *jPad;
+    ControlCoalescer *coalescer;
     QElapsedTimer *stopwatch;
     QTimer *poller;
-    IWindows_XInput_Wrapper * xWrapper;
     QButtonGroup *armControls;
     XmlWindow *secondaryWindow;
-    QTimer *windowPoller;
 
 
 private slots:
-    void xChanged();
-    void yChanged();
-    void xyChanged();
+    void joyPadChanged(float x, float y, bool xChanged, bool yChanged);
 
     void setVelocityX();
     void setVelocityY();
@@ -75,14 +82,18 @@ private slots:
 
     void keyPressEvent(QKeyEvent *event);
 
-    void GetButtons(short uID, QList<XboxOneButtons> PressedButtons);
-    void GetLeftThumbstick(short, double x, double y);
-    void GetRightThumbstick(short uID, double, double y);
-
     void updateTime();
 
+    void showField(RobotField field, float value);
+    void showStanding(bool standing);
+    void showSession(RobotSession *session);
+
     void swapWindows();
-    void pendingWindow();
+
+protected:
+    bool eventFilter(QObject *watched, QEvent *event) override;
+    void showEvent(QShowEvent *event) override;
+    void hideEvent(QHideEvent *event) override;
 
 private:
     Ui::RoboUI *ui;
@@ -94,14 +105,11 @@ private:
     void initMovement();
     void initSearchBar();
     void initViews();
-    void initXInputWrapper();
     void initStopwatch();
     void initWindowSwap();
-
-    void connectTCP0();
-    void writeTCP0(std::string);
-    void connectTCP1();
-    void readTCP1();
-    void writeTCP1(std::string);
+    void initConsole();
+    void initPlot();
+    void initLatency();
+    void initRobotSelector();
 };
 #endif // MAINWINDOW_H
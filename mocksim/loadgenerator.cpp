@@ -0,0 +1,331 @@
+#include "loadgenerator.h"
+
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTcpSocket>
+#include <QThread>
+#include <QTimer>
+
+LoadGenerator::LoadGenerator(const Settings &settings, QObject *parent) : QObject(parent),
+    m_settings(settings),
+    m_connected(0),
+    m_sendTimer(new QTimer(this)),
+    m_sendTime(0),
+    m_cpuStart(0)
+#ifdef Q_OS_LINUX
+    , m_shmThread(nullptr)
+#endif
+{
+    for (int i = 0; i < m_settings.robots; i++)
+    {
+        std::unique_ptr<Link> link(new Link);
+        link->commandSocket = new QTcpSocket(this);
+        link->telemetrySocket = new QTcpSocket(this);
+        link->parser.addSink(&link->latency);
+
+        Link *raw = link.get();
+        connect(raw->telemetrySocket, &QTcpSocket::readyRead, this, [this, raw]() { readTelemetry(raw); });
+
+        m_links.push_back(std::move(link));
+    }
+
+    m_sendTimer->setTimerType(Qt::PreciseTimer);
+    connect(m_sendTimer, &QTimer::timeout, this, &LoadGenerator::sendCommands);
+}
+
+LoadGenerator::~LoadGenerator()
+{
+#ifdef Q_OS_LINUX
+    if (m_shmThread)
+    {
+        m_shmThread->wait();
+        delete m_shmThread;
+    }
+#endif
+}
+
+/**
+ * @brief LoadGenerator::start
+ *      Starts sending once every socket is connected
+ */
+void LoadGenerator::start()
+{
+    if (m_settings.sharedMemory)
+    {
+#ifdef Q_OS_LINUX
+        if (!startSharedMemory())
+            emit finished();
+#else
+        qWarning("shared memory transport needs Linux");
+        emit finished();
+#endif
+        return;
+    }
+
+    auto connected = [this]() {
+        if (++m_connected < 2 * (int)m_links.size())
+            return;
+
+        for (const std::unique_ptr<Link> &link : m_links)
+            link->commandSocket->setSocketOption(QAbstractSocket::LowDelayOption, 1);
+
+        m_clock.start();
+        m_cpuStart = std::clock();
+        m_sendTimer->start(1);
+        QTimer::singleShot(m_settings.duration * 1000, this, &LoadGenerator::finish);
+    };
+
+    for (const std::unique_ptr<Link> &link : m_links)
+    {
+        for (QTcpSocket *socket : { link->commandSocket, link->telemetrySocket })
+        {
+            connect(socket, &QTcpSocket::connected, this, connected);
+            connect(socket, &QTcpSocket::errorOccurred, this, [this, socket]() {
+                qWarning("%s", qPrintable(socket->errorString()));
+                emit finished();
+            });
+        }
+    }
+
+    for (int i = 0; i < (int)m_links.size(); i++)
+    {
+        m_links[i]->commandSocket->connectToHost(m_settings.host, m_settings.commandPort + i);
+        m_links[i]->telemetrySocket->connectToHost(m_settings.host, m_settings.telemetryPort + i);
+    }
+}
+
+/**
+ * @brief LoadGenerator::sendCommands
+ *      Sends every frame that is due at the configured rate, to every robot
+ */
+void LoadGenerator::sendCommands()
+{
+    qint64 due = m_clock.nsecsElapsed() * m_settings.commandRate / 1000000000;
+
+    for (const std::unique_ptr<Link> &link : m_links)
+        sendDue(link.get(), due);
+}
+
+void LoadGenerator::sendDue(Link *link, qint64 due)
+{
+    for (; link->framesSent < due; link->framesSent++)
+    {
+        // alternate between the two continuous setpoints the GUI sends most
+        float value = (float)((link->framesSent % 200) - 100) / 100.f;
+        CommandOpcode opcode = (link->framesSent & 1) ? CommandOpcode::PitchRoll : CommandOpcode::VelocityX;
+        const char *frame = link->encoder.encode(opcode, value, -value);
+
+#ifdef Q_OS_LINUX
+        if (m_settings.sharedMemory)
+        {
+            // the simulator is not keeping up, try again on the next pass
+            if (!link->shm.commands().write(frame, CommandFrameEncoder::size()))
+                return;
+        }
+        else
+#endif
+            link->commandSocket->write(frame, CommandFrameEncoder::size());
+
+        link->latency.sent(link->encoder.lastSequence(), link->encoder.lastTimestamp());
+    }
+}
+
+void LoadGenerator::readTelemetry(Link *link)
+{
+    size_t available;
+    qint64 length;
+
+    while ((length = link->telemetrySocket->read(link->parser.writeBuffer(available), (qint64)available)) > 0)
+    {
+        link->parser.commit((size_t)length);
+        link->parser.parse();
+        link->telemetryBytes += length;
+    }
+}
+
+/**
+ * @brief LoadGenerator::finish
+ *      Stops sending, waits briefly for outstanding acks and prints the report
+ */
+void LoadGenerator::finish()
+{
+    if (m_sendTimer->isActive())
+    {
+        m_sendTimer->stop();
+        m_sendTime = m_clock.nsecsElapsed();
+        QTimer::singleShot(500, this, &LoadGenerator::finish);
+        return;
+    }
+
+    report();
+}
+
+/**
+ * @brief LoadGenerator::report
+ *      Prints the figures of all robots and writes the JSON report
+ */
+void LoadGenerator::report()
+{
+    // rates are over the time spent sending, CPU over the whole run including the drain
+    double seconds = m_sendTime / 1e9;
+    double wall = m_clock.nsecsElapsed() / 1e9;
+    double cpu = (double)(std::clock() - m_cpuStart) / CLOCKS_PER_SEC;
+    int robots = (int)m_links.size();
+
+    LatencyHistogram latency;
+    qint64 framesSent = 0;
+    qint64 telemetryBytes = 0;
+    quint64 records = 0;
+    quint64 unmatched = 0;
+    QJsonArray perRobot;
+
+    for (const std::unique_ptr<Link> &link : m_links)
+    {
+        const LatencyHistogram &robot = link->latency.histogram();
+
+        QJsonObject entry;
+        entry["framesSent"] = (double)link->framesSent;
+        entry["framesAcked"] = (double)robot.count();
+        entry["latencyP50"] = (double)robot.percentile(0.5);
+        entry["latencyP99"] = (double)robot.percentile(0.99);
+        perRobot.append(entry);
+
+        latency.merge(robot);
+        framesSent += link->framesSent;
+        telemetryBytes += link->telemetryBytes;
+        records += link->parser.records();
+        unmatched += link->latency.unmatched();
+    }
+
+    qint64 acked = (qint64)latency.count();
+
+    QJsonObject report;
+    report["robots"] = robots;
+    report["framesSent"] = (double)framesSent;
+    report["framesAcked"] = (double)acked;
+    report["framesLost"] = (double)(framesSent - acked);
+    report["unmatchedAcks"] = (double)unmatched;
+    report["commandRate"] = framesSent / seconds;
+    report["telemetryRecords"] = (double)records;
+    report["telemetryRecordRate"] = records / seconds;
+    report["telemetryMBps"] = telemetryBytes / seconds / 1e6;
+    report["latencyMean"] = latency.mean();
+    report["latencyP50"] = (double)latency.percentile(0.5);
+    report["latencyP99"] = (double)latency.percentile(0.99);
+    report["latencyP999"] = (double)latency.percentile(0.999);
+    report["latencyMax"] = (double)latency.max();
+    report["sendSeconds"] = seconds;
+    report["wallSeconds"] = wall;
+    report["cpuSeconds"] = cpu;
+    report["cpuPerRobot"] = cpu / robots / wall;
+    report["perRobot"] = perRobot;
+
+    qInfo("commands  %lld sent, %lld acked, %lld lost (%.0f frames/s)",
+          framesSent, acked, framesSent - acked, framesSent / seconds);
+    qInfo("telemetry %llu records (%.0f records/s, %.2f MB/s)",
+          (unsigned long long)records, records / seconds, telemetryBytes / seconds / 1e6);
+    qInfo("round trip p50 %llu us, p99 %llu us, p99.9 %llu us, max %llu us",
+          (unsigned long long)latency.percentile(0.5), (unsigned long long)latency.percentile(0.99),
+          (unsigned long long)latency.percentile(0.999), (unsigned long long)latency.max());
+    qInfo("cpu       %.3f s in %.3f s for %d robot(s), %.2f%% of a core per robot",
+          cpu, wall, robots, 100.0 * cpu / robots / wall);
+
+    if (!m_settings.reportPath.isEmpty())
+    {
+        QFile file(m_settings.reportPath);
+        if (file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+            file.write(QJsonDocument(report).toJson());
+        else
+            qWarning("unable to write report to %s", qPrintable(m_settings.reportPath));
+    }
+
+    for (const std::unique_ptr<Link> &link : m_links)
+    {
+        link->commandSocket->disconnectFromHost();
+        link->telemetrySocket->disconnectFromHost();
+    }
+
+    emit finished();
+}
+
+//---------------------------------- SHARED MEMORY ------------------------------------
+
+#ifdef Q_OS_LINUX
+bool LoadGenerator::startSharedMemory()
+{
+    for (int i = 0; i < (int)m_links.size(); i++)
+    {
+        std::string name = ShmChannel::regionName((uint16_t)(m_settings.commandPort + i));
+
+        if (!m_links[i]->shm.attach(name))
+        {
+            qWarning("shared memory %s: %s", name.c_str(), m_links[i]->shm.errorString().c_str());
+            return false;
+        }
+    }
+
+    m_clock.start();
+    m_cpuStart = std::clock();
+
+    m_shmThread = QThread::create([this]() { runSharedMemory(); });
+    connect(m_shmThread, &QThread::finished, this, &LoadGenerator::report);
+    m_shmThread->start(QThread::HighestPriority);
+
+    return true;
+}
+
+/**
+ * @brief LoadGenerator::runSharedMemory
+ *      Sends and receives until the run is over, then drains acks for another 500 ms.
+ *      A single robot sleeps on its telemetry futex between frames; with several the
+ *      rings are polled, as one thread cannot wait on more than one futex.
+ */
+void LoadGenerator::runSharedMemory()
+{
+    const qint64 end = (qint64)m_settings.duration * 1000000000;
+    const qint64 drained = end + 500000000;
+
+    qint64 now;
+
+    while ((now = m_clock.nsecsElapsed()) < drained)
+    {
+        if (now < end)
+        {
+            qint64 due = now * m_settings.commandRate / 1000000000;
+            for (const std::unique_ptr<Link> &link : m_links)
+                sendDue(link.get(), due);
+
+            m_sendTime = m_clock.nsecsElapsed();
+        }
+
+        for (const std::unique_ptr<Link> &link : m_links)
+            readSharedTelemetry(link.get());
+
+        if (m_links.size() == 1)
+            m_links.front()->shm.telemetry().wait(1);
+        else
+            QThread::usleep(50);
+    }
+
+    for (const std::unique_ptr<Link> &link : m_links)
+        link->shm.close();
+}
+
+void LoadGenerator::readSharedTelemetry(Link *link)
+{
+    ShmRing &ring = link->shm.telemetry();
+
+    size_t available;
+    const char *data;
+
+    while ((data = ring.peek(available)), available > 0)
+    {
+        link->parser.feed(data, available);
+        link->parser.parse();
+        link->telemetryBytes += (qint64)available;
+        ring.consume(available);
+    }
+}
+#endif
@@ -0,0 +1,117 @@
+#ifndef LOADGENERATOR_H
+#define LOADGENERATOR_H
+
+#include <QElapsedTimer>
+#include <QObject>
+#include <QString>
+
+#include <ctime>
+#include <memory>
+#include <vector>
+
+#include "commandframe.h"
+#include "latencytracker.h"
+#include "telemetryparser.h"
+
+#ifdef Q_OS_LINUX
+#include "shmtransport.h"
+#endif
+
+class QTcpSocket;
+class QThread;
+class QTimer;
+
+/**
+ * @brief The LoadGenerator class
+ *      Scripted client for end-to-end benchmarks. Connects to the command and telemetry
+ *      ports like the GUI does, sends command frames at a fixed rate and measures their
+ *      round trip with the same LatencyTracker the GUI uses.
+ *
+ *      With several robots every link runs on the one event loop, as in the GUI, and the
+ *      report adds the process CPU time spent per robot.
+ *
+ *      With sharedMemory set the run attaches to the simulator's shared memory regions
+ *      instead (Linux) and sends and receives on one thread of its own.
+ *      Prints a report when the run is over and optionally writes it as JSON.
+ */
+class LoadGenerator : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Settings
+    {
+        QString host = "127.0.0.1";
+        quint16 commandPort = 9000;
+        quint16 telemetryPort = 8080;
+
+        // robot i uses commandPort + i and telemetryPort + i
+        int robots = 1;
+
+        // command frames per second and robot
+        int commandRate = 1000;
+
+        // length of the run in seconds
+        int duration = 10;
+
+        QString reportPath;
+
+        bool sharedMemory = false;
+    };
+
+    explicit LoadGenerator(const Settings &settings, QObject *parent = nullptr);
+    ~LoadGenerator();
+
+    void start();
+
+signals:
+    void finished();
+
+private slots:
+    void sendCommands();
+    void finish();
+    void report();
+
+private:
+    struct Link
+    {
+        QTcpSocket *commandSocket;
+        QTcpSocket *telemetrySocket;
+
+        CommandFrameEncoder encoder;
+        TelemetryParser parser;
+        LatencyTracker latency;
+
+        qint64 framesSent = 0;
+        qint64 telemetryBytes = 0;
+
+#ifdef Q_OS_LINUX
+        ShmChannel shm;
+#endif
+    };
+
+    void sendDue(Link *link, qint64 due);
+    void readTelemetry(Link *link);
+
+#ifdef Q_OS_LINUX
+    bool startSharedMemory();
+    void runSharedMemory();
+    void readSharedTelemetry(Link *link);
+#endif
+
+    Settings m_settings;
+
+    std::vector<std::unique_ptr<Link>> m_links;
+    int m_connected;
+
+    QTimer *m_sendTimer;
+    QElapsedTimer m_clock;
+    qint64 m_sendTime;          // nanoseconds from the start to the last send
+    std::clock_t m_cpuStart;
+
+#ifdef Q_OS_LINUX
+    QThread *m_shmThread;
+#endif
+};
+
+#endif // LOADGENERATOR_H
@@ -0,0 +1,95 @@
+#include <QCommandLineParser>
+#include <QCoreApplication>
+
+#include <memory>
+#include <vector>
+
+#include "loadgenerator.h"
+#include "mocksimulator.h"
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Stand-in simulator endpoint and load generator for RoboUI");
+    parser.addHelpOption();
+
+    QCommandLineOption load("load", "Run as load generator against a simulator instead of serving.");
+    QCommandLineOption host("host", "Simulator host for --load.", "address", "127.0.0.1");
+    QCommandLineOption commandPort("command-port", "Command port.", "port", "9000");
+    QCommandLineOption telemetryPort("telemetry-port", "Telemetry port.", "port", "8080");
+    QCommandLineOption telemetryRate("telemetry-rate", "Telemetry records per second.", "rate", "1000");
+    QCommandLineOption channels("channels", "Channels per telemetry record.", "count", "6");
+    QCommandLineOption padding("padding", "Extra bytes per telemetry record.", "bytes", "0");
+    QCommandLineOption quiet("quiet", "Do not print per second statistics.");
+    QCommandLineOption commandRate("command-rate", "Command frames per second for --load.", "rate", "1000");
+    QCommandLineOption duration("duration", "Length of a --load run in seconds.", "seconds", "10");
+    QCommandLineOption robots("robots", "Serve or drive <n> robots on consecutive ports.", "n", "1");
+    QCommandLineOption transport("transport", "\"tcp\", or \"shm\" for shared memory regions named after the command port (Linux).", "kind", "tcp");
+    QCommandLineOption report("report", "Write the --load report as JSON to <file>.", "file");
+
+    parser.addOptions({ load, host, commandPort, telemetryPort, telemetryRate, channels, padding,
+                        quiet, commandRate, duration, robots, transport, report });
+    parser.process(a);
+
+    const int firstCommandPort = (int)parser.value(commandPort).toUInt();
+    const int firstTelemetryPort = (int)parser.value(telemetryPort).toUInt();
+    const int robotCount = qMax(1, parser.value(robots).toInt());
+
+    // robot i listens on both first ports + i; the two ranges must neither overlap
+    // nor run past the last port
+    const int maxRobots = qMin(qAbs(firstCommandPort - firstTelemetryPort),
+                               65536 - qMax(firstCommandPort, firstTelemetryPort));
+
+    if (robotCount > maxRobots)
+    {
+        qCritical("%d robots do not fit on command ports %d+ and telemetry ports %d+, at most %d do",
+                  robotCount, firstCommandPort, firstTelemetryPort, qMax(0, maxRobots));
+        return 1;
+    }
+
+    if (parser.isSet(load))
+    {
+        LoadGenerator::Settings settings;
+        settings.host = parser.value(host);
+        settings.commandPort = (quint16)firstCommandPort;
+        settings.telemetryPort = (quint16)firstTelemetryPort;
+        settings.commandRate = qMax(1, parser.value(commandRate).toInt());
+        settings.duration = qMax(1, parser.value(duration).toInt());
+        settings.robots = robotCount;
+        settings.sharedMemory = parser.value(transport) == "shm";
+        settings.reportPath = parser.value(report);
+
+        LoadGenerator generator(settings);
+        QObject::connect(&generator, &LoadGenerator::finished, &a, &QCoreApplication::quit, Qt::QueuedConnection);
+        generator.start();
+
+        return a.exec();
+    }
+
+    MockSimulator::Settings settings;
+    settings.commandPort = (quint16)firstCommandPort;
+    settings.telemetryPort = (quint16)firstTelemetryPort;
+    settings.telemetryRate = qMax(0, parser.value(telemetryRate).toInt());
+    settings.channels = qMax(0, parser.value(channels).toInt());
+    settings.padding = qMax(0, parser.value(padding).toInt());
+    settings.quiet = parser.isSet(quiet);
+    settings.sharedMemory = parser.value(transport) == "shm";
+
+    // one independent simulator per robot, on consecutive ports
+    std::vector<std::unique_ptr<MockSimulator>> simulators;
+    for (int i = 0; i < robotCount; i++)
+    {
+        MockSimulator::Settings robot = settings;
+        robot.commandPort = (quint16)(settings.commandPort + i);
+        robot.telemetryPort = (quint16)(settings.telemetryPort + i);
+        robot.quiet = settings.quiet || i > 0;
+
+        simulators.emplace_back(new MockSimulator(robot));
+        if (!simulators.back()->listen())
+            return 1;
+    }
+
+    return a.exec();
+}
@@ -0,0 +1,33 @@
+QT = core network
+
+CONFIG += c++17 console
+CONFIG -= app_bundle
+
+# Stand-in for the MuJoCo simulator endpoints (commands on 9000, telemetry on 8080)
+# and a load generator that drives either it or the real simulator.
+
+INCLUDEPATH += ..
+
+SOURCES += \
+    ../commandframe.cpp \
+    ../latencyhistogram.cpp \
+    ../latencytracker.cpp \
+    ../robotcommandstate.cpp \
+    ../telemetryparser.cpp \
+    loadgenerator.cpp \
+    main.cpp \
+    mocksimulator.cpp
+
+HEADERS += \
+    ../commandframe.h \
+    ../latencyhistogram.h \
+    ../latencytracker.h \
+    ../robotcommandstate.h \
+    ../telemetryparser.h \
+    loadgenerator.h \
+    mocksimulator.h
+
+linux {
+    SOURCES += ../shmtransport.cpp
+    HEADERS += ../shmtransport.h
+}
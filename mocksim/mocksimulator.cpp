@@ -0,0 +1,362 @@
+#include "mocksimulator.h"
+
+#include <QTcpSocket>
+#include <QThread>
+#include <QTimer>
+
+#include <cmath>
+#include <cstdio>
+
+// the simulator's own channel names, further channels are numbered
+static const char *const KnownChannels[] = { "vx", "vy", "theta", "omega", "height", "yaw" };
+
+MockSimulator::MockSimulator(const Settings &settings, QObject *parent) : QObject(parent),
+    m_settings(settings),
+    m_streamTimer(new QTimer(this)),
+    m_reportTimer(new QTimer(this)),
+    m_recordsSent(0),
+    m_bytesSent(0),
+    m_framesReceived(0),
+    m_setpointsDropped(0),
+    m_reportedBytes(0),
+    m_reportedFrames(0)
+#ifdef Q_OS_LINUX
+    , m_shmThread(nullptr)
+    , m_stopping(false)
+#endif
+{
+    for (int i = 0; i < m_settings.channels; i++)
+    {
+        if (i < (int)(sizeof(KnownChannels) / sizeof(KnownChannels[0])))
+            m_channelNames.append(KnownChannels[i]);
+        else
+            m_channelNames.append("ch" + QByteArray::number(i));
+    }
+
+    if (m_settings.padding > 0)
+        m_padding = " pad=" + QByteArray(m_settings.padding, 'x');
+
+    connect(&m_commandServer, &QTcpServer::newConnection, this, &MockSimulator::acceptCommands);
+    connect(&m_telemetryServer, &QTcpServer::newConnection, this, &MockSimulator::acceptTelemetry);
+    connect(&m_setpointSocket, &QUdpSocket::readyRead, this, &MockSimulator::readSetpoints);
+
+    m_streamTimer->setTimerType(Qt::PreciseTimer);
+    connect(m_streamTimer, &QTimer::timeout, this, &MockSimulator::streamTelemetry);
+
+    connect(m_reportTimer, &QTimer::timeout, this, &MockSimulator::report);
+}
+
+MockSimulator::~MockSimulator()
+{
+#ifdef Q_OS_LINUX
+    if (m_shmThread)
+    {
+        m_stopping.store(true);
+        m_shm.commands().wake();
+        m_shmThread->wait();
+        delete m_shmThread;
+    }
+#endif
+}
+
+/**
+ * @brief MockSimulator::listen
+ * @return false if either port could not be opened
+ */
+bool MockSimulator::listen()
+{
+    if (m_settings.sharedMemory)
+    {
+#ifdef Q_OS_LINUX
+        return listenSharedMemory();
+#else
+        qWarning("shared memory transport needs Linux");
+        return false;
+#endif
+    }
+
+    if (!m_commandServer.listen(QHostAddress::Any, m_settings.commandPort))
+    {
+        qWarning("command port %d: %s", m_settings.commandPort, qPrintable(m_commandServer.errorString()));
+        return false;
+    }
+
+    if (!m_telemetryServer.listen(QHostAddress::Any, m_settings.telemetryPort))
+    {
+        qWarning("telemetry port %d: %s", m_settings.telemetryPort, qPrintable(m_telemetryServer.errorString()));
+        return false;
+    }
+
+    if (!m_setpointSocket.bind(QHostAddress::Any, m_settings.commandPort))
+    {
+        qWarning("setpoint port %d: %s", m_settings.commandPort, qPrintable(m_setpointSocket.errorString()));
+        return false;
+    }
+
+    m_clock.start();
+
+    if (m_settings.telemetryRate > 0)
+        m_streamTimer->start(1);
+
+    if (!m_settings.quiet)
+        m_reportTimer->start(1000);
+
+    qInfo("listening for commands on %d and telemetry on %d", m_settings.commandPort, m_settings.telemetryPort);
+    return true;
+}
+
+double MockSimulator::simTime() const
+{
+    return m_clock.nsecsElapsed() / 1e9;
+}
+
+//---------------------------------- COMMANDS ------------------------------------
+
+void MockSimulator::acceptCommands()
+{
+    while (QTcpSocket *socket = m_commandServer.nextPendingConnection())
+    {
+        socket->setSocketOption(QAbstractSocket::LowDelayOption, 1);
+        m_decoders.insert(socket, new CommandFrameDecoder);
+
+        connect(socket, &QTcpSocket::readyRead, this, &MockSimulator::readCommands);
+        connect(socket, &QTcpSocket::disconnected, this, [this, socket]() {
+            delete m_decoders.take(socket);
+            socket->deleteLater();
+        });
+    }
+}
+
+/**
+ * @brief MockSimulator::readCommands
+ *      Decodes every complete frame and acknowledges all of them in one telemetry write
+ */
+void MockSimulator::readCommands()
+{
+    QTcpSocket *socket = qobject_cast<QTcpSocket *>(sender());
+    CommandFrameDecoder *decoder = m_decoders.value(socket);
+    if (!decoder)
+        return;
+
+    char buffer[4096];
+    qint64 length;
+
+    while ((length = socket->read(buffer, sizeof(buffer))) > 0)
+        decoder->feed(buffer, (size_t)length);
+
+    CommandFrame frame;
+    m_out.clear();
+
+    while (decoder->next(frame))
+    {
+        appendAck(m_out, frame);
+        m_framesReceived++;
+    }
+
+    if (!m_out.isEmpty())
+        broadcast(m_out);
+}
+
+/**
+ * @brief MockSimulator::readSetpoints
+ *      Applies Setpoint datagrams latest-wins and acknowledges the ones applied
+ */
+void MockSimulator::readSetpoints()
+{
+    char datagram[CommandFrameFormat::Size];
+    CommandFrame frame;
+
+    m_out.clear();
+
+    while (m_setpointSocket.hasPendingDatagrams())
+    {
+        qint64 length = m_setpointSocket.readDatagram(datagram, sizeof(datagram));
+
+        if (length != (qint64)sizeof(datagram) || !CommandFrameDecoder::read(datagram, frame))
+            continue;
+
+        if (!m_state.apply(frame))
+        {
+            m_setpointsDropped++;
+            continue;
+        }
+
+        appendAck(m_out, frame);
+        m_framesReceived++;
+    }
+
+    if (!m_out.isEmpty())
+        broadcast(m_out);
+}
+
+void MockSimulator::appendAck(QByteArray &out, const CommandFrame &frame)
+{
+    char line[96];
+    int n = std::snprintf(line, sizeof(line), "t=%.6f ack=%u ack_time=%llu\n",
+                          simTime(), frame.sequence, (unsigned long long)CommandFrameEncoder::now());
+    out.append(line, n);
+}
+
+//---------------------------------- TELEMETRY ------------------------------------
+
+void MockSimulator::acceptTelemetry()
+{
+    while (QTcpSocket *socket = m_telemetryServer.nextPendingConnection())
+    {
+        socket->setSocketOption(QAbstractSocket::LowDelayOption, 1);
+        m_telemetryClients.append(socket);
+
+        connect(socket, &QTcpSocket::disconnected, this, [this, socket]() {
+            m_telemetryClients.removeOne(socket);
+            socket->deleteLater();
+        });
+    }
+}
+
+/**
+ * @brief MockSimulator::streamTelemetry
+ *      Writes every record that is due at the configured rate, so a late tick
+ *      catches up instead of lowering the rate
+ */
+void MockSimulator::streamTelemetry()
+{
+    double now = simTime();
+    qint64 due = (qint64)(now * m_settings.telemetryRate);
+
+    if (m_telemetryClients.isEmpty())
+    {
+        m_recordsSent = due;
+        return;
+    }
+
+    m_out.clear();
+    appendRecords(m_out, due);
+
+    if (!m_out.isEmpty())
+        broadcast(m_out);
+}
+
+/**
+ * @brief MockSimulator::appendRecords
+ *      Formats every record up to, not including, number due
+ */
+void MockSimulator::appendRecords(QByteArray &out, qint64 due)
+{
+    char line[64];
+
+    for (; m_recordsSent < due; m_recordsSent++)
+    {
+        double t = (double)m_recordsSent / m_settings.telemetryRate;
+        int n = std::snprintf(line, sizeof(line), "t=%.6f", t);
+        out.append(line, n);
+
+        for (int i = 0; i < m_channelNames.size(); i++)
+        {
+            n = std::snprintf(line, sizeof(line), "=%.5f", std::sin(t * (i + 1)) * (i + 1));
+            out.append(' ');
+            out.append(m_channelNames.at(i));
+            out.append(line, n);
+        }
+
+        out.append(m_padding);
+        out.append('\n');
+    }
+}
+
+void MockSimulator::broadcast(const QByteArray &data)
+{
+    for (QTcpSocket *socket : std::as_const(m_telemetryClients))
+    {
+        socket->write(data);
+        m_bytesSent += data.size();
+    }
+}
+
+void MockSimulator::report()
+{
+    if (m_settings.sharedMemory)
+        qInfo("shared memory: %lld frames/s | %.2f MB/s",
+              m_framesReceived - m_reportedFrames, (m_bytesSent - m_reportedBytes) / 1e6);
+    else
+        qInfo("%d command client(s): %lld frames/s, %lld stale setpoints | %d telemetry client(s): %.2f MB/s",
+              (int)m_decoders.size(), m_framesReceived - m_reportedFrames, m_setpointsDropped,
+              (int)m_telemetryClients.size(), (m_bytesSent - m_reportedBytes) / 1e6);
+
+    m_reportedFrames = m_framesReceived;
+    m_reportedBytes = m_bytesSent;
+}
+
+//---------------------------------- SHARED MEMORY ------------------------------------
+
+#ifdef Q_OS_LINUX
+bool MockSimulator::listenSharedMemory()
+{
+    std::string name = ShmChannel::regionName(m_settings.commandPort);
+
+    if (!m_shm.create(name))
+    {
+        qWarning("shared memory %s: %s", name.c_str(), m_shm.errorString().c_str());
+        return false;
+    }
+
+    m_clock.start();
+
+    m_shmThread = QThread::create([this]() { serveSharedMemory(); });
+    m_shmThread->start(QThread::HighestPriority);
+
+    if (!m_settings.quiet)
+        m_reportTimer->start(1000);
+
+    qInfo("serving shared memory region %s", name.c_str());
+    return true;
+}
+
+/**
+ * @brief MockSimulator::serveSharedMemory
+ *      Acknowledges commands as soon as the command ring's futex wakes this thread and
+ *      writes telemetry records as they fall due; without telemetry it sleeps until
+ *      the next command. A batch that does not fit into the
+ *      telemetry ring, because no client is reading it, is dropped whole so records
+ *      are never cut.
+ */
+void MockSimulator::serveSharedMemory()
+{
+    CommandFrameDecoder decoder;
+    CommandFrame frame;
+    QByteArray out;
+
+    ShmRing &commands = m_shm.commands();
+    ShmRing &telemetry = m_shm.telemetry();
+
+    while (!m_stopping.load())
+    {
+        size_t available;
+        const char *data;
+
+        while ((data = commands.peek(available)), available > 0)
+        {
+            decoder.feed(data, available);
+            commands.consume(available);
+        }
+
+        out.clear();
+
+        while (decoder.next(frame))
+        {
+            appendAck(out, frame);
+            m_framesReceived++;
+        }
+
+        if (m_settings.telemetryRate > 0)
+            appendRecords(out, (qint64)(simTime() * m_settings.telemetryRate));
+
+        if (!out.isEmpty() && telemetry.write(out.constData(), (size_t)out.size()))
+            m_bytesSent += out.size();
+
+        // without telemetry to write there is nothing to do until a command arrives
+        commands.wait(m_settings.telemetryRate > 0 ? 1 : -1);
+    }
+
+    m_shm.close();
+}
+#endif
@@ -0,0 +1,118 @@
+#ifndef MOCKSIMULATOR_H
+#define MOCKSIMULATOR_H
+
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QList>
+#include <QObject>
+#include <QTcpServer>
+#include <QUdpSocket>
+
+#include <atomic>
+
+#include "commandframe.h"
+#include "robotcommandstate.h"
+
+#ifdef Q_OS_LINUX
+#include "shmtransport.h"
+#endif
+
+class QTcpSocket;
+class QThread;
+class QTimer;
+
+/**
+ * @brief The MockSimulator class
+ *      Serves the same two ports as the simulator. Every command frame received on the
+ *      command port is acknowledged on the telemetry stream with a record
+ *
+ *          t=<sim time> ack=<sequence> ack_time=<receive time, us>
+ *
+ *      and synthetic telemetry records with a configurable number of channels, record
+ *      size and rate are streamed to every telemetry client. Setpoint datagrams sent to
+ *      the command port are acknowledged the same way, unless a newer one overtook them.
+ *
+ *      With sharedMemory set it serves the same streams over a shared memory region
+ *      instead (Linux, see shmtransport.h), from one thread that sleeps on the command
+ *      ring between telemetry records.
+ */
+class MockSimulator : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Settings
+    {
+        quint16 commandPort = 9000;
+        quint16 telemetryPort = 8080;
+
+        // telemetry records per second
+        int telemetryRate = 1000;
+        int channels = 6;
+
+        // extra bytes appended to each record to simulate larger payloads
+        int padding = 0;
+
+        bool quiet = false;
+
+        bool sharedMemory = false;
+    };
+
+    explicit MockSimulator(const Settings &settings, QObject *parent = nullptr);
+    ~MockSimulator();
+
+    bool listen();
+
+private slots:
+    void acceptCommands();
+    void acceptTelemetry();
+    void readCommands();
+    void readSetpoints();
+    void streamTelemetry();
+    void report();
+
+private:
+    void broadcast(const QByteArray &data);
+    void appendAck(QByteArray &out, const CommandFrame &frame);
+    void appendRecords(QByteArray &out, qint64 due);
+    double simTime() const;
+
+#ifdef Q_OS_LINUX
+    bool listenSharedMemory();
+    void serveSharedMemory();
+#endif
+
+    Settings m_settings;
+
+    QTcpServer m_commandServer;
+    QTcpServer m_telemetryServer;
+    QUdpSocket m_setpointSocket;
+    RobotCommandState m_state;
+
+    QHash<QTcpSocket *, CommandFrameDecoder *> m_decoders;
+    QList<QTcpSocket *> m_telemetryClients;
+
+    QList<QByteArray> m_channelNames;
+    QByteArray m_padding;
+    QByteArray m_out;
+
+    QElapsedTimer m_clock;
+    QTimer *m_streamTimer;
+    QTimer *m_reportTimer;
+
+    qint64 m_recordsSent;
+    std::atomic<qint64> m_bytesSent;
+    std::atomic<qint64> m_framesReceived;
+    qint64 m_setpointsDropped;
+    qint64 m_reportedBytes;
+    qint64 m_reportedFrames;
+
+#ifdef Q_OS_LINUX
+    ShmChannel m_shm;
+    QThread *m_shmThread;
+    std::atomic<bool> m_stopping;
+#endif
+};
+
+#endif // MOCKSIMULATOR_H
@@ -0,0 +1,783 @@
+#include "networkworker.h"
+
+#include <QRandomGenerator>
+#include <QTcpSocket>
+#include <QTimer>
+#include <QUdpSocket>
+#include <cstring>
+
+#ifdef Q_OS_LINUX
+#include <QSocketNotifier>
+
+#include "shmtransport.h"
+#endif
+
+NetworkWorker::NetworkWorker(QObject *parent) : QObject(parent),
+    m_flushPending(false),
+    m_stopping(false),
+    m_frames(0),
+    m_dropped(0),
+    m_stale(0),
+    m_reconnects(0),
+    m_totalLatency(0),
+    m_maxLatency(0)
+#ifdef Q_OS_LINUX
+    , m_shmNotifier(nullptr)
+    , m_shmWatchdog(nullptr)
+#endif
+{
+}
+
+NetworkWorker::~NetworkWorker()
+{
+}
+
+int NetworkWorker::addRobot(const RobotEndpoint &endpoint)
+{
+    std::unique_ptr<RobotLink> link(new RobotLink);
+    link->index = (int)m_robots.size();
+    link->endpoint = endpoint;
+
+    m_robots.push_back(std::move(link));
+    return m_robots.back()->index;
+}
+
+int NetworkWorker::robotCount() const
+{
+    return (int)m_robots.size();
+}
+
+//---------------------------------- WORKER THREAD ------------------------------------
+
+/**
+ * @brief NetworkWorker::start
+ */
+void NetworkWorker::start()
+{
+    if (!m_recordPath.isEmpty() && !m_recorder.open(m_recordPath))
+        qWarning("unable to record session to %s: %s", qPrintable(m_recordPath), qPrintable(m_recorder.errorString()));
+
+    for (const std::unique_ptr<RobotLink> &robot : m_robots)
+    {
+        RobotLink *link = robot.get();
+
+#ifdef Q_OS_LINUX
+        if (link->endpoint.sharedMemory)
+        {
+            if (!m_shmWaiter && !startSharedMemory())
+                continue;
+
+            link->shm.reset(new ShmChannel);
+            attachSharedMemory(link);
+            continue;
+        }
+#else
+        if (link->endpoint.sharedMemory)
+            qWarning("robot %d: shared memory transport needs Linux, using tcp", link->index);
+#endif
+
+        link->commandSocket = new QTcpSocket(this);
+        link->telemetrySocket = new QTcpSocket(this);
+
+        connect(link->telemetrySocket, &QTcpSocket::readyRead, this, [this, link]() { readTelemetry(link); });
+        connect(link->commandSocket, &QTcpSocket::bytesWritten, this, [this, link]() { commandsWritten(link); });
+
+        watchConnection(link, link->commandSocket, link->endpoint.commandPort, &RobotLink::commandBackoff);
+        watchConnection(link, link->telemetrySocket, link->endpoint.telemetryPort, &RobotLink::telemetryBackoff);
+
+        if (link->endpoint.udpSetpoints)
+        {
+            // connectionless, this only fixes the peer address
+            link->setpointSocket = new QUdpSocket(this);
+            link->setpointSocket->connectToHost(link->endpoint.host, link->endpoint.commandPort);
+        }
+    }
+
+    for (const std::unique_ptr<RobotLink> &link : m_robots)
+    {
+        if (!link->commandSocket)
+            continue;
+
+        link->commandSocket->connectToHost(link->endpoint.host, link->endpoint.commandPort);
+        link->telemetrySocket->connectToHost(link->endpoint.host, link->endpoint.telemetryPort);
+    }
+}
+
+/**
+ * @brief NetworkWorker::stop
+ */
+void NetworkWorker::stop()
+{
+    m_stopping = true;
+
+    flushCommands();
+
+    for (const std::unique_ptr<RobotLink> &link : m_robots)
+    {
+        if (link->commandSocket)
+            link->commandSocket->disconnectFromHost();
+
+        if (link->telemetrySocket)
+            link->telemetrySocket->disconnectFromHost();
+
+#ifdef Q_OS_LINUX
+        if (link->shm && link->shm->isOpen())
+        {
+            m_shmWaiter->remove(&link->shm->telemetry());
+            link->shm->close();
+        }
+#endif
+    }
+
+#ifdef Q_OS_LINUX
+    if (m_shmWaiter)
+    {
+        m_shmWatchdog->stop();
+        m_shmNotifier->setEnabled(false);
+        m_shmWaiter->stop();
+    }
+#endif
+
+    m_recorder.close();
+}
+
+void NetworkWorker::setRecording(const QString &path)
+{
+    m_recordPath = path;
+}
+
+/**
+ * @brief NetworkWorker::flushCommands
+ *      Writes every queued frame of every robot; one wakeup serves all of them
+ */
+void NetworkWorker::flushCommands()
+{
+    m_flushPending.store(false);
+
+    for (const std::unique_ptr<RobotLink> &link : m_robots)
+    {
+        if (!link->commands.empty())
+            writeCommands(link.get());
+
+        if (!link->setpoints.empty())
+            writeSetpoint(link.get());
+    }
+}
+
+/**
+ * @brief NetworkWorker::writeCommands
+ *      Writes the robot's queued frames in as few socket writes as possible. Nothing is
+ *      queued behind a peer that is gone or not reading: while disconnected every frame
+ *      is discarded, while congested only state updates are, and a keyframe is requested
+ *      once the socket has drained.
+ */
+void NetworkWorker::writeCommands(RobotLink *link)
+{
+    CommandFrame frame;
+    OutboundFrame *pending;
+
+    char batch[BatchFrames * CommandFrameFormat::Size];
+    size_t batched = 0;
+
+    bool connected;
+    bool congested;
+    bool record = m_recorder.isOpen() && link->index == 0;
+
+#ifdef Q_OS_LINUX
+    if (link->shm)
+    {
+        connected = link->shm->peerReady();
+        congested = connected && link->shm->commands().readable() > HighWater;
+
+        // there is no bytesWritten() to wait for, the simulator caught up since last time
+        if (link->resyncPending && connected && !congested)
+        {
+            link->resyncPending = false;
+            emit resyncRequired(link->index);
+        }
+    }
+    else
+#endif
+    {
+        connected = link->commandSocket && link->commandSocket->state() == QAbstractSocket::ConnectedState;
+        congested = connected && link->commandSocket->bytesToWrite() > HighWater;
+    }
+
+    while ((pending = link->commands.front()) != nullptr)
+    {
+        bool decoded = CommandFrameDecoder::read(pending->bytes, frame);
+        bool stateUpdate = decoded && frame.opcode == CommandOpcode::StateUpdate;
+
+        if (!connected || (congested && stateUpdate))
+        {
+            m_stale.fetch_add(1, std::memory_order_relaxed);
+            if (stateUpdate)
+                link->resyncPending = true;
+
+            link->commands.popFront();
+            continue;
+        }
+
+        std::memcpy(batch + batched, pending->bytes, CommandFrameFormat::Size);
+        batched += CommandFrameFormat::Size;
+
+        uint64_t now = CommandFrameEncoder::now();
+
+        if (record)
+            m_recorder.append(SessionRecord::Command, now, pending->bytes, CommandFrameFormat::Size);
+
+        if (decoded)
+            recordSent(frame, pending->due, now);
+
+        link->commands.popFront();
+
+        if (batched == sizeof(batch))
+        {
+            writeBatch(link, batch, batched);
+            batched = 0;
+        }
+    }
+
+    if (batched > 0)
+        writeBatch(link, batch, batched);
+
+    checkDrained(link);
+}
+
+void NetworkWorker::writeBatch(RobotLink *link, const char *batch, size_t length)
+{
+#ifdef Q_OS_LINUX
+    if (link->shm)
+    {
+        // a full ring is a stalled peer as well
+        if (!link->shm->commands().write(batch, length))
+        {
+            m_stale.fetch_add(length / CommandFrameFormat::Size, std::memory_order_relaxed);
+            link->resyncPending = true;
+        }
+        return;
+    }
+#endif
+
+    link->commandSocket->write(batch, (qint64)length);
+}
+
+/**
+ * @brief NetworkWorker::writeSetpoint
+ *      Sends only the newest queued setpoint, the older ones are already out of date
+ */
+void NetworkWorker::writeSetpoint(RobotLink *link)
+{
+    OutboundFrame newest;
+    OutboundFrame *pending;
+    uint64_t due = 0;
+    int count = 0;
+
+    // the newest setpoint carries the values of the scheduled ones it replaces
+    while ((pending = link->setpoints.front()) != nullptr)
+    {
+        newest = *pending;
+        if (!due)
+            due = newest.due;
+
+        link->setpoints.popFront();
+        count++;
+    }
+
+    m_stale.fetch_add(count - 1, std::memory_order_relaxed);
+
+    if (link->setpointSocket->state() != QAbstractSocket::ConnectedState)
+    {
+        m_stale.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    link->setpointSocket->write(newest.bytes, CommandFrameFormat::Size);
+
+    uint64_t now = CommandFrameEncoder::now();
+    CommandFrame frame;
+
+    if (CommandFrameDecoder::read(newest.bytes, frame))
+        recordSent(frame, due, now);
+
+    if (m_recorder.isOpen() && link->index == 0)
+        m_recorder.append(SessionRecord::Command, now, newest.bytes, CommandFrameFormat::Size);
+}
+
+/**
+ * @brief NetworkWorker::recordSent
+ *      Times a frame that is being written, from its encoding and from the time it was
+ *      scheduled for
+ */
+void NetworkWorker::recordSent(const CommandFrame &frame, uint64_t due, uint64_t now)
+{
+    uint64_t latency = now - frame.timestamp;
+
+    m_frames.fetch_add(1, std::memory_order_relaxed);
+    m_totalLatency.fetch_add(latency, std::memory_order_relaxed);
+    if (latency > m_maxLatency.load(std::memory_order_relaxed))
+        m_maxLatency.store(latency, std::memory_order_relaxed);
+
+    if (due)
+        m_sendJitter.record(now > due ? now - due : 0);
+}
+
+/**
+ * @brief NetworkWorker::commandsWritten
+ *      Asks for a keyframe once a congested socket is down to half the high-water mark
+ */
+void NetworkWorker::commandsWritten(RobotLink *link)
+{
+    if (link->resyncPending && link->commandSocket->bytesToWrite() <= HighWater / 2)
+    {
+        link->resyncPending = false;
+        emit resyncRequired(link->index);
+    }
+
+    checkDrained(link);
+}
+
+/**
+ * @brief NetworkWorker::checkDrained
+ *      Emits commandsDrained() if it was asked for and the robot's queue and connection
+ *      have room. A socket is checked again when it wrote some bytes and a connection
+ *      when it comes up; a shared memory ring tells nobody that it was read, so it is
+ *      polled every millisecond while it is too full.
+ */
+void NetworkWorker::checkDrained(RobotLink *link)
+{
+    if (!link->drainWanted.load() || !link->commands.empty())
+        return;
+
+    bool connected;
+    qint64 unsent;
+
+#ifdef Q_OS_LINUX
+    if (link->shm)
+    {
+        connected = link->shm->peerReady();
+        unsent = connected ? (qint64)link->shm->commands().readable() : 0;
+
+        if (connected && unsent > HighWater / 2)
+        {
+            if (!link->drainPolled)
+            {
+                link->drainPolled = true;
+                QTimer::singleShot(1, this, [this, link]() {
+                    link->drainPolled = false;
+                    checkDrained(link);
+                });
+            }
+            return;
+        }
+    }
+    else
+#endif
+    {
+        connected = link->commandSocket && link->commandSocket->state() == QAbstractSocket::ConnectedState;
+        unsent = connected ? link->commandSocket->bytesToWrite() : 0;
+    }
+
+    if (!connected || unsent > HighWater / 2)
+        return;
+
+    if (link->drainWanted.exchange(false))
+        emit commandsDrained(link->index);
+}
+
+/**
+ * @brief NetworkWorker::watchConnection
+ *      Sets up a socket to reconnect whenever it drops, until stop()
+ * @param backoff - the link's reconnect delay for this socket
+ */
+void NetworkWorker::watchConnection(RobotLink *link, QTcpSocket *socket, quint16 port, int RobotLink::*backoff)
+{
+    connect(socket, &QTcpSocket::connected, this, [this, link, socket, backoff]() {
+        link->*backoff = MinBackoff;
+
+        if (socket != link->commandSocket)
+        {
+            link->telemetryRestarted = true;
+            return;
+        }
+
+        // small frames must not wait for Nagle to merge them
+        socket->setSocketOption(QAbstractSocket::LowDelayOption, 1);
+
+        // the simulator may have restarted or missed updates while it was away
+        link->resyncPending = false;
+        emit connectionChanged(link->index, true);
+        emit resyncRequired(link->index);
+        checkDrained(link);
+    });
+
+    if (socket == link->commandSocket)
+        connect(socket, &QTcpSocket::disconnected, this, [this, link]() { emit connectionChanged(link->index, false); });
+
+    connect(socket, &QTcpSocket::stateChanged, this, [this, link, socket, port, backoff](QAbstractSocket::SocketState state) {
+        if (state == QAbstractSocket::UnconnectedState && !m_stopping)
+            reconnectLater(link, socket, port, backoff);
+    });
+}
+
+/**
+ * @brief NetworkWorker::reconnectLater
+ *      Waits a random time in the upper half of the current backoff, so many robots
+ *      losing the same simulator host do not all come back in lockstep
+ */
+void NetworkWorker::reconnectLater(RobotLink *link, QTcpSocket *socket, quint16 port, int RobotLink::*backoff)
+{
+    int delay = link->*backoff;
+    link->*backoff = qMin(delay * 2, MaxBackoff);
+
+    int jittered = delay / 2 + (int)QRandomGenerator::global()->bounded(delay / 2 + 1);
+
+    QTimer::singleShot(jittered, socket, [this, link, socket, port]() {
+        if (m_stopping || socket->state() != QAbstractSocket::UnconnectedState)
+            return;
+
+        m_reconnects.fetch_add(1, std::memory_order_relaxed);
+        socket->connectToHost(link->endpoint.host, port);
+    });
+}
+
+/**
+ * @brief NetworkWorker::readTelemetry
+ *      Moves readable bytes into the robot's telemetry ring. If the GUI falls behind and
+ *      the ring fills up, the rest stays in the socket until takeTelemetry() frees a slot.
+ */
+void NetworkWorker::readTelemetry(RobotLink *link)
+{
+#ifdef Q_OS_LINUX
+    if (link->shm)
+    {
+        if (link->shm->isOpen())
+            readSharedTelemetry(link);
+        return;
+    }
+#endif
+
+    link->telemetryStalled.store(false);
+
+    bool pushed = false;
+    bool record = m_recorder.isOpen() && link->index == 0;
+
+    while (link->telemetrySocket->bytesAvailable() > 0)
+    {
+        TelemetryChunk *chunk = link->telemetry.beginPush();
+
+        if (!chunk)
+        {
+            link->telemetryStalled.store(true);
+            if (link->telemetry.full())
+                break;
+
+            // the GUI freed a slot before it could see the stall flag
+            link->telemetryStalled.store(false);
+            continue;
+        }
+
+        if (link->telemetryRestarted)
+        {
+            link->telemetryRestarted = false;
+            chunk->size = 0;
+            link->telemetry.commitPush();
+            pushed = true;
+            continue;
+        }
+
+        chunk->size = (int)link->telemetrySocket->read(chunk->data, TelemetryChunk::Capacity);
+        if (chunk->size <= 0)
+            break;
+
+        if (record)
+            m_recorder.append(SessionRecord::Telemetry, CommandFrameEncoder::now(), chunk->data, chunk->size);
+
+        link->telemetry.commitPush();
+        pushed = true;
+    }
+
+    if (pushed && !link->telemetryPending.exchange(true))
+        emit telemetryReady(link->index);
+}
+
+#ifdef Q_OS_LINUX
+/**
+ * @brief NetworkWorker::startSharedMemory
+ *      Shared memory robots are served by this thread's event loop: one ShmWaiter
+ *      sleeps on the telemetry rings of all of them and wakes the loop through its
+ *      eventfd, and a timer checks once a second that their simulators are still there.
+ */
+bool NetworkWorker::startSharedMemory()
+{
+    m_shmWaiter.reset(new ShmWaiter);
+
+    if (!m_shmWaiter->start())
+    {
+        qWarning("shared memory notifier: %s", m_shmWaiter->errorString().c_str());
+        m_shmWaiter.reset();
+        return false;
+    }
+
+    m_shmNotifier = new QSocketNotifier(m_shmWaiter->fd(), QSocketNotifier::Read, this);
+    connect(m_shmNotifier, &QSocketNotifier::activated, this, &NetworkWorker::sharedTelemetryReady);
+
+    m_shmWatchdog = new QTimer(this);
+    m_shmWatchdog->setInterval(ShmWatchdogInterval);
+    connect(m_shmWatchdog, &QTimer::timeout, this, &NetworkWorker::checkSharedMemory);
+    m_shmWatchdog->start();
+
+    return true;
+}
+
+/**
+ * @brief NetworkWorker::attachSharedMemory
+ *      Attaches to the simulator's region, or tries again later with the same jittered
+ *      backoff as a socket
+ */
+void NetworkWorker::attachSharedMemory(RobotLink *link)
+{
+    if (m_stopping)
+        return;
+
+    if (link->shm->attach(ShmChannel::regionName(link->endpoint.commandPort)))
+    {
+        link->shmBackoff = MinBackoff;
+        link->telemetryRestarted = true;
+        m_shmWaiter->add(&link->shm->telemetry());
+
+        emit connectionChanged(link->index, true);
+        emit resyncRequired(link->index);
+        checkDrained(link);
+        return;
+    }
+
+    int delay = link->shmBackoff / 2 + (int)QRandomGenerator::global()->bounded(link->shmBackoff / 2 + 1);
+    link->shmBackoff = qMin(link->shmBackoff * 2, MaxBackoff);
+
+    QTimer::singleShot(delay, this, [this, link]() {
+        m_reconnects.fetch_add(1, std::memory_order_relaxed);
+        attachSharedMemory(link);
+    });
+}
+
+/**
+ * @brief NetworkWorker::detachSharedMemory
+ *      Lets go of a region whose simulator closed it, crashed or was restarted, and
+ *      starts attaching to its successor
+ */
+void NetworkWorker::detachSharedMemory(RobotLink *link)
+{
+    m_shmWaiter->remove(&link->shm->telemetry());
+    link->shm->close();
+
+    emit connectionChanged(link->index, false);
+    attachSharedMemory(link);
+}
+
+/**
+ * @brief NetworkWorker::checkSharedMemory
+ *      A simulator that closes its region wakes the waiter, one that crashes or is
+ *      restarted is only found here
+ */
+void NetworkWorker::checkSharedMemory()
+{
+    for (const std::unique_ptr<RobotLink> &link : m_robots)
+    {
+        if (link->shm && link->shm->isOpen() && !link->shm->peerAlive())
+            detachSharedMemory(link.get());
+    }
+}
+
+/**
+ * @brief NetworkWorker::sharedTelemetryReady
+ *      The waiter found data, or a closed region, on at least one ring
+ */
+void NetworkWorker::sharedTelemetryReady()
+{
+    m_shmWaiter->acknowledge();
+
+    for (const std::unique_ptr<RobotLink> &link : m_robots)
+    {
+        if (!link->shm || !link->shm->isOpen())
+            continue;
+
+        readSharedTelemetry(link.get());
+
+        if (!link->shm->peerReady())
+            detachSharedMemory(link.get());
+    }
+}
+
+/**
+ * @brief NetworkWorker::readSharedTelemetry
+ *      Moves telemetry from shared memory into the robot's telemetry ring. The ring is
+ *      only rearmed once it is empty; if the GUI falls behind, the rest stays in shared
+ *      memory until takeTelemetry() frees a slot.
+ */
+void NetworkWorker::readSharedTelemetry(RobotLink *link)
+{
+    link->telemetryStalled.store(false);
+
+    ShmRing &ring = link->shm->telemetry();
+    bool pushed = false;
+    bool drained = true;
+
+    size_t available;
+    const char *data;
+
+    while ((data = ring.peek(available)), available > 0)
+    {
+        TelemetryChunk *chunk = link->telemetry.beginPush();
+        if (!chunk)
+        {
+            link->telemetryStalled.store(true);
+            if (link->telemetry.full())
+            {
+                drained = false;
+                break;
+            }
+
+            // the GUI freed a slot before it could see the stall flag
+            link->telemetryStalled.store(false);
+            continue;
+        }
+
+        if (link->telemetryRestarted)
+        {
+            link->telemetryRestarted = false;
+            chunk->size = 0;
+            link->telemetry.commitPush();
+            pushed = true;
+            continue;
+        }
+
+        chunk->size = (int)qMin(available, (size_t)TelemetryChunk::Capacity);
+        std::memcpy(chunk->data, data, chunk->size);
+        ring.consume(chunk->size);
+
+        link->telemetry.commitPush();
+        pushed = true;
+    }
+
+    if (drained)
+        m_shmWaiter->rearm(&ring);
+
+    if (pushed && !link->telemetryPending.exchange(true))
+        emit telemetryReady(link->index);
+}
+#endif
+
+//---------------------------------- GUI THREAD ------------------------------------
+
+/**
+ * @brief NetworkWorker::send
+ * @param robot - index returned by addRobot()
+ * @param frame - encoded frame
+ * @param due - scheduled send time, or 0
+ * @return bool
+ */
+bool NetworkWorker::send(int robot, const char *frame, uint64_t due)
+{
+    OutboundFrame *slot = m_robots[robot]->commands.beginPush();
+
+    if (!slot)
+    {
+        m_dropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    std::memcpy(slot->bytes, frame, CommandFrameFormat::Size);
+    slot->due = due;
+    m_robots[robot]->commands.commitPush();
+
+    if (!m_flushPending.exchange(true))
+        QMetaObject::invokeMethod(this, &NetworkWorker::flushCommands, Qt::QueuedConnection);
+
+    return true;
+}
+
+void NetworkWorker::requestDrained(int robot)
+{
+    RobotLink *link = m_robots[robot].get();
+    link->drainWanted.store(true);
+
+    QMetaObject::invokeMethod(this, [this, link]() { checkDrained(link); }, Qt::QueuedConnection);
+}
+
+/**
+ * @brief NetworkWorker::sendSetpoint
+ * @param robot - index returned by addRobot()
+ * @param frame - encoded Setpoint frame
+ * @param due - scheduled send time, or 0
+ * @return bool
+ */
+bool NetworkWorker::sendSetpoint(int robot, const char *frame, uint64_t due)
+{
+    OutboundFrame *slot = m_robots[robot]->setpoints.beginPush();
+
+    if (!slot)
+    {
+        m_dropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    std::memcpy(slot->bytes, frame, CommandFrameFormat::Size);
+    slot->due = due;
+    m_robots[robot]->setpoints.commitPush();
+
+    if (!m_flushPending.exchange(true))
+        QMetaObject::invokeMethod(this, &NetworkWorker::flushCommands, Qt::QueuedConnection);
+
+    return true;
+}
+
+bool NetworkWorker::hasSetpointChannel(int robot) const
+{
+    const RobotEndpoint &endpoint = m_robots[robot]->endpoint;
+
+#ifdef Q_OS_LINUX
+    if (endpoint.sharedMemory)
+        return false;
+#endif
+
+    return endpoint.udpSetpoints;
+}
+
+/**
+ * @brief NetworkWorker::takeTelemetry
+ * @param robot - index returned by addRobot()
+ * @param chunk - receives the oldest chunk
+ * @return false if nothing is pending
+ */
+bool NetworkWorker::takeTelemetry(int robot, TelemetryChunk &chunk)
+{
+    RobotLink *link = m_robots[robot].get();
+    link->telemetryPending.store(false);
+
+    TelemetryChunk *pending = link->telemetry.front();
+    if (!pending)
+        return false;
+
+    chunk.size = pending->size;
+    std::memcpy(chunk.data, pending->data, pending->size);
+    link->telemetry.popFront();
+
+    // the worker left data in the socket because the ring was full
+    if (link->telemetryStalled.exchange(false))
+        QMetaObject::invokeMethod(this, [this, link]() { readTelemetry(link); }, Qt::QueuedConnection);
+
+    return true;
+}
+
+NetworkWorker::QueueStats NetworkWorker::queueStats() const
+{
+    QueueStats stats;
+    stats.frames = m_frames.load();
+    stats.dropped = m_dropped.load();
+    stats.stale = m_stale.load();
+    stats.reconnects = m_reconnects.load();
+    stats.totalLatency = m_totalLatency.load();
+    stats.maxLatency = m_maxLatency.load();
+    return stats;
+}
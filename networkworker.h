@@ -0,0 +1,285 @@
+#ifndef NETWORKWORKER_H
+#define NETWORKWORKER_H
+
+#include <QObject>
+#include <QString>
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "commandframe.h"
+#include "latencyhistogram.h"
+#include "robotendpoint.h"
+#include "sessionlog.h"
+#include "spscring.h"
+
+class QSocketNotifier;
+class QTcpSocket;
+class QTimer;
+class QUdpSocket;
+class ShmChannel;
+class ShmWaiter;
+
+/**
+ * @brief The OutboundFrame struct
+ *      One encoded command frame waiting to be written
+ */
+struct OutboundFrame
+{
+    char bytes[CommandFrameFormat::Size];
+    uint64_t due;   // CommandFrameEncoder::now() the frame was scheduled for, 0 if it was not
+};
+
+/**
+ * @brief The TelemetryChunk struct
+ *      Raw bytes read from the telemetry socket in one go. An empty chunk marks the
+ *      start of a new connection; whatever came before it was cut off mid-stream.
+ */
+struct TelemetryChunk
+{
+    static constexpr int Capacity = 4096;
+
+    int size;
+    char data[Capacity];
+};
+
+/**
+ * @brief The NetworkWorker class
+ *      Owns the command and telemetry connections of every robot and runs on its own
+ *      thread, so widgets that block the GUI thread no longer delay any of them. All
+ *      connections are multiplexed on the worker's event loop; adding a robot adds two
+ *      sockets and two rings, not a thread.
+ *
+ *      The GUI thread is the single producer of commands and the single consumer of
+ *      telemetry; both directions go through lock-free SPSC rings per robot. A queued
+ *      wakeup is only posted when the other side is not already scheduled to look at
+ *      the rings.
+ *
+ *      Both sockets of a robot reconnect on their own with jittered exponential backoff.
+ *      Commands queued in one event loop iteration go out in a single write. While a
+ *      robot is disconnected, or its socket holds more than HighWater unsent bytes,
+ *      state updates are dropped instead of piling up behind the stalled peer; once it
+ *      drains, resyncRequired() asks the GUI for a keyframe that replaces them.
+ *
+ *      Continuous setpoints can go to a robot as UDP datagrams, see robotcommandstate.h;
+ *      of the setpoints queued in one iteration only the newest is sent.
+ *
+ *      On Linux a robot on the same host can use a shared memory region instead of the
+ *      two sockets, see shmtransport.h. Commands are written to its ring by this thread,
+ *      telemetry is read on this thread too, when the ShmWaiter reports a ring with data.
+ *      A watchdog polls ShmChannel::peerAlive() and reattaches to restarted simulators.
+ *
+ *      Session recording applies to robot 0, over TCP.
+ */
+class NetworkWorker : public QObject
+{
+    Q_OBJECT
+
+public:
+    // unsent command bytes above which state updates are dropped
+    static constexpr qint64 HighWater = 64 * CommandFrameFormat::Size;
+
+    // frames gathered into one socket write
+    static constexpr int BatchFrames = 64;
+
+    // reconnect delay limits in milliseconds, doubled after every failed attempt
+    static constexpr int MinBackoff = 100;
+    static constexpr int MaxBackoff = 5000;
+
+    // milliseconds between checks that shared memory simulators are still alive
+    static constexpr int ShmWatchdogInterval = 1000;
+
+    explicit NetworkWorker(QObject *parent = nullptr);
+    ~NetworkWorker();
+
+    /**
+     * @brief addRobot
+     *      Call before start()
+     * @return index of the robot for send() and takeTelemetry()
+     */
+    int addRobot(const RobotEndpoint &endpoint);
+    int robotCount() const;
+
+    /**
+     * @brief send
+     *      GUI thread only. Queues one encoded frame of CommandFrameFormat::Size bytes.
+     * @param due - time the frame was scheduled for, see sendJitter(), or 0
+     * @return false if the robot's command queue is full and the frame was dropped
+     */
+    bool send(int robot, const char *frame, uint64_t due = 0);
+
+    /**
+     * @brief sendSetpoint
+     *      GUI thread only. Queues a Setpoint frame for the robot's datagram channel.
+     * @return false if the frame was dropped
+     */
+    bool sendSetpoint(int robot, const char *frame, uint64_t due = 0);
+
+    /**
+     * @brief requestDrained
+     *      GUI thread only. Asks for one commandsDrained() of the robot, for a sender
+     *      that paces itself instead of letting frames be dropped as stale or full.
+     */
+    void requestDrained(int robot);
+
+    /**
+     * @brief hasSetpointChannel
+     * @return true if the robot takes its setpoints as datagrams
+     */
+    bool hasSetpointChannel(int robot) const;
+
+    /**
+     * @brief takeTelemetry
+     *      GUI thread only. Pops the oldest pending telemetry chunk of a robot.
+     */
+    bool takeTelemetry(int robot, TelemetryChunk &chunk);
+
+    /**
+     * @brief The QueueStats struct
+     *      Time from a frame being stamped by the encoder to its socket write,
+     *      in microseconds, over all robots. Dropped frames did not fit in the queue,
+     *      stale ones were discarded while their robot was stalled.
+     */
+    struct QueueStats
+    {
+        uint64_t frames = 0;
+        uint64_t dropped = 0;
+        uint64_t stale = 0;
+        uint64_t reconnects = 0;
+        uint64_t totalLatency = 0;
+        uint64_t maxLatency = 0;
+    };
+
+    QueueStats queueStats() const;
+
+    /**
+     * @brief sendJitter
+     *      Microseconds between the time scheduled frames were due and their write,
+     *      over all robots. Only read it once the worker has stopped.
+     */
+    const LatencyHistogram &sendJitter() const { return m_sendJitter; }
+
+    /**
+     * @brief setRecording
+     *      Records all traffic of robot 0 to a session log, call before start()
+     */
+    void setRecording(const QString &path);
+
+signals:
+    /**
+     * @brief telemetryReady
+     *      New chunks are waiting in the robot's telemetry ring
+     */
+    void telemetryReady(int robot);
+
+    /**
+     * @brief resyncRequired
+     *      The robot's command connection came up, or drained after state updates were
+     *      dropped; the next update must be a keyframe
+     */
+    void resyncRequired(int robot);
+
+    /**
+     * @brief connectionChanged
+     *      The robot's command connection, or its shared memory region, came up or went away
+     */
+    void connectionChanged(int robot, bool connected);
+
+    /**
+     * @brief commandsDrained
+     *      Answers requestDrained(): every frame queued before the request was written,
+     *      and the robot is connected with at most HighWater / 2 bytes unsent
+     */
+    void commandsDrained(int robot);
+
+public slots:
+    /**
+     * @brief start
+     *      Creates and connects all sockets, must run on the worker thread
+     */
+    void start();
+    void stop();
+
+private slots:
+    void flushCommands();
+
+private:
+    struct RobotLink
+    {
+        int index;
+        RobotEndpoint endpoint;
+
+        QTcpSocket *commandSocket = nullptr;
+        QTcpSocket *telemetrySocket = nullptr;
+
+        QUdpSocket *setpointSocket = nullptr;
+
+        SpscRing<OutboundFrame, 1024> commands;
+        SpscRing<OutboundFrame, 64> setpoints;
+        SpscRing<TelemetryChunk, 64> telemetry;
+
+        std::atomic<bool> telemetryPending{false};
+        std::atomic<bool> telemetryStalled{false};
+        std::atomic<bool> drainWanted{false};
+
+        // the telemetry stream restarted, queue an empty chunk before its first bytes
+        bool telemetryRestarted = false;
+
+        int commandBackoff = MinBackoff;
+        int telemetryBackoff = MinBackoff;
+        bool resyncPending = false;
+
+#ifdef Q_OS_LINUX
+        // shared memory transport, attached and read on the worker thread
+        std::unique_ptr<ShmChannel> shm;
+        int shmBackoff = MinBackoff;
+        bool drainPolled = false;
+#endif
+    };
+
+    void writeCommands(RobotLink *link);
+    void readTelemetry(RobotLink *link);
+    void commandsWritten(RobotLink *link);
+    void checkDrained(RobotLink *link);
+    void writeBatch(RobotLink *link, const char *batch, size_t length);
+    void writeSetpoint(RobotLink *link);
+    void recordSent(const CommandFrame &frame, uint64_t due, uint64_t now);
+
+#ifdef Q_OS_LINUX
+    bool startSharedMemory();
+    void attachSharedMemory(RobotLink *link);
+    void detachSharedMemory(RobotLink *link);
+    void checkSharedMemory();
+    void sharedTelemetryReady();
+    void readSharedTelemetry(RobotLink *link);
+#endif
+
+    void watchConnection(RobotLink *link, QTcpSocket *socket, quint16 port, int RobotLink::*backoff);
+    void reconnectLater(RobotLink *link, QTcpSocket *socket, quint16 port, int RobotLink::*backoff);
+
+    std::vector<std::unique_ptr<RobotLink>> m_robots;
+
+    QString m_recordPath;
+    SessionRecorder m_recorder;
+
+    std::atomic<bool> m_flushPending;
+    std::atomic<bool> m_stopping;
+
+    std::atomic<uint64_t> m_frames;
+    std::atomic<uint64_t> m_dropped;
+    std::atomic<uint64_t> m_stale;
+    std::atomic<uint64_t> m_reconnects;
+    std::atomic<uint64_t> m_totalLatency;
+    std::atomic<uint64_t> m_maxLatency;
+    LatencyHistogram m_sendJitter;
+
+#ifdef Q_OS_LINUX
+    std::unique_ptr<ShmWaiter> m_shmWaiter;
+    QSocketNotifier *m_shmNotifier;
+    QTimer *m_shmWatchdog;
+#endif
+};
+
+#endif // NETWORKWORKER_H
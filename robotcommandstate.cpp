@@ -0,0 +1,113 @@
+#include "robotcommandstate.h"
+
+RobotCommandState::RobotCommandState() :
+    m_dirty(0),
+    m_stagedMask(0),
+    m_lastSetpoint(0),
+    m_hasSetpoint(false)
+{
+    for (int i = 0; i < StateUpdateFormat::FieldCount; i++)
+    {
+        m_values[i] = 0.f;
+        m_staged[i] = 0.f;
+    }
+}
+
+bool RobotCommandState::set(RobotField field, float value)
+{
+    int index = (int)field;
+
+    if (m_values[index] == value)
+        return false;
+
+    m_values[index] = value;
+    m_dirty |= 1u << index;
+    return true;
+}
+
+bool RobotCommandState::add(RobotField field, float delta)
+{
+    return set(field, m_values[(int)field] + delta);
+}
+
+const char *RobotCommandState::encodeSetpoint(CommandFrameEncoder &encoder)
+{
+    CommandFrame frame;
+    frame.opcode = CommandOpcode::Setpoint;
+
+    for (int field = 0; field < SetpointFormat::FieldCount; field++)
+        frame.setValue(field, m_values[field]);
+
+    m_dirty &= ~SetpointFormat::Fields;
+    return encoder.encode(frame);
+}
+
+bool RobotCommandState::moving() const
+{
+    for (int field = 0; field < SetpointFormat::FieldCount; field++)
+    {
+        if (m_values[field] != 0.f)
+            return true;
+    }
+
+    return false;
+}
+
+/**
+ * @brief RobotCommandState::apply
+ * @param frame - a decoded StateUpdate or Setpoint frame, other opcodes are ignored
+ * @return true if the frame committed an update
+ */
+bool RobotCommandState::apply(const CommandFrame &frame)
+{
+    if (frame.opcode == CommandOpcode::Setpoint)
+        return applySetpoint(frame);
+
+    if (frame.opcode != CommandOpcode::StateUpdate)
+        return false;
+
+    uint32_t word = frame.word(0);
+    uint32_t mask = word & StateUpdateFormat::FieldMask;
+    int count = 0;
+
+    for (int field = 0; field < StateUpdateFormat::FieldCount && count < StateUpdateFormat::FieldsPerFrame; field++)
+    {
+        if (mask & (1u << field))
+        {
+            m_staged[field] = frame.value(1 + count++);
+            m_stagedMask |= 1u << field;
+        }
+    }
+
+    if (!(word & StateUpdateFormat::Commit))
+        return false;
+
+    for (int field = 0; field < StateUpdateFormat::FieldCount; field++)
+    {
+        if (m_stagedMask & (1u << field))
+            set((RobotField)field, m_staged[field]);
+    }
+
+    m_stagedMask = 0;
+    return true;
+}
+
+/**
+ * @brief RobotCommandState::applySetpoint
+ *      Latest wins: a datagram that was overtaken by a newer one is dropped
+ */
+bool RobotCommandState::applySetpoint(const CommandFrame &frame)
+{
+    uint32_t behind = m_lastSetpoint - frame.sequence;
+
+    if (m_hasSetpoint && behind < SetpointFormat::ReorderWindow)
+        return false;
+
+    m_lastSetpoint = frame.sequence;
+    m_hasSetpoint = true;
+
+    for (int field = 0; field < SetpointFormat::FieldCount; field++)
+        set((RobotField)field, frame.value(field));
+
+    return true;
+}
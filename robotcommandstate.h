@@ -0,0 +1,186 @@
+#ifndef ROBOTCOMMANDSTATE_H
+#define ROBOTCOMMANDSTATE_H
+
+#include <cstdint>
+
+#include "commandframe.h"
+
+/*
+ *  Desired robot state, sent as CommandOpcode::StateUpdate frames.
+ *
+ *  An update carries the fields that changed since the previous update, or all of them
+ *  for a keyframe. As a frame has room for three values, an update spans as many frames
+ *  as needed; the receiver stages the fields and applies them together when the frame
+ *  with the commit flag arrives, so the robot never acts on half an update.
+ *
+ *      payload word 0  bits 0-10   fields present in this frame, at most three
+ *                      bit 30      keyframe, the update holds every field
+ *                      bit 31      commit, last frame of the update
+ *      payload 1..3    float32 values of the present fields in ascending field order
+ *
+ *  The continuous setpoints (velocity, pitch and roll) can instead travel as
+ *  CommandOpcode::Setpoint frames in single datagrams, leaving the reliable stream to
+ *  everything else. Only their newest value matters, so each datagram carries all four
+ *  of them and the receiver drops any frame older than the last one it applied; a lost
+ *  datagram is simply replaced by the next.
+ *
+ *      payload 0..3    float32 VelocityX, VelocityY, Pitch, Roll
+ */
+
+enum class RobotField : uint8_t
+{
+    VelocityX,
+    VelocityY,
+    Pitch,
+    Roll,
+    Height,
+    ArmRotate,
+    ArmExtend,
+    ArmHeight,
+    GripAngle,
+    Grip,
+    Gait,
+
+    Count
+};
+
+enum class RobotGait : uint8_t
+{
+    Stand = 0,
+    Trot = 1
+};
+
+namespace StateUpdateFormat
+{
+    constexpr int FieldCount = (int)RobotField::Count;
+    constexpr int FieldsPerFrame = CommandFrameFormat::ValueCount - 1;
+    constexpr uint32_t FieldMask = (1u << FieldCount) - 1;
+    constexpr uint32_t Keyframe = 1u << 30;
+    constexpr uint32_t Commit = 1u << 31;
+}
+
+namespace SetpointFormat
+{
+    constexpr int FieldCount = 4;
+    constexpr uint32_t Fields = (1u << FieldCount) - 1;
+
+    // a sequence number this far behind the newest is a restarted sender, not a late frame
+    constexpr uint32_t ReorderWindow = 1u << 16;
+}
+
+/**
+ * @brief The RobotCommandState class
+ *      One authoritative desired-state vector. The sender changes fields with set() and
+ *      add(), which track what changed, and sends the changes with encodeUpdate(). The
+ *      receiver feeds StateUpdate frames to apply(). Like commandframe.h this only
+ *      depends on the standard library.
+ */
+class RobotCommandState
+{
+public:
+    // increments of the buttons that nudge a field instead of setting it
+    static constexpr float HeightStep = 0.01f;
+    static constexpr float JointStep = 0.05f;
+    static constexpr float GripStep = 0.05f;
+
+    RobotCommandState();
+
+    float value(RobotField field) const { return m_values[(int)field]; }
+
+    /**
+     * @brief set
+     * @return true if the value changed
+     */
+    bool set(RobotField field, float value);
+    bool add(RobotField field, float delta);
+
+    bool dirty() const { return m_dirty != 0; }
+    uint32_t dirtyMask() const { return m_dirty; }
+
+    /**
+     * @brief encodeUpdate
+     *      Encodes the changed fields, or all of them for a keyframe, and clears the
+     *      change mask. send is called with every encoded frame before the next is encoded.
+     * @param fields - fields this update may carry, e.g. all but the setpoints
+     * @return number of frames sent
+     */
+    template <typename Send>
+    int encodeUpdate(CommandFrameEncoder &encoder, bool keyframe, Send send,
+                     uint32_t fields = StateUpdateFormat::FieldMask);
+
+    /**
+     * @brief encodeSetpoint
+     *      Encodes the continuous setpoints into one Setpoint frame and clears their
+     *      change mask
+     */
+    const char *encodeSetpoint(CommandFrameEncoder &encoder);
+
+    /**
+     * @brief moving
+     * @return true if any continuous setpoint is not zero
+     */
+    bool moving() const;
+
+    /**
+     * @brief apply
+     *      Receiving side: stages the fields of a StateUpdate frame, or applies a
+     *      Setpoint frame that is newer than the last one
+     * @return true if the frame committed an update
+     */
+    bool apply(const CommandFrame &frame);
+
+private:
+    bool applySetpoint(const CommandFrame &frame);
+
+    float m_values[StateUpdateFormat::FieldCount];
+    uint32_t m_dirty;
+
+    float m_staged[StateUpdateFormat::FieldCount];
+    uint32_t m_stagedMask;
+
+    uint32_t m_lastSetpoint;
+    bool m_hasSetpoint;
+};
+
+template <typename Send>
+int RobotCommandState::encodeUpdate(CommandFrameEncoder &encoder, bool keyframe, Send send, uint32_t fields)
+{
+    uint32_t remaining = (keyframe ? StateUpdateFormat::FieldMask : m_dirty) & fields;
+    m_dirty &= ~fields;
+
+    CommandFrame frame;
+    frame.opcode = CommandOpcode::StateUpdate;
+
+    int frames = 0;
+    int field = 0;
+
+    while (remaining != 0)
+    {
+        uint32_t mask = 0;
+        int count = 0;
+
+        for (; field < StateUpdateFormat::FieldCount && count < StateUpdateFormat::FieldsPerFrame; field++)
+        {
+            if (remaining & (1u << field))
+            {
+                mask |= 1u << field;
+                frame.setValue(1 + count++, m_values[field]);
+            }
+        }
+
+        for (; count < StateUpdateFormat::FieldsPerFrame; count++)
+            frame.setValue(1 + count, 0.f);
+
+        remaining &= ~mask;
+
+        uint32_t flags = (keyframe ? StateUpdateFormat::Keyframe : 0) | (remaining == 0 ? StateUpdateFormat::Commit : 0);
+        frame.setWord(0, mask | flags);
+
+        send(encoder.encode(frame));
+        frames++;
+    }
+
+    return frames;
+}
+
+#endif // ROBOTCOMMANDSTATE_H
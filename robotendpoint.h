@@ -0,0 +1,24 @@
+#ifndef ROBOTENDPOINT_H
+#define ROBOTENDPOINT_H
+
+#include <QString>
+
+/**
+ * @brief The RobotEndpoint struct
+ *      Where one simulated robot listens for commands and serves telemetry
+ */
+struct RobotEndpoint
+{
+    QString host = "127.0.0.1";
+    quint16 commandPort = 9000;
+    quint16 telemetryPort = 8080;
+
+    // Linux: same-host shared memory region named after commandPort instead of TCP,
+    // see shmtransport.h
+    bool sharedMemory = false;
+
+    // continuous setpoints as UDP datagrams to commandPort instead of on the stream
+    bool udpSetpoints = false;
+};
+
+#endif // ROBOTENDPOINT_H
@@ -0,0 +1,174 @@
+#include "robotsession.h"
+
+#include <QTimer>
+
+RobotSession::RobotSession(NetworkWorker *network, int robot, size_t memoryCap, QObject *parent) : QObject(parent),
+    m_network(network),
+    m_robot(robot),
+    m_connected(false),
+    m_updatePending(false),
+    m_keyframeDue(true),
+    m_due(0),
+    m_udpSetpoints(network->hasSetpointChannel(robot)),
+    m_stopRepeats(0),
+    m_setpointTimer(new QTimer(this)),
+    m_store(memoryCap)
+{
+    m_setpointTimer->setInterval(SetpointRefresh);
+    connect(m_setpointTimer, &QTimer::timeout, this, &RobotSession::sendSetpoint);
+
+    // every parsed sample is kept for plots and exports, acks are timed
+    m_telemetry.addSink(&m_store);
+    m_telemetry.addSink(&m_latency);
+
+    // the first update is a keyframe
+    scheduleStateUpdate();
+}
+
+bool RobotSession::set(RobotField field, float value, uint64_t due)
+{
+    if (!m_state.set(field, value))
+        return false;
+
+    if (due && (!m_due || due < m_due))
+        m_due = due;
+
+    scheduleStateUpdate();
+    return true;
+}
+
+bool RobotSession::add(RobotField field, float step)
+{
+    if (!m_state.add(field, step))
+        return false;
+
+    scheduleStateUpdate();
+    return true;
+}
+
+void RobotSession::requestKeyframe()
+{
+    m_keyframeDue = true;
+    scheduleStateUpdate();
+}
+
+void RobotSession::scheduleStateUpdate()
+{
+    if (m_updatePending)
+        return;
+
+    m_updatePending = true;
+    QMetaObject::invokeMethod(this, &RobotSession::sendStateUpdate, Qt::QueuedConnection);
+}
+
+void RobotSession::sendStateUpdate()
+{
+    m_updatePending = false;
+
+    bool keyframe = m_keyframeDue;
+    m_keyframeDue = false;
+
+    const uint64_t due = m_due;
+    auto send = [this, due](const char *frame) { sendFrame(frame, due); };
+
+    if (!m_udpSetpoints)
+    {
+        m_state.encodeUpdate(m_encoder, keyframe, send);
+        m_due = 0;
+        return;
+    }
+
+    if (keyframe || (m_state.dirtyMask() & SetpointFormat::Fields))
+        sendSetpoint();
+
+    m_state.encodeUpdate(m_encoder, keyframe, send, StateUpdateFormat::FieldMask & ~SetpointFormat::Fields);
+    m_due = 0;
+}
+
+/**
+ * @brief RobotSession::sendSetpoint
+ *      Sends the continuous setpoints as one datagram and keeps the refresh timer
+ *      running while they need repeating
+ */
+void RobotSession::sendSetpoint()
+{
+    if (m_network->sendSetpoint(m_robot, m_state.encodeSetpoint(m_encoder), m_due))
+        m_latency.sent(m_encoder.lastSequence(), m_encoder.lastTimestamp());
+
+    if (m_state.moving())
+        m_stopRepeats = StopRepeats;
+    else if (m_stopRepeats > 0)
+        m_stopRepeats--;
+
+    if (m_stopRepeats == 0)
+        m_setpointTimer->stop();
+    else if (!m_setpointTimer->isActive())
+        m_setpointTimer->start();
+}
+
+void RobotSession::send(CommandOpcode opcode, float first, float second)
+{
+    sendFrame(m_encoder.encode(opcode, first, second));
+}
+
+void RobotSession::send(CommandOpcode opcode, const std::string &text)
+{
+    sendFrame(m_encoder.encode(opcode, text));
+}
+
+void RobotSession::setConnected(bool connected)
+{
+    if (connected == m_connected)
+        return;
+
+    m_connected = connected;
+    emit connectedChanged(connected);
+}
+
+bool RobotSession::replay(const QByteArray &frame)
+{
+    CommandFrame decoded;
+
+    if (frame.size() != (qsizetype)CommandFrameFormat::Size || !CommandFrameDecoder::read(frame.constData(), decoded))
+        return true;
+
+    return sendFrame(m_encoder.encode(decoded));
+}
+
+/**
+ * @brief RobotSession::sendFrame
+ *      The frame's sequence number and timestamp are kept to time its acknowledgement
+ * @param frame - just encoded by m_encoder
+ * @param due - time the frame was scheduled for, or 0
+ * @return false if the worker's queue was full
+ */
+bool RobotSession::sendFrame(const char *frame, uint64_t due)
+{
+    if (!m_network->send(m_robot, frame, due))
+        return false;
+
+    m_latency.sent(m_encoder.lastSequence(), m_encoder.lastTimestamp());
+    return true;
+}
+
+void RobotSession::readTelemetry()
+{
+    bool parsed = false;
+
+    while (m_network->takeTelemetry(m_robot, m_chunk))
+    {
+        // a new connection, drop the partial record the old one left behind
+        if (m_chunk.size == 0)
+        {
+            m_telemetry.clear();
+            continue;
+        }
+
+        m_telemetry.feed(m_chunk.data, m_chunk.size);
+        m_telemetry.parse();
+        parsed = true;
+    }
+
+    if (parsed)
+        emit telemetryUpdated();
+}
@@ -0,0 +1,131 @@
+#ifndef ROBOTSESSION_H
+#define ROBOTSESSION_H
+
+#include <QByteArray>
+#include <QObject>
+
+#include <string>
+
+#include "commandframe.h"
+#include "latencytracker.h"
+#include "networkworker.h"
+#include "robotcommandstate.h"
+#include "telemetryparser.h"
+#include "telemetrystore.h"
+
+class QTimer;
+
+/**
+ * @brief The RobotSession class
+ *      GUI side of one robot: its desired state and command sequence, and the parser,
+ *      store and latency tracker for its telemetry. The connections themselves live
+ *      in the shared NetworkWorker.
+ *
+ *      If the robot takes setpoints as datagrams, they are repeated every
+ *      SetpointRefresh ms while it moves and a few times after it stopped, as any
+ *      single datagram may be lost.
+ */
+class RobotSession : public QObject
+{
+    Q_OBJECT
+
+public:
+    static constexpr int SetpointRefresh = 50;
+    static constexpr int StopRepeats = 5;
+
+    RobotSession(NetworkWorker *network, int robot, size_t memoryCap, QObject *parent = nullptr);
+
+    int index() const { return m_robot; }
+
+    /**
+     * @brief set, add
+     *      Change one field of the desired state; all changes made while handling one
+     *      event are sent together once control returns to the event loop
+     * @param due - CommandFrameEncoder::now() the change was scheduled for, or 0; the
+     *      NetworkWorker times the frame that carries it against this
+     * @return true if the value changed
+     */
+    bool set(RobotField field, float value, uint64_t due = 0);
+    bool add(RobotField field, float step);
+
+    const RobotCommandState &commandState() const { return m_state; }
+
+    /**
+     * @brief requestKeyframe
+     *      Sends every field with the next update
+     */
+    void requestKeyframe();
+
+    /**
+     * @brief send
+     *      Commands that are not part of the robot state
+     */
+    void send(CommandOpcode opcode, float first = 0.f, float second = 0.f);
+    void send(CommandOpcode opcode, const std::string &text);
+
+    bool isConnected() const { return m_connected; }
+
+    TelemetryParser &telemetry() { return m_telemetry; }
+    TelemetryStore &store() { return m_store; }
+    LatencyTracker &latency() { return m_latency; }
+
+signals:
+    void connectedChanged(bool connected);
+
+    /**
+     * @brief telemetryUpdated
+     *      readTelemetry() parsed new telemetry into the store and the latency tracker
+     */
+    void telemetryUpdated();
+
+public slots:
+    /**
+     * @brief readTelemetry
+     *      Drains the telemetry handed over by the network thread
+     */
+    void readTelemetry();
+
+    /**
+     * @brief setConnected
+     *      Called with NetworkWorker::connectionChanged() of this robot
+     */
+    void setConnected(bool connected);
+
+    /**
+     * @brief replay
+     *      Sends a recorded frame again, with this session's next sequence number and
+     *      the current time, so its ack is matched and timed like any other command
+     * @param frame - CommandFrameFormat::Size bytes from a SessionReplayer
+     * @return false if the frame could not be queued; a malformed frame is skipped
+     */
+    bool replay(const QByteArray &frame);
+
+private slots:
+    void sendStateUpdate();
+    void sendSetpoint();
+
+private:
+    bool sendFrame(const char *frame, uint64_t due = 0);
+    void scheduleStateUpdate();
+
+    NetworkWorker *m_network;
+    int m_robot;
+    bool m_connected;
+
+    CommandFrameEncoder m_encoder;
+    RobotCommandState m_state;
+    bool m_updatePending;
+    bool m_keyframeDue;
+    uint64_t m_due;             // earliest scheduled change of the pending update
+
+    bool m_udpSetpoints;
+    int m_stopRepeats;
+    QTimer *m_setpointTimer;
+
+    TelemetryChunk m_chunk;
+    TelemetryParser m_telemetry;
+    TelemetryStore m_store;
+    LatencyTracker m_latency;
+};
+
+#endif // ROBOTSESSION_H
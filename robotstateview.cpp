@@ -0,0 +1,73 @@
+#include "robotstateview.h"
+
+#include <QTimer>
+
+#include "controlcore.h"
+
+RobotStateView::RobotStateView(ControlCore *core, QObject *parent) : QObject(parent),
+    m_core(core),
+    m_dirty(0),
+    m_standingDirty(false),
+    m_frameTimer(new QTimer(this))
+{
+    m_frameTimer->setSingleShot(true);
+    m_frameTimer->setInterval(FrameInterval);
+    connect(m_frameTimer, &QTimer::timeout, this, &RobotStateView::refresh);
+
+    connect(core, &ControlCore::fieldChanged, this, &RobotStateView::fieldChanged);
+    connect(core, &ControlCore::standingChanged, this, &RobotStateView::standingChanged);
+    connect(core, &ControlCore::activeSessionChanged, this, &RobotStateView::sessionChanged);
+}
+
+void RobotStateView::fieldChanged(RobotField field)
+{
+    m_dirty |= 1u << (int)field;
+    schedule();
+}
+
+void RobotStateView::standingChanged()
+{
+    m_standingDirty = true;
+    schedule();
+}
+
+/**
+ * @brief RobotStateView::sessionChanged
+ *      Shows every field of the newly selected robot
+ */
+void RobotStateView::sessionChanged()
+{
+    m_dirty = (1u << (int)RobotField::Count) - 1;
+    schedule();
+}
+
+void RobotStateView::schedule()
+{
+    if (!m_frameTimer->isActive())
+        m_frameTimer->start();
+}
+
+/**
+ * @brief RobotStateView::refresh
+ *      Emits the values as they are now, a field that changed several times since
+ *      the last frame is shown once
+ */
+void RobotStateView::refresh()
+{
+    uint32_t dirty = m_dirty;
+    m_dirty = 0;
+
+    const RobotCommandState &state = m_core->activeSession()->commandState();
+
+    for (int field = 0; field < (int)RobotField::Count; field++)
+    {
+        if (dirty & (1u << field))
+            emit fieldShown((RobotField)field, state.value((RobotField)field));
+    }
+
+    if (m_standingDirty)
+    {
+        m_standingDirty = false;
+        emit standingShown(m_core->standing());
+    }
+}
@@ -0,0 +1,53 @@
+#ifndef ROBOTSTATEVIEW_H
+#define ROBOTSTATEVIEW_H
+
+#include <QObject>
+
+#include <cstdint>
+
+#include "robotcommandstate.h"
+
+class ControlCore;
+class QTimer;
+
+/**
+ * @brief The RobotStateView class
+ *      Adapter between the control path and the widgets. The ControlCore changes the
+ *      active robot's RobotCommandState without touching a widget; this only notes
+ *      which fields changed and, at most once per display frame, emits the current
+ *      value of each of them for the widgets to show. However fast input arrives,
+ *      the LCDs and sliders are updated at the frame rate, and their repaints and
+ *      signals never run between an input and the frame it sends.
+ */
+class RobotStateView : public QObject
+{
+    Q_OBJECT
+
+public:
+    // milliseconds between refreshes
+    static constexpr int FrameInterval = 16;
+
+    explicit RobotStateView(ControlCore *core, QObject *parent = nullptr);
+
+signals:
+    void fieldShown(RobotField field, float value);
+    void standingShown(bool standing);
+
+private slots:
+    void fieldChanged(RobotField field);
+    void standingChanged();
+    void sessionChanged();
+    void refresh();
+
+private:
+    void schedule();
+
+    ControlCore *m_core;
+
+    uint32_t m_dirty;
+    bool m_standingDirty;
+
+    QTimer *m_frameTimer;
+};
+
+#endif // ROBOTSTATEVIEW_H
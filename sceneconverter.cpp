@@ -0,0 +1,182 @@
+#include "sceneconverter.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QXmlStreamReader>
+
+namespace
+{
+
+const char ModelHeader[] =
+        "<mujoco model=\"a1 scene\">\n"
+        "\t<include file=\"a1_arm.xml\"/>\n"
+        "\t<statistic center=\"0 0 0.1\" extent=\"0.8\"/>\n\n"
+        "\t<visual>\n"
+        "\t\t<headlight diffuse=\"0.6 0.6 0.6\" ambient=\"0.3 0.3 0.3\" specular=\"0 0 0;\"/>\n"
+        "\t\t<rgba haze=\"0.15 0.25 0.35 1\"/>\n"
+        "\t\t<global azimuth=\"120\" elevation=\"-20\"/>\n"
+        "\t</visual>\n\n"
+        "\t<asset>\n"
+        "\t\t<texture type=\"skybox\" builtin=\"gradient\" rgb1=\"0.3 0.5 0.7\" rgb2=\"0 0 0\" width=\"512\" height=\"3072\"/>\n"
+        "\t\t<texture type=\"2d\" name=\"groundplane\" builtin=\"checker\" mark=\"edge\" rgb1=\"0.2 0.3 0.4\" rgb2=\"0.1 0.2 0.3\"\n"
+        "\t\t\ttmarkrgb=\"0.8 0.8 0.8\" width=\"300\" height=\"300\"/>\n"
+        "\t\t<material name=\"groundplane\" texture=\"groundplane\" texuniform=\"true\" texrepeat=\"5 5\" reflectance=\"0.2\"/>\n"
+        "\t</asset>\n\n"
+        "\t<worldbody>\n"
+        "\t\t<light pos=\"0 0 1.5\" dir=\"0 0 -1\" directional=\"true\"/>\n"
+        "\t\t<geom name=\"floor\" size=\"0 0 0.05\" type=\"plane\" material=\"groundplane\"/>\n";
+
+const char ModelBody[] =
+        "\t\t<body pos = \"2 2 0\">\n"
+        "\t\t\t<geom type=\"box\" size=\".03 .03 .3\" rgba=\"0 .9 0 1\" mass=\"1\"/>\n"
+        "\t\t</body>\n";
+
+const char ModelFooter[] =
+        "\t</worldbody>\n"
+        "</mujoco>\n";
+
+} // namespace
+
+QString SceneConverter::outputPathFor(const QString &scenePath)
+{
+    QFileInfo scene(scenePath);
+    return scene.dir().filePath(scene.completeBaseName() + ".mujoco.xml");
+}
+
+bool SceneConverter::convert(const QString &scenePath, const QString &modelPath, const Progress &progress)
+{
+    m_cuboids = 0;
+    m_sceneSize = 0;
+    m_cancelled = false;
+    m_error.clear();
+
+    if (QFileInfo(scenePath).canonicalFilePath() == QFileInfo(modelPath).canonicalFilePath()
+            && QFileInfo::exists(modelPath))
+    {
+        m_error = "the model would replace the scene";
+        return false;
+    }
+
+    return countCuboids(scenePath, progress) && writeModel(modelPath, progress);
+}
+
+/**
+ * @brief SceneConverter::countCuboids
+ *      Single pass over the scene. The reader pulls it from the file in small chunks
+ *      as it parses; handing it the whole scene with addData() would copy it, and
+ *      decode the copy at once. Progress counts the bytes read from the file.
+ */
+bool SceneConverter::countCuboids(const QString &scenePath, const Progress &progress)
+{
+    QFile scene(scenePath);
+    if (!scene.open(QIODevice::ReadOnly))
+    {
+        m_error = scene.errorString();
+        return false;
+    }
+
+    QXmlStreamReader reader(&scene);
+
+    qint64 total = scene.size();
+    int tokens = 0;
+    m_sceneSize = total;
+
+    while (!reader.atEnd())
+    {
+        if (progress && ++tokens % ProgressInterval == 0 && !progress(qMin(scene.pos(), total), total))
+        {
+            m_cancelled = true;
+            m_error = "cancelled";
+            break;
+        }
+
+        if (reader.readNext() != QXmlStreamReader::StartElement || reader.name() != QLatin1String("type"))
+            continue;
+
+        if (reader.readElementText(QXmlStreamReader::SkipChildElements).trimmed() == QLatin1String("cuboid"))
+            m_cuboids++;
+    }
+
+    if (!m_cancelled && reader.hasError())
+    {
+        m_error = QString("line %1: %2").arg(reader.lineNumber()).arg(reader.errorString());
+        m_cuboids = 0;
+    }
+
+    if (progress && m_error.isEmpty())
+        progress(total, total);
+
+    return m_error.isEmpty();
+}
+
+bool SceneConverter::writeModel(const QString &modelPath, const Progress &progress)
+{
+    QSaveFile model(modelPath);
+    if (!model.open(QIODevice::WriteOnly))
+    {
+        m_error = model.errorString();
+        return false;
+    }
+
+    m_buffer.resize(0);
+    m_buffer.reserve(WriteBuffer + (int)sizeof(ModelBody));
+
+    const QByteArray body = QByteArray::fromRawData(ModelBody, sizeof(ModelBody) - 1);
+    bool ok = append(model, QByteArray::fromRawData(ModelHeader, sizeof(ModelHeader) - 1));
+
+    for (int i = 0; ok && i < m_cuboids / 2; ++i)
+    {
+        ok = append(model, body);
+
+        if (progress && i % ProgressInterval == 0 && !progress(m_sceneSize, m_sceneSize))
+        {
+            m_cancelled = true;
+            break;
+        }
+    }
+
+    if (m_cancelled)
+    {
+        m_error = "cancelled";
+        m_buffer = QByteArray();
+        model.cancelWriting();
+        return false;
+    }
+
+    ok = ok && append(model, QByteArray::fromRawData(ModelFooter, sizeof(ModelFooter) - 1));
+
+    if (ok && !m_buffer.isEmpty())
+        ok = model.write(m_buffer) == m_buffer.size();
+
+    m_buffer = QByteArray();
+
+    if (!ok)
+    {
+        m_error = model.errorString();
+        model.cancelWriting();
+        return false;
+    }
+
+    // replaces the model only now, a failed conversion leaves it as it was
+    if (!model.commit())
+    {
+        m_error = model.errorString();
+        return false;
+    }
+
+    return true;
+}
+
+bool SceneConverter::append(QSaveFile &file, const QByteArray &data)
+{
+    m_buffer.append(data);
+
+    if (m_buffer.size() < WriteBuffer)
+        return true;
+
+    bool ok = file.write(m_buffer) == m_buffer.size();
+    m_buffer.resize(0);
+    return ok;
+}
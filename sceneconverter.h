@@ -0,0 +1,67 @@
+#ifndef SCENECONVERTER_H
+#define SCENECONVERTER_H
+
+#include <QByteArray>
+#include <QString>
+
+#include <functional>
+
+class QSaveFile;
+
+/**
+ * @brief The SceneConverter class
+ *      Turns a scene file into a MuJoCo model: every two <type>cuboid</type> elements
+ *      of the scene become one box body in the model's worldbody.
+ *
+ *      The scene is read once with QXmlStreamReader, which pulls it from the file in
+ *      small chunks, so memory use does not grow with its size. The model is assembled in a fixed size buffer and
+ *      written to a QSaveFile, which only replaces the output file once everything is
+ *      written; the scene itself is never modified. Only needs QtCore, so it can run
+ *      on any thread.
+ */
+class SceneConverter
+{
+public:
+    // bytes gathered before each write of the output
+    static constexpr int WriteBuffer = 64 * 1024;
+
+    // XML tokens read between progress reports
+    static constexpr int ProgressInterval = 4096;
+
+    /**
+     * @brief Progress
+     *      Called with the scene bytes read so far and the scene size, and with both
+     *      at the scene size while the model is written
+     * @return false to cancel the conversion
+     */
+    using Progress = std::function<bool(qint64 done, qint64 total)>;
+
+    /**
+     * @brief outputPathFor
+     * @return the model path next to a scene: scene.xml gives scene.mujoco.xml
+     */
+    static QString outputPathFor(const QString &scenePath);
+
+    /**
+     * @brief convert
+     * @return false on a read, parse or write error or when cancelled, see errorString()
+     */
+    bool convert(const QString &scenePath, const QString &modelPath, const Progress &progress = Progress());
+
+    int cuboids() const { return m_cuboids; }
+    bool cancelled() const { return m_cancelled; }
+    QString errorString() const { return m_error; }
+
+private:
+    bool countCuboids(const QString &scenePath, const Progress &progress);
+    bool writeModel(const QString &modelPath, const Progress &progress);
+    bool append(QSaveFile &file, const QByteArray &data);
+
+    int m_cuboids = 0;
+    qint64 m_sceneSize = 0;
+    bool m_cancelled = false;
+    QString m_error;
+    QByteArray m_buffer;
+};
+
+#endif // SCENECONVERTER_H
@@ -0,0 +1,352 @@
+#include "scriptdriver.h"
+
+#include <QFile>
+#include <QTimer>
+#include <QtMath>
+
+#ifdef Q_OS_UNIX
+#include <QSocketNotifier>
+#include <unistd.h>
+#endif
+
+#include "controlcore.h"
+
+namespace
+{
+
+bool parseField(const QString &name, RobotField &field)
+{
+    static const struct
+    {
+        const char *name;
+        RobotField field;
+    } fields[] = {
+        {"height", RobotField::Height},
+        {"rotate", RobotField::ArmRotate},
+        {"extend", RobotField::ArmExtend},
+        {"arm", RobotField::ArmHeight},
+        {"angle", RobotField::GripAngle},
+        {"grip", RobotField::Grip},
+    };
+
+    for (const auto &entry : fields)
+    {
+        if (name == QLatin1String(entry.name))
+        {
+            field = entry.field;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+} // namespace
+
+//---------------------------------- CONSTRUCTOR ------------------------------------
+
+ScriptDriver::ScriptDriver(ControlCore *core, QObject *parent) : QObject(parent),
+    m_core(core),
+    m_inputDone(false),
+    m_started(false),
+    m_quit(false),
+    m_lineNumber(0),
+    m_sweepLength(0),
+    m_notifier(nullptr)
+{
+    m_waitTimer = new QTimer(this);
+    m_waitTimer->setSingleShot(true);
+    m_waitTimer->setTimerType(Qt::PreciseTimer);
+    connect(m_waitTimer, &QTimer::timeout, this, &ScriptDriver::step);
+
+    m_sweepTimer = new QTimer(this);
+    m_sweepTimer->setTimerType(Qt::PreciseTimer);
+    connect(m_sweepTimer, &QTimer::timeout, this, &ScriptDriver::sweep);
+
+    for (RobotSession *session : m_core->sessions())
+        connect(session, &RobotSession::connectedChanged, this, &ScriptDriver::step);
+}
+
+//---------------------------------- INPUT ------------------------------------
+
+bool ScriptDriver::open(const QString &path)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+    {
+        qWarning("cannot open script %s: %s", qPrintable(path), qPrintable(file.errorString()));
+        return false;
+    }
+
+    m_lines = QString::fromUtf8(file.readAll()).split('\n');
+    m_inputDone = true;
+    return true;
+}
+
+void ScriptDriver::readStandardInput()
+{
+#ifdef Q_OS_UNIX
+    m_notifier = new QSocketNotifier(STDIN_FILENO, QSocketNotifier::Read, this);
+    connect(m_notifier, &QSocketNotifier::activated, this, &ScriptDriver::readInput);
+#else
+    QFile input;
+    if (input.open(stdin, QIODevice::ReadOnly | QIODevice::Text))
+        m_lines = QString::fromUtf8(input.readAll()).split('\n');
+
+    m_inputDone = true;
+#endif
+}
+
+/**
+ * @brief ScriptDriver::readInput
+ *      Takes whatever is available on stdin without blocking the event loop
+ */
+void ScriptDriver::readInput()
+{
+#ifdef Q_OS_UNIX
+    char buffer[4096];
+    ssize_t length = ::read(STDIN_FILENO, buffer, sizeof(buffer));
+
+    if (length <= 0)
+    {
+        m_notifier->setEnabled(false);
+
+        if (!m_partial.isEmpty())
+            m_lines.append(QString::fromUtf8(m_partial));
+
+        m_partial.clear();
+        m_inputDone = true;
+    }
+    else
+    {
+        m_partial.append(buffer, length);
+
+        int end;
+        while ((end = m_partial.indexOf('\n')) >= 0)
+        {
+            m_lines.append(QString::fromUtf8(m_partial.left(end)));
+            m_partial.remove(0, end + 1);
+        }
+    }
+
+    step();
+#endif
+}
+
+//---------------------------------- EXECUTION ------------------------------------
+
+void ScriptDriver::start()
+{
+    m_started = true;
+    QTimer::singleShot(0, this, &ScriptDriver::step);
+}
+
+/**
+ * @brief ScriptDriver::step
+ *      Runs queued commands until a wait, the end of the input read so far, quit, or
+ *      a robot that is not connected
+ */
+void ScriptDriver::step()
+{
+    if (!m_started || m_quit || m_waitTimer->isActive() || m_sweepTimer->isActive())
+        return;
+
+    while (!m_lines.isEmpty())
+    {
+        if (!connected())
+            return;
+
+        QString line = m_lines.takeFirst().trimmed();
+        m_lineNumber++;
+
+        if (line.isEmpty() || line.startsWith('#'))
+            continue;
+
+        if (!execute(line))
+            qWarning("script line %d: cannot run \"%s\"", m_lineNumber, qPrintable(line));
+
+        if (m_quit)
+        {
+            if (m_notifier)
+                m_notifier->setEnabled(false);
+
+            emit quitRequested();
+            emit finished();
+            return;
+        }
+
+        if (m_waitTimer->isActive() || m_sweepTimer->isActive())
+            return;
+    }
+
+    if (m_inputDone)
+    {
+        m_quit = true;
+        emit finished();
+    }
+}
+
+bool ScriptDriver::connected() const
+{
+    for (const RobotSession *session : m_core->sessions())
+    {
+        if (!session->isConnected())
+            return false;
+    }
+
+    return true;
+}
+
+bool ScriptDriver::execute(const QString &line)
+{
+    const QStringList words = line.split(' ', Qt::SkipEmptyParts);
+    const QString &command = words.first();
+    bool ok = true;
+
+    auto number = [&](int i) {
+        bool valid = false;
+        double value = words.value(i).toDouble(&valid);
+        ok = ok && valid;
+        return value;
+    };
+
+    if (command == "key" && words.size() == 2 && words[1].size() == 1 && words[1][0].isLetter())
+        return m_core->handleKey(Qt::Key_A + (words[1][0].toUpper().unicode() - 'A'));
+
+    if (command == "vx" && words.size() == 2)
+    {
+        float vx = number(1);
+        if (ok)
+            m_core->setVelocityX(vx);
+    }
+    else if (command == "vy" && words.size() == 2)
+    {
+        float vy = number(1);
+        if (ok)
+            m_core->setVelocityY(vy);
+    }
+    else if (command == "stand" && words.size() == 1)
+        m_core->stand();
+    else if (command == "trot" && words.size() == 1)
+        m_core->trot();
+    else if (command == "nudge" && words.size() == 3)
+    {
+        RobotField field;
+        int direction = (int)number(2);
+
+        if (!parseField(words[1], field) || !ok || direction == 0)
+            return false;
+
+        m_core->nudge(field, direction);
+    }
+    else if (command == "axes" && words.size() == 2)
+    {
+        if (words[1] == "none")
+            m_core->setPoseAxes(ControlCore::PoseAxes::None);
+        else if (words[1] == "roll")
+            m_core->setPoseAxes(ControlCore::PoseAxes::Roll);
+        else if (words[1] == "pitch")
+            m_core->setPoseAxes(ControlCore::PoseAxes::Pitch);
+        else if (words[1] == "both")
+            m_core->setPoseAxes(ControlCore::PoseAxes::Both);
+        else
+            return false;
+    }
+    else if (command == "pose" && words.size() == 3)
+    {
+        float x = number(1);
+        float y = number(2);
+        if (ok)
+            m_core->setPose(x, y, true, true);
+    }
+    else if (command == "view" && words.size() == 2)
+    {
+        float view = number(1);
+        if (ok)
+            m_core->setView(view);
+    }
+    else if (command == "search" && words.size() >= 2)
+        return m_core->sensorSearch(line.section(' ', 1, -1, QString::SectionSkipEmpty));
+    else if (command == "robot" && words.size() == 2)
+    {
+        int index = words[1].toInt(&ok);
+        if (!ok || index < 0 || index >= m_core->sessions().size())
+            return false;
+
+        m_core->selectRobot(index);
+    }
+    else if (command == "pad" && words.size() >= 4)
+    {
+        short uID = words[1].toShort(&ok);
+        if (!ok || uID < 0 || uID >= ClientOptions::MaxControllers)
+            return false;
+
+        if (words[2] == "buttons" && words.size() == 4)
+        {
+            quint16 buttons = words[3].toUShort(&ok, 0);
+            if (ok)
+                m_core->handleButtons(uID, buttons);
+        }
+        else if ((words[2] == "left" || words[2] == "right") && words.size() == 5)
+        {
+            double x = number(3);
+            double y = number(4);
+
+            if (ok && words[2] == "left")
+                m_core->handleLeftStick(uID, x, y);
+            else if (ok)
+                m_core->handleRightStick(uID, x, y);
+        }
+        else
+            return false;
+    }
+    else if (command == "wait" && words.size() == 2)
+    {
+        int ms = words[1].toInt(&ok);
+        if (ok && ms >= 0)
+            m_waitTimer->start(ms);
+    }
+    else if (command == "sweep" && words.size() == 3)
+    {
+        double seconds = number(1);
+        double rate = number(2);
+
+        if (!ok || seconds <= 0 || rate <= 0 || rate > 1000)
+            return false;
+
+        m_sweepLength = (qint64)(seconds * 1e9);
+        m_sweepClock.start();
+        m_sweepTimer->start(qMax(1, (int)std::lround(1000.0 / rate)));
+    }
+    else if (command == "quit" && words.size() == 1)
+        m_quit = true;
+    else
+        return false;
+
+    return ok;
+}
+
+/**
+ * @brief ScriptDriver::sweep
+ *      One update of a sweep: every robot's velocity goes round a circle once every
+ *      two seconds, so each update changes both fields. Benchmarks the whole client
+ *      path, from RobotSession through the NetworkWorker to the simulator and back.
+ */
+void ScriptDriver::sweep()
+{
+    const qint64 elapsed = m_sweepClock.nsecsElapsed();
+    const bool done = elapsed >= m_sweepLength;
+    const double angle = M_PI * (double)elapsed / 1e9;
+
+    for (RobotSession *session : m_core->sessions())
+    {
+        session->set(RobotField::VelocityX, done ? 0.f : (float)std::cos(angle));
+        session->set(RobotField::VelocityY, done ? 0.f : (float)std::sin(angle));
+    }
+
+    if (done)
+    {
+        m_sweepTimer->stop();
+        step();
+    }
+}
@@ -0,0 +1,97 @@
+#ifndef SCRIPTDRIVER_H
+#define SCRIPTDRIVER_H
+
+#include <QElapsedTimer>
+#include <QObject>
+#include <QString>
+#include <QStringList>
+
+class ControlCore;
+class QSocketNotifier;
+class QTimer;
+
+/**
+ * @brief The ScriptDriver class
+ *      Drives a ControlCore from a script file or from standard input, one command per
+ *      line, for --headless runs:
+ *
+ *          key <letter>                    same as pressing the key in the window
+ *          vx <value>, vy <value>          velocity
+ *          stand, trot
+ *          nudge <field> <1|-1>            height, rotate, extend, arm, angle or grip
+ *          axes none|roll|pitch|both       JoyPad axes that drive the pose
+ *          pose <x> <y>                    JoyPad position, -1 to 1
+ *          view <1-5>
+ *          search <text>
+ *          robot <index>                   selects the robot the commands go to
+ *          pad <id> buttons <mask>         XboxOneButtons bitmask from gamepad <id>
+ *          pad <id> left|right <x> <y>     thumbstick of gamepad <id>
+ *          wait <ms>
+ *          sweep <seconds> <rate>          moves vx and vy of every robot along a circle,
+ *                                          <rate> updates per second, then stops them
+ *          quit
+ *
+ *      Empty lines and lines starting with # are skipped. Commands are held back until
+ *      every robot is connected, and again while one is not, so none of them are lost
+ *      to a simulator that is still starting. The driver finishes at quit or when the
+ *      input ends.
+ */
+class ScriptDriver : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit ScriptDriver(ControlCore *core, QObject *parent = nullptr);
+
+    /**
+     * @brief open
+     *      Reads the whole script file
+     */
+    bool open(const QString &path);
+
+    /**
+     * @brief readStandardInput
+     *      Runs commands as they are typed or piped in. Elsewhere than on Unix the
+     *      whole input is read before the first command runs.
+     */
+    void readStandardInput();
+
+    void start();
+
+signals:
+    void finished();
+
+    /**
+     * @brief quitRequested
+     *      The script ran quit, emitted just before finished()
+     */
+    void quitRequested();
+
+private slots:
+    void step();
+    void readInput();
+    void sweep();
+
+private:
+    bool execute(const QString &line);
+    bool connected() const;
+
+    ControlCore *m_core;
+
+    QStringList m_lines;
+    QByteArray m_partial;
+    bool m_inputDone;
+    bool m_started;
+    bool m_quit;
+    int m_lineNumber;
+
+    QTimer *m_waitTimer;
+
+    QTimer *m_sweepTimer;
+    QElapsedTimer m_sweepClock;
+    qint64 m_sweepLength;       // nanoseconds
+
+    QSocketNotifier *m_notifier;
+};
+
+#endif // SCRIPTDRIVER_H
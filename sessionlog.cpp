@@ -0,0 +1,269 @@
+#include "sessionlog.h"
+
+#include <QDateTime>
+#include <QtEndian>
+
+#include <algorithm>
+#include <cstring>
+
+#include "commandframe.h"
+
+static const char Magic[8] = {'R', 'G', 'S', 'E', 'S', 'S', 0, 1};
+static const qint64 GrowthStep = 64 * 1024 * 1024;
+
+static inline qint64 padded(qint64 length)
+{
+    return (length + 7) & ~qint64(7);
+}
+
+//---------------------------------- RECORDER ------------------------------------
+
+SessionRecorder::SessionRecorder() :
+    m_map(nullptr),
+    m_mapped(0),
+    m_used(0),
+    m_nextIndexOffset(0)
+{
+}
+
+SessionRecorder::~SessionRecorder()
+{
+    close();
+}
+
+/**
+ * @brief SessionRecorder::open
+ * @param path - log file, replaced if it exists; the index goes to path + ".idx"
+ * @return false if either file can not be created or mapped
+ */
+bool SessionRecorder::open(const QString &path)
+{
+    close();
+
+    m_log.setFileName(path);
+    m_index.setFileName(path + ".idx");
+
+    if (!m_log.open(QIODevice::ReadWrite | QIODevice::Truncate) ||
+        !m_index.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+        m_log.close();
+        m_index.close();
+        return false;
+    }
+
+    if (!remap(GrowthStep))
+    {
+        m_log.close();
+        m_index.close();
+        return false;
+    }
+
+    std::memcpy(m_map, Magic, sizeof(Magic));
+    qToLittleEndian<quint32>(SessionLogFormat::Version, m_map + 8);
+    qToLittleEndian<quint32>(SessionLogFormat::HeaderSize, m_map + 12);
+    qToLittleEndian<quint64>(CommandFrameEncoder::now(), m_map + 16);
+    qToLittleEndian<quint64>(QDateTime::currentMSecsSinceEpoch(), m_map + 24);
+
+    m_used = SessionLogFormat::HeaderSize;
+    m_nextIndexOffset = m_used;
+
+    return true;
+}
+
+/**
+ * @brief SessionRecorder::close
+ *      Cuts the log back to the bytes actually written
+ */
+void SessionRecorder::close()
+{
+    if (!m_log.isOpen())
+        return;
+
+    if (m_map)
+        m_log.unmap(m_map);
+    m_map = nullptr;
+    m_mapped = 0;
+
+    m_log.resize(m_used);
+    m_log.close();
+    m_index.close();
+}
+
+bool SessionRecorder::remap(qint64 size)
+{
+    if (m_map)
+        m_log.unmap(m_map);
+
+    m_map = nullptr;
+
+    if (!m_log.resize(size))
+        return false;
+
+    m_map = m_log.map(0, size);
+    m_mapped = m_map ? size : 0;
+
+    return m_map != nullptr;
+}
+
+/**
+ * @brief SessionRecorder::append
+ * @param kind
+ * @param timestamp - microseconds on the CommandFrameEncoder::now() clock
+ * @param data
+ * @param length
+ */
+void SessionRecorder::append(SessionRecord::Kind kind, uint64_t timestamp, const char *data, uint32_t length)
+{
+    if (!m_map)
+        return;
+
+    qint64 size = SessionLogFormat::RecordHeaderSize + padded(length);
+
+    // keep room for the end marker
+    if (m_used + size + SessionLogFormat::RecordHeaderSize > m_mapped)
+    {
+        if (!remap(m_mapped + qMax(GrowthStep, padded(size) * 2)))
+        {
+            close();
+            return;
+        }
+    }
+
+    if (m_used >= m_nextIndexOffset)
+    {
+        quint64 entry[2] = { qToLittleEndian<quint64>(timestamp), qToLittleEndian<quint64>(m_used) };
+        m_index.write((const char *)entry, sizeof(entry));
+        m_nextIndexOffset = m_used + SessionLogFormat::IndexInterval;
+    }
+
+    uchar *out = m_map + m_used;
+    qToLittleEndian<quint64>(timestamp, out);
+    qToLittleEndian<quint32>(length, out + 8);
+    out[12] = kind;
+    out[13] = out[14] = out[15] = 0;
+    std::memcpy(out + SessionLogFormat::RecordHeaderSize, data, length);
+
+    m_used += size;
+}
+
+//---------------------------------- READER ------------------------------------
+
+SessionReader::SessionReader() :
+    m_map(nullptr),
+    m_size(0),
+    m_offset(0),
+    m_start(0)
+{
+}
+
+SessionReader::~SessionReader()
+{
+    close();
+}
+
+bool SessionReader::open(const QString &path)
+{
+    close();
+
+    m_log.setFileName(path);
+    if (!m_log.open(QIODevice::ReadOnly) || m_log.size() < SessionLogFormat::HeaderSize)
+    {
+        m_log.close();
+        return false;
+    }
+
+    m_size = m_log.size();
+    m_map = m_log.map(0, m_size);
+
+    if (!m_map || std::memcmp(m_map, Magic, sizeof(Magic)) != 0 ||
+        qFromLittleEndian<quint32>(m_map + 8) != SessionLogFormat::Version)
+    {
+        close();
+        return false;
+    }
+
+    m_start = qFromLittleEndian<quint64>(m_map + 16);
+    m_offset = qFromLittleEndian<quint32>(m_map + 12);
+
+    // the index is optional, without it seek() scans
+    QFile index(path + ".idx");
+    if (index.open(QIODevice::ReadOnly))
+    {
+        QByteArray raw = index.readAll();
+        const uchar *p = (const uchar *)raw.constData();
+
+        for (qsizetype i = 0; i + 16 <= raw.size(); i += 16)
+            m_index.push_back(IndexEntry{qFromLittleEndian<quint64>(p + i), qFromLittleEndian<quint64>(p + i + 8)});
+    }
+
+    return true;
+}
+
+void SessionReader::close()
+{
+    if (m_map)
+        m_log.unmap(const_cast<uchar *>(m_map));
+
+    m_map = nullptr;
+    m_size = 0;
+    m_offset = 0;
+    m_index.clear();
+    m_log.close();
+}
+
+bool SessionReader::readAt(qint64 offset, SessionRecord &record, qint64 &nextOffset) const
+{
+    if (!m_map || offset + SessionLogFormat::RecordHeaderSize > m_size)
+        return false;
+
+    const uchar *in = m_map + offset;
+    record.timestamp = qFromLittleEndian<quint64>(in);
+    record.length = qFromLittleEndian<quint32>(in + 8);
+    record.kind = (SessionRecord::Kind)in[12];
+    record.data = (const char *)in + SessionLogFormat::RecordHeaderSize;
+
+    nextOffset = offset + SessionLogFormat::RecordHeaderSize + padded(record.length);
+
+    if (record.kind == SessionRecord::End || nextOffset > m_size)
+        return false;
+
+    return true;
+}
+
+/**
+ * @brief SessionReader::next
+ * @param record - valid until the reader is closed
+ * @return false at the end of the log
+ */
+bool SessionReader::next(SessionRecord &record)
+{
+    qint64 nextOffset;
+
+    if (!readAt(m_offset, record, nextOffset))
+        return false;
+
+    m_offset = nextOffset;
+    return true;
+}
+
+void SessionReader::seek(uint64_t timestamp)
+{
+    rewind();
+
+    // last index entry before the timestamp, then scan forward
+    auto it = std::upper_bound(m_index.begin(), m_index.end(), timestamp,
+                               [](uint64_t t, const IndexEntry &entry) { return t < entry.timestamp; });
+    if (it != m_index.begin())
+        m_offset = (qint64)(it - 1)->offset;
+
+    SessionRecord record;
+    qint64 nextOffset;
+
+    while (readAt(m_offset, record, nextOffset) && record.timestamp < timestamp)
+        m_offset = nextOffset;
+}
+
+void SessionReader::rewind()
+{
+    m_offset = m_map ? qFromLittleEndian<quint32>(m_map + 12) : 0;
+}
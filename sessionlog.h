@@ -0,0 +1,127 @@
+#ifndef SESSIONLOG_H
+#define SESSIONLOG_H
+
+#include <QFile>
+#include <QString>
+
+#include <cstdint>
+#include <vector>
+
+/*
+ *  Session log file layout, all integers little-endian:
+ *
+ *      header   32 bytes   "RGSESS\0\1", u32 version, u32 header size,
+ *                          u64 monotonic start (us), u64 wall clock start (ms since epoch)
+ *      records  16 bytes   u64 timestamp (us, monotonic), u32 payload length,
+ *                          u8 kind, 3 reserved bytes
+ *               payload    padded to a multiple of 8 bytes
+ *
+ *  A record with length 0 and kind 0 marks the end, which is what an unfinished
+ *  file left behind by a crash reads as.
+ *
+ *  Next to the log an index file (<log>.idx) holds u64 timestamp / u64 offset pairs,
+ *  one for roughly every 64 KB of log, so a reader can seek by time.
+ */
+
+namespace SessionLogFormat
+{
+    constexpr int HeaderSize = 32;
+    constexpr int RecordHeaderSize = 16;
+    constexpr uint32_t Version = 1;
+    constexpr qint64 IndexInterval = 64 * 1024;
+}
+
+/**
+ * @brief The SessionRecord struct
+ *      data points into the reader's mapping
+ */
+struct SessionRecord
+{
+    enum Kind : uint8_t
+    {
+        End = 0,
+        Command = 1,
+        Telemetry = 2
+    };
+
+    uint64_t timestamp = 0;
+    Kind kind = End;
+    const char *data = nullptr;
+    uint32_t length = 0;
+};
+
+/**
+ * @brief The SessionRecorder class
+ *      Append-only writer. The log is memory mapped and grown in large steps, so
+ *      appending a record is a memcpy into the mapping and never a system call on
+ *      the hot path. Not thread safe; use it from the thread doing the I/O.
+ */
+class SessionRecorder
+{
+public:
+    SessionRecorder();
+    ~SessionRecorder();
+
+    bool open(const QString &path);
+    void close();
+    bool isOpen() const { return m_map != nullptr; }
+
+    void append(SessionRecord::Kind kind, uint64_t timestamp, const char *data, uint32_t length);
+
+    qint64 bytesWritten() const { return m_used; }
+    QString errorString() const { return m_log.errorString(); }
+
+private:
+    bool remap(qint64 size);
+
+    QFile m_log;
+    QFile m_index;
+    uchar *m_map;
+    qint64 m_mapped;
+    qint64 m_used;
+    qint64 m_nextIndexOffset;
+};
+
+/**
+ * @brief The SessionReader class
+ *      Maps a whole session log read-only and walks its records
+ */
+class SessionReader
+{
+public:
+    SessionReader();
+    ~SessionReader();
+
+    bool open(const QString &path);
+    void close();
+
+    uint64_t startTimestamp() const { return m_start; }
+
+    bool next(SessionRecord &record);
+
+    /**
+     * @brief seek
+     *      Positions the reader on the first record at or after timestamp
+     */
+    void seek(uint64_t timestamp);
+    void rewind();
+
+private:
+    bool readAt(qint64 offset, SessionRecord &record, qint64 &nextOffset) const;
+
+    QFile m_log;
+    const uchar *m_map;
+    qint64 m_size;
+    qint64 m_offset;
+    uint64_t m_start;
+
+    struct IndexEntry
+    {
+        uint64_t timestamp;
+        uint64_t offset;
+    };
+
+    std::vector<IndexEntry> m_index;
+};
+
+#endif // SESSIONLOG_H
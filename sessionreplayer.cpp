@@ -0,0 +1,133 @@
+#include "sessionreplayer.h"
+
+#include <QTimer>
+
+SessionReplayer::SessionReplayer(QObject *parent) : QObject(parent),
+    m_hasNext(false),
+    m_started(false),
+    m_waiting(false),
+    m_firstTimestamp(0),
+    m_speed(1),
+    m_timer(new QTimer(this))
+{
+    m_timer->setSingleShot(true);
+    m_timer->setTimerType(Qt::PreciseTimer);
+    connect(m_timer, &QTimer::timeout, this, &SessionReplayer::step);
+}
+
+void SessionReplayer::setSender(const Sender &sender)
+{
+    m_sender = sender;
+}
+
+bool SessionReplayer::open(const QString &path)
+{
+    stop();
+    return m_reader.open(path);
+}
+
+void SessionReplayer::setSpeed(double speed)
+{
+    m_speed = qMax(0.0, speed);
+}
+
+double SessionReplayer::speed() const
+{
+    return m_speed;
+}
+
+/**
+ * @brief SessionReplayer::start
+ *      Starts from the first recorded command
+ */
+void SessionReplayer::start()
+{
+    m_reader.rewind();
+    m_hasNext = false;
+    m_started = true;
+    m_waiting = false;
+
+    while (m_reader.next(m_next))
+    {
+        if (m_next.kind == SessionRecord::Command)
+        {
+            m_hasNext = true;
+            break;
+        }
+    }
+
+    if (!m_hasNext)
+    {
+        emit finished();
+        return;
+    }
+
+    m_firstTimestamp = m_next.timestamp;
+    m_clock.start();
+    step();
+}
+
+void SessionReplayer::stop()
+{
+    m_timer->stop();
+    m_hasNext = false;
+    m_started = false;
+    m_waiting = false;
+}
+
+void SessionReplayer::resume()
+{
+    if (!m_waiting)
+        return;
+
+    m_waiting = false;
+    step();
+}
+
+/**
+ * @brief SessionReplayer::step
+ *      Sends every command that is due and sleeps until the next one. The sleep is
+ *      rounded up to whole milliseconds, so a frame is never sent early and the timer
+ *      only fires with 0 ms once the frame really is due. More than BurstSize due
+ *      frames, or a refused one, wait for resume().
+ */
+void SessionReplayer::step()
+{
+    int sent = 0;
+
+    while (m_hasNext)
+    {
+        if (m_speed > 0)
+        {
+            qint64 due = (qint64)((m_next.timestamp - m_firstTimestamp) / m_speed);
+            qint64 now = m_clock.nsecsElapsed() / 1000;
+
+            if (due > now)
+            {
+                m_timer->start((int)((due - now + 999) / 1000));
+                return;
+            }
+        }
+
+        if (sent == BurstSize || !m_sender(QByteArray::fromRawData(m_next.data, (int)m_next.length)))
+        {
+            m_waiting = true;
+            emit waiting();
+            return;
+        }
+
+        sent++;
+
+        m_hasNext = false;
+        while (m_reader.next(m_next))
+        {
+            if (m_next.kind == SessionRecord::Command)
+            {
+                m_hasNext = true;
+                break;
+            }
+        }
+    }
+
+    emit finished();
+}
@@ -0,0 +1,97 @@
+#ifndef SESSIONREPLAYER_H
+#define SESSIONREPLAYER_H
+
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QObject>
+
+#include <functional>
+
+#include "sessionlog.h"
+
+class QTimer;
+
+/**
+ * @brief The SessionReplayer class
+ *      Plays the commands of a recorded session back with their original spacing,
+ *      scaled by a speed factor, or as fast as possible with speed 0.
+ *
+ *      Frames go out through the Sender in bursts of at most BurstSize. After a burst,
+ *      or when the Sender refuses a frame, the replayer emits waiting() and holds the
+ *      rest back until resume(), which the caller invokes once the frames sent so far
+ *      were written; a refused frame is offered again. Nothing is lost to a full queue
+ *      however fast the replay runs.
+ */
+class SessionReplayer : public QObject
+{
+    Q_OBJECT
+
+public:
+    // frames sent before waiting for them to be written, well below the high-water
+    // mark above which NetworkWorker drops state updates
+    static constexpr int BurstSize = 16;
+
+    /**
+     * @brief Sender
+     *      Called with the recorded frame bytes; the array does not own them and is
+     *      only valid during the call
+     * @return false if the frame could not be queued
+     */
+    using Sender = std::function<bool(const QByteArray &frame)>;
+
+    explicit SessionReplayer(QObject *parent = nullptr);
+
+    void setSender(const Sender &sender);
+
+    bool open(const QString &path);
+
+    /**
+     * @brief setSpeed
+     * @param speed - 1 for real time, N for N times faster, 0 for as fast as possible
+     */
+    void setSpeed(double speed);
+    double speed() const;
+
+    /**
+     * @brief isStarted
+     * @return true once start() ran, until stop()
+     */
+    bool isStarted() const { return m_started; }
+
+signals:
+    /**
+     * @brief waiting
+     *      A burst went out or a frame was refused, call resume() once it was written
+     */
+    void waiting();
+    void finished();
+
+public slots:
+    void start();
+    void stop();
+
+    /**
+     * @brief resume
+     *      Continues after waiting()
+     */
+    void resume();
+
+private slots:
+    void step();
+
+private:
+    Sender m_sender;
+
+    SessionReader m_reader;
+    SessionRecord m_next;
+    bool m_hasNext;
+    bool m_started;
+    bool m_waiting;
+    uint64_t m_firstTimestamp;
+
+    double m_speed;
+    QElapsedTimer m_clock;
+    QTimer *m_timer;
+};
+
+#endif // SESSIONREPLAYER_H
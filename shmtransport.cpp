@@ -0,0 +1,541 @@
+#include "shmtransport.h"
+
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <new>
+
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "shared rings need lock-free 64 bit atomics");
+static_assert(sizeof(ShmRegionHeader) == 64, "ShmRegionHeader layout");
+static_assert(sizeof(ShmRingHeader) == 192, "ShmRingHeader layout");
+
+// offsets of the two ring headers and the ring data, see the layout in shmtransport.h
+static const size_t CommandHeaderOffset = sizeof(ShmRegionHeader);
+static const size_t TelemetryHeaderOffset = CommandHeaderOffset + sizeof(ShmRingHeader);
+static const size_t DataOffset = TelemetryHeaderOffset + sizeof(ShmRingHeader);
+
+// the futex word is shared between processes, so no FUTEX_PRIVATE_FLAG
+static long futex(std::atomic<uint32_t> *word, int op, uint32_t value, const struct timespec *timeout)
+{
+    return syscall(SYS_futex, reinterpret_cast<uint32_t *>(word), op, value, timeout, nullptr, 0);
+}
+
+static bool isPowerOfTwo(size_t value)
+{
+    return value >= 2 && (value & (value - 1)) == 0;
+}
+
+//---------------------------------- RING ------------------------------------
+
+char *ShmRing::reserve(size_t &available)
+{
+    uint64_t head = m_header->head.load(std::memory_order_relaxed);
+    uint64_t tail = m_header->tail.load(std::memory_order_acquire);
+
+    size_t offset = (size_t)(head & (m_capacity - 1));
+    size_t free = m_capacity - (size_t)(head - tail);
+
+    // only up to the end of the buffer, the rest comes with the next reserve()
+    available = free < m_capacity - offset ? free : m_capacity - offset;
+    return m_data + offset;
+}
+
+void ShmRing::commit(size_t length)
+{
+    m_header->head.store(m_header->head.load(std::memory_order_relaxed) + length, std::memory_order_release);
+    m_header->doorbell.fetch_add(1, std::memory_order_seq_cst);
+
+    if (m_header->sleeping.load(std::memory_order_seq_cst))
+        futex(&m_header->doorbell, FUTEX_WAKE, 1, nullptr);
+}
+
+bool ShmRing::write(const void *data, size_t length)
+{
+    uint64_t head = m_header->head.load(std::memory_order_relaxed);
+    uint64_t tail = m_header->tail.load(std::memory_order_acquire);
+
+    if (m_capacity - (size_t)(head - tail) < length)
+        return false;
+
+    const char *bytes = static_cast<const char *>(data);
+    size_t offset = (size_t)(head & (m_capacity - 1));
+    size_t first = length < m_capacity - offset ? length : m_capacity - offset;
+
+    std::memcpy(m_data + offset, bytes, first);
+    std::memcpy(m_data, bytes + first, length - first);
+
+    commit(length);
+    return true;
+}
+
+const char *ShmRing::peek(size_t &available)
+{
+    uint64_t tail = m_header->tail.load(std::memory_order_relaxed);
+    uint64_t head = m_header->head.load(std::memory_order_acquire);
+
+    size_t offset = (size_t)(tail & (m_capacity - 1));
+    size_t used = (size_t)(head - tail);
+
+    available = used < m_capacity - offset ? used : m_capacity - offset;
+    return m_data + offset;
+}
+
+void ShmRing::consume(size_t length)
+{
+    m_header->tail.store(m_header->tail.load(std::memory_order_relaxed) + length, std::memory_order_release);
+}
+
+size_t ShmRing::readable() const
+{
+    return (size_t)(m_header->head.load(std::memory_order_acquire) - m_header->tail.load(std::memory_order_relaxed));
+}
+
+/**
+ * @brief ShmRing::wait
+ *      The doorbell is read before checking for data, so a commit() in between makes
+ *      FUTEX_WAIT return at once instead of sleeping through it
+ */
+bool ShmRing::wait(int timeoutMs)
+{
+    uint32_t seen = m_header->doorbell.load(std::memory_order_seq_cst);
+
+    if (readable() > 0)
+        return true;
+
+    m_header->sleeping.store(1, std::memory_order_seq_cst);
+
+    if (readable() == 0)
+    {
+        struct timespec timeout;
+        timeout.tv_sec = timeoutMs / 1000;
+        timeout.tv_nsec = (long)(timeoutMs % 1000) * 1000000L;
+
+        futex(&m_header->doorbell, FUTEX_WAIT, seen, timeoutMs < 0 ? nullptr : &timeout);
+    }
+
+    m_header->sleeping.store(0, std::memory_order_relaxed);
+    return readable() > 0;
+}
+
+void ShmRing::wake()
+{
+    m_header->doorbell.fetch_add(1, std::memory_order_seq_cst);
+    futex(&m_header->doorbell, FUTEX_WAKE, 1, nullptr);
+}
+
+//---------------------------------- CHANNEL ------------------------------------
+
+ShmChannel::ShmChannel() :
+    m_region(nullptr),
+    m_size(0),
+    m_owner(false),
+    m_device(0),
+    m_inode(0)
+{
+}
+
+ShmChannel::~ShmChannel()
+{
+    close();
+}
+
+std::string ShmChannel::regionName(uint16_t commandPort)
+{
+    return "/roboui." + std::to_string(commandPort);
+}
+
+bool ShmChannel::create(const std::string &name, size_t commandCapacity, size_t telemetryCapacity)
+{
+    close();
+
+    if (!isPowerOfTwo(commandCapacity) || !isPowerOfTwo(telemetryCapacity))
+    {
+        m_error = "ring capacities must be powers of two";
+        return false;
+    }
+
+    // a region left behind by a crashed simulator holds stale data
+    shm_unlink(name.c_str());
+
+    int fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (fd < 0)
+    {
+        m_error = std::strerror(errno);
+        return false;
+    }
+
+    size_t size = DataOffset + commandCapacity + telemetryCapacity;
+
+    if (ftruncate(fd, (off_t)size) != 0 || !map(fd, size))
+    {
+        if (m_error.empty())
+            m_error = std::strerror(errno);
+
+        ::close(fd);
+        shm_unlink(name.c_str());
+        return false;
+    }
+
+    ::close(fd);
+
+    // ftruncate zero fills, the atomics only need constructing
+    char *base = reinterpret_cast<char *>(m_region);
+    new (m_region) ShmRegionHeader();
+    new (base + CommandHeaderOffset) ShmRingHeader();
+    new (base + TelemetryHeaderOffset) ShmRingHeader();
+
+    m_region->magic = ShmTransportFormat::Magic;
+    m_region->version = ShmTransportFormat::Version;
+    m_region->commandCapacity = commandCapacity;
+    m_region->telemetryCapacity = telemetryCapacity;
+    m_region->ownerPid = (uint32_t)getpid();
+
+    m_owner = true;
+    m_name = name;
+    setRings();
+
+    m_region->ready.store(1, std::memory_order_release);
+    return true;
+}
+
+bool ShmChannel::attach(const std::string &name)
+{
+    close();
+
+    int fd = shm_open(name.c_str(), O_RDWR, 0);
+    if (fd < 0)
+    {
+        m_error = std::strerror(errno);
+        return false;
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || (size_t)info.st_size < DataOffset || !map(fd, (size_t)info.st_size))
+    {
+        m_error = "shared memory region too small";
+        ::close(fd);
+        return false;
+    }
+
+    ::close(fd);
+
+    m_device = (uint64_t)info.st_dev;
+    m_inode = (uint64_t)info.st_ino;
+
+    const ShmRegionHeader *header = m_region;
+    bool valid = header->magic == ShmTransportFormat::Magic
+            && header->version == ShmTransportFormat::Version
+            && isPowerOfTwo(header->commandCapacity)
+            && isPowerOfTwo(header->telemetryCapacity)
+            && DataOffset + header->commandCapacity + header->telemetryCapacity <= m_size
+            && header->ready.load(std::memory_order_acquire) != 0;
+
+    if (!valid)
+    {
+        m_error = "shared memory region not ready";
+        close();
+        return false;
+    }
+
+    m_name = name;
+    setRings();
+    return true;
+}
+
+void ShmChannel::close()
+{
+    if (!m_region)
+        return;
+
+    if (m_owner)
+    {
+        m_region->ready.store(0, std::memory_order_release);
+        m_telemetry.wake();
+        shm_unlink(m_name.c_str());
+    }
+
+    munmap(m_region, m_size);
+
+    m_region = nullptr;
+    m_size = 0;
+    m_owner = false;
+    m_commands = ShmRing();
+    m_telemetry = ShmRing();
+}
+
+bool ShmChannel::peerReady() const
+{
+    return m_region && m_region->ready.load(std::memory_order_acquire) != 0;
+}
+
+bool ShmChannel::peerAlive() const
+{
+    if (!peerReady())
+        return false;
+
+    // a simulator in another pid namespace may show up as gone, its region's name is
+    // still checked below
+    pid_t owner = (pid_t)m_region->ownerPid;
+    if (owner != 0 && kill(owner, 0) != 0 && errno == ESRCH)
+        return false;
+
+    int fd = shm_open(m_name.c_str(), O_RDONLY, 0);
+    if (fd < 0)
+        return false;
+
+    struct stat info;
+    bool same = fstat(fd, &info) == 0 && (uint64_t)info.st_dev == m_device && (uint64_t)info.st_ino == m_inode;
+
+    ::close(fd);
+    return same;
+}
+
+bool ShmChannel::map(int fd, size_t size)
+{
+    void *address = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (address == MAP_FAILED)
+    {
+        m_error = std::strerror(errno);
+        return false;
+    }
+
+    m_region = static_cast<ShmRegionHeader *>(address);
+    m_size = size;
+    return true;
+}
+
+void ShmChannel::setRings()
+{
+    char *base = reinterpret_cast<char *>(m_region);
+
+    m_commands = ShmRing(reinterpret_cast<ShmRingHeader *>(base + CommandHeaderOffset),
+                         base + DataOffset, m_region->commandCapacity);
+    m_telemetry = ShmRing(reinterpret_cast<ShmRingHeader *>(base + TelemetryHeaderOffset),
+                          base + DataOffset + m_region->commandCapacity, m_region->telemetryCapacity);
+}
+
+//---------------------------------- WAITER ------------------------------------
+
+#ifdef SYS_futex_waitv
+static struct futex_waitv waitOn(std::atomic<uint32_t> *word, uint32_t value, uint32_t flags)
+{
+    struct futex_waitv waiter;
+    std::memset(&waiter, 0, sizeof(waiter));
+    waiter.val = value;
+    waiter.uaddr = (uint64_t)(uintptr_t)word;
+    waiter.flags = FUTEX_32 | flags;
+    return waiter;
+}
+#endif
+
+ShmWaiter::ShmWaiter() :
+    m_changing(false),
+    m_control(0),
+    m_stopping(false),
+    m_fd(-1)
+{
+}
+
+ShmWaiter::~ShmWaiter()
+{
+    stop();
+}
+
+bool ShmWaiter::start()
+{
+    if (m_fd >= 0)
+        return true;
+
+    m_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (m_fd < 0)
+    {
+        m_error = std::strerror(errno);
+        return false;
+    }
+
+    m_stopping.store(false);
+    m_thread = std::thread([this]() { run(); });
+    return true;
+}
+
+void ShmWaiter::stop()
+{
+    if (m_fd < 0)
+        return;
+
+    m_stopping.store(true);
+    kick();
+    m_thread.join();
+
+    ::close(m_fd);
+    m_fd = -1;
+}
+
+void ShmWaiter::acknowledge()
+{
+    uint64_t count;
+    while (::read(m_fd, &count, sizeof(count)) == (ssize_t)sizeof(count))
+        ;
+}
+
+void ShmWaiter::add(ShmRing *ring)
+{
+    std::unique_ptr<Entry> entry(new Entry);
+    entry->ring = ring;
+    entry->armed.store(true);
+
+    m_changing.store(true);
+    kick();
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_entries.push_back(std::move(entry));
+    }
+    m_changing.store(false);
+}
+
+void ShmWaiter::remove(ShmRing *ring)
+{
+    m_changing.store(true);
+    kick();
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (size_t i = 0; i < m_entries.size(); i++)
+        {
+            if (m_entries[i]->ring == ring)
+            {
+                m_entries.erase(m_entries.begin() + (long)i);
+                break;
+            }
+        }
+    }
+    m_changing.store(false);
+}
+
+/**
+ * @brief ShmWaiter::rearm
+ *      Only the consumer's thread changes m_entries, so it can read them without the lock
+ */
+void ShmWaiter::rearm(ShmRing *ring)
+{
+    for (const std::unique_ptr<Entry> &entry : m_entries)
+    {
+        if (entry->ring == ring)
+        {
+            if (!entry->armed.exchange(true))
+                kick();
+            return;
+        }
+    }
+}
+
+void ShmWaiter::kick()
+{
+    m_control.fetch_add(1, std::memory_order_seq_cst);
+    futex(&m_control, FUTEX_WAKE_PRIVATE, 1, nullptr);
+}
+
+/**
+ * @brief ShmWaiter::run
+ *      Announces the sleep on every armed ring as ShmRing::wait() does and sleeps on
+ *      all of their doorbells and the control word at once. The control word is read
+ *      first, so a kick() that comes before the wait makes it return at once.
+ */
+void ShmWaiter::run()
+{
+#ifdef SYS_futex_waitv
+    std::vector<struct futex_waitv> waiters;
+    bool vectored = true;
+#endif
+
+    while (!m_stopping.load())
+    {
+        const uint32_t control = m_control.load(std::memory_order_seq_cst);
+
+        if (m_changing.load())
+        {
+            std::this_thread::yield();
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(m_mutex);
+        bool ready = false;
+
+#ifdef SYS_futex_waitv
+        waiters.clear();
+        waiters.push_back(waitOn(&m_control, control, FUTEX_PRIVATE_FLAG));
+#endif
+
+        for (const std::unique_ptr<Entry> &entry : m_entries)
+        {
+            if (!entry->armed.load())
+                continue;
+
+            ShmRingHeader *header = entry->ring->m_header;
+            uint32_t seen = header->doorbell.load(std::memory_order_seq_cst);
+            header->sleeping.store(1, std::memory_order_seq_cst);
+
+            if (entry->ring->readable() > 0)
+            {
+                ready = true;
+                break;
+            }
+
+#ifdef SYS_futex_waitv
+            waiters.push_back(waitOn(&header->doorbell, seen, 0));
+#else
+            (void)seen;
+#endif
+        }
+
+        if (!ready)
+        {
+#ifdef SYS_futex_waitv
+            if (vectored && syscall(SYS_futex_waitv, waiters.data(), (unsigned)waiters.size(), 0, nullptr, 0) < 0
+                    && errno == ENOSYS)
+                vectored = false;
+
+            if (!vectored)
+#endif
+            {
+                // kernels before 5.16 cannot wait on several futexes, poll the rings
+                struct timespec timeout = {0, 1000000L};
+                futex(&m_control, FUTEX_WAIT_PRIVATE, control, &timeout);
+            }
+        }
+
+        bool notify = false;
+
+        for (const std::unique_ptr<Entry> &entry : m_entries)
+        {
+            if (!entry->armed.load())
+                continue;
+
+            entry->ring->m_header->sleeping.store(0, std::memory_order_relaxed);
+
+            if (entry->ring->readable() > 0)
+            {
+                entry->armed.store(false);
+                notify = true;
+            }
+        }
+
+        lock.unlock();
+
+        // only fails with EAGAIN when the counter is full, which is readable as well
+        if (notify)
+        {
+            uint64_t one = 1;
+            ssize_t written = ::write(m_fd, &one, sizeof(one));
+            (void)written;
+        }
+    }
+}
@@ -0,0 +1,292 @@
+#ifndef SHMTRANSPORT_H
+#define SHMTRANSPORT_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/*
+ *  Same-host transport between RoboUI and the simulator over a POSIX shared memory
+ *  region, replacing the two loopback TCP connections. Like commandframe.h this only
+ *  depends on the standard library and POSIX (Linux futexes), so the simulator can
+ *  compile shmtransport.cpp as is; it is the reference implementation of both peers.
+ *
+ *  The region holds two single-producer single-consumer byte rings with the same
+ *  message semantics as the sockets they replace:
+ *
+ *      commands    client -> simulator   32 byte command frames, see commandframe.h
+ *      telemetry   simulator -> client   newline terminated text records
+ *
+ *  Region layout (version 1, native endianness, both peers on one host):
+ *
+ *      offset  size                field
+ *      0       64                  ShmRegionHeader
+ *      64      192                 ShmRingHeader of the command ring
+ *      256     192                 ShmRingHeader of the telemetry ring
+ *      448     commandCapacity     command ring data
+ *      ...     telemetryCapacity   telemetry ring data
+ *
+ *  Head and tail are free running byte counters. After writing, the producer bumps the
+ *  ring's doorbell and wakes the consumer with FUTEX_WAKE only if it announced that it
+ *  is about to sleep, so a busy stream costs no system calls at all.
+ *
+ *  The simulator creates the region, clients attach to it by name. A simulator that
+ *  crashes cannot clear ready, and a restarted one creates a new region under the same
+ *  name while clients still map the old one; ShmChannel::peerAlive() notices both.
+ */
+
+namespace ShmTransportFormat
+{
+    constexpr uint32_t Magic = 0x52424f53;  // "SOBR"
+    constexpr uint32_t Version = 1;
+
+    constexpr size_t CommandCapacity = 64 * 1024;
+    constexpr size_t TelemetryCapacity = 4 * 1024 * 1024;
+}
+
+/**
+ * @brief The ShmRingHeader struct
+ *      Shared state of one ring; producer and consumer fields on separate cache lines
+ */
+struct ShmRingHeader
+{
+    alignas(64) std::atomic<uint64_t> head;     // bytes written, producer only
+    alignas(64) std::atomic<uint64_t> tail;     // bytes read, consumer only
+    alignas(64) std::atomic<uint32_t> doorbell; // futex word, bumped on every commit
+    std::atomic<uint32_t> sleeping;             // consumer is about to wait on the doorbell
+};
+
+/**
+ * @brief The ShmRegionHeader struct
+ */
+struct alignas(64) ShmRegionHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint64_t commandCapacity;
+    uint64_t telemetryCapacity;
+
+    // set by the simulator once the region is initialised, cleared when it closes
+    std::atomic<uint32_t> ready;
+
+    // process id of the simulator; 0, as left by older simulators, if unknown
+    uint32_t ownerPid;
+};
+
+/**
+ * @brief The ShmRing class
+ *      One side's view of a ring in the shared region. The reserve()/commit() and
+ *      peek()/consume() pairs work in place, so large payloads are written straight
+ *      into shared memory and parsed from there.
+ */
+class ShmRing
+{
+public:
+    ShmRing() : m_header(nullptr), m_data(nullptr), m_capacity(0) {}
+    ShmRing(ShmRingHeader *header, char *data, size_t capacity) : m_header(header), m_data(data), m_capacity(capacity) {}
+
+    bool isValid() const { return m_header != nullptr; }
+    size_t capacity() const { return m_capacity; }
+
+    // ---- producer side ----
+
+    /**
+     * @brief reserve
+     * @param available - receives the contiguous free space at the returned pointer
+     */
+    char *reserve(size_t &available);
+    void commit(size_t length);
+
+    /**
+     * @brief write
+     *      Copies all of data or nothing, e.g. one command frame
+     * @return false if there is not enough free space
+     */
+    bool write(const void *data, size_t length);
+
+    // ---- consumer side ----
+
+    /**
+     * @brief peek
+     * @param available - receives the contiguous readable bytes at the returned pointer
+     */
+    const char *peek(size_t &available);
+    void consume(size_t length);
+
+    size_t readable() const;
+
+    /**
+     * @brief wait
+     *      Blocks until the ring is not empty, wake() is called or the timeout expires
+     * @param timeoutMs - negative to wait without a timeout
+     * @return true if there is something to read
+     */
+    bool wait(int timeoutMs);
+
+    /**
+     * @brief wake
+     *      Releases a consumer blocked in wait(), e.g. to shut it down
+     */
+    void wake();
+
+private:
+    friend class ShmWaiter;
+
+    ShmRingHeader *m_header;
+    char *m_data;
+    size_t m_capacity;
+};
+
+/**
+ * @brief The ShmChannel class
+ *      Maps the shared region of one robot
+ */
+class ShmChannel
+{
+public:
+    ShmChannel();
+    ~ShmChannel();
+
+    ShmChannel(const ShmChannel &) = delete;
+    ShmChannel &operator=(const ShmChannel &) = delete;
+
+    /**
+     * @brief create
+     *      Simulator side: replaces any stale region of that name with an empty one
+     * @param name - POSIX shared memory name, e.g. "/roboui.9000"
+     */
+    bool create(const std::string &name,
+                size_t commandCapacity = ShmTransportFormat::CommandCapacity,
+                size_t telemetryCapacity = ShmTransportFormat::TelemetryCapacity);
+
+    /**
+     * @brief attach
+     *      Client side: maps a region created by the simulator
+     * @return false if it does not exist (yet) or is not ready
+     */
+    bool attach(const std::string &name);
+
+    void close();
+
+    bool isOpen() const { return m_region != nullptr; }
+
+    /**
+     * @brief peerReady
+     *      Client side: false once the simulator closed the region
+     */
+    bool peerReady() const;
+
+    /**
+     * @brief peerAlive
+     *      Client side: false if the simulator closed the region, its process is gone,
+     *      or the region's name now belongs to a new region of a restarted simulator.
+     *      Makes a few system calls, meant to be polled about once a second.
+     */
+    bool peerAlive() const;
+
+    ShmRing &commands() { return m_commands; }
+    ShmRing &telemetry() { return m_telemetry; }
+
+    const std::string &errorString() const { return m_error; }
+
+    /**
+     * @brief regionName
+     *      Name the simulator and the client derive from a robot's command port
+     */
+    static std::string regionName(uint16_t commandPort);
+
+private:
+    bool map(int fd, size_t size);
+    void setRings();
+
+    ShmRegionHeader *m_region;
+    size_t m_size;
+    bool m_owner;
+    std::string m_name;
+
+    // identity of the mapped region, to tell it from a new one of the same name
+    uint64_t m_device;
+    uint64_t m_inode;
+
+    std::string m_error;
+
+    ShmRing m_commands;
+    ShmRing m_telemetry;
+};
+
+/**
+ * @brief The ShmWaiter class
+ *      Lets an event loop wait for data on any number of rings. A thread of its own
+ *      sleeps on the doorbells of all armed rings at once (futex_waitv, Linux 5.16)
+ *      and makes fd(), an eventfd, readable as soon as one of them has data.
+ *
+ *      A ring is disarmed when it is reported and left alone until the consumer calls
+ *      rearm() after draining it, so a consumer that falls behind costs no wakeups.
+ *      add(), remove() and rearm() are for the consumer's thread only; remove() a ring
+ *      before closing its channel.
+ */
+class ShmWaiter
+{
+public:
+    ShmWaiter();
+    ~ShmWaiter();
+
+    ShmWaiter(const ShmWaiter &) = delete;
+    ShmWaiter &operator=(const ShmWaiter &) = delete;
+
+    bool start();
+    void stop();
+
+    /**
+     * @brief fd
+     * @return eventfd that becomes readable when a ring has data, -1 before start()
+     */
+    int fd() const { return m_fd; }
+
+    /**
+     * @brief acknowledge
+     *      Resets fd() after it was reported readable
+     */
+    void acknowledge();
+
+    void add(ShmRing *ring);
+    void remove(ShmRing *ring);
+
+    /**
+     * @brief rearm
+     *      The consumer drained the ring, report it again once it has new data
+     */
+    void rearm(ShmRing *ring);
+
+    const std::string &errorString() const { return m_error; }
+
+private:
+    struct Entry
+    {
+        ShmRing *ring;
+        std::atomic<bool> armed;
+    };
+
+    void run();
+    void kick();
+
+    // held by the waiting thread while it touches the rings, so remove() cannot
+    // unmap one under it; add() and remove() set m_changing to get it back
+    std::mutex m_mutex;
+    std::vector<std::unique_ptr<Entry>> m_entries;
+    std::atomic<bool> m_changing;
+
+    std::atomic<uint32_t> m_control;    // futex word, bumped to make the thread look again
+    std::atomic<bool> m_stopping;
+
+    std::thread m_thread;
+    int m_fd;
+    std::string m_error;
+};
+
+#endif // SHMTRANSPORT_H
@@ -0,0 +1,129 @@
+#ifndef SPSCRING_H
+#define SPSCRING_H
+
+#include <atomic>
+#include <cstddef>
+
+/**
+ * @brief The SpscRing class
+ *      Lock-free bounded queue for exactly one producer thread and one consumer thread.
+ *      Slots are preallocated; besides push/pop, a slot can be filled or read in place
+ *      through beginPush()/commitPush() and front()/popFront() to avoid copying large items.
+ *
+ *      Capacity has to be a power of two.
+ */
+template <typename T, size_t Capacity>
+class SpscRing
+{
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "SpscRing capacity must be a power of two");
+
+public:
+    SpscRing() : m_head(0), m_cachedTail(0), m_tail(0), m_cachedHead(0) {}
+
+    SpscRing(const SpscRing &) = delete;
+    SpscRing &operator=(const SpscRing &) = delete;
+
+    // ---- producer side ----
+
+    bool push(const T &item)
+    {
+        T *slot = beginPush();
+        if (!slot)
+            return false;
+
+        *slot = item;
+        commitPush();
+        return true;
+    }
+
+    /**
+     * @brief beginPush
+     * @return the next free slot, or nullptr if the ring is full
+     */
+    T *beginPush()
+    {
+        const size_t tail = m_tail.load(std::memory_order_relaxed);
+
+        if (tail - m_cachedHead == Capacity)
+        {
+            m_cachedHead = m_head.load(std::memory_order_acquire);
+            if (tail - m_cachedHead == Capacity)
+                return nullptr;
+        }
+
+        return &m_items[tail & (Capacity - 1)];
+    }
+
+    /**
+     * @brief commitPush
+     *      Publishes the slot returned by beginPush()
+     */
+    void commitPush()
+    {
+        m_tail.store(m_tail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    bool full() const
+    {
+        return m_tail.load(std::memory_order_relaxed) - m_head.load(std::memory_order_acquire) == Capacity;
+    }
+
+    // ---- consumer side ----
+
+    bool pop(T &item)
+    {
+        T *slot = front();
+        if (!slot)
+            return false;
+
+        item = *slot;
+        popFront();
+        return true;
+    }
+
+    /**
+     * @brief front
+     * @return the oldest item, or nullptr if the ring is empty
+     */
+    T *front()
+    {
+        const size_t head = m_head.load(std::memory_order_relaxed);
+
+        if (head == m_cachedTail)
+        {
+            m_cachedTail = m_tail.load(std::memory_order_acquire);
+            if (head == m_cachedTail)
+                return nullptr;
+        }
+
+        return &m_items[head & (Capacity - 1)];
+    }
+
+    /**
+     * @brief popFront
+     *      Releases the slot returned by front()
+     */
+    void popFront()
+    {
+        m_head.store(m_head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    bool empty() const
+    {
+        return m_head.load(std::memory_order_relaxed) == m_tail.load(std::memory_order_acquire);
+    }
+
+    static constexpr size_t capacity() { return Capacity; }
+
+private:
+    // consumer and producer indices live on separate cache lines
+    alignas(64) std::atomic<size_t> m_head;
+    size_t m_cachedTail;
+
+    alignas(64) std::atomic<size_t> m_tail;
+    size_t m_cachedHead;
+
+    alignas(64) T m_items[Capacity];
+};
+
+#endif // SPSCRING_H
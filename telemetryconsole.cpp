@@ -0,0 +1,341 @@
+#include "telemetryconsole.h"
+
+#include <QContextMenuEvent>
+#include <QInputDialog>
+#include <QKeyEvent>
+#include <QLineEdit>
+#include <QMenu>
+#include <QPainter>
+#include <QScrollBar>
+#include <QTimer>
+
+#include <algorithm>
+#include <cstring>
+
+TelemetryConsole::TelemetryConsole(QWidget *parent, int capacity) : QAbstractScrollArea(parent),
+    m_lines(qMax(1, capacity)),
+    m_total(0),
+    m_matchesHead(0),
+    m_paused(false),
+    m_updatingScrollBar(false),
+    m_topLine(0),
+    m_refreshTimer(new QTimer(this)),
+    m_lineHeight(1)
+{
+    // at most one repaint per display frame
+    m_refreshTimer->setSingleShot(true);
+    m_refreshTimer->setInterval(16);
+    connect(m_refreshTimer, &QTimer::timeout, this, &TelemetryConsole::refresh);
+
+    setHorizontalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
+    setVerticalScrollBarPolicy(Qt::ScrollBarAsNeeded);
+    setFocusPolicy(Qt::StrongFocus);
+
+    m_lineHeight = qMax(1, fontMetrics().lineSpacing());
+}
+
+bool TelemetryConsole::isPaused() const
+{
+    return m_paused;
+}
+
+QString TelemetryConsole::filter() const
+{
+    return QString::fromLatin1(m_filter);
+}
+
+//---------------------------------- APPENDING ------------------------------------
+
+/**
+ * @brief TelemetryConsole::record
+ * @param line - telemetry record from the TelemetryParser
+ */
+void TelemetryConsole::record(std::string_view line)
+{
+    append(line.data(), (int)line.size());
+}
+
+void TelemetryConsole::appendLine(const QByteArray &line)
+{
+    append(line.constData(), line.size());
+}
+
+/**
+ * @brief TelemetryConsole::append
+ *      Overwrites the oldest slot; the slot keeps its allocation once the ring has wrapped
+ */
+void TelemetryConsole::append(const char *data, int size)
+{
+    QByteArray &slot = m_lines[m_total % m_lines.size()];
+    slot.resize(size);
+    std::memcpy(slot.data(), data, size);
+
+    if (!m_filter.isEmpty() && slot.contains(m_filter))
+        m_matches.push_back(m_total);
+
+    m_total++;
+    scheduleRefresh();
+}
+
+void TelemetryConsole::clear()
+{
+    for (QByteArray &line : m_lines)
+        line.clear();
+
+    m_total = 0;
+    m_topLine = 0;
+    m_matches.clear();
+    m_matchesHead = 0;
+
+    scheduleRefresh();
+}
+
+void TelemetryConsole::scheduleRefresh()
+{
+    if (!m_refreshTimer->isActive())
+        m_refreshTimer->start();
+}
+
+/**
+ * @brief TelemetryConsole::refresh
+ *      Applies everything appended since the last frame in one go
+ */
+void TelemetryConsole::refresh()
+{
+    dropExpiredMatches();
+    updateScrollBar();
+    viewport()->update();
+}
+
+//---------------------------------- PAUSE AND FILTER ------------------------------------
+
+/**
+ * @brief TelemetryConsole::setPaused
+ * @param paused - freeze the view at the current rows, or follow new lines again
+ */
+void TelemetryConsole::setPaused(bool paused)
+{
+    if (m_paused == paused)
+        return;
+
+    m_paused = paused;
+
+    if (m_paused)
+    {
+        int index = verticalScrollBar()->value();
+        if (index < viewCount())
+            m_topLine = m_filter.isEmpty() ? (m_total - viewCount()) + index : m_matches[m_matchesHead + index];
+        else
+            m_topLine = m_total;
+    }
+
+    emit pausedChanged(m_paused);
+    scheduleRefresh();
+}
+
+/**
+ * @brief TelemetryConsole::setFilter
+ * @param filter - only lines containing this text are shown, empty shows all
+ */
+void TelemetryConsole::setFilter(const QString &filter)
+{
+    m_filter = filter.toLatin1();
+    rebuildMatches();
+    scheduleRefresh();
+}
+
+void TelemetryConsole::rebuildMatches()
+{
+    m_matches.clear();
+    m_matchesHead = 0;
+
+    if (m_filter.isEmpty())
+        return;
+
+    uint64_t first = m_total > m_lines.size() ? m_total - m_lines.size() : 0;
+
+    for (uint64_t line = first; line < m_total; ++line)
+    {
+        if (m_lines[line % m_lines.size()].contains(m_filter))
+            m_matches.push_back(line);
+    }
+}
+
+/**
+ * @brief TelemetryConsole::dropExpiredMatches
+ *      Forgets matches whose lines were overwritten
+ */
+void TelemetryConsole::dropExpiredMatches()
+{
+    uint64_t first = m_total > m_lines.size() ? m_total - m_lines.size() : 0;
+
+    while (m_matchesHead < m_matches.size() && m_matches[m_matchesHead] < first)
+        m_matchesHead++;
+
+    if (m_matchesHead > 1024 && m_matchesHead > m_matches.size() / 2)
+    {
+        m_matches.erase(m_matches.begin(), m_matches.begin() + m_matchesHead);
+        m_matchesHead = 0;
+    }
+}
+
+//---------------------------------- VIEW ------------------------------------
+
+int TelemetryConsole::viewCount() const
+{
+    if (!m_filter.isEmpty())
+        return (int)(m_matches.size() - m_matchesHead);
+
+    return (int)qMin<uint64_t>(m_total, m_lines.size());
+}
+
+const QByteArray &TelemetryConsole::viewLine(int index) const
+{
+    uint64_t line;
+
+    if (!m_filter.isEmpty())
+        line = m_matches[m_matchesHead + index];
+    else
+        line = (m_total - viewCount()) + index;
+
+    return m_lines[line % m_lines.size()];
+}
+
+int TelemetryConsole::visibleRows() const
+{
+    return qMax(1, viewport()->height() / m_lineHeight);
+}
+
+void TelemetryConsole::updateScrollBar()
+{
+    int count = viewCount();
+    int rows = visibleRows();
+    int maximum = qMax(0, count - rows);
+    int value = maximum;
+
+    if (m_paused)
+    {
+        // index of the first line at or after the frozen top line
+        if (!m_filter.isEmpty())
+        {
+            auto begin = m_matches.begin() + m_matchesHead;
+            value = (int)(std::lower_bound(begin, m_matches.end(), m_topLine) - begin);
+        }
+        else
+        {
+            uint64_t first = m_total - count;
+            value = m_topLine > first ? (int)(m_topLine - first) : 0;
+        }
+
+        value = qMin(value, maximum);
+    }
+
+    m_updatingScrollBar = true;
+    verticalScrollBar()->setRange(0, maximum);
+    verticalScrollBar()->setPageStep(rows);
+    verticalScrollBar()->setValue(value);
+    m_updatingScrollBar = false;
+}
+
+void TelemetryConsole::scrollContentsBy(int dx, int dy)
+{
+    Q_UNUSED(dx)
+    Q_UNUSED(dy)
+
+    if (!m_updatingScrollBar)
+    {
+        // scrolling back pauses the view, scrolling to the end resumes following
+        QScrollBar *bar = verticalScrollBar();
+        bool atEnd = bar->value() >= bar->maximum();
+
+        if (atEnd)
+            setPaused(false);
+        else
+        {
+            setPaused(true);
+            int index = bar->value();
+            m_topLine = m_filter.isEmpty() ? (m_total - viewCount()) + index : m_matches[m_matchesHead + index];
+        }
+    }
+
+    viewport()->update();
+}
+
+/**
+ * @brief TelemetryConsole::paintEvent
+ *      Draws only the rows inside the viewport
+ * @param event
+ */
+void TelemetryConsole::paintEvent(QPaintEvent *event)
+{
+    Q_UNUSED(event)
+
+    QPainter painter(viewport());
+    painter.setPen(palette().color(QPalette::Text));
+
+    int count = viewCount();
+    int first = verticalScrollBar()->value();
+    int last = qMin(count, first + visibleRows() + 1);
+    int ascent = fontMetrics().ascent();
+
+    for (int row = first; row < last; ++row)
+    {
+        int y = (row - first) * m_lineHeight;
+        painter.drawText(4, y + ascent, QString::fromLatin1(viewLine(row)));
+    }
+}
+
+void TelemetryConsole::resizeEvent(QResizeEvent *event)
+{
+    QAbstractScrollArea::resizeEvent(event);
+    updateScrollBar();
+}
+
+//---------------------------------- INTERACTION ------------------------------------
+
+void TelemetryConsole::keyPressEvent(QKeyEvent *event)
+{
+    switch (event->key())
+    {
+    case Qt::Key_Space:
+        setPaused(!m_paused);
+        break;
+
+    case Qt::Key_Escape:
+        setFilter(QString());
+        break;
+
+    default:
+        QAbstractScrollArea::keyPressEvent(event);
+        break;
+    }
+}
+
+void TelemetryConsole::contextMenuEvent(QContextMenuEvent *event)
+{
+    QMenu menu(this);
+
+    QAction *pause = menu.addAction(m_paused ? tr("Resume") : tr("Pause"));
+    QAction *filter = menu.addAction(tr("Filter..."));
+    QAction *clearFilter = menu.addAction(tr("Clear Filter"));
+    clearFilter->setEnabled(!m_filter.isEmpty());
+    menu.addSeparator();
+    QAction *clearLines = menu.addAction(tr("Clear"));
+
+    QAction *chosen = menu.exec(event->globalPos());
+
+    if (chosen == pause)
+        setPaused(!m_paused);
+    else if (chosen == filter)
+    {
+        bool ok = false;
+        QString text = QInputDialog::getText(this, tr("Filter Telemetry"), tr("Show lines containing:"),
+                                             QLineEdit::Normal, this->filter(), &ok);
+        if (ok)
+            setFilter(text);
+    }
+    else if (chosen == clearFilter)
+        setFilter(QString());
+    else if (chosen == clearLines)
+        clear();
+}
@@ -0,0 +1,81 @@
+#ifndef TELEMETRYCONSOLE_H
+#define TELEMETRYCONSOLE_H
+
+#include <QAbstractScrollArea>
+#include <QByteArray>
+#include <QString>
+
+#include <cstdint>
+#include <vector>
+
+#include "telemetryparser.h"
+
+class QTimer;
+
+/**
+ * @brief The TelemetryConsole class
+ *      Log view for telemetry records backed by a fixed-capacity ring of lines.
+ *      Only the visible rows are painted and appending never triggers more than one
+ *      repaint per display frame, no matter how fast records arrive.
+ *
+ *      The view follows new lines until it is paused, either explicitly (space bar,
+ *      context menu) or by scrolling back. Lines keep being recorded while paused.
+ */
+class TelemetryConsole : public QAbstractScrollArea, public TelemetrySink
+{
+    Q_OBJECT
+
+public:
+    explicit TelemetryConsole(QWidget *parent = nullptr, int capacity = 10000);
+
+    void record(std::string_view line) override;
+
+    bool isPaused() const;
+    QString filter() const;
+
+public slots:
+    void appendLine(const QByteArray &line);
+    void setPaused(bool paused);
+    void setFilter(const QString &filter);
+    void clear();
+
+signals:
+    void pausedChanged(bool paused);
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+    void resizeEvent(QResizeEvent *event) override;
+    void keyPressEvent(QKeyEvent *event) override;
+    void contextMenuEvent(QContextMenuEvent *event) override;
+    void scrollContentsBy(int dx, int dy) override;
+
+private slots:
+    void refresh();
+
+private:
+    void append(const char *data, int size);
+    void scheduleRefresh();
+    void rebuildMatches();
+    void dropExpiredMatches();
+
+    int viewCount() const;
+    const QByteArray &viewLine(int index) const;
+    int visibleRows() const;
+    void updateScrollBar();
+
+    std::vector<QByteArray> m_lines;
+    uint64_t m_total;           // lines appended since the last clear()
+
+    QByteArray m_filter;
+    std::vector<uint64_t> m_matches;  // absolute line numbers matching m_filter, oldest first
+    size_t m_matchesHead;
+
+    bool m_paused;
+    bool m_updatingScrollBar;
+    uint64_t m_topLine;         // absolute line number of the first visible row while paused
+
+    QTimer *m_refreshTimer;
+    int m_lineHeight;
+};
+
+#endif // TELEMETRYCONSOLE_H
@@ -0,0 +1,202 @@
+#include "telemetryparser.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+
+static inline bool isSeparator(char c)
+{
+    return c == ' ' || c == '\t' || c == ',';
+}
+
+TelemetryParser::TelemetryParser(size_t capacity) :
+    m_buffer(capacity),
+    m_head(0),
+    m_scan(0),
+    m_tail(0),
+    m_discarding(false),
+    m_time(0),
+    m_records(0),
+    m_samples(0),
+    m_oversized(0)
+{
+    m_fields.reserve(32);
+}
+
+void TelemetryParser::addSink(TelemetrySink *sink)
+{
+    if (std::find(m_sinks.begin(), m_sinks.end(), sink) == m_sinks.end())
+        m_sinks.push_back(sink);
+}
+
+void TelemetryParser::removeSink(TelemetrySink *sink)
+{
+    m_sinks.erase(std::remove(m_sinks.begin(), m_sinks.end(), sink), m_sinks.end());
+}
+
+/**
+ * @brief TelemetryParser::writeBuffer
+ * @param available
+ * @return char*
+ */
+char *TelemetryParser::writeBuffer(size_t &available)
+{
+    if (m_tail == m_buffer.size())
+        compact();
+
+    // a single record fills the whole buffer, drop it up to its terminator; it may
+    // take several buffers to get there
+    if (m_tail == m_buffer.size())
+    {
+        if (!m_discarding)
+            m_oversized++;
+
+        m_head = m_scan = m_tail = 0;
+        m_discarding = true;
+    }
+
+    available = m_buffer.size() - m_tail;
+    return m_buffer.data() + m_tail;
+}
+
+void TelemetryParser::commit(size_t length)
+{
+    m_tail = std::min(m_tail + length, m_buffer.size());
+}
+
+void TelemetryParser::feed(const char *data, size_t length)
+{
+    while (length > 0)
+    {
+        size_t available;
+        char *out = writeBuffer(available);
+        size_t n = std::min(available, length);
+
+        std::memcpy(out, data, n);
+        commit(n);
+
+        data += n;
+        length -= n;
+
+        // make room for the rest
+        if (length > 0)
+            parse();
+    }
+}
+
+/**
+ * @brief TelemetryParser::parse
+ * @return size_t
+ */
+size_t TelemetryParser::parse()
+{
+    const char *data = m_buffer.data();
+    size_t parsed = 0;
+
+    while (m_scan < m_tail)
+    {
+        const char *terminator = (const char *)std::memchr(data + m_scan, '\n', m_tail - m_scan);
+
+        // only search the new bytes next time
+        if (!terminator)
+        {
+            m_scan = m_tail;
+            break;
+        }
+
+        size_t end = terminator - data;
+
+        if (m_discarding)
+            m_discarding = false;
+        else
+        {
+            parseRecord(data + m_head, data + end);
+            parsed++;
+        }
+
+        m_head = m_scan = end + 1;
+    }
+
+    if (m_head == m_tail)
+        m_head = m_scan = m_tail = 0;
+
+    return parsed;
+}
+
+void TelemetryParser::clear()
+{
+    m_head = m_scan = m_tail = 0;
+    m_discarding = false;
+}
+
+/**
+ * @brief TelemetryParser::compact
+ *      Moves the partial record at the end of the buffer to the front
+ */
+void TelemetryParser::compact()
+{
+    if (m_head == 0)
+        return;
+
+    std::memmove(m_buffer.data(), m_buffer.data() + m_head, m_tail - m_head);
+    m_scan -= m_head;
+    m_tail -= m_head;
+    m_head = 0;
+}
+
+/**
+ * @brief TelemetryParser::parseRecord
+ * @param begin
+ * @param end - points at the terminator
+ */
+void TelemetryParser::parseRecord(const char *begin, const char *end)
+{
+    if (end > begin && end[-1] == '\r')
+        end--;
+
+    m_records++;
+    m_fields.clear();
+
+    const char *p = begin;
+
+    while (p < end)
+    {
+        while (p < end && isSeparator(*p))
+            p++;
+
+        const char *token = p;
+        while (p < end && !isSeparator(*p))
+            p++;
+
+        const char *equals = (const char *)std::memchr(token, '=', p - token);
+        if (!equals || equals == token)
+            continue;
+
+        double value;
+        std::from_chars_result result = std::from_chars(equals + 1, p, value);
+        if (result.ec != std::errc() || result.ptr != p)
+            continue;
+
+        std::string_view name(token, equals - token);
+
+        if (name == "t")
+            m_time = value;
+        else
+            m_fields.push_back(TelemetrySample{name, 0, value});
+    }
+
+    std::string_view line(begin, end - begin);
+
+    for (TelemetrySink *sink : m_sinks)
+        sink->record(line);
+
+    for (TelemetrySample &sample : m_fields)
+    {
+        sample.time = m_time;
+
+        for (TelemetrySink *sink : m_sinks)
+            sink->sample(sample);
+    }
+
+    m_samples += m_fields.size();
+}
@@ -0,0 +1,111 @@
+#ifndef TELEMETRYPARSER_H
+#define TELEMETRYPARSER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+/*
+ *  Telemetry stream from the simulator (port 8080).
+ *
+ *  The stream is a sequence of records terminated by '\n'. A record holds
+ *  name=value fields separated by spaces, tabs or commas:
+ *
+ *      t=12.345 vx=0.51 theta=-0.02 omega=0.10
+ *
+ *  The field "t" is the simulation time of the record; every other numeric
+ *  field becomes one TelemetrySample. Fields that are not name=value pairs
+ *  or whose value is not a number are kept in the raw record only.
+ */
+
+/**
+ * @brief The TelemetrySample struct
+ *      channel points into the parser's receive buffer and is only valid during the callback
+ */
+struct TelemetrySample
+{
+    std::string_view channel;
+    double time;
+    double value;
+};
+
+/**
+ * @brief The TelemetrySink class
+ *      Receives parsed telemetry. Both callbacks run on the thread calling TelemetryParser::parse().
+ */
+class TelemetrySink
+{
+public:
+    virtual ~TelemetrySink() = default;
+
+    /**
+     * @brief record
+     * @param line - one complete record without the terminator
+     */
+    virtual void record(std::string_view line) { (void)line; }
+
+    virtual void sample(const TelemetrySample &sample) { (void)sample; }
+};
+
+/**
+ * @brief The TelemetryParser class
+ *      Incremental decoder for the telemetry stream. Bytes are written straight into a
+ *      fixed receive buffer that is reused for the whole session; complete records are
+ *      parsed in place and only the trailing partial record is ever moved.
+ */
+class TelemetryParser
+{
+public:
+    explicit TelemetryParser(size_t capacity = 64 * 1024);
+
+    void addSink(TelemetrySink *sink);
+    void removeSink(TelemetrySink *sink);
+
+    /**
+     * @brief writeBuffer
+     *      Space to read incoming bytes into, call commit() with the number written
+     * @param available - receives the number of writable bytes
+     */
+    char *writeBuffer(size_t &available);
+    void commit(size_t length);
+
+    /**
+     * @brief feed
+     *      Convenience for data that already sits in another buffer
+     */
+    void feed(const char *data, size_t length);
+
+    /**
+     * @brief parse
+     *      Hands every complete record to the sinks
+     * @return number of records parsed
+     */
+    size_t parse();
+
+    void clear();
+
+    uint64_t records() const { return m_records; }
+    uint64_t samples() const { return m_samples; }
+    uint64_t oversized() const { return m_oversized; }
+
+private:
+    void parseRecord(const char *begin, const char *end);
+    void compact();
+
+    std::vector<char> m_buffer;
+    size_t m_head;          // start of the first unparsed record
+    size_t m_scan;          // bytes before this have been searched for a terminator
+    size_t m_tail;          // end of received data
+    bool m_discarding;      // skipping the rest of a record larger than the buffer
+
+    double m_time;
+    std::vector<TelemetrySample> m_fields;
+    std::vector<TelemetrySink *> m_sinks;
+
+    uint64_t m_records;
+    uint64_t m_samples;
+    uint64_t m_oversized;
+};
+
+#endif // TELEMETRYPARSER_H
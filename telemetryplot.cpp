@@ -0,0 +1,403 @@
+#include "telemetryplot.h"
+
+#include <QContextMenuEvent>
+#include <QMenu>
+#include <QPainter>
+#include <QTimer>
+
+#include <cmath>
+#include <cstring>
+
+static const int MaxTraces = 12;
+
+static const QColor TraceColors[MaxTraces] =
+{
+    QColor(20, 110, 255), QColor(255, 170, 0), QColor(80, 220, 100), QColor(255, 80, 80),
+    QColor(200, 120, 255), QColor(0, 210, 210), QColor(255, 255, 120), QColor(255, 140, 200),
+    QColor(150, 200, 255), QColor(190, 150, 90), QColor(170, 255, 170), QColor(230, 230, 230)
+};
+
+static const QColor Background(60, 60, 60);
+
+TelemetryPlot::TelemetryPlot(QWidget *parent) : QWidget(parent),
+    m_store(nullptr),
+    m_autoSelect(true),
+    m_scannedChannels(0),
+    m_span(10),
+    m_min(-2), m_max(2),
+    m_columnTime(1),
+    m_lastColumn(0),
+    m_latest(-1),
+    m_valid(false),
+    m_frameTimer(new QTimer(this))
+{
+    // display rate; armed by new samples or a changed view while the plot is visible
+    m_frameTimer->setSingleShot(true);
+    m_frameTimer->setTimerType(Qt::PreciseTimer);
+    m_frameTimer->setInterval(16);
+    connect(m_frameTimer, &QTimer::timeout, this, &TelemetryPlot::tick);
+
+    setAttribute(Qt::WA_OpaquePaintEvent);
+}
+
+void TelemetryPlot::setStore(const TelemetryStore *store)
+{
+    m_store = store;
+    m_scannedChannels = 0;
+    invalidate();
+}
+
+void TelemetryPlot::setTimeSpan(double seconds)
+{
+    m_span = qMax(0.001, seconds);
+    invalidate();
+}
+
+double TelemetryPlot::timeSpan() const
+{
+    return m_span;
+}
+
+void TelemetryPlot::setRange(float min, float max)
+{
+    m_min = qMin(min, max);
+    m_max = qMax(max, m_min + 1e-6f);
+    invalidate();
+}
+
+void TelemetryPlot::addChannel(const QString &name)
+{
+    std::string key = name.toStdString();
+
+    for (const Trace &trace : m_traces)
+    {
+        if (trace.name == key)
+            return;
+    }
+
+    if ((int)m_traces.size() >= MaxTraces)
+        return;
+
+    m_traces.push_back(Trace{key, TraceColors[m_traces.size()]});
+    invalidate();
+}
+
+void TelemetryPlot::removeChannel(const QString &name)
+{
+    std::string key = name.toStdString();
+
+    for (size_t i = 0; i < m_traces.size(); ++i)
+    {
+        if (m_traces[i].name == key)
+        {
+            m_traces.erase(m_traces.begin() + i);
+            break;
+        }
+    }
+
+    for (size_t i = 0; i < m_traces.size(); ++i)
+        m_traces[i].color = TraceColors[i];
+
+    invalidate();
+}
+
+QStringList TelemetryPlot::channels() const
+{
+    QStringList names;
+
+    for (const Trace &trace : m_traces)
+        names << QString::fromStdString(trace.name);
+
+    return names;
+}
+
+void TelemetryPlot::selectDefaultChannels()
+{
+    for (const std::string &name : m_store->channelNames())
+    {
+        if ((int)m_traces.size() >= MaxTraces)
+            break;
+
+        // command acknowledgements are bookkeeping, not signals
+        if (name.compare(0, 3, "ack") == 0)
+            continue;
+
+        addChannel(QString::fromStdString(name));
+    }
+}
+
+void TelemetryPlot::invalidate()
+{
+    m_valid = false;
+    scheduleFrame();
+}
+
+void TelemetryPlot::storeChanged()
+{
+    scheduleFrame();
+}
+
+/**
+ * @brief TelemetryPlot::scheduleFrame
+ *      Changes within one display interval share a frame
+ */
+void TelemetryPlot::scheduleFrame()
+{
+    if (isVisible() && !m_frameTimer->isActive())
+        m_frameTimer->start();
+}
+
+double TelemetryPlot::latestTime() const
+{
+    double latest = -1;
+
+    for (const Trace &trace : m_traces)
+    {
+        const TelemetryChannel *channel = m_store->channel(trace.name);
+        if (channel && !channel->empty())
+            latest = qMax(latest, channel->lastTime());
+    }
+
+    return latest;
+}
+
+//---------------------------------- RENDERING ------------------------------------
+
+/**
+ * @brief TelemetryPlot::tick
+ *      Draws a frame, unless the traces did not move since the last one
+ */
+void TelemetryPlot::tick()
+{
+    if (!m_store || m_image.isNull())
+        return;
+
+    // the store only ever adds channels, or drops all of them on clear()
+    if (m_autoSelect && m_store->channelCount() != m_scannedChannels)
+    {
+        m_scannedChannels = m_store->channelCount();
+        if ((int)m_traces.size() < MaxTraces)
+            selectDefaultChannels();
+    }
+
+    double latest = latestTime();
+    if (latest < 0 || (m_valid && latest == m_latest))
+        return;
+
+    m_latest = latest;
+
+    const int width = m_image.width();
+    m_columnTime = m_span / width;
+
+    int64_t column = (int64_t)std::floor(latest / m_columnTime);
+    int64_t shift = column - m_lastColumn;
+    int64_t previous = m_lastColumn;
+
+    m_lastColumn = column;
+
+    if (!m_valid || shift < 0 || shift >= width)
+    {
+        m_image.fill(Background);
+        m_valid = true;
+        renderColumns(column - width + 1, column);
+    }
+    else
+    {
+        // the previous rightmost column was still filling up, draw it again
+        scrollImage((int)shift);
+        renderColumns(previous, column);
+    }
+
+    update();
+}
+
+/**
+ * @brief TelemetryPlot::scrollImage
+ * @param columns - pixels to move the image to the left
+ */
+void TelemetryPlot::scrollImage(int columns)
+{
+    if (columns <= 0)
+        return;
+
+    const int width = m_image.width();
+    const int bytes = (width - columns) * 4;
+
+    for (int y = 0; y < m_image.height(); ++y)
+    {
+        uchar *line = m_image.scanLine(y);
+        std::memmove(line, line + columns * 4, bytes);
+    }
+}
+
+/**
+ * @brief TelemetryPlot::renderColumns
+ *      Clears and redraws absolute columns [first, last] of every trace
+ */
+void TelemetryPlot::renderColumns(int64_t first, int64_t last)
+{
+    const int width = m_image.width();
+    const int height = m_image.height();
+    const int64_t offset = (width - 1) - m_lastColumn;   // column + offset = x
+
+    QPainter painter(&m_image);
+    painter.fillRect(QRect((int)(first + offset), 0, (int)(last - first + 1), height), Background);
+
+    // start one column early so the trace joins the part that is already drawn
+    int64_t from = qMax(first - 1, m_lastColumn - width + 1);
+    size_t count = (size_t)(last - from + 1);
+
+    if (m_buckets.size() < count)
+        m_buckets.resize(count);
+
+    const double scale = (height - 1) / (double)(m_max - m_min);
+
+    for (const Trace &trace : m_traces)
+    {
+        const TelemetryChannel *channel = m_store->channel(trace.name);
+        if (!channel)
+            continue;
+
+        channel->query(from * m_columnTime, (last + 1) * m_columnTime, m_buckets.data(), count);
+
+        painter.setPen(trace.color);
+        m_polyline.clear();
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            const TelemetryBucket &bucket = m_buckets[i];
+
+            // gap in the data, finish the current segment
+            if (bucket.count == 0)
+            {
+                if (m_polyline.size() > 1)
+                    painter.drawPolyline(m_polyline);
+                m_polyline.clear();
+                continue;
+            }
+
+            // out of range, grow it and redraw everything on the next frame
+            if (!fitRange(bucket))
+                return;
+
+            qreal x = (qreal)(from + (int64_t)i + offset);
+            m_polyline << QPointF(x, (height - 1) - (bucket.min - m_min) * scale);
+            if (bucket.max != bucket.min)
+                m_polyline << QPointF(x, (height - 1) - (bucket.max - m_min) * scale);
+        }
+
+        if (m_polyline.size() > 1)
+            painter.drawPolyline(m_polyline);
+        else if (m_polyline.size() == 1)
+            painter.drawPoint(m_polyline.first());
+    }
+}
+
+bool TelemetryPlot::fitRange(const TelemetryBucket &bucket)
+{
+    if (bucket.min >= m_min && bucket.max <= m_max)
+        return true;
+
+    float margin = 0.1f * (qMax(m_max, bucket.max) - qMin(m_min, bucket.min));
+    m_min = qMin(m_min, bucket.min - margin);
+    m_max = qMax(m_max, bucket.max + margin);
+
+    invalidate();
+    return false;
+}
+
+void TelemetryPlot::paintEvent(QPaintEvent *event)
+{
+    Q_UNUSED(event)
+
+    QPainter painter(this);
+
+    if (m_image.isNull())
+        painter.fillRect(rect(), Background);
+    else
+        painter.drawImage(QRectF(rect()), m_image);
+
+    // zero line
+    if (m_min < 0 && m_max > 0)
+    {
+        qreal y = (height() - 1) * (m_max / (m_max - m_min));
+        painter.setPen(QColor(110, 110, 110));
+        painter.drawLine(QPointF(0, y), QPointF(width(), y));
+    }
+
+    // legend
+    int x = 4;
+    int y = fontMetrics().ascent() + 2;
+
+    for (const Trace &trace : m_traces)
+    {
+        QString label = QString::fromStdString(trace.name);
+        painter.setPen(trace.color);
+        painter.drawText(x, y, label);
+        x += fontMetrics().horizontalAdvance(label) + 8;
+    }
+}
+
+void TelemetryPlot::resizeEvent(QResizeEvent *event)
+{
+    Q_UNUSED(event)
+
+    QSize pixels = size() * devicePixelRatioF();
+    m_image = pixels.isEmpty() ? QImage() : QImage(pixels, QImage::Format_RGB32);
+    invalidate();
+}
+
+void TelemetryPlot::showEvent(QShowEvent *event)
+{
+    Q_UNUSED(event)
+    invalidate();
+}
+
+void TelemetryPlot::hideEvent(QHideEvent *event)
+{
+    Q_UNUSED(event)
+    m_frameTimer->stop();
+}
+
+void TelemetryPlot::contextMenuEvent(QContextMenuEvent *event)
+{
+    if (!m_store)
+        return;
+
+    QMenu menu(this);
+    QStringList selected = channels();
+
+    for (const std::string &name : m_store->channelNames())
+    {
+        QAction *action = menu.addAction(QString::fromStdString(name));
+        action->setCheckable(true);
+        action->setChecked(selected.contains(action->text()));
+    }
+
+    menu.addSeparator();
+    QMenu *spans = menu.addMenu(tr("Time Span"));
+
+    for (int seconds : {5, 10, 30, 60})
+    {
+        QAction *action = spans->addAction(tr("%1 s").arg(seconds));
+        action->setData(seconds);
+        action->setCheckable(true);
+        action->setChecked(m_span == seconds);
+    }
+
+    QAction *chosen = menu.exec(event->globalPos());
+    if (!chosen)
+        return;
+
+    if (chosen->data().isValid())
+        setTimeSpan(chosen->data().toInt());
+    else
+    {
+        m_autoSelect = false;
+
+        if (chosen->isChecked())
+            addChannel(chosen->text());
+        else
+            removeChannel(chosen->text());
+    }
+}
@@ -0,0 +1,113 @@
+#ifndef TELEMETRYPLOT_H
+#define TELEMETRYPLOT_H
+
+#include <QColor>
+#include <QImage>
+#include <QPolygonF>
+#include <QString>
+#include <QStringList>
+#include <QWidget>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "telemetrystore.h"
+
+class QTimer;
+
+/**
+ * @brief The TelemetryPlot class
+ *      Live strip chart for channels of a TelemetryStore.
+ *
+ *      Every pixel column covers a fixed slice of simulation time and shows the min/max
+ *      of that slice, queried from the store's summary pyramid, and each channel is drawn
+ *      as one polyline. Traces are rendered into an image that is scrolled as time advances,
+ *      so a frame only queries and draws the columns that are new since the last one.
+ *
+ *      Frames are drawn when storeChanged() reports new samples or the view changes,
+ *      at most once per display interval, so an idle plot costs no wakeups.
+ *
+ *      Channels are picked from the context menu; until then the first channels in the
+ *      store are shown.
+ */
+class TelemetryPlot : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit TelemetryPlot(QWidget *parent = nullptr);
+
+    void setStore(const TelemetryStore *store);
+
+    /**
+     * @brief setTimeSpan
+     * @param seconds - simulation time covered by the full width
+     */
+    void setTimeSpan(double seconds);
+    double timeSpan() const;
+
+    /**
+     * @brief setRange
+     *      Initial value range; it grows automatically when a trace leaves it
+     */
+    void setRange(float min, float max);
+
+    void addChannel(const QString &name);
+    void removeChannel(const QString &name);
+    QStringList channels() const;
+
+public slots:
+    /**
+     * @brief storeChanged
+     *      New samples were added to the store
+     */
+    void storeChanged();
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+    void resizeEvent(QResizeEvent *event) override;
+    void showEvent(QShowEvent *event) override;
+    void hideEvent(QHideEvent *event) override;
+    void contextMenuEvent(QContextMenuEvent *event) override;
+
+private slots:
+    void tick();
+
+private:
+    struct Trace
+    {
+        std::string name;
+        QColor color;
+    };
+
+    void selectDefaultChannels();
+    void invalidate();
+    void scheduleFrame();
+    void renderColumns(int64_t first, int64_t last);
+    void scrollImage(int columns);
+    bool fitRange(const TelemetryBucket &bucket);
+    double latestTime() const;
+
+    const TelemetryStore *m_store;
+    std::vector<Trace> m_traces;
+    bool m_autoSelect;
+    size_t m_scannedChannels;   // store channels seen by the last selectDefaultChannels()
+
+    double m_span;
+    float m_min;
+    float m_max;
+
+    QImage m_image;             // one column per device pixel
+    double m_columnTime;        // simulation time per column
+    int64_t m_lastColumn;       // absolute index of the rightmost rendered column
+    double m_latest;            // latestTime() of the last frame
+    bool m_valid;
+
+    std::vector<TelemetryBucket> m_buckets;
+    QPolygonF m_polyline;
+
+    QTimer *m_frameTimer;
+};
+
+#endif // TELEMETRYPLOT_H
@@ -0,0 +1,402 @@
+#include "telemetrystore.h"
+
+#include <algorithm>
+#include <limits>
+
+static constexpr size_t InitialCapacity = 4096;
+
+static size_t levelCapacity(size_t rawCapacity, int level)
+{
+    return std::max<size_t>(1, rawCapacity >> (TelemetryChannel::LevelFactorBits * (level + 1)));
+}
+
+//---------------------------------- CHANNEL ------------------------------------
+
+TelemetryChannel::TelemetryChannel(TelemetryStore *store, const std::string &name) :
+    m_store(store),
+    m_name(name),
+    m_successor(nullptr),
+    m_times(InitialCapacity),
+    m_values(InitialCapacity),
+    m_mask(InitialCapacity - 1),
+    m_total(0)
+{
+    for (int l = 0; l < LevelCount; ++l)
+    {
+        m_levels[l].entries.resize(levelCapacity(InitialCapacity, l));
+        m_levels[l].pendingCount = 0;
+        m_levels[l].completed = 0;
+    }
+}
+
+TelemetryChannel::~TelemetryChannel()
+{
+    m_store->release(memoryUsage());
+}
+
+/**
+ * @brief TelemetryChannel::initialMemoryUsage
+ * @return memoryUsage() of a new channel, reserved by the store before creating it
+ */
+size_t TelemetryChannel::initialMemoryUsage()
+{
+    size_t bytes = InitialCapacity * (sizeof(double) + sizeof(float));
+
+    for (int l = 0; l < LevelCount; ++l)
+        bytes += levelCapacity(InitialCapacity, l) * sizeof(Summary);
+
+    return bytes;
+}
+
+/**
+ * @brief TelemetryChannel::append
+ * @param time - simulation time of the sample
+ * @param value
+ */
+void TelemetryChannel::append(double time, float value)
+{
+    if (m_total > 0 && time < lastTime())
+        clear();
+
+    // the rings are only contiguous until they wrap for the first time, so that is the
+    // only point where they can grow
+    if (m_total == m_times.size())
+        grow();
+
+    m_times[m_total & m_mask] = time;
+    m_values[m_total & m_mask] = value;
+    m_total++;
+
+    summarize(0, Summary{time, value, value, value});
+}
+
+/**
+ * @brief TelemetryChannel::summarize
+ *      Adds one child summary to a level, cascading upwards once the level has a full entry
+ */
+void TelemetryChannel::summarize(int level, const Summary &summary)
+{
+    Level &l = m_levels[level];
+
+    if (l.pendingCount == 0)
+        l.pending = summary;
+    else
+    {
+        l.pending.sum += summary.sum;
+        l.pending.min = std::min(l.pending.min, summary.min);
+        l.pending.max = std::max(l.pending.max, summary.max);
+    }
+
+    if (++l.pendingCount < (uint32_t)LevelFactor)
+        return;
+
+    l.entries[l.completed % l.entries.size()] = l.pending;
+    l.completed++;
+    l.pendingCount = 0;
+
+    if (level + 1 < LevelCount)
+        summarize(level + 1, l.pending);
+}
+
+bool TelemetryChannel::grow()
+{
+    size_t capacity = m_times.size() * 2;
+    size_t bytes = (capacity - m_times.size()) * (sizeof(double) + sizeof(float));
+
+    for (int l = 0; l < LevelCount; ++l)
+        bytes += (levelCapacity(capacity, l) - m_levels[l].entries.size()) * sizeof(Summary);
+
+    if (!m_store->reserve(bytes))
+        return false;
+
+    m_times.resize(capacity);
+    m_values.resize(capacity);
+    m_mask = capacity - 1;
+
+    for (int l = 0; l < LevelCount; ++l)
+        m_levels[l].entries.resize(levelCapacity(capacity, l));
+
+    return true;
+}
+
+void TelemetryChannel::clear()
+{
+    m_total = 0;
+
+    for (Level &l : m_levels)
+    {
+        l.pendingCount = 0;
+        l.completed = 0;
+    }
+}
+
+size_t TelemetryChannel::size() const
+{
+    return (size_t)std::min<uint64_t>(m_total, m_times.size());
+}
+
+double TelemetryChannel::time(size_t index) const
+{
+    return rawTime(m_total - size() + index);
+}
+
+float TelemetryChannel::value(size_t index) const
+{
+    return rawValue(m_total - size() + index);
+}
+
+double TelemetryChannel::firstTime() const
+{
+    return empty() ? 0 : time(0);
+}
+
+double TelemetryChannel::lastTime() const
+{
+    return empty() ? 0 : rawTime(m_total - 1);
+}
+
+float TelemetryChannel::lastValue() const
+{
+    return empty() ? 0 : rawValue(m_total - 1);
+}
+
+size_t TelemetryChannel::memoryUsage() const
+{
+    size_t bytes = m_times.size() * sizeof(double) + m_values.size() * sizeof(float);
+
+    for (const Level &l : m_levels)
+        bytes += l.entries.size() * sizeof(Summary);
+
+    return bytes;
+}
+
+/**
+ * @brief TelemetryChannel::lowerBound
+ * @return absolute index of the first held sample at or after t
+ */
+uint64_t TelemetryChannel::lowerBound(double t) const
+{
+    uint64_t first = m_total - size();
+    uint64_t count = m_total - first;
+
+    while (count > 0)
+    {
+        uint64_t step = count / 2;
+        uint64_t middle = first + step;
+
+        if (rawTime(middle) < t)
+        {
+            first = middle + 1;
+            count -= step + 1;
+        }
+        else
+            count = step;
+    }
+
+    return first;
+}
+
+/**
+ * @brief TelemetryChannel::query
+ * @param t0 - window start
+ * @param t1 - window end, exclusive
+ * @param out
+ * @param buckets
+ * @return size_t
+ */
+size_t TelemetryChannel::query(double t0, double t1, TelemetryBucket *out, size_t buckets) const
+{
+    for (size_t b = 0; b < buckets; ++b)
+        out[b] = TelemetryBucket{std::numeric_limits<float>::max(), std::numeric_limits<float>::lowest(), 0, 0};
+
+    if (buckets == 0 || !(t1 > t0) || empty())
+        return 0;
+
+    uint64_t i0 = lowerBound(t0);
+    uint64_t i1 = lowerBound(t1);
+    uint64_t n = i1 - i0;
+
+    if (n == 0)
+        return 0;
+
+    // coarsest level whose entries still fit into one bucket on average
+    int top = -1;
+    for (int l = 0; l < LevelCount; ++l)
+    {
+        if (((uint64_t)1 << (LevelFactorBits * (l + 1))) * buckets > n)
+            break;
+        top = l;
+    }
+
+    const double scale = (double)buckets / (t1 - t0);
+
+    auto bucketFor = [&](double t) -> TelemetryBucket & {
+        size_t b = (size_t)std::max(0.0, (t - t0) * scale);
+        return out[std::min(b, buckets - 1)];
+    };
+
+    uint64_t index = i0;
+
+    while (index < i1)
+    {
+        // largest aligned summary that fits into the rest of the window, raw samples
+        // are only visited at the unaligned edges
+        int used = -1;
+
+        for (int l = top; l >= 0; --l)
+        {
+            uint64_t width = (uint64_t)1 << (LevelFactorBits * (l + 1));
+
+            if ((index & (width - 1)) != 0 || index + width > i1)
+                continue;
+
+            const Level &level = m_levels[l];
+            uint64_t entry = index >> (LevelFactorBits * (l + 1));
+
+            if (entry < level.completed && entry + level.entries.size() >= level.completed)
+            {
+                const Summary &s = level.entries[entry % level.entries.size()];
+                TelemetryBucket &bucket = bucketFor(s.firstTime);
+
+                bucket.min = std::min(bucket.min, s.min);
+                bucket.max = std::max(bucket.max, s.max);
+                bucket.mean += s.sum;
+                bucket.count += (uint32_t)width;
+
+                index += width;
+                used = l;
+                break;
+            }
+        }
+
+        if (used >= 0)
+            continue;
+
+        float v = rawValue(index);
+        TelemetryBucket &bucket = bucketFor(rawTime(index));
+
+        bucket.min = std::min(bucket.min, v);
+        bucket.max = std::max(bucket.max, v);
+        bucket.mean += v;
+        bucket.count++;
+
+        index++;
+    }
+
+    for (size_t b = 0; b < buckets; ++b)
+    {
+        if (out[b].count > 0)
+            out[b].mean /= out[b].count;
+    }
+
+    return (size_t)n;
+}
+
+//---------------------------------- STORE ------------------------------------
+
+TelemetryStore::TelemetryStore(size_t memoryCap) :
+    m_first(nullptr),
+    m_previous(nullptr),
+    m_memoryCap(memoryCap),
+    m_memoryUsage(0),
+    m_dropped(0)
+{
+}
+
+TelemetryStore::~TelemetryStore()
+{
+    clear();
+}
+
+/**
+ * @brief TelemetryStore::sample
+ *      Appends a parsed sample to its channel, creating the channel on first use.
+ *      Samples of a channel that does not fit under the memory cap are dropped.
+ * @param sample
+ */
+void TelemetryStore::sample(const TelemetrySample &sample)
+{
+    // records repeat the same channels in the same order, so the channel that followed
+    // the previous one last time is almost always the right guess
+    TelemetryChannel *target = m_previous ? m_previous->m_successor : m_first;
+
+    if (!target || target->name() != sample.channel)
+    {
+        target = channel(sample.channel);
+        if (!target)
+            target = addChannel(sample.channel);
+
+        if (!target)
+        {
+            m_dropped++;
+            return;
+        }
+
+        if (m_previous)
+            m_previous->m_successor = target;
+        else
+            m_first = target;
+    }
+
+    m_previous = target;
+    target->append(sample.time, (float)sample.value);
+}
+
+TelemetryChannel *TelemetryStore::channel(std::string_view name) const
+{
+    auto it = m_channels.find(name);
+    return it == m_channels.end() ? nullptr : it->second.get();
+}
+
+/**
+ * @brief TelemetryStore::addChannel
+ *      New channels are only created while their first block fits under the memory
+ *      cap, so a stream of ever new names cannot grow the store without bound
+ * @return the channel, nullptr if it does not exist and there is no room for it
+ */
+TelemetryChannel *TelemetryStore::addChannel(std::string_view name)
+{
+    if (TelemetryChannel *existing = channel(name))
+        return existing;
+
+    if (!reserve(TelemetryChannel::initialMemoryUsage()))
+        return nullptr;
+
+    std::string key(name);
+    TelemetryChannel *created = new TelemetryChannel(this, key);
+    m_channels.emplace(key, std::unique_ptr<TelemetryChannel>(created));
+
+    return created;
+}
+
+std::vector<std::string> TelemetryStore::channelNames() const
+{
+    std::vector<std::string> names;
+    names.reserve(m_channels.size());
+
+    for (const auto &entry : m_channels)
+        names.push_back(entry.first);
+
+    return names;
+}
+
+void TelemetryStore::clear()
+{
+    m_first = nullptr;
+    m_previous = nullptr;
+    m_channels.clear();
+}
+
+bool TelemetryStore::reserve(size_t bytes)
+{
+    if (m_memoryUsage + bytes > m_memoryCap)
+        return false;
+
+    m_memoryUsage += bytes;
+    return true;
+}
+
+void TelemetryStore::release(size_t bytes)
+{
+    m_memoryUsage -= std::min(bytes, m_memoryUsage);
+}
@@ -0,0 +1,171 @@
+#ifndef TELEMETRYSTORE_H
+#define TELEMETRYSTORE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "telemetryparser.h"
+
+class TelemetryStore;
+
+/**
+ * @brief The TelemetryBucket struct
+ *      Aggregate of all samples falling into one query bucket
+ */
+struct TelemetryBucket
+{
+    float min;
+    float max;
+    double mean;
+    uint32_t count;
+};
+
+/**
+ * @brief The TelemetryChannel class
+ *      Column store for one channel: timestamps and values live in two contiguous
+ *      ring arrays, oldest samples are overwritten once the store's memory cap is hit.
+ *
+ *      Next to the raw samples the channel keeps a pyramid of min/max/sum levels, level l
+ *      summarizing 16^l consecutive samples. Queries combine the coarsest levels that fit
+ *      the requested resolution, so their cost depends on the number of buckets asked
+ *      for rather than on the number of samples in the window.
+ *
+ *      Timestamps are expected to be non-decreasing; a step back in time (simulation
+ *      reset) clears the channel.
+ */
+class TelemetryChannel
+{
+public:
+    static constexpr int LevelFactorBits = 4;
+    static constexpr int LevelFactor = 1 << LevelFactorBits;
+    static constexpr int LevelCount = 5;
+
+    TelemetryChannel(TelemetryStore *store, const std::string &name);
+    ~TelemetryChannel();
+
+    const std::string &name() const { return m_name; }
+
+    void append(double time, float value);
+    void clear();
+
+    /**
+     * @brief size
+     * @return number of samples currently held
+     */
+    size_t size() const;
+    bool empty() const { return size() == 0; }
+
+    // index 0 is the oldest sample held
+    double time(size_t index) const;
+    float value(size_t index) const;
+
+    double firstTime() const;
+    double lastTime() const;
+    float lastValue() const;
+
+    /**
+     * @brief query
+     *      Aggregates [t0, t1) into evenly spaced buckets
+     * @param out - receives buckets entries, empty buckets have count 0
+     * @return number of samples covered
+     */
+    size_t query(double t0, double t1, TelemetryBucket *out, size_t buckets) const;
+
+    size_t memoryUsage() const;
+
+private:
+    friend class TelemetryStore;
+
+    struct Summary
+    {
+        double firstTime;
+        double sum;
+        float min;
+        float max;
+    };
+
+    struct Level
+    {
+        std::vector<Summary> entries;   // ring indexed by absolute entry number
+        Summary pending;
+        uint32_t pendingCount;
+        uint64_t completed;             // entries finished so far
+    };
+
+    static size_t initialMemoryUsage();
+
+    bool grow();
+    uint64_t lowerBound(double t) const;
+    void summarize(int level, const Summary &summary);
+
+    double rawTime(uint64_t absolute) const { return m_times[absolute & m_mask]; }
+    float rawValue(uint64_t absolute) const { return m_values[absolute & m_mask]; }
+
+    TelemetryStore *m_store;
+    std::string m_name;
+
+    // channel that came after this one in the last record, see TelemetryStore::sample()
+    TelemetryChannel *m_successor;
+
+    std::vector<double> m_times;
+    std::vector<float> m_values;
+    uint64_t m_mask;
+    uint64_t m_total;     // samples appended since the last clear
+
+    Level m_levels[LevelCount];
+};
+
+/**
+ * @brief The TelemetryStore class
+ *      Keeps every telemetry channel seen by the parser. Channels start small and
+ *      double their rings until the shared memory cap is reached, after which they
+ *      wrap and drop their oldest samples. Channels that first appear once the cap is
+ *      reached are not stored at all.
+ */
+class TelemetryStore : public TelemetrySink
+{
+public:
+    explicit TelemetryStore(size_t memoryCap = 256u * 1024u * 1024u);
+    ~TelemetryStore();
+
+    void sample(const TelemetrySample &sample) override;
+
+    TelemetryChannel *channel(std::string_view name) const;
+    TelemetryChannel *addChannel(std::string_view name);
+    std::vector<std::string> channelNames() const;
+    size_t channelCount() const { return m_channels.size(); }
+
+    void clear();
+
+    size_t memoryCap() const { return m_memoryCap; }
+    size_t memoryUsage() const { return m_memoryUsage; }
+
+    /**
+     * @brief droppedSamples
+     * @return samples of channels that were refused for lack of memory
+     */
+    uint64_t droppedSamples() const { return m_dropped; }
+
+private:
+    friend class TelemetryChannel;
+
+    bool reserve(size_t bytes);
+    void release(size_t bytes);
+
+    std::map<std::string, std::unique_ptr<TelemetryChannel>, std::less<>> m_channels;
+
+    // predicts the channel of the next sample without a map lookup
+    TelemetryChannel *m_first;
+    TelemetryChannel *m_previous;
+
+    size_t m_memoryCap;
+    size_t m_memoryUsage;
+    uint64_t m_dropped;
+};
+
+#endif // TELEMETRYSTORE_H
@@ -0,0 +1,39 @@
+#ifndef CHECK_H
+#define CHECK_H
+
+#include <cstdio>
+
+/*
+ *  Minimal checks for the tests of the modules that only depend on the standard
+ *  library. Those tests are built without Qt, like the simulator side that shares
+ *  the modules. A test is a main() that runs CHECK()s and returns checkResult().
+ */
+
+namespace Check
+{
+    inline int checks = 0;
+    inline int failures = 0;
+}
+
+#define CHECK(condition) \
+    do { \
+        Check::checks++; \
+        if (!(condition)) \
+        { \
+            Check::failures++; \
+            std::fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition); \
+        } \
+    } while (0)
+
+/**
+ * @brief checkResult
+ *      Prints the summary of a test
+ * @return exit code of the test, 1 if any check failed
+ */
+inline int checkResult(const char *test)
+{
+    std::printf("%s: %d checks, %d failed\n", test, Check::checks, Check::failures);
+    return Check::failures ? 1 : 0;
+}
+
+#endif // CHECK_H
@@ -0,0 +1,15 @@
+CONFIG += c++17 console testcase warn_on
+CONFIG -= app_bundle qt
+!msvc: QMAKE_CXXFLAGS += -Werror
+
+# CommandFrameEncoder and CommandFrameDecoder. Standard library only.
+
+INCLUDEPATH += ../..
+
+SOURCES += \
+    ../../commandframe.cpp \
+    main.cpp
+
+HEADERS += \
+    ../../commandframe.h \
+    ../check.h
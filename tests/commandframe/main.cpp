@@ -0,0 +1,141 @@
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "check.h"
+#include "commandframe.h"
+
+/*
+ *  Encodes frames and decodes them again, whole and in arbitrary chunks.
+ */
+
+static void testRoundTrip()
+{
+    CommandFrameEncoder encoder;
+    const char *bytes = encoder.encode(CommandOpcode::PitchRoll, 0.25f, -1.5f);
+
+    CommandFrame frame;
+    CHECK(CommandFrameDecoder::read(bytes, frame));
+    CHECK(frame.opcode == CommandOpcode::PitchRoll);
+    CHECK(frame.sequence == 1);
+    CHECK(frame.sequence == encoder.lastSequence());
+    CHECK(frame.timestamp == encoder.lastTimestamp());
+    CHECK(frame.value(0) == 0.25f);
+    CHECK(frame.value(1) == -1.5f);
+    CHECK(frame.value(2) == 0.f);
+    CHECK(frame.value(3) == 0.f);
+
+    encoder.encode(CommandOpcode::Stand);
+    CHECK(encoder.lastSequence() == 2);
+}
+
+static void testWireLayout()
+{
+    CommandFrame frame;
+    frame.opcode = CommandOpcode::View;
+    frame.sequence = 0x01020304;
+    frame.timestamp = 0x1122334455667788ull;
+    frame.setWord(0, 0xa0b0c0d0);
+
+    char bytes[CommandFrameFormat::Size];
+    CommandFrameEncoder::write(frame, bytes);
+
+    // little-endian whatever the host
+    CHECK((unsigned char)bytes[0] == 0x52 && (unsigned char)bytes[1] == 0x47);
+    CHECK((unsigned char)bytes[2] == CommandFrameFormat::Version);
+    CHECK(bytes[3] == 'V');
+    CHECK((unsigned char)bytes[4] == 0x04 && (unsigned char)bytes[7] == 0x01);
+    CHECK((unsigned char)bytes[8] == 0x88 && (unsigned char)bytes[15] == 0x11);
+    CHECK((unsigned char)bytes[16] == 0xd0 && (unsigned char)bytes[19] == 0xa0);
+}
+
+static void testText()
+{
+    CommandFrameEncoder encoder;
+    CommandFrame frame;
+
+    CHECK(CommandFrameDecoder::read(encoder.encode(CommandOpcode::SensorSearch, std::string("lidar")), frame));
+    CHECK(frame.text() == "lidar");
+
+    // a full payload has no terminator, longer text is cut
+    CHECK(CommandFrameDecoder::read(encoder.encode(CommandOpcode::SensorSearch, std::string(20, 'x')), frame));
+    CHECK(frame.text() == std::string(CommandFrameFormat::PayloadSize, 'x'));
+}
+
+static void testRejectsForeignBytes()
+{
+    CommandFrameEncoder encoder;
+    char bytes[CommandFrameFormat::Size];
+    std::memcpy(bytes, encoder.encode(CommandOpcode::Trot), sizeof(bytes));
+
+    CommandFrame frame;
+
+    bytes[0] ^= 1;
+    CHECK(!CommandFrameDecoder::read(bytes, frame));
+
+    bytes[0] ^= 1;
+    bytes[2] = (char)(CommandFrameFormat::Version + 1);
+    CHECK(!CommandFrameDecoder::read(bytes, frame));
+}
+
+static void testChunkedStream()
+{
+    CommandFrameEncoder encoder;
+    std::vector<char> stream;
+
+    for (int i = 0; i < 100; i++)
+    {
+        const char *bytes = encoder.encode(CommandOpcode::VelocityX, (float)i);
+        stream.insert(stream.end(), bytes, bytes + CommandFrameEncoder::size());
+    }
+
+    CommandFrameDecoder decoder;
+    CommandFrame frame;
+    int decoded = 0;
+    bool ordered = true;
+
+    // chunks of 1 to 7 bytes never line up with frames
+    for (size_t offset = 0, chunk = 1; offset < stream.size(); offset += chunk, chunk = chunk % 7 + 1)
+    {
+        decoder.feed(stream.data() + offset, std::min(chunk, stream.size() - offset));
+
+        while (decoder.next(frame))
+        {
+            ordered = ordered && frame.value(0) == (float)decoded && frame.sequence == (uint32_t)decoded + 1;
+            decoded++;
+        }
+    }
+
+    CHECK(decoded == 100);
+    CHECK(ordered);
+    CHECK(decoder.skippedBytes() == 0);
+}
+
+static void testResynchronizes()
+{
+    CommandFrameEncoder encoder;
+    CommandFrameDecoder decoder;
+    CommandFrame frame;
+
+    const char garbage[] = {1, 2, 3, 4, 5};
+    decoder.feed(garbage, sizeof(garbage));
+    decoder.feed(encoder.encode(CommandOpcode::Stand), CommandFrameEncoder::size());
+
+    CHECK(decoder.next(frame));
+    CHECK(frame.opcode == CommandOpcode::Stand);
+    CHECK(decoder.skippedBytes() == sizeof(garbage));
+    CHECK(!decoder.next(frame));
+}
+
+int main()
+{
+    testRoundTrip();
+    testWireLayout();
+    testText();
+    testRejectsForeignBytes();
+    testChunkedStream();
+    testResynchronizes();
+
+    return checkResult("commandframe");
+}
@@ -0,0 +1,22 @@
+QT = core testlib
+
+CONFIG += c++17 console testcase warn_on
+CONFIG -= app_bundle
+
+# EvdevDecoder. Linux only; links the evdev backend, which needs QtCore for
+# GamepadInput.
+
+INCLUDEPATH += ../..
+
+SOURCES += \
+    ../../commandframe.cpp \
+    ../../evdevgamepad.cpp \
+    ../../gamepadinput.cpp \
+    ../../inputconditioner.cpp \
+    main.cpp
+
+HEADERS += \
+    ../../commandframe.h \
+    ../../evdevgamepad.h \
+    ../../gamepadinput.h \
+    ../../inputconditioner.h
@@ -0,0 +1,255 @@
+#include <QtTest>
+
+#include <cstring>
+#include <vector>
+
+#include "evdevgamepad.h"
+
+// older headers only have the timeval member
+#ifndef input_event_sec
+#define input_event_sec time.tv_sec
+#define input_event_usec time.tv_usec
+#endif
+
+/*
+ *  Decoding recorded input_event streams: axis scaling and the flipped Y axes, the
+ *  hat switch as d-pad buttons, SYN_DROPPED and the frames ignored until the next
+ *  SYN_REPORT, and the kernel timestamp of every frame.
+ */
+
+class TestEvdevDecoder : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void sticks();
+    void customRange();
+    void triggers();
+    void hat();
+    void dropped();
+    void timestamps();
+
+private:
+    struct Decoded
+    {
+        std::vector<EvdevDecoder::Result> results;
+        std::vector<GamepadState> frames;
+    };
+
+    static input_event event(int type, int code, int value, qint64 usec = 0);
+    static input_event report(qint64 usec = 0);
+    static Decoded decode(EvdevDecoder &decoder, const std::vector<input_event> &events);
+};
+
+input_event TestEvdevDecoder::event(int type, int code, int value, qint64 usec)
+{
+    input_event event;
+    memset(&event, 0, sizeof(event));
+
+    event.input_event_sec = usec / 1000000;
+    event.input_event_usec = usec % 1000000;
+    event.type = (quint16)type;
+    event.code = (quint16)code;
+    event.value = value;
+    return event;
+}
+
+input_event TestEvdevDecoder::report(qint64 usec)
+{
+    return event(EV_SYN, SYN_REPORT, 0, usec);
+}
+
+/**
+ * @brief TestEvdevDecoder::decode
+ *      Feeds a recorded stream and collects every result and every complete frame
+ */
+TestEvdevDecoder::Decoded TestEvdevDecoder::decode(EvdevDecoder &decoder, const std::vector<input_event> &events)
+{
+    Decoded decoded;
+    GamepadState state;
+    memset(&state, 0, sizeof(state));
+
+    for (const input_event &e : events)
+    {
+        EvdevDecoder::Result result = decoder.feed(e, state);
+        decoded.results.push_back(result);
+
+        if (result == EvdevDecoder::Frame)
+            decoded.frames.push_back(state);
+    }
+
+    return decoded;
+}
+
+void TestEvdevDecoder::sticks()
+{
+    EvdevDecoder decoder;
+
+    // xpad ranges: full deflection keeps X and flips Y, evdev's Y grows downwards
+    Decoded decoded = decode(decoder, {
+        event(EV_ABS, ABS_X, 32767), event(EV_ABS, ABS_Y, 32767),
+        event(EV_ABS, ABS_RX, -32768), event(EV_ABS, ABS_RY, -32768),
+        report(),
+        event(EV_ABS, ABS_X, 0), event(EV_ABS, ABS_Y, 0),
+        event(EV_ABS, ABS_RX, 0), event(EV_ABS, ABS_RY, 0),
+        report(),
+    });
+
+    QCOMPARE(decoded.frames.size(), size_t(2));
+
+    const GamepadState &full = decoded.frames[0];
+    QVERIFY(full.connected);
+    QCOMPARE(full.thumbLX, qint16(32767));
+    QCOMPARE(full.thumbLY, qint16(-32767));
+    QCOMPARE(full.thumbRX, qint16(-32768));
+    QCOMPARE(full.thumbRY, qint16(32767));
+
+    const GamepadState &centred = decoded.frames[1];
+    QCOMPARE(centred.thumbLX, qint16(0));
+    QCOMPARE(centred.thumbLY, qint16(0));
+    QCOMPARE(centred.thumbRX, qint16(0));
+    QCOMPARE(centred.thumbRY, qint16(0));
+    QVERIFY(centred.packet != full.packet);
+
+    // only a SYN_REPORT completes a frame
+    for (size_t i = 0; i < decoded.results.size(); ++i)
+        QCOMPARE(decoded.results[i], i == 4 || i == 9 ? EvdevDecoder::Frame : EvdevDecoder::Pending);
+}
+
+void TestEvdevDecoder::customRange()
+{
+    EvdevDecoder decoder;
+    decoder.setRange(ABS_X, 0, 255);
+    decoder.setRange(ABS_Y, 0, 255);
+
+    // an empty range is ignored and the default kept
+    decoder.setRange(ABS_RX, 10, 10);
+
+    Decoded decoded = decode(decoder, {
+        event(EV_ABS, ABS_X, 0), event(EV_ABS, ABS_Y, 0), event(EV_ABS, ABS_RX, 32767),
+        report(),
+        event(EV_ABS, ABS_X, 255), event(EV_ABS, ABS_Y, 255),
+        report(),
+    });
+
+    QCOMPARE(decoded.frames.size(), size_t(2));
+    QCOMPARE(decoded.frames[0].thumbLX, qint16(-32768));
+    QCOMPARE(decoded.frames[0].thumbLY, qint16(32767));
+    QCOMPARE(decoded.frames[0].thumbRX, qint16(32767));
+    QCOMPARE(decoded.frames[1].thumbLX, qint16(32767));
+    QCOMPARE(decoded.frames[1].thumbLY, qint16(-32767));
+}
+
+void TestEvdevDecoder::triggers()
+{
+    EvdevDecoder decoder;
+
+    // ABS_BRAKE and ABS_GAS are the triggers of pads that do not use ABS_Z and ABS_RZ
+    decoder.setRange(ABS_GAS, 0, 255);
+
+    Decoded decoded = decode(decoder, {
+        event(EV_ABS, ABS_Z, 1023), event(EV_ABS, ABS_RZ, 512),
+        report(),
+        event(EV_ABS, ABS_BRAKE, 0), event(EV_ABS, ABS_GAS, 255),
+        report(),
+    });
+
+    QCOMPARE(decoded.frames.size(), size_t(2));
+    QCOMPARE(decoded.frames[0].leftTrigger, quint8(255));
+    QCOMPARE(decoded.frames[0].rightTrigger, quint8(128));
+    QCOMPARE(decoded.frames[1].leftTrigger, quint8(0));
+    QCOMPARE(decoded.frames[1].rightTrigger, quint8(255));
+}
+
+void TestEvdevDecoder::hat()
+{
+    EvdevDecoder decoder;
+
+    Decoded decoded = decode(decoder, {
+        event(EV_KEY, BTN_SOUTH, 1),
+        event(EV_ABS, ABS_HAT0X, -1), event(EV_ABS, ABS_HAT0Y, -1),
+        report(),
+        event(EV_ABS, ABS_HAT0X, 1), event(EV_ABS, ABS_HAT0Y, 1),
+        report(),
+        event(EV_ABS, ABS_HAT0X, 0), event(EV_ABS, ABS_HAT0Y, 0),
+        report(),
+        event(EV_KEY, BTN_SOUTH, 0),
+        report(),
+    });
+
+    QCOMPARE(decoded.frames.size(), size_t(4));
+
+    // opposite directions replace each other, other buttons stay as they are
+    QCOMPARE(decoded.frames[0].buttons, quint16(X1_a | X1_left | X1_up));
+    QCOMPARE(decoded.frames[1].buttons, quint16(X1_a | X1_right | X1_down));
+    QCOMPARE(decoded.frames[2].buttons, quint16(X1_a));
+    QCOMPARE(decoded.frames[3].buttons, quint16(0));
+}
+
+void TestEvdevDecoder::dropped()
+{
+    EvdevDecoder decoder;
+
+    Decoded decoded = decode(decoder, {
+        event(EV_KEY, BTN_EAST, 1),
+        report(1000),
+        // the kernel's buffer overflowed: the rest up to the next report is incomplete
+        event(EV_SYN, SYN_DROPPED, 0, 2000),
+        event(EV_KEY, BTN_EAST, 0, 2000),
+        event(EV_ABS, ABS_X, 32767, 2000),
+        report(2000),
+        // decoded again from here
+        event(EV_KEY, BTN_SOUTH, 1, 3000),
+        report(3000),
+    });
+
+    QCOMPARE(decoded.results.size(), size_t(8));
+    QCOMPARE(decoded.results[1], EvdevDecoder::Frame);
+    QCOMPARE(decoded.results[2], EvdevDecoder::Pending);
+    QCOMPARE(decoded.results[3], EvdevDecoder::Pending);
+    QCOMPARE(decoded.results[4], EvdevDecoder::Pending);
+    QCOMPARE(decoded.results[5], EvdevDecoder::Dropped);
+    QCOMPARE(decoded.results[7], EvdevDecoder::Frame);
+
+    // the events after SYN_DROPPED never reached the state
+    QCOMPARE(decoded.frames.size(), size_t(2));
+    QCOMPARE(decoded.frames[0].buttons, quint16(X1_b));
+    QCOMPARE(decoded.frames[1].buttons, quint16(X1_a | X1_b));
+    QCOMPARE(decoded.frames[1].thumbLX, qint16(0));
+    QCOMPARE(decoded.frames[1].timestamp, qint64(3000));
+
+    // a resync applies what the device reports now
+    decoder.setKey(BTN_EAST, false);
+    decoder.setAxis(ABS_X, 32767);
+
+    Decoded resynced = decode(decoder, { report(4000) });
+    QCOMPARE(resynced.frames.size(), size_t(1));
+    QCOMPARE(resynced.frames[0].buttons, quint16(X1_a));
+    QCOMPARE(resynced.frames[0].thumbLX, qint16(32767));
+}
+
+void TestEvdevDecoder::timestamps()
+{
+    EvdevDecoder decoder;
+
+    // every frame carries its SYN_REPORT's time, not that of the events before it
+    Decoded decoded = decode(decoder, {
+        event(EV_ABS, ABS_X, 100, 5000000),
+        report(5000250),
+        event(EV_ABS, ABS_X, 200, 5004000),
+        event(EV_SYN, SYN_CONFIG, 0, 5006000),
+        report(5008001),
+        report(12999999),
+    });
+
+    QCOMPARE(decoded.frames.size(), size_t(3));
+    QCOMPARE(decoded.frames[0].timestamp, qint64(5000250));
+    QCOMPARE(decoded.frames[1].timestamp, qint64(5008001));
+    QCOMPARE(decoded.frames[2].timestamp, qint64(12999999));
+    QVERIFY(decoded.frames[0].packet < decoded.frames[1].packet);
+    QVERIFY(decoded.frames[1].packet < decoded.frames[2].packet);
+}
+
+QTEST_GUILESS_MAIN(TestEvdevDecoder)
+
+#include "main.moc"
@@ -0,0 +1,17 @@
+CONFIG += c++17 console testcase warn_on
+CONFIG -= app_bundle qt
+!msvc: QMAKE_CXXFLAGS += -Werror
+
+# InputConditioner. Standard library only.
+
+INCLUDEPATH += ../..
+
+SOURCES += \
+    ../../inputconditioner.cpp \
+    ../../latencyhistogram.cpp \
+    main.cpp
+
+HEADERS += \
+    ../../inputconditioner.h \
+    ../../latencyhistogram.h \
+    ../check.h
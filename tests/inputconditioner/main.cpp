@@ -0,0 +1,179 @@
+#include <cmath>
+
+#include "check.h"
+#include "inputconditioner.h"
+
+/*
+ *  Deadzone and response curve, the filter on resting, jittering and moving input,
+ *  snapping a resting input, the bypass and the recorded lag.
+ */
+
+namespace
+{
+
+bool near(double a, double b, double tolerance = 1e-9)
+{
+    return std::fabs(a - b) <= tolerance;
+}
+
+} // namespace
+
+static void testShape()
+{
+    InputConditionerConfig config;
+    config.deadzone = 0.2;
+    InputConditioner conditioner(config);
+
+    InputConditioner::Output out = conditioner.shape(0.1, -0.1);
+    CHECK(out.x == 0 && out.y == 0);
+
+    // the rest of the range is rescaled to 0..1, the direction kept
+    out = conditioner.shape(0.6, 0);
+    CHECK(near(out.x, 0.5) && out.y == 0);
+
+    out = conditioner.shape(0, -1);
+    CHECK(out.x == 0 && near(out.y, -1));
+
+    // diagonals are not cut off, and corners are clamped to the unit circle
+    out = conditioner.shape(0.5, 0.5);
+    CHECK(near(out.x, out.y) && out.x > 0);
+    out = conditioner.shape(1, 1);
+    CHECK(near(std::hypot(out.x, out.y), 1));
+
+    // finer control near the centre
+    config.exponent = 2;
+    conditioner.setConfig(config);
+    out = conditioner.shape(0.6, 0);
+    CHECK(near(out.x, 0.25));
+    out = conditioner.shape(1, 0);
+    CHECK(near(out.x, 1));
+}
+
+static void testFilter()
+{
+    InputConditionerConfig config;
+    config.deadzone = 0;
+    InputConditioner conditioner(config);
+
+    // the first sample passes as is
+    InputConditioner::Output out = conditioner.condition(0.5, 0, 1000);
+    CHECK(near(out.x, 0.5));
+    CHECK(!conditioner.settling());
+
+    // jitter around a resting input is damped
+    double spread = 0;
+    uint64_t time = 1000;
+    for (int i = 0; i < 200; ++i)
+    {
+        time += 4000;
+        out = conditioner.condition(0.5 + ((i & 1) ? 0.02 : -0.02), 0, time);
+        if (i >= 100)
+            spread = std::max(spread, std::fabs(out.x - 0.5));
+    }
+
+    CHECK(spread > 0 && spread < 0.01);
+
+    // a step is followed, behind the input at first
+    out = conditioner.condition(0.9, 0, time += 4000);
+    CHECK(out.x > 0.5 && out.x < 0.9);
+    CHECK(conditioner.settling());
+
+    for (int i = 0; i < 200; ++i)
+        out = conditioner.condition(0.9, 0, time += 4000);
+
+    CHECK(near(out.x, 0.9, 1e-3));
+
+    // back into the deadzone is zero at once
+    config.deadzone = 0.1;
+    conditioner.setConfig(config);
+    conditioner.condition(0.9, 0, time += 4000);
+    out = conditioner.condition(0.05, 0, time += 4000);
+    CHECK(out.x == 0 && out.y == 0);
+    CHECK(!conditioner.settling());
+}
+
+static void testSnap()
+{
+    InputConditionerConfig config;
+    config.deadzone = 0;
+    InputConditioner conditioner(config);
+
+    CHECK(conditioner.snap().x == 0);
+
+    conditioner.condition(0, 0.2, 1000);
+    InputConditioner::Output out = conditioner.condition(0, 0.8, 5000);
+    CHECK(out.y < 0.8);
+    CHECK(conditioner.settling());
+
+    // an input that stopped moving is snapped onto its last sample
+    out = conditioner.snap();
+    CHECK(out.x == 0 && out.y == 0.8);
+    CHECK(!conditioner.settling());
+
+    // and the filter continues from there without a jump
+    out = conditioner.condition(0, 0.8, 5000 + InputConditioner::SettleDelay * 1000);
+    CHECK(out.y == 0.8);
+}
+
+static void testBypass()
+{
+    InputConditionerConfig config;
+    config.deadzone = 0.2;
+    config.filter = false;
+    config.prediction = 0.05;
+    InputConditioner conditioner(config);
+
+    // shaped, but neither filtered nor predicted
+    conditioner.condition(0.3, 0, 1000);
+    InputConditioner::Output out = conditioner.condition(0.6, 0, 2000);
+    CHECK(near(out.x, 0.5));
+    CHECK(!conditioner.settling());
+    CHECK(conditioner.lag().max() == 0);
+}
+
+static void testLagAndPrediction()
+{
+    InputConditionerConfig config;
+    config.deadzone = 0;
+    config.beta = 0;
+    InputConditioner conditioner(config);
+
+    conditioner.condition(0.1, 0, 0);
+    conditioner.condition(0.2, 0, 10000);
+
+    // a fixed cutoff of 5 Hz delays by 1 / (2 pi 5) s, about 32 ms
+    CHECK(conditioner.lag().count() == 2);
+    CHECK(conditioner.lag().min() == 0);
+    CHECK(near((double)conditioner.lag().max(), 1e6 / (2 * 3.14159265358979 * 5), 1));
+
+    // predicting that far ahead compensates the lag of a steady ramp
+    config.prediction = 1 / (2 * 3.14159265358979 * 5);
+    InputConditioner predicted(config);
+
+    InputConditionerConfig lagging = config;
+    lagging.prediction = 0;
+    InputConditioner plain(lagging);
+
+    InputConditioner::Output ahead = { 0, 0 }, behind = { 0, 0 };
+    for (int i = 1; i <= 100; ++i)
+    {
+        double x = i * 0.005;
+        ahead = predicted.condition(x, 0, i * 4000);
+        behind = plain.condition(x, 0, i * 4000);
+    }
+
+    CHECK(std::fabs(ahead.x - 0.5) < std::fabs(behind.x - 0.5));
+    CHECK(std::fabs(ahead.x - 0.5) < 0.01);
+    CHECK(predicted.lag().percentile(0.99) <= 1);
+}
+
+int main()
+{
+    testShape();
+    testFilter();
+    testSnap();
+    testBypass();
+    testLagAndPrediction();
+
+    return checkResult("inputconditioner");
+}
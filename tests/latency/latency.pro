@@ -0,0 +1,21 @@
+CONFIG += c++17 console testcase warn_on
+CONFIG -= app_bundle qt
+!msvc: QMAKE_CXXFLAGS += -Werror
+
+# LatencyHistogram and LatencyTracker. Standard library only.
+
+INCLUDEPATH += ../..
+
+SOURCES += \
+    ../../commandframe.cpp \
+    ../../latencyhistogram.cpp \
+    ../../latencytracker.cpp \
+    ../../telemetryparser.cpp \
+    main.cpp
+
+HEADERS += \
+    ../../commandframe.h \
+    ../../latencyhistogram.h \
+    ../../latencytracker.h \
+    ../../telemetryparser.h \
+    ../check.h
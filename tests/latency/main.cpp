@@ -0,0 +1,175 @@
+#include <cstdint>
+#include <string>
+
+#include "check.h"
+#include "commandframe.h"
+#include "latencyhistogram.h"
+#include "latencytracker.h"
+
+/*
+ *  Bucket layout and percentiles of the histogram, and the tracker matching acks from
+ *  the telemetry stream to the frames that were sent.
+ */
+
+namespace
+{
+
+void ack(LatencyTracker &tracker, double sequence)
+{
+    tracker.sample(TelemetrySample{ "ack", 0, sequence });
+}
+
+} // namespace
+
+static void testBuckets()
+{
+    // one bucket per value below 16
+    for (uint64_t v = 0; v < 16; ++v)
+        CHECK(LatencyHistogram::bucketIndex(v) == (int)v);
+
+    // buckets are contiguous, ordered and hold what bucketIndex() puts into them
+    bool contiguous = true;
+    bool consistent = true;
+
+    for (int i = 0; i + 1 < LatencyHistogram::BucketCount; ++i)
+    {
+        if (LatencyHistogram::bucketUpper(i) + 1 != LatencyHistogram::bucketLower(i + 1))
+            contiguous = false;
+
+        if (LatencyHistogram::bucketIndex(LatencyHistogram::bucketLower(i)) != i
+                || LatencyHistogram::bucketIndex(LatencyHistogram::bucketUpper(i)) != i)
+            consistent = false;
+    }
+
+    CHECK(contiguous);
+    CHECK(consistent);
+    CHECK(LatencyHistogram::bucketUpper(LatencyHistogram::BucketCount - 1) == UINT64_MAX);
+    CHECK(LatencyHistogram::bucketIndex(UINT64_MAX) == LatencyHistogram::BucketCount - 1);
+
+    // every bucket is narrower than 1/16 of its values
+    bool precise = true;
+
+    for (int i = LatencyHistogram::SubBucketCount; i < LatencyHistogram::BucketCount; ++i)
+    {
+        uint64_t lower = LatencyHistogram::bucketLower(i);
+        if (LatencyHistogram::bucketUpper(i) - lower >= lower / 16 + 1)
+            precise = false;
+    }
+
+    CHECK(precise);
+}
+
+static void testPercentile()
+{
+    LatencyHistogram histogram;
+
+    CHECK(histogram.count() == 0);
+    CHECK(histogram.min() == 0 && histogram.max() == 0);
+    CHECK(histogram.mean() == 0);
+    CHECK(histogram.percentile(0.5) == 0);
+
+    for (uint64_t v = 1; v <= 1000; ++v)
+        histogram.record(v);
+
+    CHECK(histogram.count() == 1000);
+    CHECK(histogram.min() == 1 && histogram.max() == 1000);
+    CHECK(histogram.mean() == 500.5);
+
+    // upper bound of the bucket, within 1/16 of the true value
+    uint64_t p50 = histogram.percentile(0.5);
+    uint64_t p99 = histogram.percentile(0.99);
+
+    CHECK(p50 >= 501 && p50 <= 501 + 501 / 16);
+    CHECK(p99 >= 991 && p99 <= 1000);
+    CHECK(histogram.percentile(0) == 1);
+    CHECK(histogram.percentile(1) == 1000);
+
+    // never beyond the largest value recorded
+    LatencyHistogram single;
+    single.record(1000);
+    CHECK(single.percentile(0.5) == 1000);
+
+    histogram.clear();
+    CHECK(histogram.count() == 0 && histogram.percentile(0.99) == 0);
+}
+
+static void testMerge()
+{
+    LatencyHistogram fast, slow;
+
+    for (int i = 0; i < 90; ++i)
+        fast.record(100);
+    for (int i = 0; i < 10; ++i)
+        slow.record(10000);
+
+    LatencyHistogram all;
+    all.merge(fast);
+    all.merge(slow);
+
+    CHECK(all.count() == 100);
+    CHECK(all.min() == 100 && all.max() == 10000);
+    CHECK(all.mean() == (90 * 100 + 10 * 10000) / 100.0);
+    CHECK(all.bucketCount(LatencyHistogram::bucketIndex(100)) == 90);
+    CHECK(all.percentile(0.5) == LatencyHistogram::bucketUpper(LatencyHistogram::bucketIndex(100)));
+    CHECK(all.percentile(0.95) == 10000);
+
+    // merging an empty histogram changes nothing
+    all.merge(LatencyHistogram());
+    CHECK(all.count() == 100 && all.min() == 100);
+}
+
+static void testTracker()
+{
+    LatencyTracker tracker;
+    uint64_t now = CommandFrameEncoder::now();
+
+    tracker.sent(1, now);
+    tracker.sent(2, now);
+
+    ack(tracker, 1);
+    CHECK(tracker.histogram().count() == 1);
+
+    // acked twice, never sent, and other channels are ignored
+    ack(tracker, 1);
+    ack(tracker, 3);
+    ack(tracker, -1);
+    tracker.sample(TelemetrySample{ "vx", 0, 2 });
+
+    CHECK(tracker.histogram().count() == 1);
+    CHECK(tracker.unmatched() == 2);
+
+    ack(tracker, 2);
+    CHECK(tracker.histogram().count() == 2);
+    CHECK(tracker.lost() == 0);
+
+    // a frame whose slot is reused before its ack arrives is lost, its late ack unmatched
+    tracker.sent(10, now);
+    tracker.sent(10 + LatencyTracker::PendingCapacity, now);
+    CHECK(tracker.lost() == 1);
+
+    ack(tracker, 10);
+    CHECK(tracker.unmatched() == 3);
+
+    ack(tracker, 10 + LatencyTracker::PendingCapacity);
+    CHECK(tracker.histogram().count() == 3);
+
+    // the time from the frame's stamp to the ack being parsed
+    LatencyTracker timed;
+    timed.sent(7, now - 5000);
+    ack(timed, 7);
+    CHECK(timed.histogram().min() >= 5000);
+    CHECK(timed.histogram().min() < 5000 + 1000000);
+
+    tracker.clear();
+    CHECK(tracker.histogram().count() == 0 && tracker.lost() == 0 && tracker.unmatched() == 0);
+}
+
+int main()
+{
+    testBuckets();
+    testPercentile();
+    testMerge();
+    testTracker();
+
+    return checkResult("latency");
+}
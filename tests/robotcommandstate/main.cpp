@@ -0,0 +1,222 @@
+#include <vector>
+
+#include "check.h"
+#include "commandframe.h"
+#include "robotcommandstate.h"
+
+/*
+ *  Delta and keyframe updates sent through the wire format and applied on the
+ *  receiving side, and the ordering of Setpoint datagrams.
+ */
+
+namespace
+{
+
+// encodes an update and decodes its frames again, as the receiver would see them
+std::vector<CommandFrame> encode(RobotCommandState &state, CommandFrameEncoder &encoder, bool keyframe,
+                                 uint32_t fields = StateUpdateFormat::FieldMask)
+{
+    std::vector<CommandFrame> frames;
+
+    state.encodeUpdate(encoder, keyframe, [&](const char *bytes) {
+        CommandFrame frame;
+        CommandFrameDecoder::read(bytes, frame);
+        frames.push_back(frame);
+    }, fields);
+
+    return frames;
+}
+
+bool sameValues(const RobotCommandState &a, const RobotCommandState &b)
+{
+    for (int field = 0; field < StateUpdateFormat::FieldCount; ++field)
+    {
+        if (a.value((RobotField)field) != b.value((RobotField)field))
+            return false;
+    }
+
+    return true;
+}
+
+CommandFrame setpoint(uint32_t sequence, float vx)
+{
+    CommandFrame frame;
+    frame.opcode = CommandOpcode::Setpoint;
+    frame.sequence = sequence;
+    frame.setValue(0, vx);
+    frame.setValue(1, 0.f);
+    frame.setValue(2, 0.f);
+    frame.setValue(3, 0.f);
+    return frame;
+}
+
+} // namespace
+
+static void testChanges()
+{
+    RobotCommandState state;
+
+    CHECK(!state.dirty());
+    CHECK(state.value(RobotField::Height) == 0.f);
+
+    CHECK(state.set(RobotField::Height, 0.3f));
+    CHECK(!state.set(RobotField::Height, 0.3f));
+    CHECK(state.add(RobotField::ArmRotate, RobotCommandState::JointStep));
+    CHECK(state.value(RobotField::ArmRotate) == RobotCommandState::JointStep);
+
+    CHECK(state.dirtyMask() == ((1u << (int)RobotField::Height) | (1u << (int)RobotField::ArmRotate)));
+
+    CHECK(!state.moving());
+    state.set(RobotField::Roll, -0.5f);
+    CHECK(state.moving());
+}
+
+static void testDelta()
+{
+    CommandFrameEncoder encoder;
+    RobotCommandState sender, receiver;
+
+    // nothing changed, nothing sent
+    CHECK(encode(sender, encoder, false).empty());
+
+    sender.set(RobotField::VelocityX, 0.5f);
+    sender.set(RobotField::Grip, 1.f);
+
+    std::vector<CommandFrame> frames = encode(sender, encoder, false);
+    CHECK(frames.size() == 1);
+    CHECK(!sender.dirty());
+
+    uint32_t word = frames[0].word(0);
+    CHECK((word & StateUpdateFormat::FieldMask) == ((1u << (int)RobotField::VelocityX) | (1u << (int)RobotField::Grip)));
+    CHECK(word & StateUpdateFormat::Commit);
+    CHECK(!(word & StateUpdateFormat::Keyframe));
+
+    // values in ascending field order, unused slots zero
+    CHECK(frames[0].value(1) == 0.5f && frames[0].value(2) == 1.f && frames[0].value(3) == 0.f);
+
+    CHECK(receiver.apply(frames[0]));
+    CHECK(sameValues(sender, receiver));
+
+    // seven changes take three frames of at most three fields, committed by the last
+    const RobotField changed[] = { RobotField::VelocityY, RobotField::Pitch, RobotField::Height, RobotField::ArmExtend,
+                                   RobotField::ArmHeight, RobotField::GripAngle, RobotField::Gait };
+    float value = 0.1f;
+    for (RobotField field : changed)
+        sender.set(field, value += 0.1f);
+
+    frames = encode(sender, encoder, false);
+    CHECK(frames.size() == 3);
+
+    CHECK(!receiver.apply(frames[0]));
+    CHECK(!receiver.apply(frames[1]));
+
+    // nothing is applied before the commit
+    CHECK(receiver.value(RobotField::VelocityY) == 0.f);
+
+    CHECK(receiver.apply(frames[2]));
+    CHECK(sameValues(sender, receiver));
+    CHECK(frames[1].sequence == frames[0].sequence + 1);
+}
+
+static void testKeyframe()
+{
+    CommandFrameEncoder encoder;
+    RobotCommandState sender, receiver;
+
+    for (int field = 0; field < StateUpdateFormat::FieldCount; ++field)
+        sender.set((RobotField)field, field * 0.25f - 1.f);
+
+    encode(sender, encoder, false);
+    CHECK(!sender.dirty());
+
+    // every field although none changed since the last update
+    std::vector<CommandFrame> frames = encode(sender, encoder, true);
+    int expected = (StateUpdateFormat::FieldCount + StateUpdateFormat::FieldsPerFrame - 1) / StateUpdateFormat::FieldsPerFrame;
+    CHECK((int)frames.size() == expected);
+
+    uint32_t fields = 0;
+    bool keyframe = true;
+    int commits = 0;
+
+    for (const CommandFrame &frame : frames)
+    {
+        fields |= frame.word(0) & StateUpdateFormat::FieldMask;
+        keyframe = keyframe && (frame.word(0) & StateUpdateFormat::Keyframe);
+        commits += (frame.word(0) & StateUpdateFormat::Commit) ? 1 : 0;
+        receiver.apply(frame);
+    }
+
+    CHECK(fields == StateUpdateFormat::FieldMask);
+    CHECK(keyframe);
+    CHECK(commits == 1);
+    CHECK(sameValues(sender, receiver));
+}
+
+static void testFieldMask()
+{
+    CommandFrameEncoder encoder;
+    RobotCommandState sender, receiver;
+
+    // setpoints travel as datagrams, the reliable update leaves them dirty
+    sender.set(RobotField::VelocityX, 0.5f);
+    sender.set(RobotField::Height, 0.2f);
+
+    std::vector<CommandFrame> frames = encode(sender, encoder, false, StateUpdateFormat::FieldMask & ~SetpointFormat::Fields);
+    CHECK(frames.size() == 1);
+    CHECK((frames[0].word(0) & StateUpdateFormat::FieldMask) == (1u << (int)RobotField::Height));
+    CHECK(sender.dirtyMask() == (1u << (int)RobotField::VelocityX));
+
+    CommandFrame frame;
+    CHECK(CommandFrameDecoder::read(sender.encodeSetpoint(encoder), frame));
+    CHECK(!sender.dirty());
+    CHECK(frame.opcode == CommandOpcode::Setpoint);
+    CHECK(frame.value(0) == 0.5f);
+
+    CHECK(receiver.apply(frames[0]));
+    CHECK(receiver.apply(frame));
+    CHECK(sameValues(sender, receiver));
+
+    // other opcodes are none of the state's business
+    CommandFrame stand;
+    stand.opcode = CommandOpcode::Stand;
+    CHECK(!receiver.apply(stand));
+}
+
+static void testSetpointOrder()
+{
+    RobotCommandState receiver;
+
+    CHECK(receiver.apply(setpoint(10, 1.f)));
+    CHECK(receiver.value(RobotField::VelocityX) == 1.f);
+
+    // late and repeated datagrams are dropped
+    CHECK(!receiver.apply(setpoint(9, 2.f)));
+    CHECK(!receiver.apply(setpoint(10, 2.f)));
+    CHECK(receiver.value(RobotField::VelocityX) == 1.f);
+
+    CHECK(receiver.apply(setpoint(12, 3.f)));
+    CHECK(!receiver.apply(setpoint(11, 4.f)));
+    CHECK(receiver.value(RobotField::VelocityX) == 3.f);
+
+    // sequence numbers wrap
+    RobotCommandState wrapped;
+    CHECK(wrapped.apply(setpoint(0xffffffffu, 1.f)));
+    CHECK(wrapped.apply(setpoint(0, 2.f)));
+    CHECK(!wrapped.apply(setpoint(0xfffffffeu, 3.f)));
+
+    // far behind means a restarted sender, not a late frame
+    CHECK(receiver.apply(setpoint(12 + 0x100000u, 5.f)));
+    CHECK(receiver.apply(setpoint(1, 6.f)));
+    CHECK(receiver.value(RobotField::VelocityX) == 6.f);
+}
+
+int main()
+{
+    testChanges();
+    testDelta();
+    testKeyframe();
+    testFieldMask();
+    testSetpointOrder();
+
+    return checkResult("robotcommandstate");
+}
@@ -0,0 +1,17 @@
+CONFIG += c++17 console testcase warn_on
+CONFIG -= app_bundle qt
+!msvc: QMAKE_CXXFLAGS += -Werror
+
+# RobotCommandState. Standard library only.
+
+INCLUDEPATH += ../..
+
+SOURCES += \
+    ../../commandframe.cpp \
+    ../../robotcommandstate.cpp \
+    main.cpp
+
+HEADERS += \
+    ../../commandframe.h \
+    ../../robotcommandstate.h \
+    ../check.h
@@ -0,0 +1,258 @@
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QTemporaryDir>
+#include <QtTest>
+
+#include "sceneconverter.h"
+
+/*
+ *  Converting small and large scenes into a temporary directory, and the cases that
+ *  must leave an existing model alone: parse errors, cancelling and a model path
+ *  that is the scene itself.
+ */
+
+class TestSceneConverter : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void outputPath();
+    void convert();
+    void largeScene();
+    void memoryBounded();
+    void parseError();
+    void cancel();
+    void sceneNotReplaced();
+
+private:
+    QString write(const QString &name, const QByteArray &text);
+    static QByteArray read(const QString &path);
+    static QByteArray objects(int cuboids, int others);
+    static QByteArray scene(int cuboids, int others);
+    static qint64 peakResident();
+
+    QTemporaryDir m_dir;
+};
+
+QString TestSceneConverter::write(const QString &name, const QByteArray &text)
+{
+    QString path = m_dir.filePath(name);
+
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate) || file.write(text) != text.size())
+        return QString();
+
+    return path;
+}
+
+QByteArray TestSceneConverter::read(const QString &path)
+{
+    QFile file(path);
+    return file.open(QIODevice::ReadOnly) ? file.readAll() : QByteArray();
+}
+
+QByteArray TestSceneConverter::objects(int cuboids, int others)
+{
+    QByteArray text;
+
+    for (int i = 0; i < cuboids + others; ++i)
+    {
+        text += "  <object id=\"" + QByteArray::number(i) + "\">\n";
+        text += i < cuboids ? "    <type> cuboid </type>\n" : "    <type>sphere</type>\n";
+        text += "    <size>0.1 0.2 0.3</size>\n  </object>\n";
+    }
+
+    return text;
+}
+
+QByteArray TestSceneConverter::scene(int cuboids, int others)
+{
+    return "<?xml version=\"1.0\"?>\n<scene>\n" + objects(cuboids, others) + "</scene>\n";
+}
+
+/**
+ * @brief TestSceneConverter::peakResident
+ * @return peak resident set size of the process in KB, -1 if unknown
+ */
+qint64 TestSceneConverter::peakResident()
+{
+    QFile status("/proc/self/status");
+    if (!status.open(QIODevice::ReadOnly | QIODevice::Text))
+        return -1;
+
+    while (!status.atEnd())
+    {
+        QByteArray line = status.readLine();
+        if (line.startsWith("VmHWM:"))
+            return line.mid(6).trimmed().split(' ').value(0).toLongLong();
+    }
+
+    return -1;
+}
+
+void TestSceneConverter::outputPath()
+{
+    QCOMPARE(SceneConverter::outputPathFor("/data/scenes/lab.xml"), QString("/data/scenes/lab.mujoco.xml"));
+    QCOMPARE(SceneConverter::outputPathFor("/data/lab.v2.xml"), QString("/data/lab.v2.mujoco.xml"));
+    QCOMPARE(SceneConverter::outputPathFor("scenes/lab.xml"), QString("scenes/lab.mujoco.xml"));
+}
+
+void TestSceneConverter::convert()
+{
+    QString scenePath = write("small.xml", scene(5, 3));
+    QString modelPath = SceneConverter::outputPathFor(scenePath);
+
+    QVector<qint64> reported;
+    SceneConverter converter;
+
+    QVERIFY(converter.convert(scenePath, modelPath, [&](qint64 done, qint64 total) {
+        reported.append(done);
+        return done <= total;
+    }));
+
+    QVERIFY(converter.errorString().isEmpty());
+    QVERIFY(!converter.cancelled());
+    QCOMPARE(converter.cuboids(), 5);
+
+    // every two cuboids make one body
+    QByteArray model = read(modelPath);
+    QVERIFY(model.startsWith("<mujoco model="));
+    QVERIFY(model.endsWith("</worldbody>\n</mujoco>\n"));
+    QCOMPARE(model.count("<body "), 2);
+
+    QVERIFY(!reported.isEmpty());
+    QCOMPARE(reported.last(), QFileInfo(scenePath).size());
+
+    // the model is replaced, not appended to
+    QVERIFY(converter.convert(write("small.xml", scene(2, 0)), modelPath));
+    QCOMPARE(read(modelPath).count("<body "), 1);
+}
+
+void TestSceneConverter::largeScene()
+{
+    // many times the write buffer and the progress interval
+    QString scenePath = write("large.xml", scene(20001, 500));
+    QString modelPath = m_dir.filePath("large.model.xml");
+
+    bool ordered = true;
+    qint64 last = 0;
+    SceneConverter converter;
+
+    QVERIFY(converter.convert(scenePath, modelPath, [&](qint64 done, qint64) {
+        ordered = ordered && done >= last;
+        last = done;
+        return true;
+    }));
+
+    QVERIFY(ordered);
+    QCOMPARE(converter.cuboids(), 20001);
+
+    QByteArray model = read(modelPath);
+    QCOMPARE(model.count("<body "), 10000);
+    QVERIFY(model.size() > SceneConverter::WriteBuffer);
+    QVERIFY(model.endsWith("</mujoco>\n"));
+}
+
+void TestSceneConverter::memoryBounded()
+{
+#ifndef Q_OS_LINUX
+    QSKIP("peak memory is read from /proc");
+#else
+    // a 64 MB scene, written in pieces so the test itself never holds it
+    QString scenePath = m_dir.filePath("huge.xml");
+    QFile file(scenePath);
+    QVERIFY(file.open(QIODevice::WriteOnly | QIODevice::Truncate));
+
+    const QByteArray block = objects(1000, 1000);
+    QVERIFY(file.write("<?xml version=\"1.0\"?>\n<scene>\n") > 0);
+
+    int blocks = 0;
+    while (file.size() < 64 * 1024 * 1024)
+    {
+        QVERIFY(file.write(block) == block.size());
+        blocks++;
+    }
+
+    QVERIFY(file.write("</scene>\n") > 0);
+    file.close();
+
+    // resets the peak resident set size of the process
+    QFile clearRefs("/proc/self/clear_refs");
+    if (!clearRefs.open(QIODevice::WriteOnly) || clearRefs.write("5") != 1)
+        QSKIP("cannot reset the peak resident set size");
+    clearRefs.close();
+
+    qint64 before = peakResident();
+    QVERIFY(before > 0);
+
+    SceneConverter converter;
+    QVERIFY(converter.convert(scenePath, m_dir.filePath("huge.mujoco.xml")));
+    QCOMPARE(converter.cuboids(), blocks * 1000);
+
+    // reading the scene into memory, let alone decoding it, would take far more
+    qint64 grown = peakResident() - before;
+    QVERIFY2(grown < 16 * 1024, qPrintable(QString("peak grew by %1 KB").arg(grown)));
+#endif
+}
+
+void TestSceneConverter::parseError()
+{
+    QString modelPath = write("broken.mujoco.xml", "previous model\n");
+    QString scenePath = write("broken.xml", "<scene>\n<type>cuboid</type>\n<object>\n</scene>\n");
+
+    SceneConverter converter;
+    QVERIFY(!converter.convert(scenePath, modelPath));
+    QVERIFY(converter.errorString().startsWith("line 4: "));
+    QVERIFY(!converter.cancelled());
+    QCOMPARE(converter.cuboids(), 0);
+
+    QCOMPARE(read(modelPath), QByteArray("previous model\n"));
+
+    QVERIFY(!converter.convert(m_dir.filePath("missing.xml"), modelPath));
+    QVERIFY(!converter.errorString().isEmpty());
+}
+
+void TestSceneConverter::cancel()
+{
+    QString scenePath = write("cancelled.xml", scene(10000, 0));
+    QString modelPath = write("cancelled.mujoco.xml", "previous model\n");
+
+    // while the scene is read
+    int calls = 0;
+    SceneConverter converter;
+
+    QVERIFY(!converter.convert(scenePath, modelPath, [&](qint64, qint64) { return ++calls < 2; }));
+    QVERIFY(converter.cancelled());
+    QCOMPARE(calls, 2);
+    QCOMPARE(read(modelPath), QByteArray("previous model\n"));
+
+    // and while the model is written, after the final report of the scene
+    calls = 0;
+    QVERIFY(!converter.convert(scenePath, modelPath, [&](qint64 done, qint64 total) {
+        return done < total || ++calls < 2;
+    }));
+
+    QVERIFY(converter.cancelled());
+    QCOMPARE(read(modelPath), QByteArray("previous model\n"));
+
+    // without leaving the unfinished model behind
+    QCOMPARE(QDir(m_dir.path()).entryList({ "cancelled.mujoco.xml*" }, QDir::Files).size(), 1);
+}
+
+void TestSceneConverter::sceneNotReplaced()
+{
+    QByteArray text = scene(4, 0);
+    QString scenePath = write("same.xml", text);
+
+    SceneConverter converter;
+    QVERIFY(!converter.convert(scenePath, scenePath));
+    QCOMPARE(converter.errorString(), QString("the model would replace the scene"));
+
+    QVERIFY(!converter.convert(scenePath, m_dir.path() + "/./same.xml"));
+    QCOMPARE(read(scenePath), text);
+}
+
+QTEST_GUILESS_MAIN(TestSceneConverter)
+
+#include "main.moc"
@@ -0,0 +1,15 @@
+QT = core testlib
+
+CONFIG += c++17 console testcase warn_on
+CONFIG -= app_bundle
+
+# SceneConverter. Needs QtCore for its XML reader and QSaveFile.
+
+INCLUDEPATH += ../..
+
+SOURCES += \
+    ../../sceneconverter.cpp \
+    main.cpp
+
+HEADERS += \
+    ../../sceneconverter.h
@@ -0,0 +1,235 @@
+#include <cstring>
+#include <string>
+#include <thread>
+
+#include <poll.h>
+#include <unistd.h>
+
+#include "check.h"
+#include "shmtransport.h"
+
+/*
+ *  The simulator and the client side of a region in one process: ring writes and
+ *  reads across the wrap, blocking waits, the peer checks after the simulator closed
+ *  or replaced the region, and ShmWaiter reporting rings through its eventfd.
+ */
+
+namespace
+{
+
+const size_t CommandCapacity = 1024;
+const size_t TelemetryCapacity = 4096;
+
+std::string regionName()
+{
+    return "/roboui.test." + std::to_string(getpid());
+}
+
+bool readable(int fd, int timeoutMs)
+{
+    struct pollfd entry = { fd, POLLIN, 0 };
+    return poll(&entry, 1, timeoutMs) == 1 && (entry.revents & POLLIN);
+}
+
+std::string drain(ShmRing &ring)
+{
+    std::string text;
+    size_t available;
+    const char *data;
+
+    while ((data = ring.peek(available)), available > 0)
+    {
+        text.append(data, available);
+        ring.consume(available);
+    }
+
+    return text;
+}
+
+} // namespace
+
+static void testAttach()
+{
+    ShmChannel simulator, client;
+
+    CHECK(!client.attach(regionName()));
+    CHECK(!client.errorString().empty());
+
+    // capacities have to be powers of two
+    CHECK(!simulator.create(regionName(), 1000, TelemetryCapacity));
+
+    CHECK(simulator.create(regionName(), CommandCapacity, TelemetryCapacity));
+    CHECK(client.attach(regionName()));
+    CHECK(client.isOpen());
+    CHECK(client.commands().capacity() == CommandCapacity);
+    CHECK(client.telemetry().capacity() == TelemetryCapacity);
+    CHECK(client.peerReady());
+    CHECK(client.peerAlive());
+
+    CHECK(ShmChannel::regionName(9000) == "/roboui.9000");
+}
+
+static void testRing()
+{
+    ShmChannel simulator, client;
+    CHECK(simulator.create(regionName(), CommandCapacity, TelemetryCapacity));
+    CHECK(client.attach(regionName()));
+
+    ShmRing &out = client.commands();
+    ShmRing &in = simulator.commands();
+
+    char frame[24];
+    std::memset(frame, 'f', sizeof(frame));
+
+    // all or nothing
+    int written = 0;
+    while (out.write(frame, sizeof(frame)))
+        written++;
+
+    CHECK(written == (int)(CommandCapacity / sizeof(frame)));
+    CHECK(in.readable() == written * sizeof(frame));
+
+    size_t available;
+    in.peek(available);
+    CHECK(available == written * sizeof(frame));
+
+    // a write across the end of the buffer comes back in two pieces
+    char message[64];
+    for (size_t i = 0; i < sizeof(message); ++i)
+        message[i] = (char)('a' + i % 26);
+
+    CHECK(!out.write(message, sizeof(message)));
+    in.consume(available - 8);
+    CHECK(out.write(message, sizeof(message)));
+
+    in.peek(available);
+    CHECK(available == CommandCapacity - (written * sizeof(frame) - 8));
+
+    std::string text = drain(in);
+    CHECK(text.size() == 8 + sizeof(message));
+    CHECK(text.compare(8, std::string::npos, message, sizeof(message)) == 0);
+    CHECK(in.readable() == 0);
+
+    // reserve() only hands out contiguous space up to the end of the buffer
+    ShmRing &telemetry = simulator.telemetry();
+    char *buffer = telemetry.reserve(available);
+    CHECK(available == TelemetryCapacity);
+    std::memset(buffer, 'x', TelemetryCapacity - 10);
+    telemetry.commit(TelemetryCapacity - 10);
+    client.telemetry().consume(TelemetryCapacity - 10);
+
+    telemetry.reserve(available);
+    CHECK(available == 10);
+}
+
+static void testWait()
+{
+    ShmChannel simulator, client;
+    CHECK(simulator.create(regionName(), CommandCapacity, TelemetryCapacity));
+    CHECK(client.attach(regionName()));
+
+    ShmRing &in = client.telemetry();
+
+    CHECK(!in.wait(10));
+
+    std::thread producer([&simulator]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        simulator.telemetry().write("t=1 vx=0\n", 9);
+    });
+
+    CHECK(in.wait(5000));
+    producer.join();
+    CHECK(drain(in) == "t=1 vx=0\n");
+
+    // wake() releases a consumer without data
+    std::thread waker([&in]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        in.wake();
+    });
+
+    CHECK(!in.wait(-1));
+    waker.join();
+}
+
+static void testPeer()
+{
+    ShmChannel simulator, client;
+    CHECK(simulator.create(regionName(), CommandCapacity, TelemetryCapacity));
+    CHECK(client.attach(regionName()));
+
+    simulator.close();
+    CHECK(!client.peerReady());
+    CHECK(!client.peerAlive());
+
+    // a restarted simulator leaves the old region ready but replaced
+    ShmChannel first, restarted, stale;
+    CHECK(first.create(regionName(), CommandCapacity, TelemetryCapacity));
+    CHECK(stale.attach(regionName()));
+    CHECK(restarted.create(regionName(), CommandCapacity, TelemetryCapacity));
+
+    CHECK(stale.peerReady());
+    CHECK(!stale.peerAlive());
+
+    ShmChannel fresh;
+    CHECK(fresh.attach(regionName()));
+    CHECK(fresh.peerAlive());
+}
+
+static void testWaiter()
+{
+    ShmChannel first, second, client, other;
+    CHECK(first.create(regionName(), CommandCapacity, TelemetryCapacity));
+    CHECK(client.attach(regionName()));
+    CHECK(second.create(regionName() + ".2", CommandCapacity, TelemetryCapacity));
+    CHECK(other.attach(regionName() + ".2"));
+
+    ShmWaiter waiter;
+    CHECK(waiter.fd() < 0);
+    CHECK(waiter.start());
+    CHECK(waiter.fd() >= 0);
+
+    waiter.add(&client.telemetry());
+    waiter.add(&other.telemetry());
+
+    CHECK(!readable(waiter.fd(), 20));
+
+    // the second ring wakes it up
+    second.telemetry().write("t=1\n", 4);
+    CHECK(readable(waiter.fd(), 5000));
+    waiter.acknowledge();
+    CHECK(!readable(waiter.fd(), 0));
+
+    // disarmed until the consumer drained the ring and rearms it
+    second.telemetry().write("t=2\n", 4);
+    CHECK(!readable(waiter.fd(), 20));
+
+    CHECK(drain(other.telemetry()) == "t=1\nt=2\n");
+    waiter.rearm(&other.telemetry());
+    CHECK(!readable(waiter.fd(), 20));
+
+    first.telemetry().write("t=3\n", 4);
+    CHECK(readable(waiter.fd(), 5000));
+    waiter.acknowledge();
+    drain(client.telemetry());
+    waiter.rearm(&client.telemetry());
+
+    // removed rings are left alone
+    waiter.remove(&client.telemetry());
+    first.telemetry().write("t=4\n", 4);
+    CHECK(!readable(waiter.fd(), 20));
+
+    waiter.remove(&other.telemetry());
+    waiter.stop();
+    CHECK(waiter.fd() < 0);
+}
+
+int main()
+{
+    testAttach();
+    testRing();
+    testWait();
+    testPeer();
+    testWaiter();
+
+    return checkResult("shmtransport");
+}
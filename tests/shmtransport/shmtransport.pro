@@ -0,0 +1,17 @@
+CONFIG += c++17 console testcase warn_on
+CONFIG -= app_bundle qt
+!msvc: QMAKE_CXXFLAGS += -Werror
+
+# ShmChannel, ShmRing and ShmWaiter in one process. Linux only, like the transport.
+
+INCLUDEPATH += ../..
+
+LIBS += -lpthread -lrt
+
+SOURCES += \
+    ../../shmtransport.cpp \
+    main.cpp
+
+HEADERS += \
+    ../../shmtransport.h \
+    ../check.h
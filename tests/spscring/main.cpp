@@ -0,0 +1,134 @@
+#include <cstdint>
+#include <thread>
+
+#include "check.h"
+#include "spscring.h"
+
+/*
+ *  Order, capacity and wraparound of SpscRing, and a producer and a consumer thread
+ *  passing a million items through a small ring.
+ */
+
+static void testFifo()
+{
+    SpscRing<int, 4> ring;
+    int item = -1;
+
+    CHECK(ring.empty());
+    CHECK(!ring.pop(item));
+
+    CHECK(ring.push(1));
+    CHECK(ring.push(2));
+    CHECK(!ring.empty());
+
+    CHECK(ring.pop(item) && item == 1);
+    CHECK(ring.pop(item) && item == 2);
+    CHECK(ring.empty());
+}
+
+static void testFull()
+{
+    SpscRing<int, 4> ring;
+
+    for (int i = 0; i < 4; i++)
+        CHECK(ring.push(i));
+
+    CHECK(ring.full());
+    CHECK(!ring.push(4));
+    CHECK(ring.beginPush() == nullptr);
+
+    int item = -1;
+    CHECK(ring.pop(item) && item == 0);
+    CHECK(!ring.full());
+    CHECK(ring.push(4));
+}
+
+static void testWraparound()
+{
+    SpscRing<int, 4> ring;
+    int item = -1;
+    bool ordered = true;
+
+    // many times round the ring, never more than three items in it
+    for (int i = 0; i < 1000; i++)
+    {
+        ordered = ordered && ring.push(i);
+        if (i >= 2)
+            ordered = ordered && ring.pop(item) && item == i - 2;
+    }
+
+    CHECK(ordered);
+}
+
+static void testInPlace()
+{
+    struct Chunk
+    {
+        int size;
+        char data[64];
+    };
+
+    SpscRing<Chunk, 2> ring;
+
+    Chunk *slot = ring.beginPush();
+    CHECK(slot != nullptr);
+    slot->size = 3;
+    slot->data[2] = 'z';
+
+    // not visible until committed
+    CHECK(ring.front() == nullptr);
+    ring.commitPush();
+
+    Chunk *front = ring.front();
+    CHECK(front == slot);
+    CHECK(front->size == 3 && front->data[2] == 'z');
+
+    ring.popFront();
+    CHECK(ring.empty());
+}
+
+static void testTwoThreads()
+{
+    static SpscRing<uint64_t, 16> ring;
+    const uint64_t count = 1000000;
+
+    std::thread producer([count]() {
+        for (uint64_t i = 0; i < count; i++)
+        {
+            while (!ring.push(i))
+                std::this_thread::yield();
+        }
+    });
+
+    uint64_t expected = 0;
+    bool ordered = true;
+
+    while (expected < count)
+    {
+        uint64_t item;
+        if (!ring.pop(item))
+        {
+            std::this_thread::yield();
+            continue;
+        }
+
+        ordered = ordered && item == expected;
+        expected++;
+    }
+
+    producer.join();
+
+    CHECK(ordered);
+    CHECK(ring.empty());
+}
+
+int main()
+{
+    testFifo();
+    testFull();
+    testWraparound();
+    testInPlace();
+    testTwoThreads();
+
+    return checkResult("spscring");
+}
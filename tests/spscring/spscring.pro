@@ -0,0 +1,16 @@
+CONFIG += c++17 console testcase warn_on
+CONFIG -= app_bundle qt
+!msvc: QMAKE_CXXFLAGS += -Werror
+
+# SpscRing, on one thread and between two. Standard library only.
+
+INCLUDEPATH += ../..
+
+LIBS += -lpthread
+
+SOURCES += \
+    main.cpp
+
+HEADERS += \
+    ../../spscring.h \
+    ../check.h
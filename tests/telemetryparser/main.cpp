@@ -0,0 +1,213 @@
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "check.h"
+#include "telemetryparser.h"
+
+/*
+ *  Records and samples as the sinks see them, for whole records, records split over
+ *  several reads, malformed fields and records larger than the receive buffer.
+ */
+
+namespace
+{
+
+struct Sample
+{
+    std::string channel;
+    double time;
+    double value;
+};
+
+class Collector : public TelemetrySink
+{
+public:
+    void record(std::string_view line) override { records.emplace_back(line); }
+    void sample(const TelemetrySample &sample) override { samples.push_back({std::string(sample.channel), sample.time, sample.value}); }
+
+    std::vector<std::string> records;
+    std::vector<Sample> samples;
+};
+
+void feed(TelemetryParser &parser, const std::string &text)
+{
+    parser.feed(text.data(), text.size());
+}
+
+} // namespace
+
+static void testRecord()
+{
+    TelemetryParser parser;
+    Collector sink;
+    parser.addSink(&sink);
+
+    feed(parser, "t=1.5 vx=0.25,theta=-2\tomega=1e-3\n");
+    CHECK(parser.parse() == 1);
+
+    CHECK(sink.records.size() == 1);
+    CHECK(sink.records[0] == "t=1.5 vx=0.25,theta=-2\tomega=1e-3");
+
+    CHECK(sink.samples.size() == 3);
+    CHECK(sink.samples[0].channel == "vx" && sink.samples[0].value == 0.25);
+    CHECK(sink.samples[1].channel == "theta" && sink.samples[1].value == -2);
+    CHECK(sink.samples[2].channel == "omega" && sink.samples[2].value == 1e-3);
+    CHECK(sink.samples[0].time == 1.5 && sink.samples[2].time == 1.5);
+
+    CHECK(parser.records() == 1);
+    CHECK(parser.samples() == 3);
+}
+
+static void testMalformedFields()
+{
+    TelemetryParser parser;
+    Collector sink;
+    parser.addSink(&sink);
+
+    // kept in the raw record, but no samples
+    feed(parser, "t=2 mode=walk =3 flag vx=1x ok=4\r\n");
+    parser.parse();
+
+    CHECK(sink.records.size() == 1);
+    CHECK(sink.records[0] == "t=2 mode=walk =3 flag vx=1x ok=4");
+    CHECK(sink.samples.size() == 1);
+    CHECK(sink.samples[0].channel == "ok" && sink.samples[0].value == 4);
+}
+
+static void testTimeCarriesOver()
+{
+    TelemetryParser parser;
+    Collector sink;
+    parser.addSink(&sink);
+
+    feed(parser, "t=3 a=1\nb=2\n");
+    CHECK(parser.parse() == 2);
+
+    CHECK(sink.samples.size() == 2);
+    CHECK(sink.samples[1].channel == "b" && sink.samples[1].time == 3);
+}
+
+static void testSplitRecords()
+{
+    TelemetryParser parser;
+    Collector sink;
+    parser.addSink(&sink);
+
+    const std::string stream = "t=1 a=1\nt=2 a=2\nt=3 a=3\n";
+
+    // one byte at a time through writeBuffer() and commit()
+    for (char c : stream)
+    {
+        size_t available;
+        char *out = parser.writeBuffer(available);
+        CHECK(available > 0);
+
+        *out = c;
+        parser.commit(1);
+        parser.parse();
+    }
+
+    CHECK(sink.samples.size() == 3);
+    CHECK(sink.samples[2].time == 3 && sink.samples[2].value == 3);
+
+    // a partial record waits for its terminator
+    feed(parser, "t=4 a=");
+    CHECK(parser.parse() == 0);
+    feed(parser, "4\n");
+    CHECK(parser.parse() == 1);
+    CHECK(sink.samples.back().value == 4);
+}
+
+static void testSmallBuffer()
+{
+    TelemetryParser parser(32);
+    Collector sink;
+    parser.addSink(&sink);
+
+    // many records through a buffer that holds about two
+    std::string stream;
+    for (int i = 0; i < 100; i++)
+        stream += "t=" + std::to_string(i) + " v=" + std::to_string(i) + "\n";
+
+    feed(parser, stream);
+    parser.parse();
+
+    CHECK(sink.records.size() == 100);
+    CHECK(sink.samples.size() == 100);
+    CHECK(sink.samples.back().value == 99);
+    CHECK(parser.oversized() == 0);
+}
+
+static void testOversizedRecord()
+{
+    TelemetryParser parser(32);
+    Collector sink;
+    parser.addSink(&sink);
+
+    feed(parser, "t=1 a=1\n");
+    feed(parser, "t=2 " + std::string(100, 'x') + "\n");
+    feed(parser, "t=3 a=3\n");
+    parser.parse();
+
+    CHECK(parser.oversized() == 1);
+    CHECK(sink.records.size() == 2);
+    CHECK(sink.samples.size() == 2);
+    CHECK(sink.samples[1].time == 3);
+}
+
+static void testClear()
+{
+    TelemetryParser parser;
+    Collector sink;
+    parser.addSink(&sink);
+
+    // a connection drops mid-record, the next one starts afresh
+    feed(parser, "t=1 a=");
+    parser.parse();
+    parser.clear();
+
+    feed(parser, "t=2 b=2\n");
+    parser.parse();
+
+    CHECK(sink.records.size() == 1);
+    CHECK(sink.samples.size() == 1 && sink.samples[0].channel == "b");
+}
+
+static void testSinks()
+{
+    TelemetryParser parser;
+    Collector first;
+    Collector second;
+
+    parser.addSink(&first);
+    parser.addSink(&first);
+    parser.addSink(&second);
+
+    feed(parser, "t=1 a=1\n");
+    parser.parse();
+
+    CHECK(first.samples.size() == 1);
+    CHECK(second.samples.size() == 1);
+
+    parser.removeSink(&first);
+    feed(parser, "t=2 a=2\n");
+    parser.parse();
+
+    CHECK(first.samples.size() == 1);
+    CHECK(second.samples.size() == 2);
+}
+
+int main()
+{
+    testRecord();
+    testMalformedFields();
+    testTimeCarriesOver();
+    testSplitRecords();
+    testSmallBuffer();
+    testOversizedRecord();
+    testClear();
+    testSinks();
+
+    return checkResult("telemetryparser");
+}
@@ -0,0 +1,15 @@
+CONFIG += c++17 console testcase warn_on
+CONFIG -= app_bundle qt
+!msvc: QMAKE_CXXFLAGS += -Werror
+
+# TelemetryParser. Standard library only.
+
+INCLUDEPATH += ../..
+
+SOURCES += \
+    ../../telemetryparser.cpp \
+    main.cpp
+
+HEADERS += \
+    ../../telemetryparser.h \
+    ../check.h
@@ -0,0 +1,341 @@
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <vector>
+
+#include "check.h"
+#include "telemetrystore.h"
+
+/*
+ *  Queries over the summary pyramid against a plain scan of the raw samples, the
+ *  channel prediction of records fed through a parser, time steps back and the
+ *  memory cap.
+ */
+
+namespace
+{
+
+float wave(uint64_t i)
+{
+    return (float)std::sin(i * 0.01) * 10.f + (float)(i % 7);
+}
+
+// the same aggregate computed from the raw samples alone
+std::vector<TelemetryBucket> scan(const TelemetryChannel &channel, double t0, double t1, size_t buckets)
+{
+    std::vector<TelemetryBucket> out(buckets, TelemetryBucket{1e30f, -1e30f, 0, 0});
+
+    for (size_t i = 0; i < channel.size(); ++i)
+    {
+        double t = channel.time(i);
+        if (t < t0 || t >= t1)
+            continue;
+
+        size_t b = std::min(buckets - 1, (size_t)((t - t0) * buckets / (t1 - t0)));
+        float v = channel.value(i);
+
+        out[b].min = std::min(out[b].min, v);
+        out[b].max = std::max(out[b].max, v);
+        out[b].mean += v;
+        out[b].count++;
+    }
+
+    for (TelemetryBucket &bucket : out)
+    {
+        if (bucket.count > 0)
+            bucket.mean /= bucket.count;
+    }
+
+    return out;
+}
+
+// raw samples only, the query has to agree bucket by bucket
+bool matches(const TelemetryChannel &channel, double t0, double t1, size_t buckets)
+{
+    std::vector<TelemetryBucket> queried(buckets);
+    channel.query(t0, t1, queried.data(), buckets);
+
+    std::vector<TelemetryBucket> expected = scan(channel, t0, t1, buckets);
+
+    for (size_t b = 0; b < buckets; ++b)
+    {
+        if (queried[b].count != expected[b].count)
+            return false;
+
+        if (expected[b].count == 0)
+            continue;
+
+        if (queried[b].min != expected[b].min || queried[b].max != expected[b].max
+                || std::fabs(queried[b].mean - expected[b].mean) > 1e-6 * (1 + std::fabs(expected[b].mean)))
+            return false;
+    }
+
+    return true;
+}
+
+// summaries go to the bucket of their first sample, so samples may move into the
+// previous bucket by less than the average bucket, but none may be lost or made up
+bool consistent(const TelemetryChannel &channel, double t0, double t1, size_t buckets)
+{
+    std::vector<TelemetryBucket> queried(buckets);
+    size_t n = channel.query(t0, t1, queried.data(), buckets);
+
+    std::vector<TelemetryBucket> expected = scan(channel, t0, t1, buckets);
+
+    uint64_t queriedCount = 0, expectedCount = 0;
+    double queriedSum = 0, expectedSum = 0;
+    float queriedMin = 1e30f, expectedMin = 1e30f;
+    float queriedMax = -1e30f, expectedMax = -1e30f;
+
+    for (size_t b = 0; b < buckets; ++b)
+    {
+        queriedCount += queried[b].count;
+        expectedCount += expected[b].count;
+
+        if (queriedCount < expectedCount || queriedCount - expectedCount > n / buckets)
+            return false;
+
+        if (queried[b].count > 0)
+        {
+            queriedSum += queried[b].mean * queried[b].count;
+            queriedMin = std::min(queriedMin, queried[b].min);
+            queriedMax = std::max(queriedMax, queried[b].max);
+        }
+
+        if (expected[b].count > 0)
+        {
+            expectedSum += expected[b].mean * expected[b].count;
+            expectedMin = std::min(expectedMin, expected[b].min);
+            expectedMax = std::max(expectedMax, expected[b].max);
+        }
+    }
+
+    return queriedCount == n && expectedCount == n
+            && queriedMin == expectedMin && queriedMax == expectedMax
+            && std::fabs(queriedSum - expectedSum) <= 1e-6 * (1 + std::fabs(expectedSum));
+}
+
+// memory of a channel that has not grown yet
+size_t channelBlock()
+{
+    TelemetryStore store;
+    return store.addChannel("probe")->memoryUsage();
+}
+
+std::string record(double time, const std::vector<std::string> &channels, double value)
+{
+    std::string line = "t=" + std::to_string(time);
+
+    for (const std::string &channel : channels)
+        line += " " + channel + "=" + std::to_string(value);
+
+    return line + "\n";
+}
+
+} // namespace
+
+static void testAppend()
+{
+    TelemetryStore store;
+    TelemetryChannel *channel = store.addChannel("vx");
+
+    CHECK(store.addChannel("vx") == channel);
+    CHECK(store.channel("vx") == channel);
+    CHECK(store.channel("vy") == nullptr);
+    CHECK(channel->empty());
+    CHECK(channel->lastTime() == 0 && channel->lastValue() == 0);
+
+    for (int i = 0; i < 10; ++i)
+        channel->append(i * 0.5, (float)i);
+
+    CHECK(channel->size() == 10);
+    CHECK(channel->firstTime() == 0);
+    CHECK(channel->lastTime() == 4.5);
+    CHECK(channel->lastValue() == 9);
+    CHECK(channel->time(3) == 1.5 && channel->value(3) == 3);
+}
+
+static void testQuery()
+{
+    TelemetryStore store;
+    TelemetryChannel *channel = store.addChannel("wave");
+
+    // long enough for every level of the pyramid to hold complete entries
+    const uint64_t samples = 300000;
+    for (uint64_t i = 0; i < samples; ++i)
+        channel->append(i * 0.001, wave(i));
+
+    CHECK(channel->size() == samples);
+
+    TelemetryBucket whole;
+    CHECK(channel->query(0, samples * 0.001, &whole, 1) == samples);
+    CHECK(whole.count == samples);
+
+    // coarse resolutions combine summaries, aligned and unaligned windows
+    CHECK(matches(*channel, 0, samples * 0.001, 1));
+    CHECK(consistent(*channel, 0, samples * 0.001, 4));
+    CHECK(consistent(*channel, 0, samples * 0.001, 1000));
+    CHECK(consistent(*channel, 12.3456, 251.001, 7));
+
+    // fine ones read the raw samples
+    CHECK(matches(*channel, 100.0005, 100.2, 50));
+    CHECK(matches(*channel, 0.017, 0.023, 3));
+
+    // outside of or beyond the held samples
+    TelemetryBucket buckets[4];
+    CHECK(channel->query(-10, -5, buckets, 4) == 0);
+    CHECK(buckets[0].count == 0 && buckets[3].count == 0);
+    CHECK(channel->query(1000, 2000, buckets, 4) == 0);
+    CHECK(channel->query(5, 5, buckets, 4) == 0);
+    CHECK(channel->query(-1, 0.0105, buckets, 4) == 11);
+    CHECK(buckets[3].count == 11);
+}
+
+static void testParsedRecords()
+{
+    TelemetryParser parser;
+    TelemetryStore store;
+    parser.addSink(&store);
+
+    // the order of the channels changes midway, the prediction has to follow
+    std::string text;
+    for (int i = 0; i < 100; ++i)
+        text += record(i, { "a", "b", "c" }, i);
+    for (int i = 100; i < 200; ++i)
+        text += record(i, { "c", "a", "d" }, i);
+
+    parser.feed(text.data(), text.size());
+    parser.parse();
+
+    CHECK(store.channelCount() == 4);
+    CHECK((store.channelNames() == std::vector<std::string>{ "a", "b", "c", "d" }));
+
+    CHECK(store.channel("a")->size() == 200);
+    CHECK(store.channel("b")->size() == 100);
+    CHECK(store.channel("c")->size() == 200);
+    CHECK(store.channel("d")->size() == 100);
+
+    CHECK(store.channel("b")->lastTime() == 99);
+    CHECK(store.channel("d")->firstTime() == 100);
+    CHECK(store.channel("c")->lastValue() == 199);
+
+    store.clear();
+    CHECK(store.channelCount() == 0);
+    CHECK(store.memoryUsage() == 0);
+
+    // nothing of the old prediction may survive the clear
+    text = record(300, { "a", "b" }, 1);
+    parser.feed(text.data(), text.size());
+    parser.parse();
+
+    CHECK(store.channelCount() == 2);
+    CHECK(store.channel("a")->size() == 1 && store.channel("b")->size() == 1);
+}
+
+static void testTimeStepBack()
+{
+    TelemetryStore store;
+    TelemetryChannel *channel = store.addChannel("vx");
+
+    for (int i = 0; i < 100; ++i)
+        channel->append(i, 1);
+
+    // equal timestamps are fine, an earlier one means the simulation was reset
+    channel->append(99, 2);
+    CHECK(channel->size() == 101);
+
+    channel->append(5, 3);
+    CHECK(channel->size() == 1);
+    CHECK(channel->firstTime() == 5 && channel->lastValue() == 3);
+
+    for (int i = 6; i < 1000; ++i)
+        channel->append(i, wave(i));
+
+    CHECK(consistent(*channel, 0, 1000, 9));
+}
+
+static void testMemoryCap()
+{
+    // room for the first block of one channel only, so its rings wrap instead of growing
+    size_t initial = channelBlock();
+    TelemetryStore store(initial);
+    TelemetryChannel *channel = store.addChannel("vx");
+
+    CHECK(channel != nullptr);
+    CHECK(channel->memoryUsage() == initial);
+    CHECK(store.memoryUsage() == initial);
+
+    const uint64_t samples = 100000;
+    for (uint64_t i = 0; i < samples; ++i)
+        channel->append(i * 0.01, wave(i));
+
+    size_t capacity = channel->size();
+    CHECK(capacity > 0 && capacity < samples);
+    CHECK(channel->memoryUsage() == initial);
+    CHECK(store.memoryUsage() == initial);
+
+    // the oldest samples are gone, the newest are in order
+    CHECK(channel->firstTime() == (samples - capacity) * 0.01);
+    CHECK(channel->lastTime() == (samples - 1) * 0.01);
+    CHECK(channel->value(capacity - 1) == wave(samples - 1));
+
+    // summaries of dropped samples must not be used
+    CHECK(matches(*channel, 0, samples * 0.01, 1));
+    CHECK(consistent(*channel, 0, samples * 0.01, 5));
+    CHECK(consistent(*channel, channel->firstTime() + 0.005, samples * 0.01, 3));
+
+    // a larger cap lets the rings grow
+    TelemetryStore large(64u * 1024u * 1024u);
+    TelemetryChannel *grown = large.addChannel("vx");
+
+    for (uint64_t i = 0; i < samples; ++i)
+        grown->append(i * 0.01, wave(i));
+
+    CHECK(grown->size() == samples);
+    CHECK(large.memoryUsage() <= large.memoryCap());
+
+    large.clear();
+    CHECK(large.memoryUsage() == 0);
+}
+
+static void testChannelCap()
+{
+    TelemetryParser parser;
+    TelemetryStore store(3 * channelBlock());
+    parser.addSink(&store);
+
+    // a stream of ever new names stops creating channels at the cap
+    std::string text;
+    for (int i = 0; i < 10; ++i)
+        text += record(i, { "known", "new" + std::to_string(i) }, i);
+
+    parser.feed(text.data(), text.size());
+    parser.parse();
+
+    CHECK(store.channelCount() == 3);
+    CHECK(store.memoryUsage() <= store.memoryCap());
+    CHECK(store.droppedSamples() == 8);
+    CHECK(store.channel("new1") != nullptr);
+    CHECK(store.channel("new2") == nullptr);
+    CHECK(store.addChannel("other") == nullptr);
+
+    // channels that made it keep receiving samples
+    CHECK(store.channel("known")->size() == 10);
+    CHECK(store.channel("known")->lastValue() == 9);
+
+    // and clearing makes room again
+    store.clear();
+    CHECK(store.addChannel("other") != nullptr);
+}
+
+int main()
+{
+    testAppend();
+    testQuery();
+    testParsedRecords();
+    testTimeStepBack();
+    testMemoryCap();
+    testChannelCap();
+
+    return checkResult("telemetrystore");
+}
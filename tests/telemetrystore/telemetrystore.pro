@@ -0,0 +1,17 @@
+CONFIG += c++17 console testcase warn_on
+CONFIG -= app_bundle qt
+!msvc: QMAKE_CXXFLAGS += -Werror
+
+# TelemetryStore. Standard library only.
+
+INCLUDEPATH += ../..
+
+SOURCES += \
+    ../../telemetryparser.cpp \
+    ../../telemetrystore.cpp \
+    main.cpp
+
+HEADERS += \
+    ../../telemetryparser.h \
+    ../../telemetrystore.h \
+    ../check.h
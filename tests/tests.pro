@@ -0,0 +1,23 @@
+TEMPLATE = subdirs
+
+# Unit tests of the GUI independent modules. Every test is a console program that
+# exits with 0 when all of its checks pass; `make check` runs them all. Modules that
+# need QtCore are tested with QtTest, the others with check.h and without Qt; as the
+# simulator compiles those modules too, their tests treat warnings as errors.
+
+SUBDIRS += \
+    commandframe \
+    spscring \
+    telemetryparser \
+    telemetrystore \
+    latency \
+    robotcommandstate \
+    inputconditioner \
+    timelinesequencer \
+    sceneconverter
+
+linux {
+    SUBDIRS += \
+        evdevdecoder \
+        shmtransport
+}
@@ -0,0 +1,188 @@
+#include <QFile>
+#include <QSignalSpy>
+#include <QTemporaryDir>
+#include <QtTest>
+
+#include "commandframe.h"
+#include "timelinesequencer.h"
+
+/*
+ *  Reading timeline files, their errors, and playing them back in order with every
+ *  event due at its offset from the start.
+ */
+
+class TestTimelineSequencer : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void load();
+    void loadErrors_data();
+    void loadErrors();
+    void play();
+    void stop();
+    void empty();
+
+private:
+    QString write(const QByteArray &text);
+
+    QTemporaryDir m_dir;
+    int m_files = 0;
+};
+
+QString TestTimelineSequencer::write(const QByteArray &text)
+{
+    QString path = m_dir.filePath(QString("timeline%1.txt").arg(m_files++));
+
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly) || file.write(text) != text.size())
+        return QString();
+
+    return path;
+}
+
+void TestTimelineSequencer::load()
+{
+    TimelineSequencer sequencer;
+
+    QVERIFY(sequencer.load(write("# time field value\n"
+                                 "\n"
+                                 "1      gait   trot\n"
+                                 "0.5    vx     0.25\n"
+                                 "  0    gait   stand  \n"
+                                 "1      vx     -1\n"
+                                 "3.25   height 0.02\n")));
+
+    // sorted by time, events with the same time keep their order
+    const QVector<TimelineEvent> &events = sequencer.events();
+    QCOMPARE(events.size(), 5);
+
+    QCOMPARE(events[0].time, qint64(0));
+    QVERIFY(events[0].field == RobotField::Gait);
+    QCOMPARE(events[0].value, (float)RobotGait::Stand);
+
+    QCOMPARE(events[1].time, qint64(500000));
+    QVERIFY(events[1].field == RobotField::VelocityX);
+    QCOMPARE(events[1].value, 0.25f);
+
+    QCOMPARE(events[2].time, qint64(1000000));
+    QVERIFY(events[2].field == RobotField::Gait);
+    QCOMPARE(events[2].value, (float)RobotGait::Trot);
+
+    QCOMPARE(events[3].time, qint64(1000000));
+    QVERIFY(events[3].field == RobotField::VelocityX);
+    QCOMPARE(events[3].value, -1.f);
+
+    QCOMPARE(events[4].time, qint64(3250000));
+    QVERIFY(events[4].field == RobotField::Height);
+
+    QVERIFY(sequencer.errorString().isEmpty());
+    QVERIFY(!sequencer.isStarted());
+    QVERIFY(!sequencer.isRunning());
+}
+
+void TestTimelineSequencer::loadErrors_data()
+{
+    QTest::addColumn<QByteArray>("text");
+    QTest::addColumn<QString>("error");
+
+    QTest::newRow("field") << QByteArray("0 vx 1\n0 speed 1\n") << QString("line 2: cannot read \"0 speed 1\"");
+    QTest::newRow("negative time") << QByteArray("-1 vx 1\n") << QString("line 1: cannot read \"-1 vx 1\"");
+    QTest::newRow("time") << QByteArray("# x\nsoon vx 1\n") << QString("line 2: cannot read \"soon vx 1\"");
+    QTest::newRow("value") << QByteArray("0 vx fast\n") << QString("line 1: cannot read \"0 vx fast\"");
+    QTest::newRow("gait") << QByteArray("0 gait walk\n") << QString("line 1: cannot read \"0 gait walk\"");
+    QTest::newRow("words") << QByteArray("\n0 vx 1 2\n") << QString("line 2: cannot read \"0 vx 1 2\"");
+}
+
+void TestTimelineSequencer::loadErrors()
+{
+    QFETCH(QByteArray, text);
+    QFETCH(QString, error);
+
+    TimelineSequencer sequencer;
+    QVERIFY(sequencer.load(write("0 vx 1\n")));
+
+    // a failed load keeps the timeline loaded before
+    QVERIFY(!sequencer.load(write(text)));
+    QCOMPARE(sequencer.errorString(), error);
+    QCOMPARE(sequencer.events().size(), 1);
+
+    QVERIFY(!sequencer.load(m_dir.filePath("missing.txt")));
+    QVERIFY(!sequencer.errorString().isEmpty());
+}
+
+void TestTimelineSequencer::play()
+{
+    TimelineSequencer sequencer;
+    QVERIFY(sequencer.load(write("0.02 vy 3\n0 vx 1\n0.01 vx 2\n0.01 pitch 0.5\n")));
+
+    QVector<TimelineEvent> played;
+    QVector<quint64> due;
+
+    connect(&sequencer, &TimelineSequencer::fieldDue, this, [&](RobotField field, float value, quint64 time) {
+        played.append(TimelineEvent{0, field, value});
+        due.append(time);
+    });
+
+    QSignalSpy finished(&sequencer, &TimelineSequencer::finished);
+
+    quint64 before = CommandFrameEncoder::now();
+    sequencer.start();
+    QVERIFY(sequencer.isStarted());
+    QVERIFY(sequencer.isRunning());
+
+    QVERIFY(finished.wait(5000));
+    quint64 after = CommandFrameEncoder::now();
+
+    QCOMPARE(played.size(), 4);
+    QVERIFY(played[0].field == RobotField::VelocityX);
+    QCOMPARE(played[0].value, 1.f);
+    QCOMPARE(played[1].value, 2.f);
+    QVERIFY(played[2].field == RobotField::Pitch);
+    QVERIFY(played[3].field == RobotField::VelocityY);
+
+    // due at fixed offsets from the start, never before they were due
+    QVERIFY(due[0] >= before);
+    QCOMPARE(due[1] - due[0], quint64(10000));
+    QCOMPARE(due[2], due[1]);
+    QCOMPARE(due[3] - due[0], quint64(20000));
+    QVERIFY(after >= due[3]);
+
+    QCOMPARE(sequencer.jitter().count(), uint64_t(4));
+    QVERIFY(!sequencer.isRunning());
+}
+
+void TestTimelineSequencer::stop()
+{
+    TimelineSequencer sequencer;
+    QVERIFY(sequencer.load(write("0.05 vx 1\n")));
+
+    int played = 0;
+    connect(&sequencer, &TimelineSequencer::fieldDue, this, [&]() { played++; });
+    QSignalSpy finished(&sequencer, &TimelineSequencer::finished);
+
+    sequencer.start();
+    sequencer.stop();
+    QVERIFY(!sequencer.isStarted());
+    QVERIFY(!sequencer.isRunning());
+
+    QTest::qWait(100);
+    QCOMPARE(played, 0);
+    QCOMPARE(finished.count(), 0);
+}
+
+void TestTimelineSequencer::empty()
+{
+    TimelineSequencer sequencer;
+    QVERIFY(sequencer.load(write("# nothing to play\n")));
+
+    QSignalSpy finished(&sequencer, &TimelineSequencer::finished);
+    sequencer.start();
+
+    QCOMPARE(finished.count(), 1);
+    QVERIFY(!sequencer.isRunning());
+}
+
+QTEST_GUILESS_MAIN(TestTimelineSequencer)
+
+#include "main.moc"
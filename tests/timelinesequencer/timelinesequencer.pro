@@ -0,0 +1,20 @@
+QT = core testlib
+
+CONFIG += c++17 console testcase warn_on
+CONFIG -= app_bundle
+
+# TimelineSequencer. Needs QtCore for its file reading and timer.
+
+INCLUDEPATH += ../..
+
+SOURCES += \
+    ../../commandframe.cpp \
+    ../../latencyhistogram.cpp \
+    ../../timelinesequencer.cpp \
+    main.cpp
+
+HEADERS += \
+    ../../commandframe.h \
+    ../../latencyhistogram.h \
+    ../../robotcommandstate.h \
+    ../../timelinesequencer.h
@@ -0,0 +1,202 @@
+#include "timelinesequencer.h"
+
+#include <QFile>
+#include <QTextStream>
+#include <QTimer>
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+
+bool parseField(const QString &name, RobotField &field)
+{
+    static const struct
+    {
+        const char *name;
+        RobotField field;
+    } fields[] = {
+        {"vx", RobotField::VelocityX},
+        {"vy", RobotField::VelocityY},
+        {"pitch", RobotField::Pitch},
+        {"roll", RobotField::Roll},
+        {"height", RobotField::Height},
+        {"rotate", RobotField::ArmRotate},
+        {"extend", RobotField::ArmExtend},
+        {"arm", RobotField::ArmHeight},
+        {"angle", RobotField::GripAngle},
+        {"grip", RobotField::Grip},
+        {"gait", RobotField::Gait},
+    };
+
+    for (const auto &entry : fields)
+    {
+        if (name == QLatin1String(entry.name))
+        {
+            field = entry.field;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+} // namespace
+
+//---------------------------------- CONSTRUCTOR ------------------------------------
+
+TimelineSequencer::TimelineSequencer(QObject *parent) : QObject(parent),
+    m_next(0),
+    m_origin(0),
+    m_late(0)
+{
+    m_timer = new QTimer(this);
+    m_timer->setSingleShot(true);
+    m_timer->setTimerType(Qt::PreciseTimer);
+    connect(m_timer, &QTimer::timeout, this, &TimelineSequencer::dispatch);
+}
+
+//---------------------------------- LOADING ------------------------------------
+
+/**
+ * @brief TimelineSequencer::load
+ *      Events may be listed in any order, events with the same time keep theirs
+ */
+bool TimelineSequencer::load(const QString &path)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+    {
+        m_error = file.errorString();
+        return false;
+    }
+
+    QVector<TimelineEvent> events;
+    QTextStream in(&file);
+    int lineNumber = 0;
+
+    while (!in.atEnd())
+    {
+        QString line = in.readLine().trimmed();
+        lineNumber++;
+
+        if (line.isEmpty() || line.startsWith('#'))
+            continue;
+
+        const QStringList words = line.split(' ', Qt::SkipEmptyParts);
+        TimelineEvent event;
+        bool ok = false;
+
+        double seconds = words.value(0).toDouble(&ok);
+        ok = ok && seconds >= 0 && words.size() == 3 && parseField(words[1], event.field);
+
+        if (ok && event.field == RobotField::Gait)
+        {
+            if (words[2] == "stand")
+                event.value = (float)RobotGait::Stand;
+            else if (words[2] == "trot")
+                event.value = (float)RobotGait::Trot;
+            else
+                ok = false;
+        }
+        else if (ok)
+            event.value = words[2].toFloat(&ok);
+
+        if (!ok)
+        {
+            m_error = QString("line %1: cannot read \"%2\"").arg(lineNumber).arg(line);
+            return false;
+        }
+
+        event.time = std::llround(seconds * 1e6);
+        events.append(event);
+    }
+
+    std::stable_sort(events.begin(), events.end(),
+                     [](const TimelineEvent &a, const TimelineEvent &b) { return a.time < b.time; });
+
+    m_events = events;
+    m_error.clear();
+    return true;
+}
+
+//---------------------------------- PLAYBACK ------------------------------------
+
+bool TimelineSequencer::isRunning() const
+{
+    return m_origin != 0 && m_next < m_events.size();
+}
+
+void TimelineSequencer::start()
+{
+    m_next = 0;
+    m_late = 0;
+    m_jitter.clear();
+    m_origin = CommandFrameEncoder::now();
+
+    if (m_events.isEmpty())
+    {
+        emit finished();
+        return;
+    }
+
+    schedule();
+}
+
+void TimelineSequencer::stop()
+{
+    m_timer->stop();
+    m_next = m_events.size();
+    m_origin = 0;
+}
+
+/**
+ * @brief TimelineSequencer::schedule
+ *      Arms the timer for the whole milliseconds until SpinMargin before the next
+ *      event, against the start of the timeline rather than the previous wakeup. The
+ *      part below a millisecond is left to dispatch() to spin out; rounding it away
+ *      instead would either fire late or keep rearming a 0 ms timer until the event.
+ */
+void TimelineSequencer::schedule()
+{
+    qint64 wait = m_events[m_next].time - elapsed() - SpinMargin;
+    m_timer->start(wait >= 1000 ? (int)(wait / 1000) : 0);
+}
+
+void TimelineSequencer::dispatch()
+{
+    if (m_next >= m_events.size())
+        return;
+
+    qint64 now = elapsed();
+    qint64 due = m_events[m_next].time;
+
+    // the timer may fire early by up to a millisecond
+    if (due - now >= SpinMargin + 1000)
+    {
+        schedule();
+        return;
+    }
+
+    while (now < due)
+        now = elapsed();
+
+    while (m_next < m_events.size() && m_events[m_next].time <= now)
+    {
+        const TimelineEvent &event = m_events[m_next++];
+        qint64 lateness = now - event.time;
+
+        m_jitter.record((uint64_t)lateness);
+        if (lateness > LateThreshold)
+            m_late++;
+
+        emit fieldDue(event.field, event.value, m_origin + (quint64)event.time);
+        now = elapsed();
+    }
+
+    if (m_next < m_events.size())
+        schedule();
+    else
+        emit finished();
+}
@@ -0,0 +1,108 @@
+#ifndef TIMELINESEQUENCER_H
+#define TIMELINESEQUENCER_H
+
+#include <QObject>
+#include <QString>
+#include <QVector>
+
+#include "latencyhistogram.h"
+#include "robotcommandstate.h"
+
+class QTimer;
+
+/**
+ * @brief The TimelineEvent struct
+ *      One timestamped setpoint of a timeline
+ */
+struct TimelineEvent
+{
+    qint64 time;        // microseconds from the start of the timeline
+    RobotField field;
+    float value;
+};
+
+/**
+ * @brief The TimelineSequencer class
+ *      Plays a timeline file of timestamped setpoints, for repeatable motion sequences.
+ *      One event per line, times in seconds from the start:
+ *
+ *          # time  field   value
+ *          0       gait    stand
+ *          0.5     height  0.02
+ *          1       gait    trot
+ *          1       vx      0.5
+ *          3.25    vx      0
+ *
+ *      Fields are vx, vy, pitch, roll, height, rotate, extend, arm, angle, grip and
+ *      gait (stand or trot).
+ *
+ *      Every event is due at a fixed offset from the start, so a late wakeup never
+ *      shifts the events after it. The timer is armed for the whole milliseconds up to
+ *      SpinMargin before the event and the rest is spun out, as timers only have
+ *      millisecond resolution. Events that are already due go out together. How late
+ *      each event was dispatched is recorded in jitter(); fieldDue() carries the time
+ *      it was due, so the NetworkWorker can time the frame that sends it as well.
+ */
+class TimelineSequencer : public QObject
+{
+    Q_OBJECT
+
+public:
+    // microseconds before an event the timer fires and the sequencer spins
+    static constexpr qint64 SpinMargin = 300;
+
+    // an event this many microseconds late counts as missed
+    static constexpr qint64 LateThreshold = 1000;
+
+    explicit TimelineSequencer(QObject *parent = nullptr);
+
+    bool load(const QString &path);
+    QString errorString() const { return m_error; }
+
+    const QVector<TimelineEvent> &events() const { return m_events; }
+    bool isRunning() const;
+
+    /**
+     * @brief isStarted
+     * @return true once start() ran, until stop()
+     */
+    bool isStarted() const { return m_origin != 0; }
+
+    /**
+     * @brief jitter
+     *      Microseconds between the time events were due and the time they were dispatched
+     */
+    const LatencyHistogram &jitter() const { return m_jitter; }
+    quint64 lateEvents() const { return m_late; }
+
+public slots:
+    void start();
+    void stop();
+
+signals:
+    /**
+     * @brief fieldDue
+     * @param due - CommandFrameEncoder::now() the event was due at
+     */
+    void fieldDue(RobotField field, float value, quint64 due);
+    void finished();
+
+private slots:
+    void dispatch();
+
+private:
+    void schedule();
+    qint64 elapsed() const { return (qint64)(CommandFrameEncoder::now() - m_origin); }
+
+    QVector<TimelineEvent> m_events;
+    QString m_error;
+    int m_next;
+
+    uint64_t m_origin;      // CommandFrameEncoder::now() at start(), 0 before
+    QTimer *m_timer;
+
+    LatencyHistogram m_jitter;
+    quint64 m_late;
+};
+
+#endif // TIMELINESEQUENCER_H
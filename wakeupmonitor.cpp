@@ -0,0 +1,105 @@
+#include "wakeupmonitor.h"
+
+#include <QAbstractEventDispatcher>
+#include <QTimer>
+
+#if defined(Q_OS_WIN)
+#include <qt_windows.h>
+#elif defined(Q_OS_UNIX)
+#include <sys/resource.h>
+#endif
+
+WakeupMonitor::WakeupMonitor(QObject *parent) : QObject(parent),
+    m_timer(new QTimer(this)),
+    m_wakeups(0),
+    m_cpuTime(0),
+    m_contextSwitches(0)
+{
+    m_timer->setInterval(ReportInterval);
+    connect(m_timer, &QTimer::timeout, this, &WakeupMonitor::report);
+}
+
+/**
+ * @brief WakeupMonitor::start
+ *      Call on the main thread once its event dispatcher exists
+ */
+void WakeupMonitor::start()
+{
+    QAbstractEventDispatcher *dispatcher = QAbstractEventDispatcher::instance();
+    if (!dispatcher)
+    {
+        qWarning("wakeup measurement needs a running application");
+        return;
+    }
+
+    connect(dispatcher, &QAbstractEventDispatcher::awake, this, [this]() { m_wakeups++; });
+
+    m_wakeups = 0;
+    m_cpuTime = cpuTime();
+    m_contextSwitches = contextSwitches();
+    m_clock.start();
+    m_timer->start();
+}
+
+void WakeupMonitor::report()
+{
+    double seconds = (double)m_clock.nsecsElapsed() / 1e9;
+    qint64 cpu = cpuTime();
+    qint64 switches = contextSwitches();
+
+    // the report timer itself woke the loop once
+    quint64 wakeups = m_wakeups > 0 ? m_wakeups - 1 : 0;
+
+    if (switches >= 0)
+        qInfo("wakeups: %.2f/s on the main thread, %.2f%% cpu, %.2f context switches/s over %.0f s",
+              (double)wakeups / seconds,
+              (double)(cpu - m_cpuTime) / (seconds * 1e4),
+              (double)(switches - m_contextSwitches) / seconds,
+              seconds);
+    else
+        qInfo("wakeups: %.2f/s on the main thread, %.2f%% cpu over %.0f s",
+              (double)wakeups / seconds,
+              (double)(cpu - m_cpuTime) / (seconds * 1e4),
+              seconds);
+
+    m_wakeups = 0;
+    m_cpuTime = cpu;
+    m_contextSwitches = switches;
+    m_clock.restart();
+}
+
+qint64 WakeupMonitor::cpuTime()
+{
+#if defined(Q_OS_WIN)
+    FILETIME creation, exit, kernel, user;
+    if (!GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &user))
+        return 0;
+
+    // 100 ns units
+    quint64 total = ((quint64)kernel.dwHighDateTime << 32 | kernel.dwLowDateTime)
+                  + ((quint64)user.dwHighDateTime << 32 | user.dwLowDateTime);
+    return (qint64)(total / 10);
+#elif defined(Q_OS_UNIX)
+    rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+        return 0;
+
+    return (qint64)(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000000
+         + usage.ru_utime.tv_usec + usage.ru_stime.tv_usec;
+#else
+    return 0;
+#endif
+}
+
+qint64 WakeupMonitor::contextSwitches()
+{
+#if defined(Q_OS_UNIX)
+    rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+        return -1;
+
+    return (qint64)usage.ru_nvcsw + usage.ru_nivcsw;
+#else
+    return -1;
+#endif
+}
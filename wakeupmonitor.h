@@ -0,0 +1,53 @@
+#ifndef WAKEUPMONITOR_H
+#define WAKEUPMONITOR_H
+
+#include <QElapsedTimer>
+#include <QObject>
+
+class QTimer;
+
+/**
+ * @brief The WakeupMonitor class
+ *      --measure-wakeups: logs every ReportInterval how often the event loop of the
+ *      main thread woke up, the CPU time of the whole process and, where the system
+ *      counts them, the context switches of all its threads. An idle client should
+ *      show next to none of either; the monitor's own report adds one wakeup per
+ *      interval, which is not counted.
+ */
+class WakeupMonitor : public QObject
+{
+    Q_OBJECT
+
+public:
+    // milliseconds between reports
+    static constexpr int ReportInterval = 10000;
+
+    explicit WakeupMonitor(QObject *parent = nullptr);
+
+    void start();
+
+private slots:
+    void report();
+
+private:
+    /**
+     * @brief cpuTime
+     * @return user and system time of all threads in microseconds
+     */
+    static qint64 cpuTime();
+
+    /**
+     * @brief contextSwitches
+     * @return context switches of all threads so far, -1 if unknown
+     */
+    static qint64 contextSwitches();
+
+    QTimer *m_timer;
+    QElapsedTimer m_clock;
+
+    quint64 m_wakeups;
+    qint64 m_cpuTime;
+    qint64 m_contextSwitches;
+};
+
+#endif // WAKEUPMONITOR_H
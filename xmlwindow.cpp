@@ -1,87 +1,156 @@
 #include "xmlwindow.h"
 #include "ui_xmlwindow.h"
 
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QTimer>
+#include <QUrl>
+#include <QtConcurrent/QtConcurrent>
+
+#include "sceneconverter.h"
+
 XmlWindow::XmlWindow(QWidget *parent) :
     QMainWindow(parent),
-    ui(new Ui::XmlWindow)
+    ui(new Ui::XmlWindow),
+    m_editTimer(new QTimer(this)),
+    m_watcher(new QFutureWatcher<Conversion>(this))
 {
     ui->setupUi(this);
+
+    m_editTimer->setSingleShot(true);
+    m_editTimer->setInterval(EditDelay);
+
     connect(this->ui->pushButton, &QPushButton::clicked, this, &XmlWindow::swapWindows);
-    connect(this->ui->textEdit, &QTextEdit::textChanged, this, &XmlWindow::processFile);
+    connect(this->ui->textEdit, &QTextEdit::textChanged, m_editTimer, qOverload<>(&QTimer::start));
+    connect(m_editTimer, &QTimer::timeout, this, &XmlWindow::processFile);
+    connect(m_watcher, &QFutureWatcher<Conversion>::progressValueChanged, this, &XmlWindow::conversionProgress);
+    connect(m_watcher, &QFutureWatcher<Conversion>::finished, this, &XmlWindow::conversionFinished);
 }
 
 XmlWindow::~XmlWindow()
 {
+    // a cancelled job stops at its next progress report and discards its output
+    m_watcher->cancel();
+    m_watcher->waitForFinished();
+
     delete ui;
 }
 
+bool XmlWindow::Conversion::sameScene(const Conversion &other) const
+{
+    return scenePath == other.scenePath && modified == other.modified && size == other.size;
+}
+
 void XmlWindow::swapWindows()
 {
     this->hide();
 }
 
-void XmlWindow::processFile()
+/**
+ * @brief XmlWindow::scenePath
+ *      The text edit holds a path or a dropped file:// URL
+ */
+QString XmlWindow::scenePath() const
 {
-    QString path = this->ui->textEdit->toPlainText();
-    path.remove(0,8);
-
-    xml = new QFile(path);
+    QString text = this->ui->textEdit->toPlainText().trimmed();
 
-    xml->open((QIODevice::ReadWrite | QIODevice::Text));
+    if (text.startsWith("file:"))
+        return QUrl(text).toLocalFile();
 
-    if (xml->isOpen())
-        this->ui->label->setText("File Status: Open");
-    else
-        this->ui->label->setText("File Status: Failed to Open");
-
-    createMujocoXML();
+    return text;
 }
 
-void XmlWindow::createMujocoXML()
+/**
+ * @brief XmlWindow::processFile
+ *      Starts converting the scene into a MuJoCo model next to it, see SceneConverter
+ */
+void XmlWindow::processFile()
 {
-    const QString result = "<mujoco model=\"a1 scene\">\n"
-                     "\t<include file=\"a1_arm.xml\"/>\n"
-                     "\t<statistic center=\"0 0 0.1\" extent=\"0.8\"/>\n\n"
-                     "\t<visual>\n"
-                     "\t\t<headlight diffuse=\"0.6 0.6 0.6\" ambient=\"0.3 0.3 0.3\" specular=\"0 0 0;\"/>\n"
-                     "\t\t<rgba haze=\"0.15 0.25 0.35 1\"/>\n"
-                     "\t\t<global azimuth=\"120\" elevation=\"-20\"/>\n"
-                     "\t</visual>\n\n"
-                     "\t<asset>\n"
-                     "\t\t<texture type=\"skybox\" builtin=\"gradient\" rgb1=\"0.3 0.5 0.7\" rgb2=\"0 0 0\" width=\"512\" height=\"3072\"/>\n"
-                     "\t\t<texture type=\"2d\" name=\"groundplane\" builtin=\"checker\" mark=\"edge\" rgb1=\"0.2 0.3 0.4\" rgb2=\"0.1 0.2 0.3\"\n"
-                     "\t\t\ttmarkrgb=\"0.8 0.8 0.8\" width=\"300\" height=\"300\"/>\n"
-                     "\t\t<material name=\"groundplane\" texture=\"groundplane\" texuniform=\"true\" texrepeat=\"5 5\" reflectance=\"0.2\"/>\n"
-                     "\t</asset>\n\n"
-                     "\t<worldbody>\n"
-                     "\t\t<light pos=\"0 0 1.5\" dir=\"0 0 -1\" directional=\"true\"/>\n"
-                     "\t\t<geom name=\"floor\" size=\"0 0 0.05\" type=\"plane\" material=\"groundplane\"/>\n";
-
-    const QString close = "\t</worldbody>\n"
-                          "</mujoco>\n";
-
-    const QByteArray cuboid = "<type>cuboid</type>";
-    int count = 0;
-
-    while (!xml->atEnd())
-    {
-        QByteArray line = xml->readLine();
+    QFileInfo info(scenePath());
 
-        if (line.contains(cuboid))
-            count++;
+    if (!info.isFile())
+    {
+        m_watcher->cancel();
+        this->ui->label->setText("File Status: Failed to Open");
+        return;
     }
 
-    this->xml->reset(); // go to top of file
-    QTextStream outfile(this->xml);
-    outfile << result; // overwrite with mujoco file structure
+    Conversion conversion;
+    conversion.scenePath = info.absoluteFilePath();
+    conversion.modified = info.lastModified();
+    conversion.size = info.size();
+    conversion.modelPath = SceneConverter::outputPathFor(conversion.scenePath);
 
-    for (int i = 0; i < count/2; ++i)
+    // already converted, or being converted
+    if (m_last.ok && m_last.sameScene(conversion) && QFileInfo::exists(m_last.modelPath))
     {
-        outfile << "\t\t<body pos = \"2 2 0\">\n"
-                << "\t\t\t<geom type=\"box\" size=\".03 .03 .3\" rgba=\"0 .9 0 1\" mass=\"1\"/>\n"
-                << "\t\t</body>\n";
+        m_watcher->cancel();
+        showConversion(m_last);
+        return;
     }
 
-    outfile << close;
+    if (m_watcher->isRunning() && !m_watcher->isCanceled() && m_running.sameScene(conversion))
+        return;
+
+    m_watcher->cancel();
+    m_running = conversion;
+
+    this->ui->label->setText("File Status: Converting");
+    m_watcher->setFuture(QtConcurrent::run(&XmlWindow::runConversion, conversion));
 }
 
+/**
+ * @brief XmlWindow::runConversion
+ *      Runs on a pool thread
+ */
+void XmlWindow::runConversion(QPromise<Conversion> &promise, Conversion conversion)
+{
+    promise.setProgressRange(0, 100);
+
+    QElapsedTimer timer;
+    timer.start();
+
+    SceneConverter converter;
+    conversion.ok = converter.convert(conversion.scenePath, conversion.modelPath, [&promise](qint64 done, qint64 total) {
+        promise.setProgressValue(total > 0 ? (int)(done * 100 / total) : 100);
+        return !promise.isCanceled();
+    });
+
+    if (converter.cancelled())
+        return;
+
+    conversion.cuboids = converter.cuboids();
+    conversion.error = converter.errorString();
+    conversion.elapsed = timer.elapsed();
+
+    promise.addResult(conversion);
+}
+
+void XmlWindow::conversionProgress(int percent)
+{
+    if (m_watcher->isRunning())
+        this->ui->label->setText(QString("File Status: Converting, %1%").arg(percent));
+}
+
+void XmlWindow::conversionFinished()
+{
+    if (m_watcher->isCanceled() || m_watcher->future().resultCount() == 0)
+        return;
+
+    Conversion conversion = m_watcher->result();
+    if (conversion.ok)
+        m_last = conversion;
+
+    showConversion(conversion);
+}
+
+void XmlWindow::showConversion(const Conversion &conversion)
+{
+    if (conversion.ok)
+        this->ui->label->setText(QString("File Status: %1 cuboids, written to %2 in %3 ms")
+                                 .arg(conversion.cuboids)
+                                 .arg(QFileInfo(conversion.modelPath).fileName())
+                                 .arg(conversion.elapsed));
+    else
+        this->ui->label->setText("File Status: Failed, " + conversion.error);
+}
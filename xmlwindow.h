@@ -1,30 +1,74 @@
 #ifndef XMLWINDOW_H
 #define XMLWINDOW_H
 
+#include <QDateTime>
+#include <QFutureWatcher>
 #include <QMainWindow>
-#include <QFile>
+#include <QPromise>
 #include <QStringList>
 
+class QTimer;
+
 namespace Ui {
 class XmlWindow;
 }
 
+/**
+ * @brief The XmlWindow class
+ *      Converts the scene whose path is typed or dropped into the text edit. The path
+ *      is only looked at once it has not changed for EditDelay ms, and the conversion
+ *      runs as a QtConcurrent job that reports its progress in the status label. A
+ *      new path cancels the running job; a path whose file has not changed since its
+ *      last conversion shows that result again.
+ */
 class XmlWindow : public QMainWindow
 {
     Q_OBJECT
 
 public:
+    // milliseconds without an edit before the path is converted
+    static constexpr int EditDelay = 300;
+
     explicit XmlWindow(QWidget *parent = nullptr);
     ~XmlWindow();
 
 private:
+    /**
+     * @brief The Conversion struct
+     *      One scene, as it was when its conversion started, and the outcome
+     */
+    struct Conversion
+    {
+        QString scenePath;
+        QDateTime modified;
+        qint64 size = -1;
+
+        QString modelPath;
+        bool ok = false;
+        int cuboids = 0;
+        QString error;
+        qint64 elapsed = 0;
+
+        bool sameScene(const Conversion &other) const;
+    };
+
+    static void runConversion(QPromise<Conversion> &promise, Conversion conversion);
+    void showConversion(const Conversion &conversion);
+
     Ui::XmlWindow *ui;
-    QFile *xml;
+
+    QTimer *m_editTimer;
+    QFutureWatcher<Conversion> *m_watcher;
+    Conversion m_running;
+    Conversion m_last;
+
+    QString scenePath() const;
 
 private slots:
     void swapWindows();
     void processFile();
-    void createMujocoXML();
+    void conversionProgress(int percent);
+    void conversionFinished();
 };
 
 #endif // XMLWINDOW_H